@@ -0,0 +1,179 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Implements helpers shared by ulog benchmarks.
+ * \date        2016/03/05 10:40:02 AM
+ * \file        bench.c
+ * \version     1.0
+ *
+ *
+ **/
+
+#define _POSIX_C_SOURCE 201509L /* for clock_gettime, sysconf */
+
+#include "bench.h"
+
+#include <ulog/universal.h> /* UNUSED */
+
+#include <inttypes.h> /* PRIu64 */
+#include <stdbool.h> /* bool */
+#include <stdio.h> /* FILE, fprintf, printf, tmpfile, vfprintf */
+#include <stdlib.h> /* EXIT_FAILURE, exit, getenv, qsort, strtoul */
+#include <time.h> /* clock_gettime, struct timespec */
+#include <unistd.h> /* sysconf */
+
+static bool first_entry;
+
+void
+bench_fail( char const * const what )
+{
+    UNUSED( fprintf( stderr, "benchmark failed: %s\n", what ));
+    exit( EXIT_FAILURE );
+}
+
+uint64_t
+bench_now( void )
+{
+    struct timespec now;
+    UNUSED( clock_gettime( CLOCK_MONOTONIC, &now ));
+    return (( uint64_t ) now.tv_sec ) * 1000000000U + ( uint64_t ) now.tv_nsec;
+}
+
+size_t
+bench_parameter( char const * const name, size_t const fallback )
+{
+    char const * const value = getenv( name );
+    if( NULL == value ) { return fallback; }
+    unsigned long const result = strtoul( value, NULL, 10 );
+    return ( 0U == result ) ? fallback : ( size_t ) result;
+}
+
+size_t
+bench_processors( void )
+{
+    long const result = sysconf( _SC_NPROCESSORS_ONLN );
+    return ( 0 < result ) ? ( size_t ) result : 1U;
+}
+
+void
+bench_begin( char const * const name )
+{
+    printf( "{\"benchmark\":\"%s\",\"results\":[", name );
+    first_entry = true;
+}
+
+void
+bench_end( void )
+{
+    printf( "\n]}\n" );
+}
+
+static void
+entry( void )
+{
+    printf( first_entry ? "\n" : ",\n" );
+    first_entry = false;
+}
+
+static int
+compare( void const * const first, void const * const second )
+{
+    uint64_t const a = *( uint64_t const * ) first;
+    uint64_t const b = *( uint64_t const * ) second;
+    return ( a > b ) - ( a < b );
+}
+
+static uint64_t
+percentile( uint64_t const * const sorted, size_t const count, double rank )
+{
+    size_t const index = ( size_t ) ( rank * ( double ) ( count - 1U ));
+    return sorted[ index ];
+}
+
+static unsigned
+bucket( uint64_t value )
+{
+    unsigned result = 0U;
+    while(( 1U < value ) && ( result < ( BENCH_BUCKETS - 1U )))
+    {
+        value >>= 1U;
+        ++result;
+    }
+    return result;
+}
+
+void
+bench_latency(
+    char const * const name,
+    uint64_t * const samples,
+    size_t const count
+)
+{
+    if( 0U == count ) { return; }
+    qsort( samples, count, sizeof( uint64_t ), compare );
+
+    uint64_t histogram[ BENCH_BUCKETS ] = { 0U };
+    double sum = 0.0;
+    for( size_t i = 0U; i < count; ++i )
+    {
+        ++histogram[ bucket( samples[ i ] ) ];
+        sum += ( double ) samples[ i ];
+    }
+
+    entry();
+    printf(
+        "{\"case\":\"%s\",\"unit\":\"ns\",\"samples\":%zu,\"mean\":%.1f,"
+        "\"p50\":%" PRIu64 ",\"p99\":%" PRIu64 ",\"p999\":%" PRIu64 ","
+        "\"max\":%" PRIu64 ",\"histogram_log2\":[",
+        name,
+        count,
+        sum / ( double ) count,
+        percentile( samples, count, 0.5 ),
+        percentile( samples, count, 0.99 ),
+        percentile( samples, count, 0.999 ),
+        samples[ count - 1U ]
+    );
+    unsigned last = BENCH_BUCKETS - 1U;
+    while(( 0U < last ) && ( 0U == histogram[ last ] )) { --last; }
+    for( unsigned i = 0U; i <= last; ++i )
+    {
+        printf( "%s%" PRIu64, ( 0U == i ) ? "" : ",", histogram[ i ] );
+    }
+    printf( "]}" );
+}
+
+void
+bench_value( char const * const name, char const * const unit, double value )
+{
+    entry();
+    printf(
+        "{\"case\":\"%s\",\"unit\":\"%s\",\"value\":%.3f}",
+        name,
+        unit,
+        value
+    );
+}
+
+void
+bench_null_handler(
+    ulog_level const level,
+    char const * const format,
+    va_list args
+)
+{
+    UNUSED( level );
+    UNUSED( format );
+    UNUSED( args );
+}
+
+void
+bench_file_handler(
+    ulog_level const level,
+    char const * const format,
+    va_list args
+)
+{
+    static FILE * file;
+    UNUSED( level );
+    if( NULL == file ) { file = tmpfile(); }
+    if( NULL != file ) { UNUSED( vfprintf( file, format, args )); }
+}
@@ -0,0 +1,129 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Helpers shared by ulog benchmarks.
+ * \date        2016/03/05 10:12:31 AM
+ * \file        bench.h
+ * \version     1.0
+ *
+ * Each benchmark prints a single JSON object to standard output, so the
+ * results of "make bench" can be compared between runs by scripts.
+ **/
+
+#ifndef ULOG_BENCH_H__
+# define ULOG_BENCH_H__
+
+# include <ulog/ulog.h> /* ulog_level */
+
+# include <stdarg.h> /* va_list */
+# include <stdbool.h> /* bool */
+# include <stddef.h> /* size_t */
+# include <stdint.h> /* uint64_t */
+
+# ifdef __cplusplus
+extern "C" {
+# endif /* __cplusplus */
+
+/**
+ * \brief Number of logarithmic buckets in latency histogram.
+ */
+# define BENCH_BUCKETS 32U
+/**
+ * \brief Ends benchmark after a call it depends on failed.
+ * \param what Description of the call.
+ */
+void
+bench_fail( char const * const what );
+/**
+ * \brief Checks result of a call made by benchmark.
+ * \param passed Whether the call succeeded.
+ * \param what Description of the call, printed if it failed.
+ *
+ * Unlike assert(), the check stays in builds with NDEBUG, and the call is
+ * made before it regardless, so what's measured doesn't depend on flags.
+ */
+static inline void
+bench_require( bool const passed, char const * const what )
+{
+    if( !passed ) { bench_fail( what ); }
+}
+/**
+ * \brief Returns monotonic time in nanoseconds.
+ * \return Current time.
+ */
+uint64_t
+bench_now( void );
+/**
+ * \brief Reads positive integer from environment variable.
+ * \param name Name of the variable.
+ * \param fallback Value used when variable is unset or invalid.
+ * \return Value of the variable or fallback.
+ */
+size_t
+bench_parameter( char const * const name, size_t const fallback );
+/**
+ * \brief Returns number of online processors.
+ * \return Number of processors, at least one.
+ */
+size_t
+bench_processors( void );
+/**
+ * \brief Starts the JSON object describing benchmark.
+ * \param name Name of the benchmark.
+ */
+void
+bench_begin( char const * const name );
+/**
+ * \brief Ends the JSON object describing benchmark.
+ */
+void
+bench_end( void );
+/**
+ * \brief Prints latency percentiles and histogram of samples as JSON.
+ * \param name Name of the measured case.
+ * \param samples Latencies in nanoseconds; sorted by this function.
+ * \param count Number of samples.
+ *
+ * Histogram bucket i counts samples in range [2^i, 2^(i+1)) nanoseconds.
+ */
+void
+bench_latency(
+    char const * const name,
+    uint64_t * const samples,
+    size_t const count
+);
+/**
+ * \brief Prints a single named value as JSON.
+ * \param name Name of the measured case.
+ * \param unit Unit of the value.
+ * \param value Measured value.
+ */
+void
+bench_value( char const * const name, char const * const unit, double value );
+/**
+ * \brief Handler which discards messages.
+ * \see ulog_handler_fn
+ */
+void
+bench_null_handler(
+    ulog_level const level,
+    char const * const format,
+    va_list args
+);
+/**
+ * \brief Handler which writes messages to a temporary file.
+ * \see ulog_handler_fn
+ *
+ * The file is created on first use and removed at exit.
+ */
+void
+bench_file_handler(
+    ulog_level const level,
+    char const * const format,
+    va_list args
+);
+
+# ifdef __cplusplus
+}
+# endif /* __cplusplus */
+
+#endif /* ULOG_BENCH_H__ */
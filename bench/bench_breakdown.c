@@ -0,0 +1,106 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Measures cost of individual stages of a logging call.
+ * \date        2016/03/05 11:48:55 AM
+ * \file        bench_breakdown.c
+ * \version     1.0
+ *
+ * Each stage is repeated BENCH_ITERATIONS times and the mean cost of one
+ * repetition is reported, so that it can be compared to the full call.
+ **/
+
+#define _POSIX_C_SOURCE 201509L /* for snprintf in strict mode */
+
+#include "bench.h"
+
+#include <ulog/mutex.h>
+#include <ulog/status.h>
+#include <ulog/ulog.h>
+#include <ulog/universal.h> /* UNUSED */
+
+#include <inttypes.h> /* PRIu64 */
+#include <stddef.h> /* size_t */
+#include <stdint.h> /* uint64_t */
+#include <stdio.h> /* snprintf */
+
+static size_t iterations;
+
+static void
+report( char const * const name, uint64_t const start )
+{
+    bench_value(
+        name,
+        "ns/op",
+        ( double ) ( bench_now() - start ) / ( double ) iterations
+    );
+}
+
+int
+main( void )
+{
+    iterations = bench_parameter( "BENCH_ITERATIONS", 1000000U );
+    ulog_obj const * const ulog = ulog_obj_get();
+    ulog_mutex mutex = ulog_mutex_get();
+    char buffer[ 256U ];
+    volatile uint64_t sink = 0U;
+    bench_require( ulog_status_success( ulog->op->setup( ulog )), "setup" );
+    bench_require(
+        ulog_status_success( ulog->op->add( ulog, bench_null_handler )),
+        "add"
+    );
+    bench_require(
+        ulog_status_success( mutex.op->setup( &mutex )),
+        "mutex setup"
+    );
+
+    bench_begin( "breakdown" );
+
+    uint64_t start = bench_now();
+    for( size_t i = 0U; i < iterations; ++i )
+    {
+        sink += ulog_current_time_();
+    }
+    report( "timestamp", start );
+
+    start = bench_now();
+    for( size_t i = 0U; i < iterations; ++i )
+    {
+        sink += ( uint64_t ) snprintf(
+            buffer,
+            sizeof( buffer ),
+            ULOG_HEADER_FORMAT_ "breakdown %zu%c",
+            ulog_level_to_char_( INFO ),
+            ( uint64_t ) i,
+            __FILE__,
+            __func__,
+            __LINE__,
+            i,
+            '\n'
+        );
+    }
+    report( "format", start );
+
+    start = bench_now();
+    for( size_t i = 0U; i < iterations; ++i )
+    {
+        UNUSED( mutex.op->lock( &mutex ));
+        UNUSED( mutex.op->unlock( &mutex ));
+    }
+    report( "lock", start );
+
+    start = bench_now();
+    for( size_t i = 0U; i < iterations; ++i )
+    {
+        UINFO( "breakdown %zu", i );
+    }
+    report( "full_call", start );
+
+    bench_end();
+
+    bench_require(
+        ulog_status_success( mutex.op->cleanup( &mutex )),
+        "mutex cleanup"
+    );
+    bench_require( ulog_status_success( ulog->op->cleanup( ulog )), "cleanup" );
+    return ( 0U == sink ) ? 1 : 0;
+}
@@ -0,0 +1,93 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Compares latency of C++ front-end with C logging macros.
+ * \date        2016/04/30 16:08:43 PM
+ * \file        bench_cxx.cpp
+ * \version     1.0
+ *
+ * The C case is what logging macros expanded to in C++ before ulog.hpp:
+ * a call to ulog_() without types of arguments. Both cases log the same
+ * message to a handler discarding it, once with a number and a string, and
+ * once with std::string, which C++ passes as is.
+ **/
+
+#include "bench.h"
+
+#include <ulog/status.h>
+#include <ulog/ulog.hpp>
+
+#include <cstddef> /* std::size_t */
+#include <cstdint> /* std::uint64_t */
+#include <string> /* std::string */
+#include <vector> /* std::vector */
+
+namespace
+{
+
+void
+c_macro( std::size_t const i, std::string const & name )
+{
+    if( ulog_enabled_( INFO ))
+    {
+        ulog_(
+            INFO,
+            ULOG_HEADER_FORMAT_ "sample %zu of %s" "%c",
+            ulog_level_char_( INFO ),
+            ulog_current_time_(),
+            __FILE__,
+            __func__,
+            static_cast< unsigned >( __LINE__ ),
+            i,
+            name.c_str(),
+            '\n'
+        );
+    }
+}
+
+void
+cxx( std::size_t const i, std::string const & name )
+{
+    UINFO( "sample %zu of %s", i, name );
+}
+
+template< typename Call >
+void
+measure(
+    char const * const name,
+    std::vector< std::uint64_t > & samples,
+    Call const call
+)
+{
+    std::string const argument = name;
+    for( std::size_t i = 0U; i < samples.size(); ++i )
+    {
+        std::uint64_t const start = bench_now();
+        call( i, argument );
+        samples[ i ] = bench_now() - start;
+    }
+    bench_latency( name, samples.data(), samples.size());
+}
+
+} // namespace
+
+int
+main()
+{
+    std::vector< std::uint64_t > samples(
+        bench_parameter( "BENCH_SAMPLES", 100000U )
+    );
+    ulog_obj const * const ulog = ulog_obj_get();
+    bench_require( ulog_status_success( ulog->op->setup( ulog )), "setup" );
+    bench_require(
+        ulog_status_success( ulog->op->add( ulog, bench_null_handler )),
+        "add"
+    );
+
+    bench_begin( "cxx" );
+    measure( "c_null_handler", samples, c_macro );
+    measure( "cxx_null_handler", samples, cxx );
+    bench_end();
+
+    bench_require( ulog_status_success( ulog->op->cleanup( ulog )), "cleanup" );
+    return 0;
+}
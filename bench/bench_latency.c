@@ -0,0 +1,80 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Measures latency of single logging calls.
+ * \date        2016/03/05 11:02:17 AM
+ * \file        bench_latency.c
+ * \version     1.0
+ *
+ * Cases: call filtered out by verbosity, call delivered to handler which
+ * discards the message and call delivered to handler writing to a file.
+ * Number of samples is taken from BENCH_SAMPLES environment variable.
+ **/
+
+#include "bench.h"
+
+#include <ulog/status.h>
+#include <ulog/ulog.h>
+
+#include <stddef.h> /* size_t */
+#include <stdint.h> /* uint64_t */
+#include <stdlib.h> /* free, malloc */
+
+static void
+measure(
+    char const * const name,
+    uint64_t * const samples,
+    size_t const count
+)
+{
+    for( size_t i = 0U; i < count; ++i )
+    {
+        uint64_t const start = bench_now();
+        UDEBUG( "latency sample %zu of %s", i, name );
+        samples[ i ] = bench_now() - start;
+    }
+    bench_latency( name, samples, count );
+}
+
+int
+main( void )
+{
+    size_t const count = bench_parameter( "BENCH_SAMPLES", 100000U );
+    uint64_t * const samples = malloc( count * sizeof( uint64_t ));
+    bench_require( NULL != samples, "allocation" );
+    ulog_obj const * const ulog = ulog_obj_get();
+    bench_require( ulog_status_success( ulog->op->setup( ulog )), "setup" );
+
+    bench_begin( "latency" );
+
+    bench_require(
+        ulog_status_success( ulog->op->add( ulog, bench_null_handler )),
+        "add"
+    );
+    bench_require(
+        ulog_status_success( ulog->op->verbosity( ulog, ERROR )),
+        "verbosity"
+    );
+    measure( "disabled", samples, count );
+
+    bench_require(
+        ulog_status_success( ulog->op->verbosity( ulog, DEBUG )),
+        "verbosity"
+    );
+    measure( "null_handler", samples, count );
+    bench_require(
+        ulog_status_success( ulog->op->remove( ulog, bench_null_handler )),
+        "remove"
+    );
+
+    bench_require(
+        ulog_status_success( ulog->op->add( ulog, bench_file_handler )),
+        "add"
+    );
+    measure( "file_handler", samples, count );
+
+    bench_end();
+
+    bench_require( ulog_status_success( ulog->op->cleanup( ulog )), "cleanup" );
+    free( samples );
+    return 0;
+}
@@ -0,0 +1,97 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Compares plain and adaptive mutex under contention.
+ * \date        2016/03/12 11:05:36 AM
+ * \file        bench_mutex.c
+ * \version     1.0
+ *
+ * Same pattern as test_mutex_threaded_c99_01: each of BENCH_THREADS
+ * (64 by default) threads increments shared counter under the mutex
+ * BENCH_LOOPS times.
+ **/
+
+#include "bench.h"
+
+#include <ulog/mutex.h>
+#include <ulog/status.h>
+
+#include <pthread.h> /* pthread_create, pthread_join, pthread_t */
+#include <stdbool.h> /* bool */
+#include <stddef.h> /* NULL, size_t */
+#include <stdint.h> /* uint64_t */
+#include <stdio.h> /* snprintf */
+#include <stdlib.h> /* free, malloc */
+
+static size_t resource;
+static size_t loops;
+
+static void *
+increment( void * const arg )
+{
+    ulog_mutex const * const mutex = arg;
+    for( size_t i = 0U; i < loops; ++i )
+    {
+        bool const locked = ulog_mutex_lock( mutex );
+        ++resource;
+        bool const unlocked = ulog_mutex_unlock( mutex );
+        bench_require( locked && unlocked, "mutex lock" );
+    }
+    return NULL;
+}
+
+static void
+measure(
+    char const * const kind,
+    ulog_mutex mutex,
+    size_t const threads,
+    pthread_t * const workers
+)
+{
+    bench_require(
+        ulog_status_success( mutex.op->setup( &mutex )),
+        "mutex setup"
+    );
+    resource = 0U;
+    uint64_t const start = bench_now();
+    for( size_t i = 0U; i < threads; ++i )
+    {
+        int const created =
+            pthread_create( &workers[ i ], NULL, increment, &mutex );
+        bench_require( 0 == created, "thread create" );
+    }
+    for( size_t i = 0U; i < threads; ++i )
+    {
+        int const joined = pthread_join( workers[ i ], NULL );
+        bench_require( 0 == joined, "thread join" );
+    }
+    uint64_t const elapsed = bench_now() - start;
+    bench_require(( threads * loops ) == resource, "mutual exclusion" );
+    bench_require(
+        ulog_status_success( mutex.op->cleanup( &mutex )),
+        "mutex cleanup"
+    );
+
+    char name[ 64U ];
+    ( void ) snprintf( name, sizeof( name ), "%s_%zu_threads", kind, threads );
+    bench_value( name, "ns/op", ( double ) elapsed / ( double ) resource );
+}
+
+int
+main( void )
+{
+    size_t const threads = bench_parameter( "BENCH_THREADS", 64U );
+    pthread_t * const workers = malloc( threads * sizeof( pthread_t ));
+    bench_require( NULL != workers, "allocation" );
+    loops = bench_parameter( "BENCH_LOOPS", 100000U );
+
+    bench_begin( "mutex" );
+    for( size_t i = 1U; i <= threads; i *= 4U )
+    {
+        measure( "plain", ulog_mutex_get(), i, workers );
+        measure( "adaptive", ulog_mutex_get_adaptive(), i, workers );
+    }
+    bench_end();
+
+    free( workers );
+    return 0;
+}
@@ -0,0 +1,130 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Measures logging throughput with growing number of threads.
+ * \date        2016/03/05 11:26:40 AM
+ * \file        bench_throughput.c
+ * \version     1.0
+ *
+ * Threads from 1 up to BENCH_THREADS (number of processors by default)
+ * each log BENCH_MESSAGES messages to a handler discarding them, first
+ * synchronously, with the guard of handlers taken shared, then through the
+ * asynchronous channel.
+ **/
+
+#include "bench.h"
+
+#include <ulog/status.h>
+#include <ulog/ulog.h>
+
+#include <pthread.h> /* pthread_create, pthread_join, pthread_t */
+#include <stdbool.h> /* bool, false, true */
+#include <stddef.h> /* NULL, size_t */
+#include <stdint.h> /* UINT64_MAX, uint64_t */
+#include <stdio.h> /* snprintf */
+#include <stdlib.h> /* free, malloc */
+
+static size_t messages;
+
+static void *
+producer( void * const arg )
+{
+    ( void ) arg;
+    for( size_t i = 0U; i < messages; ++i )
+    {
+        UINFO( "throughput message %zu", i );
+    }
+    return NULL;
+}
+
+static void
+measure(
+    bool const asynchronous,
+    size_t const threads,
+    pthread_t * const producers
+)
+{
+    ulog_obj const * const ulog = ulog_obj_get();
+    uint64_t const start = bench_now();
+    for( size_t i = 0U; i < threads; ++i )
+    {
+        int const created =
+            pthread_create( &producers[ i ], NULL, producer, NULL );
+        bench_require( 0 == created, "thread create" );
+    }
+    for( size_t i = 0U; i < threads; ++i )
+    {
+        int const joined = pthread_join( producers[ i ], NULL );
+        bench_require( 0 == joined, "thread join" );
+    }
+    /* queued messages count once they're handled, so wait for the consumer */
+    ulog_async_counters counters = { .delivered = 0U, .dropped = 0U };
+    while(
+        asynchronous
+        && (( counters.delivered + counters.dropped ) < threads * messages )
+    )
+    {
+        ulog_status const read = ulog->op->counters( ulog, &counters );
+        bench_require( ulog_status_success( read ), "counters" );
+    }
+    uint64_t const elapsed = bench_now() - start;
+
+    char name[ 64U ];
+    ( void ) snprintf(
+        name,
+        sizeof( name ),
+        "%s_%zu_threads",
+        asynchronous ? "async" : "sync",
+        threads
+    );
+    bench_value(
+        name,
+        "messages/s",
+        ( double ) ( threads * messages ) * 1e9 / ( double ) elapsed
+    );
+}
+
+int
+main( void )
+{
+    size_t const threads =
+        bench_parameter( "BENCH_THREADS", bench_processors());
+    pthread_t * const producers = malloc( threads * sizeof( pthread_t ));
+    bench_require( NULL != producers, "allocation" );
+    messages = bench_parameter( "BENCH_MESSAGES", 100000U );
+    ulog_obj const * const ulog = ulog_obj_get();
+    ulog_async_config const config =
+    {
+        .capacity = 4096U,
+        .policy = ULOG_BLOCK,
+        .timeout = UINT64_MAX
+    };
+    bench_require( ulog_status_success( ulog->op->setup( ulog )), "setup" );
+    bench_require(
+        ulog_status_success( ulog->op->add( ulog, bench_null_handler )),
+        "add"
+    );
+
+    bench_begin( "throughput" );
+    for( size_t i = 1U; i <= threads; i *= 2U )
+    {
+        measure( false, i, producers );
+    }
+
+    for( size_t i = 1U; i <= threads; i *= 2U )
+    {
+        bench_require(
+            ulog_status_success( ulog->op->async( ulog, &config )),
+            "async"
+        );
+        measure( true, i, producers );
+        bench_require(
+            ulog_status_success( ulog->op->async( ulog, NULL )),
+            "async"
+        );
+    }
+    bench_end();
+
+    bench_require( ulog_status_success( ulog->op->cleanup( ulog )), "cleanup" );
+    free( producers );
+    return 0;
+}
@@ -0,0 +1,226 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Defines API for asynchronous delivery of log records.
+ * \date        2016/02/20 10:41:12 AM
+ * \file        async.h
+ * \version     1.0
+ *
+ *
+ **/
+
+#ifndef ULOG_ASYNC_H__
+# define ULOG_ASYNC_H__
+
+# include <ulog/status.h> /* ulog_status */
+# include <ulog/ulog.h> /* ulog_level, ulog_async_config */
+# include <ulog/universal.h> /* THREADUNSAFE */
+
+# include <stdarg.h> /* va_list */
+# include <stddef.h> /* size_t */
+
+# ifdef __cplusplus
+extern "C" {
+# endif /* __cplusplus */
+
+/**
+ * \brief Forward declaration of opaque ulog_async state.
+ * \see struct ulog_async_state_struct
+ */
+typedef struct ulog_async_state_struct ulog_async_state;
+/**
+ * \brief Forward declaration of asynchronous channel operations table.
+ * \see struct ulog_async_op_table_struct
+ */
+typedef struct ulog_async_op_table_struct ulog_async_op_table;
+/**
+ * \brief Definition of asynchronous channel object.
+ * \see ulog_async_state
+ * \see ulog_async_op_table
+ * \see ulog_async_config
+ *
+ * The channel renders records into preallocated buffers and queues them
+ * for a consumer thread, which passes them to a sink function. Producers
+ * never take a lock; what happens when all buffers are in use is decided
+ * by the back-pressure policy in ulog_async_config. The life cycle is the
+ * same as of ulog_mutex: setup() starts the consumer thread, cleanup()
+ * delivers what's left and stops it. Sample code:
+ * ulog_async a = ulog_async_get();
+ * ulog_async_config c = { .capacity = 1024U, .policy = ULOG_DROP_NEWEST };
+ * a.op->setup(&a, &c, sink, NULL);
+ * a.op->submit(&a, INFO, format, args);
+ * a.op->cleanup(&a);
+ */
+typedef struct
+{
+    /** Object's state. */
+    ulog_async_state * state;
+    /** Table of operations. */
+    ulog_async_op_table const * op;
+}
+ulog_async;
+/**
+ * \brief Definition of a function receiving rendered records.
+ * \param userdata Pointer given to setup().
+ * \param level Log level of the record.
+ * \param text Rendered record, NUL-terminated.
+ * \param length Length of text, without terminating NUL.
+ *
+ * Sink is called from the consumer thread only, one record at a time.
+ */
+typedef void
+( * ulog_async_sink_fn )(
+    void * const userdata,
+    ulog_level const level,
+    char const * const text,
+    size_t const length
+);
+/**
+ * \brief Defines type of setup operation on ulog_async object.
+ * \param self The ulog_async object on which we'll operate.
+ * \param config Capacity and back-pressure policy.
+ * \param sink Function receiving records in consumer thread.
+ * \param userdata Pointer passed to sink.
+ * \return Status object.
+ * \see THREADUNSAFE
+ * \see ulog_status
+ * \see ulog_async_config
+ *
+ * All record buffers are allocated here.
+ * Possible status codes:
+ * 1. 0 (zero) - setup successful;
+ * 2. EINVAL - invalid self, config or sink given;
+ * 3. EALREADY - self already initialized;
+ * 4. ENOMEM - cannot allocate memory for channel state;
+ * 5. EIO - cannot open overflow file or start consumer thread.
+ */
+typedef THREADUNSAFE ulog_status
+    ( * ulog_async_setup_op )(
+        ulog_async * const self,
+        ulog_async_config const * const config,
+        ulog_async_sink_fn const sink,
+        void * const userdata
+    );
+/**
+ * \brief Defines type of cleanup operation on ulog_async object.
+ * \param self The ulog_async object on which we'll operate.
+ * \return Status object.
+ * \see THREADUNSAFE
+ * \see ulog_status
+ *
+ * Records submitted before cleanup() are delivered before it returns.
+ * Possible status codes:
+ * 1. 0 (zero) - cleanup successful;
+ * 2. EINVAL - invalid self given;
+ * 3. EALREADY - self already uninitialized.
+ */
+typedef THREADUNSAFE ulog_status
+    ( * ulog_async_ctrl_op )( ulog_async * const self );
+/**
+ * \brief Defines type of reset operation on ulog_async object.
+ * \param self The ulog_async object on which we'll operate.
+ * \return Status object.
+ * \see THREADUNSAFE
+ * \see ulog_status
+ *
+ * Meant for the child process after fork(), which inherits the buffers but
+ * not the consumer thread. Records queued before fork() are discarded, as
+ * the parent delivers them, and counters start from zero. The channel is
+ * set up again with the same configuration, so it's uninitialized if that
+ * fails.
+ * Possible status codes:
+ * 1. 0 (zero) - reset successful;
+ * 2. EINVAL - invalid or uninitialized self given;
+ * 3. any status code returned by setup().
+ */
+typedef THREADUNSAFE ulog_status
+    ( * ulog_async_reset_op )( ulog_async * const self );
+/**
+ * \brief Defines type of submit() operation on ulog_async object.
+ * \param self The ulog_async object on which we'll operate.
+ * \param level Log level.
+ * \param format Formatting string, as in printf.
+ * \param args Arguments for the format string, as in vprintf.
+ * \return Status object.
+ * \see ulog_status
+ * \see ulog_async_policy
+ *
+ * Renders the record and queues it for delivery. Records longer than
+ * ULOG_RECORD_SIZE - 1 bytes are truncated.
+ * Possible status codes:
+ * 1. 0 (zero) - record queued;
+ * 2. EINVAL - invalid or uninitialized self given;
+ * 3. ENOBUFS - record dropped according to policy;
+ * 4. EOVERFLOW - record written to overflow file instead of sink.
+ */
+typedef ulog_status
+    ( * ulog_async_submit_op )(
+        ulog_async const * const self,
+        ulog_level const level,
+        char const * const format,
+        va_list args
+    );
+/**
+ * \brief Defines type of flush() operation on ulog_async object.
+ * \param self The ulog_async object on which we'll operate.
+ * \return Status object.
+ * \see ulog_status
+ *
+ * Waits until all records queued before the call are delivered.
+ * Possible status codes:
+ * 1. 0 (zero) - records delivered;
+ * 2. EINVAL - invalid or uninitialized self given.
+ */
+typedef ulog_status
+    ( * ulog_async_op )( ulog_async const * const self );
+/**
+ * \brief Defines type of counters() operation on ulog_async object.
+ * \param self The ulog_async object on which we'll operate.
+ * \param counters Receives current values of counters.
+ * \return Status object.
+ * \see ulog_status
+ * \see ulog_async_counters
+ *
+ * If stall was configured, the consumer also serves as a watchdog of the
+ * sink: each delivery taking longer is counted, and a delivery currently
+ * taking longer is reported as stalled.
+ * Possible status codes:
+ * 1. 0 (zero) - counters read;
+ * 2. EINVAL - invalid or uninitialized self given;
+ * 3. ENODATA - invalid pointer to counters given.
+ */
+typedef ulog_status
+    ( * ulog_async_counters_op )(
+        ulog_async const * const self,
+        ulog_async_counters * const counters
+    );
+/**
+ * \brief Definition of asynchronous channel operations table.
+ */
+struct ulog_async_op_table_struct
+{
+    /** Allocates buffers and starts consumer thread. */
+    ulog_async_setup_op setup;
+    /** Delivers remaining records, stops thread and frees buffers. */
+    ulog_async_ctrl_op cleanup;
+    /** Queues a record for delivery. */
+    ulog_async_submit_op submit;
+    /** Waits for delivery of queued records. */
+    ulog_async_op flush;
+    /** Reads counters of delivered, dropped and spilled records. */
+    ulog_async_counters_op counters;
+    /** Starts consumer thread again in the child process after fork(). */
+    ulog_async_reset_op reset;
+};
+/**
+ * \brief Creates asynchronous channel object in default state.
+ * \return Asynchronous channel object.
+ * \see ulog_async
+ */
+ulog_async
+ulog_async_get( void );
+
+# ifdef __cplusplus
+}
+# endif /* __cplusplus */
+
+#endif /* ULOG_ASYNC_H__ */
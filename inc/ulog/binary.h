@@ -0,0 +1,122 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Binary encoding of log records.
+ * \date        2016/04/23 10:05:37 AM
+ * \file        binary.h
+ * \version     1.0
+ *
+ *
+ **/
+
+#ifndef ULOG_BINARY_H__
+# define ULOG_BINARY_H__
+
+# include <stdarg.h> /* va_list */
+# include <stddef.h> /* size_t */
+# include <stdint.h> /* uint8_t, uint16_t, uint32_t */
+# include <ulog/context.h> /* ulog_context */
+# include <ulog/status.h> /* ulog_status */
+# include <ulog/ulog.h> /* ulog_arg_type, ulog_level */
+# include <ulog/universal.h> /* ULOG_EXPORT */
+
+# ifdef __cplusplus
+extern "C" {
+# endif /* __cplusplus */
+
+/**
+ * \brief Definition of header starting each binary record.
+ * \see ulog_binary_handler_fn
+ *
+ * The header is followed by one byte of ulog_arg_type per argument, then by
+ * the arguments in order. Numbers and pointers are stored in their native
+ * representation and size, strings as uint32_t length followed by that many
+ * characters, without terminating zero. If the record has context, it
+ * follows the arguments as uint16_t size of its data, uint16_t offset of
+ * each key and the data. Nothing after the header is aligned.
+ * The format is stored as a pointer, so records can be decoded only within
+ * the process which logged them.
+ */
+typedef struct
+{
+    /** Size of the whole record, including this header. */
+    uint32_t size;
+    /** Log level. */
+    uint8_t level;
+    /** Number of arguments. */
+    uint8_t count;
+    /** Number of context pairs. */
+    uint16_t context;
+    /** Formatting string, as given to ulog_(). */
+    char const * format;
+}
+ulog_binary_header;
+/**
+ * \brief Encodes message into binary record.
+ * \param buffer Receives the record.
+ * \param size Size of the buffer.
+ * \param level Log level.
+ * \param signature Types of arguments, terminated with ULOG_ARG_END.
+ * \param format Formatting string, as in printf.
+ * \param args Arguments, according to signature.
+ * \param context Context attached to the record, may be NULL.
+ * \return Size of the record, zero if even its header doesn't fit.
+ * \see ulog_binary_header
+ *
+ * Strings which don't fit in the buffer are truncated, other arguments which
+ * don't fit are dropped along with all the following ones. Context which
+ * doesn't fit after the arguments is dropped.
+ */
+size_t
+ulog_binary_encode(
+    void * const buffer,
+    size_t const size,
+    ulog_level const level,
+    unsigned char const * const signature,
+    char const * const format,
+    va_list args,
+    ulog_context const * const context
+);
+/**
+ * \brief Renders binary record into text.
+ * \param record Record, as given to a binary handler.
+ * \param size Size of the record.
+ * \param text Receives the message, always zero-terminated.
+ * \param length Size of text buffer; longer messages are truncated.
+ * \return Status object.
+ * \see ulog_binary_handler_fn
+ *
+ * The result is the same as rendering the message with printf.
+ * Possible error codes:
+ * 1. EINVAL - record is malformed or its arguments don't match the format,
+ * 2. ENOTSUP - format uses '*' width or precision, or %n conversion.
+ */
+ULOG_EXPORT ulog_status
+ulog_binary_decode(
+    void const * const record,
+    size_t const size,
+    char * const text,
+    size_t const length
+);
+/**
+ * \brief Extracts context from binary record.
+ * \param record Record, as given to a binary handler.
+ * \param size Size of the record.
+ * \param context Receives the context, empty if record has none.
+ * \return Status object.
+ * \see ulog_context
+ *
+ * Possible error codes:
+ * 1. EINVAL - record is malformed.
+ */
+ULOG_EXPORT ulog_status
+ulog_binary_context(
+    void const * const record,
+    size_t const size,
+    ulog_context * const context
+);
+
+# ifdef __cplusplus
+}
+# endif /* __cplusplus */
+
+#endif /* ULOG_BINARY_H__ */
@@ -0,0 +1,165 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Block compression of logged records.
+ * \date        2016/06/06 09:24:37 AM
+ * \file        compress.h
+ * \version     1.0
+ *
+ * Log text repeats itself a lot and compresses several times over with a
+ * simple LZ77 scheme, the same as of LZ4 blocks, fast enough to keep up
+ * with a disk. Each block is compressed on its own and starts with a header
+ * telling its sizes, so readers can hop from block to block without
+ * decompressing them, decompress all of them at once on many threads or
+ * stream them, one block at a time.
+ **/
+
+#ifndef ULOG_COMPRESS_H__
+# define ULOG_COMPRESS_H__
+
+# include <stdbool.h> /* bool */
+# include <stddef.h> /* size_t */
+# include <ulog/status.h> /* ulog_status */
+# include <ulog/universal.h> /* ULOG_EXPORT */
+
+# ifdef __cplusplus
+extern "C" {
+# endif /* __cplusplus */
+
+/**
+ * \brief Size of header starting each block.
+ * \see ulog_compress_block
+ *
+ * The header is "ULZ1", then uint32_t size of data before compression and
+ * uint32_t size of data stored after the header. Data stored as large as
+ * before compression is not compressed.
+ */
+# define ULOG_COMPRESS_HEADER 12U
+/**
+ * \brief Largest data compressed into one block.
+ */
+# define ULOG_COMPRESS_MAXIMUM ( 64U * 1024U * 1024U )
+/**
+ * \brief Size of buffer sufficient for block of given data.
+ * \param size Size of data before compression.
+ * \return Size of the buffer.
+ * \see ulog_compress_block
+ */
+ULOG_EXPORT size_t
+ulog_compress_bound( size_t const size );
+/**
+ * \brief Compresses data into one block.
+ * \param data Data to compress.
+ * \param size Size of data, at most ULOG_COMPRESS_MAXIMUM.
+ * \param block Receives the block, along with its header.
+ * \param capacity Size of block buffer.
+ * \param written Receives number of bytes of the block.
+ * \return Status object.
+ * \see ulog_compress_bound
+ *
+ * Data which doesn't get smaller is stored as it is.
+ * Possible error codes:
+ * 1. EINVAL - invalid arguments given or data too large,
+ * 2. ENOBUFS - block buffer is smaller than ulog_compress_bound().
+ */
+ULOG_EXPORT ulog_status
+ulog_compress_block(
+    void const * const data,
+    size_t const size,
+    void * const block,
+    size_t const capacity,
+    size_t * const written
+);
+/**
+ * \brief Tells whether data begins with a compressed block.
+ * \param data Contents of a file, e.g. mapped into memory.
+ * \param size Size of data.
+ * \return True if data starts with a block header.
+ */
+ULOG_EXPORT bool
+ulog_compressed( void const * const data, size_t const size );
+/**
+ * \brief Decompresses one block.
+ * \param block Block, starting at its header.
+ * \param size Size of data available at block.
+ * \param consumed Receives size of the whole block, so that the next one
+ * starts after it.
+ * \param data Receives decompressed data.
+ * \param capacity Size of data buffer.
+ * \param written Receives number of bytes of decompressed data.
+ * \return Status object.
+ *
+ * Passing NULL data and zero capacity reads the header alone: consumed and
+ * written tell sizes of the block, for seeking, and ENOBUFS is returned.
+ * Possible error codes:
+ * 1. ENODATA - size is smaller than the whole block,
+ * 2. EINVAL - invalid arguments given or block is malformed,
+ * 3. ENOBUFS - data buffer is too small.
+ */
+ULOG_EXPORT ulog_status
+ulog_decompress_block(
+    void const * const block,
+    size_t const size,
+    size_t * const consumed,
+    void * const data,
+    size_t const capacity,
+    size_t * const written
+);
+/**
+ * \brief Decompresses all blocks of a file using many threads.
+ * \param blocks Blocks one after another, e.g. a file mapped into memory.
+ * \param size Size of blocks.
+ * \param threads Number of threads, zero for one per processor.
+ * \param data Receives decompressed data, to be freed with free().
+ * \param length Receives size of decompressed data.
+ * \return Status object.
+ *
+ * Headers are read first to tell where each block and its data begin,
+ * then threads take blocks one by one, each decompressing straight into
+ * its place of the output. The last block may be incomplete, e.g. still
+ * being written; it's left out, along with its data.
+ * Possible error codes:
+ * 1. EINVAL - invalid arguments given or a block is malformed,
+ * 2. ENOMEM - no memory for decompressed data.
+ */
+ULOG_EXPORT ulog_status
+ulog_decompress(
+    void const * const blocks,
+    size_t const size,
+    unsigned const threads,
+    void * * const data,
+    size_t * const length
+);
+/**
+ * \brief Appends data of the next block to data decompressed so far.
+ * \param blocks Blocks one after another, e.g. a file mapped into memory.
+ * \param size Size of blocks.
+ * \param offset Offset of the next block, moved past it.
+ * \param data Buffer of decompressed data, may be NULL; grown with
+ * realloc() as needed, to be freed with free().
+ * \param capacity Size of data buffer, updated when it grows.
+ * \param length Number of bytes held in data, the block's are added.
+ * \return Status object.
+ *
+ * Readers stream a file this way: they move data they still need to the
+ * start of the buffer, then append the next block, so that memory used
+ * depends on size of blocks rather than the file.
+ * Possible error codes:
+ * 1. ENODATA - no whole block is left, the last one may be still written,
+ * 2. EINVAL - invalid arguments given or block is malformed,
+ * 3. ENOMEM - no memory to grow data buffer.
+ */
+ULOG_EXPORT ulog_status
+ulog_decompress_next(
+    void const * const blocks,
+    size_t const size,
+    size_t * const offset,
+    void * * const data,
+    size_t * const capacity,
+    size_t * const length
+);
+
+# ifdef __cplusplus
+}
+# endif /* __cplusplus */
+
+#endif /* ULOG_COMPRESS_H__ */
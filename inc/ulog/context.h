@@ -0,0 +1,145 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Thread-local context attached to log records.
+ * \date        2016/05/07 10:14:52 AM
+ * \file        context.h
+ * \version     1.0
+ *
+ * Each thread has a stack of key and value pairs, e.g. request and tenant
+ * identifiers, which handlers can read for every record without them being
+ * formatted into messages. Pairs are kept in a fixed thread-local arena, so
+ * pushing and popping them only moves its top.
+ **/
+
+#ifndef ULOG_CONTEXT_H__
+# define ULOG_CONTEXT_H__
+
+# include <stddef.h> /* size_t */
+# include <stdint.h> /* uint16_t */
+# include <string.h> /* strlen */
+# include <ulog/status.h> /* ulog_status */
+# include <ulog/universal.h> /* ULOG_EXPORT */
+
+# ifdef __cplusplus
+extern "C" {
+# endif /* __cplusplus */
+
+/**
+ * \brief Maximum number of pairs in context.
+ */
+# define ULOG_CONTEXT_ENTRIES 8U
+/**
+ * \brief Size of arena holding keys and values of context.
+ */
+# define ULOG_CONTEXT_SIZE 256U
+/**
+ * \brief Definition of context type.
+ *
+ * Keys and values are stored as zero-terminated strings in data, each value
+ * right after its key. Entries refer to them by offsets, so context can be
+ * copied by copying just the used part of data.
+ */
+typedef struct
+{
+    /** Number of pairs. */
+    uint16_t count;
+    /** Bytes of data in use. */
+    uint16_t used;
+    /** Offsets of keys in data. */
+    uint16_t entry[ ULOG_CONTEXT_ENTRIES ];
+    /** Keys and values. */
+    char data[ ULOG_CONTEXT_SIZE ];
+}
+ulog_context;
+/**
+ * \brief Adds pair on top of calling thread's context.
+ * \param key Key, copied into context.
+ * \param value Value, copied into context.
+ * \return Status object.
+ * \see ulog_context_pop
+ *
+ * Possible error codes:
+ * 1. ENODATA - NULL key or value given,
+ * 2. ENOBUFS - there's no space left for the pair.
+ */
+ULOG_EXPORT ulog_status
+ulog_context_push( char const * const key, char const * const value );
+/**
+ * \brief Removes pair from top of calling thread's context.
+ * \return Status object.
+ * \see ulog_context_push
+ *
+ * Possible error codes:
+ * 1. ENOENT - context is empty.
+ */
+ULOG_EXPORT ulog_status
+ulog_context_pop( void );
+/**
+ * \brief Returns context of the record being handled.
+ * \return Context, never NULL.
+ *
+ * Called from a handler returns context of the thread which logged the
+ * record, even if the record is delivered asynchronously. Elsewhere it
+ * returns calling thread's context. The context may change after handler
+ * returns, so it must not be kept.
+ */
+ULOG_EXPORT ulog_context const *
+ulog_context_get( void );
+/**
+ * \brief Renders context as space-separated "key=value" pairs.
+ * \param context The context.
+ * \param text Receives the pairs, always zero-terminated.
+ * \param length Size of text buffer; longer output is truncated.
+ * \return Length of rendered text.
+ */
+ULOG_EXPORT size_t
+ulog_context_render(
+    ulog_context const * const context,
+    char * const text,
+    size_t const length
+);
+/**
+ * \brief Returns key of context entry.
+ * \param context The context.
+ * \param index Index of the entry, less than context's count.
+ * \return Zero-terminated key.
+ */
+static inline char const *
+ulog_context_key( ulog_context const * const context, size_t const index )
+{
+    return context->data + context->entry[ index ];
+}
+/**
+ * \brief Returns value of context entry.
+ * \param context The context.
+ * \param index Index of the entry, less than context's count.
+ * \return Zero-terminated value.
+ */
+static inline char const *
+ulog_context_value( ulog_context const * const context, size_t const index )
+{
+    char const * const key = ulog_context_key( context, index );
+    return key + strlen( key ) + 1U;
+}
+/**
+ * \brief Copies calling thread's context.
+ * \param copy Receives the context.
+ *
+ * Used by asynchronous delivery, which hands the copy to handlers with
+ * ulog_context_install().
+ */
+void
+ulog_context_capture( ulog_context * const copy );
+/**
+ * \brief Sets context returned to calling thread by ulog_context_get().
+ * \param context Context to return, NULL to return thread's own again.
+ * \return Previously installed context, NULL if it was thread's own.
+ */
+ulog_context const *
+ulog_context_install( ulog_context const * const context );
+
+# ifdef __cplusplus
+}
+# endif /* __cplusplus */
+
+#endif /* ULOG_CONTEXT_H__ */
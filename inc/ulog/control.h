@@ -0,0 +1,74 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Control of verbosity from outside of the process.
+ * \date        2016/05/21 10:12:44 AM
+ * \file        control.h
+ * \version     1.0
+ *
+ *
+ **/
+
+#ifndef ULOG_CONTROL_H__
+# define ULOG_CONTROL_H__
+
+# include <ulog/status.h> /* ulog_status */
+# include <ulog/ulog.h> /* ulog_control_config */
+# include <ulog/universal.h> /* THREADUNSAFE */
+
+# ifdef __cplusplus
+extern "C" {
+# endif /* __cplusplus */
+
+/**
+ * \brief Maximum size of control file; the rest of it is ignored.
+ */
+# define ULOG_CONTROL_SIZE 4096U
+/**
+ * \brief Definition of a function changing verbosity by number of levels.
+ * \param levels Positive to log more, negative to log less.
+ *
+ * Called from signal handlers, so it must be async-signal-safe.
+ */
+typedef void
+( * ulog_control_step_fn )( int const levels );
+/**
+ * \brief Opens control channels.
+ * \param config Channels to open.
+ * \param step Function changing verbosity on signals.
+ * \return Status object.
+ * \see ulog_obj_control_op
+ *
+ * Control file is applied through operations of ulog_obj_get(), first
+ * before this function returns, then on each change by watcher thread.
+ * Possible error codes:
+ * 1. ENOTSUP - control file given, but not supported on this platform,
+ * 2. ENOMEM - no memory for name of control file,
+ * 3. EIO - failure installing signal handlers, watching the file or
+ * starting the thread.
+ */
+THREADUNSAFE ulog_status
+ulog_control_start(
+    ulog_control_config const * const config,
+    ulog_control_step_fn const step
+);
+/**
+ * \brief Closes control channels, if open.
+ *
+ * Restores previous handlers of signals and stops watcher thread.
+ */
+THREADUNSAFE void
+ulog_control_stop( void );
+/**
+ * \brief Starts watcher thread again in the child process after fork().
+ * \return Status object.
+ * Child inherits signal handlers, but not the thread watching control file.
+ * Possible error codes: those of ulog_control_start() watching the file.
+ */
+THREADUNSAFE ulog_status
+ulog_control_restart( void );
+
+# ifdef __cplusplus
+}
+# endif /* __cplusplus */
+
+#endif /* ULOG_CONTROL_H__ */
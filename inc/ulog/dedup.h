@@ -0,0 +1,162 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Per-thread suppression of consecutive duplicate records.
+ * \date        2016/02/07 14:12:40 PM
+ * \file        dedup.h
+ * \version     1.0
+ *
+ *
+ **/
+
+#ifndef ULOG_DEDUP_H__
+# define ULOG_DEDUP_H__
+
+# include <ulog/status.h> /* ulog_status */
+# include <ulog/ulog.h> /* ulog_level */
+
+# include <stdbool.h> /* bool */
+# include <stddef.h> /* size_t */
+# include <stdint.h> /* uint64_t */
+
+# ifdef __cplusplus
+extern "C" {
+# endif /* __cplusplus */
+
+/**
+ * \brief Number of threads whose records are allocated in advance.
+ *
+ * Records are taken from a pool allocated once, when the first thread is
+ * listed, and given back when their threads exit. Threads logging while
+ * all of them are taken aren't suppressed.
+ */
+# define ULOG_DEDUP_THREADS 256U
+/**
+ * \brief Definition of record identity used by duplicate suppression.
+ *
+ * File and function are pointers to the strings given by logging macros.
+ * They are NULL for messages logged without the standard header.
+ */
+typedef struct
+{
+    /** Hash of call site, level and rendered arguments. */
+    uint64_t hash;
+    /** Time of the record, or of the last summary of its duplicates. */
+    uint64_t time;
+    /** Number of suppressed duplicates. */
+    unsigned repeated;
+    /** Log level of the record. */
+    ulog_level level;
+    /** File name of call site. */
+    char const * file;
+    /** Function name of call site. */
+    char const * function;
+    /** Line number of call site. */
+    unsigned line;
+}
+ulog_dedup_record;
+/**
+ * \brief Hashes given data, continuing from given seed.
+ * \param seed Result of previous call, or zero to start new hash.
+ * \param data Data to hash.
+ * \param size Size of data in bytes.
+ * \return Hash value.
+ */
+uint64_t
+ulog_dedup_hash( uint64_t const seed, void const * const data, size_t size );
+/**
+ * \brief Checks whether record duplicates previous record of this thread.
+ * \param record Incoming record, with hash, time and call site set.
+ * \param timeout Nanoseconds after which pending duplicates are flushed.
+ * \param flushed Receives summary of duplicates which should be reported.
+ * \return Status object.
+ * \see ulog_dedup_record
+ *
+ * Each thread holds a single ulog_dedup_record describing the last record
+ * it has seen, listed along with those of other threads so that they can
+ * be swept. If the incoming record is different, the previous one is
+ * replaced and the incoming record should be delivered. If it's the same,
+ * it's counted as repeated and shouldn't be delivered. Whenever flushed
+ * holds non-zero repeated count after the call, caller should report it
+ * before delivering the incoming record (if any).
+ * Possible status codes:
+ * 1. 0 (zero) - record is new and should be delivered;
+ * 2. EALREADY - record is a duplicate and was suppressed.
+ */
+ulog_status
+ulog_dedup_filter(
+    ulog_dedup_record const * const record,
+    uint64_t const timeout,
+    ulog_dedup_record * const flushed
+);
+/**
+ * \brief Lists the calling thread in advance.
+ * \return True if the thread is listed.
+ * \see ulog_dedup_filter
+ *
+ * Each thread is listed on its first call of ulog_dedup_filter(), unless
+ * this was called before. The first thread listed allocates records of all
+ * threads.
+ */
+bool
+ulog_dedup_prepare( void );
+/**
+ * \brief Takes pending duplicates of the calling thread and forgets them.
+ * \param flushed Receives summary of duplicates which should be reported.
+ *
+ * After this call the next record logged by the calling thread will be
+ * treated as new.
+ */
+void
+ulog_dedup_flush( ulog_dedup_record * const flushed );
+/**
+ * \brief Takes pending duplicates of all threads.
+ * \param now Current time, as of records.
+ * \param timeout Nanoseconds after which pending duplicates are taken, or
+ * zero to take all of them and forget the records, as if flushed.
+ * \param flushed Receives summaries of duplicates which should be reported.
+ * \param capacity Number of elements of flushed.
+ * \return Number of summaries taken.
+ * \see ulog_dedup_flush
+ *
+ * Duplicates of threads which have exited are taken regardless of timeout.
+ * Taken summaries aren't taken again, so the caller reports them and calls
+ * again as long as capacity was filled.
+ */
+size_t
+ulog_dedup_sweep(
+    uint64_t const now,
+    uint64_t const timeout,
+    ulog_dedup_record * const flushed,
+    size_t const capacity
+);
+/**
+ * \brief Keeps other threads from changing the list of threads.
+ * \see ulog_dedup_unlock
+ * \see ulog_dedup_reset
+ *
+ * Called before fork(), so that the child inherits a consistent list.
+ * Afterwards the parent calls ulog_dedup_unlock(), and the child calls
+ * ulog_dedup_reset(), which unlocks the list too.
+ */
+void
+ulog_dedup_lock( void );
+/**
+ * \brief Lets other threads change the list of threads again.
+ * \see ulog_dedup_lock
+ */
+void
+ulog_dedup_unlock( void );
+/**
+ * \brief Forgets records of other threads, in the child after fork().
+ * \see ulog_dedup_lock
+ *
+ * Duplicates pending in threads of the parent are reported by the parent.
+ */
+void
+ulog_dedup_reset( void );
+
+# ifdef __cplusplus
+}
+# endif /* __cplusplus */
+
+#endif /* ULOG_DEDUP_H__ */
@@ -0,0 +1,180 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Defines API for files written by each thread on its own.
+ * \date        2016/06/02 09:47:22 AM
+ * \file        files.h
+ * \version     1.0
+ *
+ *
+ **/
+
+#ifndef ULOG_FILES_H__
+# define ULOG_FILES_H__
+
+# include <ulog/status.h> /* ulog_status */
+# include <ulog/ulog.h> /* ulog_files_config, ulog_level */
+# include <ulog/universal.h> /* THREADUNSAFE */
+
+# include <stdarg.h> /* va_list */
+
+# ifdef __cplusplus
+extern "C" {
+# endif /* __cplusplus */
+
+/**
+ * \brief Forward declaration of opaque ulog_files state.
+ * \see struct ulog_files_state_struct
+ */
+typedef struct ulog_files_state_struct ulog_files_state;
+/**
+ * \brief Forward declaration of files operations table.
+ * \see struct ulog_files_op_table_struct
+ */
+typedef struct ulog_files_op_table_struct ulog_files_op_table;
+/**
+ * \brief Definition of per-thread files object.
+ * \see ulog_files_state
+ * \see ulog_files_op_table
+ * \see ulog_files_config
+ *
+ * Each thread submitting records opens its own file, named after the base
+ * and its thread ID, on its first record and renders records into a buffer
+ * of its own, written to the file whenever it fills up. Threads share no
+ * buffer, descriptor or lock while logging; the lock guarding the list of
+ * files is taken only when a thread opens or closes its file. The file is
+ * closed when its thread exits or when the object is cleaned up, with the
+ * buffer written first. If compression is configured, each thread has two
+ * buffers and hands the full one to a compressing thread, which writes it
+ * as a block; the thread waits only if its previous block isn't written
+ * yet.
+ * Sample code:
+ * ulog_files f = ulog_files_get();
+ * ulog_files_config c = { .base = "/tmp/app" };
+ * f.op->setup(&f, &c);
+ * f.op->submit(&f, INFO, format, args);
+ * f.op->cleanup(&f);
+ */
+typedef struct
+{
+    /** Object's state. */
+    ulog_files_state * state;
+    /** Table of operations. */
+    ulog_files_op_table const * op;
+}
+ulog_files;
+/**
+ * \brief Defines type of setup operation on ulog_files object.
+ * \param self The ulog_files object on which we'll operate.
+ * \param config Base of names of files and size of buffers.
+ * \return Status object.
+ * \see THREADUNSAFE
+ * \see ulog_status
+ * \see ulog_files_config
+ *
+ * No file is opened until a thread submits a record; compressing thread
+ * is started right away.
+ * Possible status codes:
+ * 1. 0 (zero) - setup successful;
+ * 2. EINVAL - invalid self or config given, or buffer to compress is
+ * larger than ULOG_COMPRESS_MAXIMUM;
+ * 3. EALREADY - self already initialized;
+ * 4. ENOMEM - cannot allocate memory for state or thread-local key;
+ * 5. EIO - cannot start compressing thread.
+ */
+typedef THREADUNSAFE ulog_status
+    ( * ulog_files_setup_op )(
+        ulog_files * const self,
+        ulog_files_config const * const config
+    );
+/**
+ * \brief Defines type of cleanup operation on ulog_files object.
+ * \param self The ulog_files object on which we'll operate.
+ * \return Status object.
+ * \see THREADUNSAFE
+ * \see ulog_status
+ *
+ * Writes buffers of all threads and closes their files, then stops the
+ * compressing thread. No thread may submit records meanwhile.
+ * Possible status codes:
+ * 1. 0 (zero) - cleanup successful;
+ * 2. EINVAL - invalid self given;
+ * 3. EALREADY - self already uninitialized.
+ */
+typedef THREADUNSAFE ulog_status
+    ( * ulog_files_ctrl_op )( ulog_files * const self );
+/**
+ * \brief Defines type of reset operation on ulog_files object.
+ * \param self The ulog_files object on which we'll operate.
+ * \return Status object.
+ * \see THREADUNSAFE
+ * \see ulog_status
+ *
+ * Meant for the child process after fork(), which inherits buffers and
+ * files of the parent's threads. They're dropped unwritten, as the parent
+ * writes them, and the child's thread opens a file of its own. Compressing
+ * thread is started again, as the child has none.
+ * Possible status codes:
+ * 1. 0 (zero) - reset successful;
+ * 2. EINVAL - invalid or uninitialized self given;
+ * 3. EIO - cannot start compressing thread, buffers are dropped instead.
+ */
+typedef THREADUNSAFE ulog_status
+    ( * ulog_files_reset_op )( ulog_files * const self );
+/**
+ * \brief Defines type of submit() operation on ulog_files object.
+ * \param self The ulog_files object on which we'll operate.
+ * \param level Log level.
+ * \param signature Types of arguments, terminated with ULOG_ARG_END, NULL
+ * if unknown.
+ * \param format Formatting string, as in printf.
+ * \param args Arguments for the format string, as in vprintf.
+ * \return Status object.
+ * \see ulog_status
+ *
+ * Renders the record into buffer of the calling thread, opening its file
+ * first if needed. Records longer than ULOG_RECORD_SIZE - 1 bytes are
+ * truncated. Interned files take the record encoded as for binary handlers
+ * instead, from the rendered text if its signature is unknown.
+ * Possible status codes:
+ * 1. 0 (zero) - record buffered;
+ * 2. EINVAL - invalid or uninitialized self given;
+ * 3. ENOMEM - cannot allocate buffer of the thread;
+ * 4. EIO - cannot open the file or write buffer into it, record lost;
+ * failure to write a compressed block is reported by the next submit()
+ * handing off a buffer.
+ */
+typedef ulog_status
+    ( * ulog_files_submit_op )(
+        ulog_files const * const self,
+        ulog_level const level,
+        unsigned char const * const signature,
+        char const * const format,
+        va_list args
+    );
+/**
+ * \brief Definition of files operations table.
+ */
+struct ulog_files_op_table_struct
+{
+    /** Prepares for threads to open their files. */
+    ulog_files_setup_op setup;
+    /** Writes buffers and closes files of all threads. */
+    ulog_files_ctrl_op cleanup;
+    /** Buffers a record in file of the calling thread. */
+    ulog_files_submit_op submit;
+    /** Drops files of the parent in the child process after fork(). */
+    ulog_files_reset_op reset;
+};
+/**
+ * \brief Creates files object in default state.
+ * \return Files object.
+ * \see ulog_files
+ */
+ulog_files
+ulog_files_get( void );
+
+# ifdef __cplusplus
+}
+# endif /* __cplusplus */
+
+#endif /* ULOG_FILES_H__ */
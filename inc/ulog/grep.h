@@ -0,0 +1,91 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Parallel search of logged records.
+ * \date        2016/05/30 09:12:51 AM
+ * \file        grep.h
+ * \version     1.0
+ *
+ * Files are mapped into memory and split into chunks searched by several
+ * threads at once, each with memmem() and memchr(), which libraries
+ * implement with vector instructions. Matches are written in file order.
+ **/
+
+#ifndef ULOG_GREP_H__
+# define ULOG_GREP_H__
+
+# include <stddef.h> /* size_t */
+# include <stdint.h> /* uint64_t */
+# include <stdio.h> /* FILE */
+# include <ulog/status.h> /* ulog_status */
+# include <ulog/universal.h> /* ULOG_EXPORT */
+
+# ifdef __cplusplus
+extern "C" {
+# endif /* __cplusplus */
+
+/**
+ * \brief Default number of bytes searched by a thread at once.
+ */
+# define ULOG_GREP_CHUNK ( 64U * 1024U * 1024U )
+/**
+ * \brief Definition of search criteria.
+ * \see ulog_grep
+ *
+ * Records match if they contain the pattern, have one of the levels and
+ * were logged within the time range; zero members don't restrict.
+ */
+typedef struct
+{
+    /** Substring searched for, NULL or empty to match any record. */
+    char const * pattern;
+    /** Characters of levels kept, e.g. "EW", NULL to keep all of them. */
+    char const * levels;
+    /** Earliest time of record, in nanoseconds. */
+    uint64_t since;
+    /** Latest time of record, in nanoseconds, zero for no limit. */
+    uint64_t until;
+    /** Number of searching threads, zero for one per processor. */
+    unsigned threads;
+    /** Bytes searched by a thread at once, zero for ULOG_GREP_CHUNK. */
+    size_t chunk;
+}
+ulog_grep_config;
+/**
+ * \brief Writes records of a file which match criteria.
+ * \param path File with records, as written by a handler.
+ * \param config Search criteria.
+ * \param output Receives matching records.
+ * \param matched Receives number of matching records, may be NULL.
+ * \return Status object.
+ * \see ulog_grep_config
+ *
+ * Text records are lines beginning with the standard header, whose level
+ * and time are used by filters; lines without it match only if neither
+ * levels nor time are restricted. Files beginning with a marker of
+ * interned stream are decoded, record by record, into such lines, which
+ * are matched and written instead; each thread decodes its chunk on its
+ * own, as chunks are split where decoding may start again, e.g. at
+ * checkpoints. Memory used doesn't depend on size of the file: blocks of a
+ * compressed one are decompressed one at a time into a window, searched
+ * once it holds a chunk for each thread. An incomplete last block, e.g.
+ * one still being written, ends the file, as does an incomplete last
+ * interned record.
+ * Possible error codes:
+ * 1. ENODATA - NULL path, config or output given,
+ * 2. ENOMEM - no memory for matches or window of blocks,
+ * 3. EIO - failure reading file, starting thread or writing output,
+ * 4. EINVAL - interned record or compressed block is malformed.
+ */
+ULOG_EXPORT ulog_status
+ulog_grep(
+    char const * const path,
+    ulog_grep_config const * const config,
+    FILE * const output,
+    uint64_t * const matched
+);
+
+# ifdef __cplusplus
+}
+# endif /* __cplusplus */
+
+#endif /* ULOG_GREP_H__ */
@@ -0,0 +1,218 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Interning of strings repeated by binary records.
+ * \date        2016/06/03 09:18:44 AM
+ * \file        intern.h
+ * \version     1.0
+ *
+ * Format, file name and function name of a record come from the same few
+ * static strings over and over. Interned streams carry each of them once,
+ * as a definition of a small integer ID, and only the ID in each record,
+ * which also makes records readable outside of the logging process.
+ * Time of such records is stored as varint difference from the previous
+ * one, or in whole by checkpoints. Checkpoints come every
+ * ULOG_INTERN_CHECKPOINT records, and with the first record with time after
+ * one without it; they define the strings they use again, as do records
+ * after them, so that reading may start at any checkpoint. Streams written
+ * to files begin with a marker, by which readers tell them from text.
+ **/
+
+#ifndef ULOG_INTERN_H__
+# define ULOG_INTERN_H__
+
+# include <stdbool.h> /* bool */
+# include <stddef.h> /* size_t */
+# include <stdint.h> /* uint8_t, uint32_t, uint64_t */
+# include <ulog/status.h> /* ulog_status */
+# include <ulog/ulog.h> /* ULOG_RECORD_SIZE */
+# include <ulog/universal.h> /* ULOG_EXPORT */
+
+# ifdef __cplusplus
+extern "C" {
+# endif /* __cplusplus */
+
+/**
+ * \brief Number of distinct strings which can be interned by a process.
+ *
+ * Strings seen after that are written in full by each record.
+ */
+# define ULOG_INTERN_CAPACITY 4096U
+/**
+ * \brief Size of buffer sufficient for an encoded record.
+ * \see ulog_intern_encode
+ *
+ * Holds any record given to binary handlers whose format is shorter than
+ * ULOG_RECORD_SIZE, along with definitions it needs.
+ */
+# define ULOG_INTERN_BUFFER ( 4U * ULOG_RECORD_SIZE )
+/**
+ * \brief Number of records between checkpoints of a stream.
+ * \see ulog_intern_encode
+ *
+ * The first record of a stream is a checkpoint as well.
+ */
+# define ULOG_INTERN_CHECKPOINT 256U
+/**
+ * \brief State of an interned stream on the writing side.
+ * \see ulog_intern_encode
+ *
+ * Remembers which IDs the stream has defined since the last checkpoint.
+ * Zeroed state begins a new stream, e.g. a new file.
+ */
+typedef struct
+{
+    /** Bit of each ID defined in the stream. */
+    uint8_t defined[ ULOG_INTERN_CAPACITY / 8U ];
+    /** Time of the last record. */
+    uint64_t time;
+    /** Number of records since the last checkpoint. */
+    uint32_t since;
+    /** Whether the last checkpoint had time. */
+    bool timed;
+}
+ulog_intern_stream;
+/**
+ * \brief Strings defined by an interned stream on the reading side.
+ * \see ulog_intern_decode
+ *
+ * Zeroed dictionary begins reading a new stream; it must be released with
+ * ulog_intern_release() afterwards.
+ */
+typedef struct
+{
+    /** Text of each ID, NULL if not defined. */
+    char * * text;
+    /** Number of elements of text. */
+    size_t count;
+    /** Time of the last record. */
+    uint64_t time;
+    /** Whether the stream gave whole time already. */
+    bool timed;
+}
+ulog_intern_dictionary;
+/**
+ * \brief Begins new interned stream, e.g. in a file.
+ * \param stream State of the stream, reset to define all strings again.
+ * \param buffer Receives marker of the stream start.
+ * \param capacity Size of the buffer.
+ * \param written Receives number of bytes of the buffer to be written.
+ * \return Status object.
+ * \see ulog_interned
+ *
+ * Reader of the stream forgets strings defined before the marker, so that
+ * streams appended to the same file are decoded each on its own.
+ * Possible error codes:
+ * 1. EINVAL - invalid arguments given,
+ * 2. ENOBUFS - buffer is too small, stream is unchanged.
+ */
+ULOG_EXPORT ulog_status
+ulog_intern_begin(
+    ulog_intern_stream * const stream,
+    void * const buffer,
+    size_t const capacity,
+    size_t * const written
+);
+/**
+ * \brief Encodes binary record into interned stream.
+ * \param stream State of the stream.
+ * \param record Record, as given to a binary handler.
+ * \param size Size of the record.
+ * \param buffer Receives the encoded record, preceded by definitions of
+ * strings it uses for the first time in the stream.
+ * \param capacity Size of the buffer.
+ * \param written Receives number of bytes of the buffer to be written.
+ * \return Status object.
+ * \see ulog_binary_header
+ *
+ * Format is interned, as are file and function name of records logged by
+ * the wrapper macros; other strings are written in full. Time of records
+ * logged by the wrapper macros is stored as difference from the previous
+ * one, which may be negative, and in whole at checkpoints. The same string
+ * has the same ID in all streams of the process, for as long as it lives.
+ * Bytes written to the stream must stay in order of encoding, so a stream
+ * must be used by one thread at a time, e.g. under lock of its sink or by
+ * the thread owning it.
+ * Possible error codes:
+ * 1. EINVAL - invalid arguments given or record is malformed,
+ * 2. ENOBUFS - buffer is too small, stream is unchanged.
+ */
+ULOG_EXPORT ulog_status
+ulog_intern_encode(
+    ulog_intern_stream * const stream,
+    void const * const record,
+    size_t const size,
+    void * const buffer,
+    size_t const capacity,
+    size_t * const written
+);
+/**
+ * \brief Decodes next record of interned stream into text.
+ * \param dictionary Strings defined by the stream so far.
+ * \param data Stream, starting at an entry.
+ * \param size Size of data.
+ * \param consumed Receives number of bytes of data decoded.
+ * \param text Receives the message, always zero-terminated.
+ * \param length Size of text buffer; longer messages are truncated.
+ * \return Status object.
+ * \see ulog_binary_decode
+ *
+ * Definitions preceding the record are added to dictionary, marker of
+ * stream start empties it. The result is the same as rendering the message
+ * with printf.
+ * Possible error codes:
+ * 1. ENODATA - data ends before a whole record, consumed tells how many
+ * bytes of definitions and markers were decoded,
+ * 2. ENOMEM - no memory for definition,
+ * 3. EINVAL - invalid arguments given, stream is malformed, uses ID it
+ * didn't define or gives difference of time before its whole value,
+ * 4. ENOTSUP - as with ulog_binary_decode().
+ */
+ULOG_EXPORT ulog_status
+ulog_intern_decode(
+    ulog_intern_dictionary * const dictionary,
+    void const * const data,
+    size_t const size,
+    size_t * const consumed,
+    char * const text,
+    size_t const length
+);
+/**
+ * \brief Tells whether data begins with a marker of interned stream.
+ * \param data Contents of a file, e.g. mapped into memory.
+ * \param size Size of data.
+ * \return True if data starts with the marker.
+ * \see ulog_intern_begin
+ */
+ULOG_EXPORT bool
+ulog_interned( void const * const data, size_t const size );
+/**
+ * \brief Finds next place where decoding of interned stream may start.
+ * \param data Stream, starting at an entry.
+ * \param size Size of data.
+ * \param from Offset of an entry within data, e.g. one returned before.
+ * \return Offset of the first such place after from, size if there's none
+ * in whole entries of data.
+ * \see ulog_intern_decode
+ *
+ * Decoding may start with an empty dictionary at a marker of stream start
+ * or at definitions preceding a checkpoint, so parts of a stream split
+ * there can be decoded independently, e.g. by many threads.
+ */
+ULOG_EXPORT size_t
+ulog_intern_restart(
+    void const * const data,
+    size_t const size,
+    size_t const from
+);
+/**
+ * \brief Frees strings of dictionary and empties it.
+ * \param dictionary Dictionary filled by ulog_intern_decode().
+ */
+ULOG_EXPORT void
+ulog_intern_release( ulog_intern_dictionary * const dictionary );
+
+# ifdef __cplusplus
+}
+# endif /* __cplusplus */
+
+#endif /* ULOG_INTERN_H__ */
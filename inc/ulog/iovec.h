@@ -0,0 +1,68 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Rendering of log records into scattered pieces.
+ * \date        2016/04/09 10:12:55 AM
+ * \file        iovec.h
+ * \version     1.0
+ *
+ *
+ **/
+
+#ifndef ULOG_IOVEC_H__
+# define ULOG_IOVEC_H__
+
+# include <stdarg.h> /* va_list */
+# include <stddef.h> /* size_t */
+# include <sys/uio.h> /* struct iovec */
+
+# ifdef __cplusplus
+extern "C" {
+# endif /* __cplusplus */
+
+/**
+ * \brief Maximum number of pieces of a rendered record.
+ */
+# define ULOG_IOVEC_PIECES 6U
+/**
+ * \brief Definition of a record rendered into pieces.
+ *
+ * A record logged with the standard header is split into: level and time,
+ * file name, separator, function name, line and the body. File and function
+ * names point at strings given by logging macros and separator points at
+ * a constant, so only level, time, line and body are rendered. Records
+ * without the standard header consist of the body only.
+ */
+typedef struct
+{
+    /** Pieces to be written in order. */
+    struct iovec piece[ ULOG_IOVEC_PIECES ];
+    /** Number of pieces in use. */
+    int count;
+    /** Rendered "[level][time][". */
+    char prefix[ 32U ];
+    /** Rendered ":line] ". */
+    char suffix[ 16U ];
+}
+ulog_iovec_record;
+/**
+ * \brief Renders record into pieces.
+ * \param record Receives the pieces.
+ * \param body Buffer for rendered body.
+ * \param size Size of body buffer; longer bodies are truncated.
+ * \param format Formatting string, as given to ulog_().
+ * \param args Arguments for the format string.
+ */
+void
+ulog_iovec_render(
+    ulog_iovec_record * const record,
+    char * const body,
+    size_t const size,
+    char const * const format,
+    va_list args
+);
+
+# ifdef __cplusplus
+}
+# endif /* __cplusplus */
+
+#endif /* ULOG_IOVEC_H__ */
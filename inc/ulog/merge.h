@@ -0,0 +1,65 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Merge of logged records by time.
+ * \date        2016/06/01 09:31:15 AM
+ * \file        merge.h
+ * \version     1.0
+ *
+ * Threads or processes may log into files of their own, so that they never
+ * contend for a buffer or descriptor; ulog_merge() reads them back as one
+ * stream ordered by time of records.
+ **/
+
+#ifndef ULOG_MERGE_H__
+# define ULOG_MERGE_H__
+
+# include <stddef.h> /* size_t */
+# include <stdint.h> /* uint64_t */
+# include <stdio.h> /* FILE */
+# include <ulog/status.h> /* ulog_status */
+# include <ulog/universal.h> /* ULOG_EXPORT */
+
+# ifdef __cplusplus
+extern "C" {
+# endif /* __cplusplus */
+
+/**
+ * \brief Writes records of many files ordered by their time.
+ * \param paths Files with records, as written by handlers.
+ * \param count Number of files.
+ * \param output Receives merged records.
+ * \param merged Receives number of records written, may be NULL.
+ * \return Status object.
+ *
+ * Records are lines beginning with the standard header; lines without it
+ * belong to the record before them, or precede all records if they start
+ * the file. Each file is expected to be ordered already, as it's read
+ * once, from start to end: the files are mapped into memory and the record
+ * with the earliest time among their current ones is written next, taken
+ * from a heap. Records of the same time are written in order of files
+ * given, so merging is stable. Memory used doesn't depend on size of the
+ * files: blocks of compressed ones are decompressed one at a time, into a
+ * window which keeps the current record. An incomplete last block, e.g.
+ * one still being written, ends its file. Files beginning with a marker of
+ * interned stream are decoded, record by record, into lines, which are
+ * written instead; records without the standard header among them keep
+ * time of the record before.
+ * Possible error codes:
+ * 1. ENODATA - NULL paths or output given,
+ * 2. ENOMEM - no memory for state of files or window of blocks,
+ * 3. EIO - failure reading file or writing output,
+ * 4. EINVAL - compressed block or interned record is malformed.
+ */
+ULOG_EXPORT ulog_status
+ulog_merge(
+    char const * const * const paths,
+    size_t const count,
+    FILE * const output,
+    uint64_t * const merged
+);
+
+# ifdef __cplusplus
+}
+# endif /* __cplusplus */
+
+#endif /* ULOG_MERGE_H__ */
@@ -12,13 +12,69 @@
 #ifndef ULOG_MUTEX_H__
 # define ULOG_MUTEX_H__
 
-# include <ulog/status.h> /* ulog_status */
-# include <ulog/universal.h> /* THREADUNSAFE */
+# include <stdbool.h> /* bool */
+# include <stddef.h> /* NULL */
+# include <stdint.h> /* uint32_t, uint64_t */
+# include <ulog/queue.h> /* ULOG_CACHE_LINE */
+# include <ulog/status.h> /* ulog_status, ulog_status_success */
+# include <ulog/universal.h> /* THREADLOCAL, THREADUNSAFE, UNUSED */
 
 # ifdef __cplusplus
 extern "C" {
 # endif /* __cplusplus */
 
+/**
+ * \brief Number of reader slots of adaptive mutex.
+ * \see ulog_mutex_get_adaptive
+ *
+ * Readers are spread among slots, each on a separate cache line, so that
+ * concurrent shared locking doesn't bounce a single counter between CPUs.
+ */
+# define ULOG_MUTEX_READER_SLOTS 16U
+/**
+ * \brief Value of unlocked adaptive mutex word.
+ * \see ulog_mutex_fast
+ */
+# define ULOG_MUTEX_UNLOCKED 0U
+/**
+ * \brief Value of adaptive mutex word locked without waiters.
+ * \see ulog_mutex_fast
+ */
+# define ULOG_MUTEX_LOCKED 1U
+/**
+ * \brief Leading members of every mutex state, used by inline fast paths.
+ * \see ulog_mutex_lock
+ * \see ulog_mutex_unlock
+ * \see ulog_mutex_lock_shared
+ * \see ulog_mutex_unlock_shared
+ *
+ * The word is the lock of adaptive mutex. Other mutexes, and adaptive ones
+ * not set up, keep a value there which fast paths never match, so they
+ * fall back to the operations table. The shared flag is raised for good
+ * the first time an adaptive mutex is locked shared, from then on the
+ * exclusive lock has to wait for readers and takes the slow path too.
+ * Readers count themselves in slots, a cache line apart, starting at
+ * readers; only adaptive mutex which is set up has them.
+ */
+typedef struct
+{
+    /** Lock word of adaptive mutex. */
+    uint32_t word;
+    /** Nonzero once the mutex was locked shared. */
+    uint32_t shared;
+    /** Nonzero while exclusive lock keeps readers out. */
+    uint32_t writer;
+    /** Counter of the first reader slot, or NULL. */
+    uint32_t * readers;
+}
+ulog_mutex_fast;
+/**
+ * \brief Reader slot of the calling thread, plus one; zero until assigned.
+ * \see ulog_mutex_lock_shared
+ *
+ * Assigned round robin by the first shared lock() the thread makes.
+ */
+extern THREADLOCAL unsigned ulog_mutex_reader_;
 /**
  * \brief Forward declaration of opaque ulog_mutex state.
  * \see struct ulog_mutex_state_struct
@@ -108,7 +164,10 @@ typedef struct
  * is holding the mutex). In case mutex is held by another thread,
  * the cleanup() operation will block until the mutex is free. No
  * other threads can be waiting on the mutex after the cleanup()
- * operation returns.
+ * operation returns. The reset() operation is meant for the child
+ * process after fork(), where threads which held or waited on the
+ * mutex don't exist: it makes the mutex unlocked, as if it was set
+ * up again, without waiting for anyone.
  * Possible status codes:
  * 1. setup:
  *    a. 0 (zero) - setup successful;
@@ -121,6 +180,10 @@ typedef struct
  *    b. EINVAL - invalid self given;
  *    c. EALREADY - self already uninitialized;
  *    d. EIO - failure cleaning up the underlying mutex mechanism;
+ * 3. reset:
+ *    a. 0 (zero) - reset successful;
+ *    b. EINVAL - invalid or uninitialized self given;
+ *    c. EIO - failure setting up the underlying mutex mechanism;
  * In all cases status description may be checked for further
  * information.
  */
@@ -135,8 +198,11 @@ typedef THREADUNSAFE ulog_status
  *
  * Recursively locking the mutex is undefined behaviour. Unlocking
  * mutex that is not locked or is held by another thread is also
- * undefined behaviour.
- * Possible status codes:
+ * undefined behaviour. Mutex locked with lock_shared() must be
+ * unlocked with unlock_shared() by the same thread. Any number of
+ * threads may hold the mutex shared at once, but none while it's
+ * held by lock(). Plain mutex treats shared locking as exclusive.
+ * Possible status codes (same for shared variants):
  * 1. lock:
  *    a. 0 (zero) - mutex locked successfully
  *    b. EINVAL - invalid or uninitialized self given;
@@ -165,6 +231,12 @@ struct ulog_mutex_op_table_struct
     ulog_mutex_op lock;
     /** Mutex unlocking operation. */
     ulog_mutex_op unlock;
+    /** Mutex locking operation for reading. */
+    ulog_mutex_op lock_shared;
+    /** Mutex unlocking operation for reading. */
+    ulog_mutex_op unlock_shared;
+    /** Mutex reinitialization in the child process after fork(). */
+    ulog_mutex_ctrl_op reset;
 };
 /**
  * \brief Creates mutex object in default state.
@@ -173,6 +245,189 @@ struct ulog_mutex_op_table_struct
  */
 ulog_mutex
 ulog_mutex_get( void );
+/**
+ * \brief Creates adaptive mutex object in default state.
+ * \return Mutex object.
+ * \see ulog_mutex
+ *
+ * The returned object has the same operations and life cycle as the one
+ * returned by ulog_mutex_get(), but uses a different locking mechanism.
+ * Uncontended lock() and unlock() are a single atomic instruction each,
+ * as long as the mutex was never locked shared; ulog_mutex_lock() and
+ * ulog_mutex_unlock() inline them, skipping the operations table.
+ * Contended lock() first spins, for a number of iterations adapted to how
+ * long the mutex was held recently, and only then parks the thread on
+ * a futex (on systems other than Linux it sleeps briefly instead).
+ * Shared locking is scalable: readers announce themselves in one of
+ * ULOG_MUTEX_READER_SLOTS slots and don't write to any common memory.
+ * Unless a writer is in, ulog_mutex_lock_shared() and
+ * ulog_mutex_unlock_shared() inline it as a single atomic instruction.
+ * Once the mutex was locked shared, exclusive lock() becomes more
+ * expensive instead, as it has to wait for all readers to leave. Threads
+ * are woken up by unlock() only if some of them are parked.
+ * It's preferable when critical sections are short, as in ulog framework.
+ * Objects returned by both functions must not be mixed, i.e. operations
+ * of one cannot be applied to the other.
+ */
+ulog_mutex
+ulog_mutex_get_adaptive( void );
+/**
+ * \brief Parks calling thread while word holds given value.
+ * \param word The word to wait on, must not be NULL.
+ * \param value Value of the word the thread parks on.
+ * \param nanoseconds Longest time to park, UINT64_MAX for no limit.
+ * \param shared True if the word lies in memory shared by processes.
+ * \see ulog_mutex_unpark_
+ *
+ * Used by adaptive mutex and by the threads of ulog framework which wait
+ * for each other. It returns at once if the word doesn't hold the value,
+ * and may return spuriously, so callers check their condition in a loop.
+ * Systems other than Linux have no futex, there the thread sleeps for
+ * a short while instead.
+ */
+void
+ulog_mutex_park_(
+    uint32_t * const word,
+    uint32_t const value,
+    uint64_t const nanoseconds,
+    bool const shared
+);
+/**
+ * \brief Wakes threads parked on word.
+ * \param word The word threads park on, must not be NULL.
+ * \param count Most threads to wake up.
+ * \param shared True if the word lies in memory shared by processes.
+ * \see ulog_mutex_park_
+ */
+void
+ulog_mutex_unpark_( uint32_t * const word, int const count, bool const shared );
+/**
+ * \brief Locks mutex exclusively, inlining the uncontended path.
+ * \param self The mutex object, must not be NULL.
+ * \return True if locked, false if lock() of the mutex failed.
+ * \see ulog_mutex_fast
+ *
+ * Uncontended adaptive mutex which was never locked shared is locked with
+ * a single compare-and-swap, without calling anything. Otherwise lock()
+ * from the operations table of the mutex is called.
+ */
+static inline bool
+ulog_mutex_lock( ulog_mutex const * const self )
+{
+    /* state of any mutex starts with ulog_mutex_fast */
+    ulog_mutex_fast * const fast = ( ulog_mutex_fast * ) self->state;
+    uint32_t expected = ULOG_MUTEX_UNLOCKED;
+    if(
+        __atomic_compare_exchange_n(
+            &( fast->word ),
+            &expected,
+            ULOG_MUTEX_LOCKED,
+            false,
+            __ATOMIC_ACQUIRE,
+            __ATOMIC_RELAXED
+        )
+    )
+    {
+        /* the flag is raised only under the lock, so it's stable now */
+        if( 0U == __atomic_load_n( &( fast->shared ), __ATOMIC_RELAXED ))
+        {
+            return true;
+        }
+        /* rare: first reader came between, unlock to wait for readers */
+        if( !ulog_status_success( self->op->unlock( self ))) { return false; }
+    }
+    return ulog_status_success( self->op->lock( self ));
+}
+/**
+ * \brief Unlocks mutex locked exclusively, inlining the uncontended path.
+ * \param self The mutex object, must not be NULL.
+ * \return True if unlocked, false if unlock() of the mutex failed.
+ * \see ulog_mutex_lock
+ *
+ * Adaptive mutex without waiters, which was never locked shared, is
+ * unlocked with a single compare-and-swap. Otherwise unlock() from the
+ * operations table of the mutex is called, e.g. to wake a waiter up.
+ */
+static inline bool
+ulog_mutex_unlock( ulog_mutex const * const self )
+{
+    ulog_mutex_fast * const fast = ( ulog_mutex_fast * ) self->state;
+    uint32_t expected = ULOG_MUTEX_LOCKED;
+    if(
+        ( 0U == __atomic_load_n( &( fast->shared ), __ATOMIC_RELAXED ))
+        && __atomic_compare_exchange_n(
+            &( fast->word ),
+            &expected,
+            ULOG_MUTEX_UNLOCKED,
+            false,
+            __ATOMIC_RELEASE,
+            __ATOMIC_RELAXED
+        )
+    )
+    {
+        return true;
+    }
+    return ulog_status_success( self->op->unlock( self ));
+}
+
+/**
+ * \brief Locks mutex shared, inlining the path without writers.
+ * \param self The mutex object, must not be NULL.
+ * \return True if locked, false if lock_shared() of the mutex failed.
+ * \see ulog_mutex_fast
+ *
+ * Adaptive mutex, once locked shared by the calling thread before, is
+ * locked by counting the thread in its reader slot, if no writer holds or
+ * waits for the mutex. Otherwise lock_shared() from the operations table
+ * of the mutex is called, e.g. to park until the writer is done.
+ */
+static inline bool
+ulog_mutex_lock_shared( ulog_mutex const * const self )
+{
+    ulog_mutex_fast * const fast = ( ulog_mutex_fast * ) self->state;
+    unsigned const reader = ulog_mutex_reader_;
+    if(
+        ( NULL != fast->readers ) && ( 0U != reader )
+        && ( 0U != __atomic_load_n( &( fast->shared ), __ATOMIC_ACQUIRE ))
+    )
+    {
+        uint32_t * const count =
+            fast->readers
+            + ( reader - 1U ) * ( ULOG_CACHE_LINE / sizeof( uint32_t ));
+        /* pairs with writer raising its flag before checking the slots */
+        UNUSED( __atomic_fetch_add( count, 1U, __ATOMIC_SEQ_CST ));
+        if( 0U == __atomic_load_n( &( fast->writer ), __ATOMIC_SEQ_CST ))
+        {
+            return true;
+        }
+        UNUSED( __atomic_fetch_sub( count, 1U, __ATOMIC_RELEASE ));
+    }
+    return ulog_status_success( self->op->lock_shared( self ));
+}
+/**
+ * \brief Unlocks mutex locked shared, inlining the path of adaptive mutex.
+ * \param self The mutex object, must not be NULL.
+ * \return True if unlocked, false if unlock_shared() of the mutex failed.
+ * \see ulog_mutex_lock_shared
+ *
+ * Reader of adaptive mutex leaves its slot with a single atomic
+ * instruction. Other mutexes call unlock_shared() from operations table.
+ */
+static inline bool
+ulog_mutex_unlock_shared( ulog_mutex const * const self )
+{
+    ulog_mutex_fast * const fast = ( ulog_mutex_fast * ) self->state;
+    unsigned const reader = ulog_mutex_reader_;
+    if(( NULL != fast->readers ) && ( 0U != reader ))
+    {
+        uint32_t * const count =
+            fast->readers
+            + ( reader - 1U ) * ( ULOG_CACHE_LINE / sizeof( uint32_t ));
+        UNUSED( __atomic_fetch_sub( count, 1U, __ATOMIC_RELEASE ));
+        return true;
+    }
+    return ulog_status_success( self->op->unlock_shared( self ));
+}
 
 # ifdef __cplusplus
 }
@@ -0,0 +1,162 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Defines API for fixed-size block pool.
+ * \date        2016/02/27 09:52:18 AM
+ * \file        pool.h
+ * \version     1.0
+ *
+ *
+ **/
+
+#ifndef ULOG_POOL_H__
+# define ULOG_POOL_H__
+
+# include <ulog/status.h> /* ulog_status */
+# include <ulog/universal.h> /* THREADUNSAFE */
+
+# include <stddef.h> /* size_t */
+
+# ifdef __cplusplus
+extern "C" {
+# endif /* __cplusplus */
+
+/**
+ * \brief Alignment of blocks given out by the pool.
+ */
+# define ULOG_POOL_ALIGNMENT 16U
+/**
+ * \brief Forward declaration of opaque ulog_pool state.
+ * \see struct ulog_pool_state_struct
+ */
+typedef struct ulog_pool_state_struct ulog_pool_state;
+/**
+ * \brief Forward declaration of pool operations table.
+ * \see struct ulog_pool_op_table_struct
+ */
+typedef struct ulog_pool_op_table_struct ulog_pool_op_table;
+/**
+ * \brief Definition of pool object.
+ * \see ulog_pool_state
+ * \see ulog_pool_op_table
+ *
+ * The pool allocates a single arena for a fixed number of equally sized
+ * blocks in setup(). Afterwards acquire() and release() hand the blocks
+ * out and take them back without calling malloc() or free() and without
+ * taking locks, so they're safe and cheap to use on logging hot path from
+ * any number of threads. The life cycle is the same as of ulog_mutex.
+ * Sample code:
+ * void * block;
+ * ulog_pool p = ulog_pool_get();
+ * p.op->setup(&p, sizeof(foo), 16U);
+ * p.op->acquire(&p, &block);
+ * p.op->release(&p, block);
+ * p.op->cleanup(&p);
+ */
+typedef struct
+{
+    /** Object's state. */
+    ulog_pool_state * state;
+    /** Table of operations. */
+    ulog_pool_op_table const * op;
+}
+ulog_pool;
+/**
+ * \brief Defines type of setup operation on ulog_pool object.
+ * \param self The ulog_pool object on which we'll operate.
+ * \param size Size of each block in bytes.
+ * \param count Number of blocks.
+ * \return Status object.
+ * \see THREADUNSAFE
+ * \see ulog_status
+ *
+ * Possible status codes:
+ * 1. 0 (zero) - setup successful;
+ * 2. EINVAL - invalid self, zero size or zero count given;
+ * 3. EALREADY - self already initialized;
+ * 4. ENOMEM - cannot allocate memory for the arena.
+ */
+typedef THREADUNSAFE ulog_status
+    ( * ulog_pool_setup_op )(
+        ulog_pool * const self,
+        size_t const size,
+        size_t const count
+    );
+/**
+ * \brief Defines type of cleanup operation on ulog_pool object.
+ * \param self The ulog_pool object on which we'll operate.
+ * \return Status object.
+ * \see THREADUNSAFE
+ * \see ulog_status
+ *
+ * Frees the arena; blocks still acquired become invalid.
+ * Possible status codes:
+ * 1. 0 (zero) - cleanup successful;
+ * 2. EINVAL - invalid self given;
+ * 3. EALREADY - self already uninitialized.
+ */
+typedef THREADUNSAFE ulog_status
+    ( * ulog_pool_ctrl_op )( ulog_pool * const self );
+/**
+ * \brief Defines type of acquire() operation on ulog_pool object.
+ * \param self The ulog_pool object on which we'll operate.
+ * \param block Receives pointer to a free block.
+ * \return Status object.
+ * \see ulog_status
+ *
+ * Contents of acquired block are unspecified.
+ * Possible status codes:
+ * 1. 0 (zero) - block acquired;
+ * 2. EINVAL - invalid or uninitialized self given;
+ * 3. ENODATA - invalid pointer to block given;
+ * 4. ENOMEM - all blocks are in use.
+ */
+typedef ulog_status
+    ( * ulog_pool_acquire_op )(
+        ulog_pool const * const self,
+        void * * const block
+    );
+/**
+ * \brief Defines type of release() operation on ulog_pool object.
+ * \param self The ulog_pool object on which we'll operate.
+ * \param block Block previously acquired from this pool.
+ * \return Status object.
+ * \see ulog_status
+ *
+ * Releasing a block twice is undefined behaviour.
+ * Possible status codes:
+ * 1. 0 (zero) - block released;
+ * 2. EINVAL - invalid or uninitialized self given;
+ * 3. ENODATA - block doesn't belong to this pool.
+ */
+typedef ulog_status
+    ( * ulog_pool_release_op )(
+        ulog_pool const * const self,
+        void * const block
+    );
+/**
+ * \brief Definition of pool operations table.
+ */
+struct ulog_pool_op_table_struct
+{
+    /** Allocates the arena. */
+    ulog_pool_setup_op setup;
+    /** Frees the arena. */
+    ulog_pool_ctrl_op cleanup;
+    /** Takes a free block. */
+    ulog_pool_acquire_op acquire;
+    /** Gives the block back. */
+    ulog_pool_release_op release;
+};
+/**
+ * \brief Creates pool object in default state.
+ * \return Pool object.
+ * \see ulog_pool
+ */
+ulog_pool
+ulog_pool_get( void );
+
+# ifdef __cplusplus
+}
+# endif /* __cplusplus */
+
+#endif /* ULOG_POOL_H__ */
@@ -0,0 +1,230 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Defines API for bounded lock-free queue.
+ * \date        2016/02/13 11:20:45 AM
+ * \file        queue.h
+ * \version     1.0
+ *
+ *
+ **/
+
+#ifndef ULOG_QUEUE_H__
+# define ULOG_QUEUE_H__
+
+# include <ulog/status.h> /* ulog_status */
+# include <ulog/universal.h> /* THREADUNSAFE */
+
+# include <stddef.h> /* offsetof, size_t */
+# include <stdint.h> /* uint8_t, uint64_t */
+
+# ifdef __cplusplus
+extern "C" {
+# endif /* __cplusplus */
+
+/**
+ * \brief Size of cache line assumed by lock-free structures.
+ *
+ * Data written by different threads is kept at least this many bytes
+ * apart to avoid false sharing.
+ */
+# define ULOG_CACHE_LINE 64U
+/**
+ * \brief Gets container of queueable element.
+ * \param QUEUEABLE Pointer to queueable element.
+ * \param TYPE Type of container, must contain queueable element.
+ * \param MEMBER Name of the queueable element in TYPE container.
+ * \return Pointer to the container of passed queueable element.
+ * \see ulog_queueable_compile_time_check
+ * \see ulog_queueable
+ *
+ * Caller must ensure that passed pointer to queueable element is
+ * actually part of memory holding structure with given TYPE.
+ */
+# define ulog_queueable_get_container( QUEUEABLE, TYPE, MEMBER ) \
+    ( \
+      ulog_queueable_compile_time_check( *( QUEUEABLE )), \
+      ( TYPE * )((( uint8_t * )( QUEUEABLE )) - offsetof( TYPE, MEMBER )) \
+    )
+/**
+ * \brief Forward declaration of opaque ulog_queue state.
+ * \see struct ulog_queue_state_struct
+ */
+typedef struct ulog_queue_state_struct ulog_queue_state;
+/**
+ * \brief Forward declaration of queue operations table.
+ * \see struct ulog_queue_op_table_struct
+ */
+typedef struct ulog_queue_op_table_struct ulog_queue_op_table;
+/**
+ * \brief Definition of queue element.
+ * \see ulog_queue
+ */
+typedef struct
+{
+    /** Position at which element was pushed; set by push(). */
+    uint64_t sequence;
+}
+ulog_queueable;
+/**
+ * \brief Definition of queue object.
+ * \see ulog_queue_state
+ * \see ulog_queue_op_table
+ * \see ulog_queueable
+ *
+ * The queue is bounded, first-in first-out and lock-free. Any number of
+ * threads may push() concurrently. It's designed for a single consumer,
+ * but pop() is also safe to call from several threads at once, which
+ * allows producers to take back the oldest element when queue is full.
+ * Like ulog_list_ctrl, the queue is intrusive: it holds pointers to
+ * ulog_queueable members of user types and never copies or frees them.
+ * All memory is allocated by setup(); push() and pop() never allocate
+ * and never block. Positions of producers and consumer live on separate
+ * cache lines. The life cycle is the same as of ulog_mutex. Sample code:
+ * typedef struct
+ * {
+ *    int i;
+ *    ulog_queueable queue;
+ * }
+ * foo;
+ *
+ * foo f = { 23, ulog_queueable_get() };
+ * ulog_queueable * element;
+ * ulog_queue q = ulog_queue_get();
+ * q.op->setup(&q, 64U);
+ * q.op->push(&q, &(f.queue));
+ * q.op->pop(&q, &element);
+ * printf("%d\n", ulog_queueable_get_container(element, foo, queue)->i);
+ * q.op->cleanup(&q);
+ */
+typedef struct
+{
+    /** Object's state. */
+    ulog_queue_state * state;
+    /** Table of operations. */
+    ulog_queue_op_table const * op;
+}
+ulog_queue;
+/**
+ * \brief Defines type of setup operation on ulog_queue object.
+ * \param self The ulog_queue object on which we'll operate.
+ * \param capacity Maximum number of elements, rounded up to power of two.
+ * \return Status object.
+ * \see THREADUNSAFE
+ * \see ulog_status
+ * \see ulog_queue
+ *
+ * Possible status codes:
+ * 1. 0 (zero) - setup successful;
+ * 2. EINVAL - invalid self or zero capacity given;
+ * 3. EALREADY - self already initialized;
+ * 4. ENOMEM - cannot allocate memory for queue state.
+ */
+typedef THREADUNSAFE ulog_status
+    ( * ulog_queue_setup_op )(
+        ulog_queue * const self,
+        size_t const capacity
+    );
+/**
+ * \brief Defines type of cleanup operation on ulog_queue object.
+ * \param self The ulog_queue object on which we'll operate.
+ * \return Status object.
+ * \see THREADUNSAFE
+ * \see ulog_status
+ * \see ulog_queue
+ *
+ * Elements still in the queue are forgotten; their memory is managed by
+ * caller. No other thread may use the queue during or after cleanup().
+ * Possible status codes:
+ * 1. 0 (zero) - cleanup successful;
+ * 2. EINVAL - invalid self given;
+ * 3. EALREADY - self already uninitialized.
+ */
+typedef THREADUNSAFE ulog_status
+    ( * ulog_queue_ctrl_op )( ulog_queue * const self );
+/**
+ * \brief Defines type of push() operation on ulog_queue object.
+ * \param self The ulog_queue object on which we'll operate.
+ * \param element Element to append at the end of the queue.
+ * \return Status object.
+ * \see ulog_status
+ * \see ulog_queue
+ * \see ulog_queueable
+ *
+ * Element must not be in any queue already.
+ * Possible status codes:
+ * 1. 0 (zero) - element pushed successfully;
+ * 2. EINVAL - invalid or uninitialized self given;
+ * 3. ENODATA - invalid element given;
+ * 4. EAGAIN - queue is full.
+ */
+typedef ulog_status
+    ( * ulog_queue_push_op )(
+        ulog_queue const * const self,
+        ulog_queueable * const element
+    );
+/**
+ * \brief Defines type of pop() operation on ulog_queue object.
+ * \param self The ulog_queue object on which we'll operate.
+ * \param element Receives the oldest element, which is removed from queue.
+ * \return Status object.
+ * \see ulog_status
+ * \see ulog_queue
+ * \see ulog_queueable
+ *
+ * Possible status codes:
+ * 1. 0 (zero) - element popped successfully;
+ * 2. EINVAL - invalid or uninitialized self given;
+ * 3. ENODATA - invalid pointer to element given;
+ * 4. ENOENT - queue is empty.
+ */
+typedef ulog_status
+    ( * ulog_queue_pop_op )(
+        ulog_queue const * const self,
+        ulog_queueable * * const element
+    );
+/**
+ * \brief Definition of queue operations table.
+ * \see ulog_queue_setup_op
+ * \see ulog_queue_ctrl_op
+ * \see ulog_queue_push_op
+ * \see ulog_queue_pop_op
+ */
+struct ulog_queue_op_table_struct
+{
+    /** Queue setup operation. */
+    ulog_queue_setup_op setup;
+    /** Queue cleanup operation. */
+    ulog_queue_ctrl_op cleanup;
+    /** Appends element to the queue. */
+    ulog_queue_push_op push;
+    /** Takes the oldest element from the queue. */
+    ulog_queue_pop_op pop;
+};
+/**
+ * \brief Returns valid, initialized queue element.
+ * \return Queue element.
+ * \see ulog_queueable
+ */
+ulog_queueable
+ulog_queueable_get( void );
+/**
+ * \brief Creates queue object in default state.
+ * \return Queue object.
+ * \see ulog_queue
+ */
+ulog_queue
+ulog_queue_get( void );
+/**
+ * \brief Ensures compile-time type safety for queue elements.
+ * \param element Queue element.
+ * \see ulog_queueable_get_container
+ * \see ulog_queueable
+ */
+void
+ulog_queueable_compile_time_check( ulog_queueable const element );
+
+# ifdef __cplusplus
+}
+# endif /* __cplusplus */
+
+#endif /* ULOG_QUEUE_H__ */
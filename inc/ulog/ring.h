@@ -0,0 +1,274 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Defines API for ring of records shared by processes.
+ * \date        2016/05/28 10:36:14 AM
+ * \file        ring.h
+ * \version     1.0
+ *
+ *
+ **/
+
+#ifndef ULOG_RING_H__
+# define ULOG_RING_H__
+
+# include <ulog/async.h> /* ulog_async_sink_fn */
+# include <ulog/status.h> /* ulog_status */
+# include <ulog/ulog.h> /* ulog_level, ulog_ring_config */
+# include <ulog/universal.h> /* THREADUNSAFE */
+
+# include <stdarg.h> /* va_list */
+# include <stddef.h> /* size_t */
+# include <stdint.h> /* uint64_t */
+
+# ifdef __cplusplus
+extern "C" {
+# endif /* __cplusplus */
+
+/**
+ * \brief Forward declaration of opaque ulog_ring state.
+ * \see struct ulog_ring_state_struct
+ */
+typedef struct ulog_ring_state_struct ulog_ring_state;
+/**
+ * \brief Forward declaration of ring operations table.
+ * \see struct ulog_ring_op_table_struct
+ */
+typedef struct ulog_ring_op_table_struct ulog_ring_op_table;
+/**
+ * \brief Definition of ring object.
+ * \see ulog_ring_state
+ * \see ulog_ring_op_table
+ * \see ulog_ring_config
+ *
+ * The ring is a bounded multi-producer single-consumer queue of records
+ * of ULOG_RECORD_SIZE bytes, in shared memory mapped by each process using
+ * it. Each slot carries a sequence number: producer reserves the slot by
+ * advancing the head with compare-and-swap when sequence equals its
+ * position, writes the record in place and commits it by advancing the
+ * sequence; collector passes committed records to sink in order of
+ * reservation and hands the slot to the next lap. Reserved slot which isn't
+ * committed within timeout is taken from its producer, which learns of it
+ * when it tries to commit. Until then the slot is skipped by producers and
+ * collector in each lap, so that the producer can't write over records
+ * of others; slot of a producer which died stays skipped. The life cycle
+ * is the same as of ulog_async.
+ * Sample code:
+ * ulog_ring r = ulog_ring_get();
+ * ulog_ring_config c = { .name = "/log", .capacity = 1024U };
+ * r.op->setup(&r, &c, NULL, NULL);
+ * r.op->submit(&r, INFO, format, args);
+ * r.op->cleanup(&r);
+ */
+typedef struct
+{
+    /** Object's state. */
+    ulog_ring_state * state;
+    /** Table of operations. */
+    ulog_ring_op_table const * op;
+}
+ulog_ring;
+/**
+ * \brief Slot reserved by producer.
+ * \see ulog_ring_reserve_op
+ */
+typedef struct
+{
+    /** Position of the slot in the ring. */
+    uint64_t position;
+    /** Buffer for the record. */
+    char * text;
+    /** Size of the buffer. */
+    size_t size;
+}
+ulog_ring_reservation;
+/**
+ * \brief Counters of the ring, shared by all processes using it.
+ */
+typedef struct
+{
+    /** Records committed by producers. */
+    uint64_t written;
+    /** Records lost because the ring was full. */
+    uint64_t dropped;
+    /** Records passed to sink by collector. */
+    uint64_t collected;
+    /** Reserved records skipped by collector after timeout. */
+    uint64_t abandoned;
+}
+ulog_ring_counters;
+/**
+ * \brief Defines type of setup operation on ulog_ring object.
+ * \param self The ulog_ring object on which we'll operate.
+ * \param config Name and capacity of the ring and role of the process.
+ * \param sink Function receiving records if config->collect is set.
+ * \param userdata Pointer passed to sink.
+ * \return Status object.
+ * \see THREADUNSAFE
+ * \see ulog_status
+ * \see ulog_ring_config
+ *
+ * Maps the ring, creating it if it doesn't exist yet, and, for collector,
+ * starts the thread passing records to sink.
+ * Possible status codes:
+ * 1. 0 (zero) - setup successful;
+ * 2. EINVAL - invalid self, config or sink given;
+ * 3. EALREADY - self already initialized;
+ * 4. ENOMEM - cannot allocate memory for ring state;
+ * 5. EBUSY - other live process collects from the ring;
+ * 6. EIO - cannot open or map the ring, it has other capacity or isn't
+ * ulog's, or cannot start collector thread.
+ */
+typedef THREADUNSAFE ulog_status
+    ( * ulog_ring_setup_op )(
+        ulog_ring * const self,
+        ulog_ring_config const * const config,
+        ulog_async_sink_fn const sink,
+        void * const userdata
+    );
+/**
+ * \brief Defines type of cleanup operation on ulog_ring object.
+ * \param self The ulog_ring object on which we'll operate.
+ * \return Status object.
+ * \see THREADUNSAFE
+ * \see ulog_status
+ *
+ * Collector passes records committed so far to sink before it returns.
+ * Possible status codes:
+ * 1. 0 (zero) - cleanup successful;
+ * 2. EINVAL - invalid self given;
+ * 3. EALREADY - self already uninitialized.
+ */
+typedef THREADUNSAFE ulog_status
+    ( * ulog_ring_ctrl_op )( ulog_ring * const self );
+/**
+ * \brief Defines type of reset operation on ulog_ring object.
+ * \param self The ulog_ring object on which we'll operate.
+ * \return Status object.
+ * \see THREADUNSAFE
+ * \see ulog_status
+ *
+ * Meant for the child process after fork(), which inherits the mapping of
+ * the ring but not the collector thread. The parent remains the collector,
+ * so the child becomes a producer; a producer stays one.
+ * Possible status codes:
+ * 1. 0 (zero) - reset successful;
+ * 2. EINVAL - invalid or uninitialized self given.
+ */
+typedef THREADUNSAFE ulog_status
+    ( * ulog_ring_reset_op )( ulog_ring * const self );
+/**
+ * \brief Defines type of reserve() operation on ulog_ring object.
+ * \param self The ulog_ring object on which we'll operate.
+ * \param reservation Receives reserved slot.
+ * \return Status object.
+ * \see ulog_status
+ * \see ulog_ring_reservation
+ *
+ * Reserved slot must be committed soon, as it holds up collection of the
+ * following ones until it's committed or timeout passes.
+ * Possible status codes:
+ * 1. 0 (zero) - slot reserved;
+ * 2. EINVAL - invalid or uninitialized self given;
+ * 3. ENODATA - invalid pointer to reservation given;
+ * 4. ENOBUFS - the ring is full, record dropped.
+ */
+typedef ulog_status
+    ( * ulog_ring_reserve_op )(
+        ulog_ring const * const self,
+        ulog_ring_reservation * const reservation
+    );
+/**
+ * \brief Defines type of commit() operation on ulog_ring object.
+ * \param self The ulog_ring object on which we'll operate.
+ * \param reservation Slot returned by reserve(), with record written.
+ * \param level Log level of the record.
+ * \param length Length of the record, without terminating NUL.
+ * \return Status object.
+ * \see ulog_status
+ * \see ulog_ring_reservation
+ *
+ * Possible status codes:
+ * 1. 0 (zero) - record committed;
+ * 2. EINVAL - invalid or uninitialized self given;
+ * 3. ENODATA - invalid reservation given;
+ * 4. ETIMEDOUT - collector skipped the slot, record lost; the slot is
+ *    given back to the ring.
+ */
+typedef ulog_status
+    ( * ulog_ring_commit_op )(
+        ulog_ring const * const self,
+        ulog_ring_reservation const * const reservation,
+        ulog_level const level,
+        size_t const length
+    );
+/**
+ * \brief Defines type of submit() operation on ulog_ring object.
+ * \param self The ulog_ring object on which we'll operate.
+ * \param level Log level.
+ * \param format Formatting string, as in printf.
+ * \param args Arguments for the format string, as in vprintf.
+ * \return Status object.
+ * \see ulog_status
+ *
+ * Reserves slot, renders the record into it and commits it. Records longer
+ * than ULOG_RECORD_SIZE - 1 bytes are truncated.
+ * Possible status codes: those of reserve() and commit().
+ */
+typedef ulog_status
+    ( * ulog_ring_submit_op )(
+        ulog_ring const * const self,
+        ulog_level const level,
+        char const * const format,
+        va_list args
+    );
+/**
+ * \brief Defines type of counters() operation on ulog_ring object.
+ * \param self The ulog_ring object on which we'll operate.
+ * \param counters Receives current values of counters.
+ * \return Status object.
+ * \see ulog_status
+ * \see ulog_ring_counters
+ *
+ * Possible status codes:
+ * 1. 0 (zero) - counters read;
+ * 2. EINVAL - invalid or uninitialized self given;
+ * 3. ENODATA - invalid pointer to counters given.
+ */
+typedef ulog_status
+    ( * ulog_ring_counters_op )(
+        ulog_ring const * const self,
+        ulog_ring_counters * const counters
+    );
+/**
+ * \brief Definition of ring operations table.
+ */
+struct ulog_ring_op_table_struct
+{
+    /** Maps the ring and starts collector thread. */
+    ulog_ring_setup_op setup;
+    /** Collects remaining records, stops thread and unmaps the ring. */
+    ulog_ring_ctrl_op cleanup;
+    /** Reserves slot for a record. */
+    ulog_ring_reserve_op reserve;
+    /** Hands record written into reserved slot to collector. */
+    ulog_ring_commit_op commit;
+    /** Writes a record into the ring. */
+    ulog_ring_submit_op submit;
+    /** Reads counters of the ring. */
+    ulog_ring_counters_op counters;
+    /** Makes the child process after fork() a producer. */
+    ulog_ring_reset_op reset;
+};
+/**
+ * \brief Creates ring object in default state.
+ * \return Ring object.
+ * \see ulog_ring
+ */
+ulog_ring
+ulog_ring_get( void );
+
+# ifdef __cplusplus
+}
+# endif /* __cplusplus */
+
+#endif /* ULOG_RING_H__ */
@@ -0,0 +1,141 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Control of logging shared by processes.
+ * \date        2016/05/24 19:02:51 PM
+ * \file        shared.h
+ * \version     1.0
+ *
+ * The page of shared memory has layout of ulog_fast_state. Processes point
+ * their ulog_fast_ to it with ulog_obj's share(), tools like ulogctl map it
+ * with ulog_shared_open(). Call sites are identified in it
+ * by bits hashed from name of their file, without directories, and line, so
+ * they're the same in all processes built from the same sources. Distinct
+ * call sites may share a bit, then enabling one enables the other as well.
+ **/
+
+#ifndef ULOG_SHARED_H__
+# define ULOG_SHARED_H__
+
+# include <stdbool.h> /* bool */
+# include <stddef.h> /* size_t */
+# include <ulog/status.h> /* ulog_status */
+# include <ulog/ulog.h> /* ulog_fast_state, ulog_level */
+# include <ulog/universal.h> /* ULOG_EXPORT */
+
+# ifdef __cplusplus
+extern "C" {
+# endif /* __cplusplus */
+
+/**
+ * \brief Number of call site bits in shared page.
+ */
+# define ULOG_SHARED_BITS \
+    ( 8U * sizeof((( ulog_fast_state * ) 0 )->enabled ))
+/**
+ * \brief Maps shared page, creating it if it doesn't exist yet.
+ * \param name Name of shared memory object, as in shm_open().
+ * \param page Receives the mapping.
+ * \return Status object.
+ *
+ * New page has verbosity DEBUG and no call sites enabled.
+ * Possible error codes:
+ * 1. ENODATA - invalid name or NULL page given,
+ * 2. EIO - failure opening or mapping the page, or it isn't ulog's.
+ */
+ULOG_EXPORT ulog_status
+ulog_shared_open( char const * const name, ulog_fast_state ** const page );
+/**
+ * \brief Unmaps page mapped by ulog_shared_open().
+ * \param page The page.
+ */
+ULOG_EXPORT void
+ulog_shared_close( ulog_fast_state * const page );
+/**
+ * \brief Removes name of shared page, as in shm_unlink().
+ * \param name Name of shared memory object.
+ * \return Status object.
+ *
+ * Processes which mapped the page keep sharing it; new ones get a new page.
+ * Possible error codes:
+ * 1. ENODATA - invalid name given,
+ * 2. EIO - failure removing the name.
+ */
+ULOG_EXPORT ulog_status
+ulog_shared_remove( char const * const name );
+/**
+ * \brief Sets verbosity of all processes sharing the page.
+ * \param page The page.
+ * \param verbosity Log level.
+ * \return Status object.
+ *
+ * Possible error codes:
+ * 1. ENODATA - invalid verbosity given.
+ */
+ULOG_EXPORT ulog_status
+ulog_shared_verbosity(
+    ulog_fast_state * const page,
+    ulog_level const verbosity
+);
+/**
+ * \brief Finds bit of call site.
+ * \param file File name of the call site, directories are ignored.
+ * \param line Line number of the call site.
+ * \return Index of the bit, less than ULOG_SHARED_BITS.
+ */
+ULOG_EXPORT size_t
+ulog_shared_bit( char const * const file, unsigned const line );
+/**
+ * \brief Checks whether call site is enabled in shared page.
+ * \param page The page.
+ * \param file File name of the call site.
+ * \param line Line number of the call site.
+ * \return True if its bit is set.
+ */
+ULOG_EXPORT bool
+ulog_shared_enabled(
+    ulog_fast_state const * const page,
+    char const * const file,
+    unsigned const line
+);
+/**
+ * \brief Enables or disables call site in all processes sharing the page.
+ * \param page The page.
+ * \param file File name of the call site.
+ * \param line Line number of the call site.
+ * \param enabled Whether the call site logs regardless of verbosity.
+ *
+ * Call sites re-evaluate their state once after each change.
+ */
+ULOG_EXPORT void
+ulog_shared_enable(
+    ulog_fast_state * const page,
+    char const * const file,
+    unsigned const line,
+    bool const enabled
+);
+/**
+ * \brief Maps shared page for ulog_fast_ to point to.
+ * \param name Name of shared memory object.
+ * \param verbosity Verbosity of the page, if it's created.
+ * \param page Receives the page, filled in.
+ * \return Status object.
+ * \see ulog_obj_share_op
+ */
+ulog_status
+ulog_shared_attach_(
+    char const * const name,
+    ulog_level const verbosity,
+    ulog_fast_state ** const page
+);
+/**
+ * \brief Unmaps page mapped by ulog_shared_attach_().
+ * \param page The page, may be NULL.
+ */
+void
+ulog_shared_detach_( ulog_fast_state * const page );
+
+# ifdef __cplusplus
+}
+# endif /* __cplusplus */
+
+#endif /* ULOG_SHARED_H__ */
@@ -0,0 +1,164 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Striped counters backing ulog statistics.
+ * \date        2016/03/26 10:07:19 AM
+ * \file        stats.h
+ * \version     1.0
+ *
+ * Counters are split into stripes, each on its own cache line(s). Every
+ * thread updates only the stripe assigned to it, so concurrent loggers
+ * don't bounce shared cache lines; the stripes are summed only on read.
+ **/
+
+#ifndef ULOG_STATS_H__
+# define ULOG_STATS_H__
+
+# include <ulog/queue.h> /* ULOG_CACHE_LINE */
+# include <ulog/ulog.h> /* ULOG_LEVELS, ULOG_STATS_BUCKETS, ulog_level */
+
+# include <stddef.h> /* size_t */
+# include <stdint.h> /* uint8_t, uint64_t */
+
+# ifdef __cplusplus
+extern "C" {
+# endif /* __cplusplus */
+
+/**
+ * \brief Number of stripes of each counter.
+ */
+# define ULOG_STATS_STRIPES 8U
+/**
+ * \brief One stripe of message counters.
+ */
+typedef struct
+{
+    /** Messages accepted by verbosity filter, per level. */
+    uint64_t messages[ ULOG_LEVELS ];
+    /** Messages rejected by verbosity filter. */
+    uint64_t suppressed;
+    /** Length of messages delivered to handlers. */
+    uint64_t bytes;
+    /** Keeps next stripe off this cache line. */
+    uint8_t padding[ ULOG_CACHE_LINE - ( ULOG_LEVELS + 2U ) * 8U ];
+}
+ulog_stats_stripe;
+/**
+ * \brief One stripe of counters of a single handler.
+ */
+typedef struct
+{
+    /** Number of calls. */
+    uint64_t calls;
+    /** Histogram of call latencies. */
+    uint64_t latency[ ULOG_STATS_BUCKETS ];
+    /** Keeps next stripe off the last cache line of this one. */
+    uint8_t padding[ ULOG_CACHE_LINE - sizeof( uint64_t ) ];
+}
+ulog_stats_handler_stripe;
+/**
+ * \brief Message counters.
+ */
+typedef struct
+{
+    /** Stripes, indexed by ulog_stats_stripe_index(). */
+    ulog_stats_stripe stripe[ ULOG_STATS_STRIPES ];
+}
+ulog_stats_messages;
+/**
+ * \brief Counters of a single handler.
+ */
+typedef struct
+{
+    /** Stripes, indexed by ulog_stats_stripe_index(). */
+    ulog_stats_handler_stripe stripe[ ULOG_STATS_STRIPES ];
+}
+ulog_stats_handler;
+/**
+ * \brief Returns index of stripe assigned to calling thread.
+ * \return Index lower than ULOG_STATS_STRIPES.
+ *
+ * Threads are assigned stripes round robin on their first call.
+ */
+unsigned
+ulog_stats_stripe_index( void );
+/**
+ * \brief Returns histogram bucket counting given latency.
+ * \param latency Latency in nanoseconds.
+ * \return Index lower than ULOG_STATS_BUCKETS.
+ */
+size_t
+ulog_stats_bucket( uint64_t const latency );
+/**
+ * \brief Zeroes message counters.
+ * \param counters Counters to reset.
+ */
+void
+ulog_stats_messages_reset( ulog_stats_messages * const counters );
+/**
+ * \brief Zeroes handler counters.
+ * \param counters Counters to reset.
+ */
+void
+ulog_stats_handler_reset( ulog_stats_handler * const counters );
+/**
+ * \brief Counts message accepted by verbosity filter.
+ * \param counters Counters to update.
+ * \param level Level of the message.
+ */
+void
+ulog_stats_count_message(
+    ulog_stats_messages * const counters,
+    ulog_level const level
+);
+/**
+ * \brief Counts message rejected by verbosity filter.
+ * \param counters Counters to update.
+ */
+void
+ulog_stats_count_suppressed( ulog_stats_messages * const counters );
+/**
+ * \brief Counts bytes of message delivered to handlers.
+ * \param counters Counters to update.
+ * \param bytes Length of the message.
+ */
+void
+ulog_stats_count_bytes(
+    ulog_stats_messages * const counters,
+    uint64_t const bytes
+);
+/**
+ * \brief Counts a call of handler.
+ * \param counters Counters of the handler.
+ * \param latency Duration of the call in nanoseconds.
+ */
+void
+ulog_stats_count_call(
+    ulog_stats_handler * const counters,
+    uint64_t const latency
+);
+/**
+ * \brief Sums stripes of message counters.
+ * \param counters Counters to read.
+ * \param result Receives messages, suppressed and bytes fields.
+ */
+void
+ulog_stats_messages_read(
+    ulog_stats_messages const * const counters,
+    ulog_stats * const result
+);
+/**
+ * \brief Sums stripes of handler counters.
+ * \param counters Counters to read.
+ * \param result Receives calls and latency fields.
+ */
+void
+ulog_stats_handler_read(
+    ulog_stats_handler const * const counters,
+    ulog_handler_stats * const result
+);
+
+# ifdef __cplusplus
+}
+# endif /* __cplusplus */
+
+#endif /* ULOG_STATS_H__ */
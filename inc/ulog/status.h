@@ -12,6 +12,7 @@
 # define ULOG_STATUS_H__
 
 # include <stdbool.h> /* bool */
+# include <ulog/universal.h> /* ULOG_EXPORT */
 
 # ifdef __cplusplus
 extern "C" {
@@ -44,7 +45,7 @@ ulog_status;
  * The following is always true:
  * code == ulog_status_to_int(ulog_status_descriptive(code, "string"))
  */
-ulog_status
+ULOG_EXPORT ulog_status
 ulog_status_descriptive( int const code, char const * const description );
 /**
  * \brief Translates ulog_status to int for easy manipulation and comparison.
@@ -58,7 +59,7 @@ ulog_status_descriptive( int const code, char const * const description );
  * The following is always true:
  * code == ulog_status_to_int(ulog_status_descriptive(code, "string"))
  */
-int
+ULOG_EXPORT int
 ulog_status_to_int( ulog_status const status );
 /**
  * \brief Checks whether status code represents success.
@@ -71,7 +72,7 @@ ulog_status_to_int( ulog_status const status );
  * directly. It's also possible that the value of successful code will change,
  * so checking it with ulog_status_to_int may become invalid.
  */
-bool
+ULOG_EXPORT bool
 ulog_status_success( ulog_status const status );
 
 # ifdef __cplusplus
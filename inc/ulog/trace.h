@@ -0,0 +1,186 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Spans measuring duration of scopes.
+ * \date        2016/05/14 09:41:27 AM
+ * \file        trace.h
+ * \version     1.0
+ *
+ * Spans are logged as ordinary records, so they pass through the same
+ * handlers and buffers as messages and are timestamped by the same clock.
+ * Records of spans can be turned into Chrome Trace Event JSON, viewable in
+ * chrome://tracing or Perfetto, by ulog_trace_export().
+ **/
+
+#ifndef ULOG_TRACE_H__
+# define ULOG_TRACE_H__
+
+# include <stdint.h> /* uint64_t */
+# include <stdio.h> /* FILE */
+# include <ulog/status.h> /* ulog_status */
+# include <ulog/ulog.h> /* ulog_level, ULOG____ */
+# include <ulog/universal.h> /* INDIRECT, THREADLOCAL, ULOG_EXPORT */
+
+# ifdef __cplusplus
+extern "C" {
+# endif /* __cplusplus */
+
+/**
+ * \brief Log level of records of spans.
+ *
+ * Spans are logged only if this level is enabled. May be defined before
+ * including this header to use another level.
+ */
+# ifndef ULOG_TRACE_LEVEL
+#  define ULOG_TRACE_LEVEL DEBUG
+# endif /* ULOG_TRACE_LEVEL */
+/**
+ * \brief Maximum nesting of spans whose names are remembered.
+ *
+ * Deeper spans are still logged, but their ends are logged with empty name.
+ */
+# define ULOG_TRACE_DEPTH 32U
+/**
+ * \brief Body of records of spans, following the standard header.
+ *
+ * Takes phase ('B' for begin, 'E' for end), process, thread, depth and
+ * name.
+ */
+# define ULOG_TRACE_FORMAT_ "trace %c %lu %u %u %s"
+/**
+ * \brief Definition of per-thread state of spans.
+ */
+typedef struct
+{
+    /** Identifier of process, zero until first span and after fork. */
+    unsigned long process;
+    /** Identifier of thread, zero until its first span. */
+    unsigned thread;
+    /** Number of spans begun and not yet ended. */
+    unsigned depth;
+    /** Names of open spans, outermost first. */
+    char const * name[ ULOG_TRACE_DEPTH ];
+}
+ulog_trace_state;
+/**
+ * \brief State of spans of calling thread.
+ */
+INDIRECT extern ULOG_EXPORT THREADLOCAL ulog_trace_state ulog_trace_;
+/**
+ * \brief Assigns identifier to calling thread, notes its process.
+ * \return The identifier, small and unique within the process.
+ */
+INDIRECT ULOG_EXPORT ULOG_COLD unsigned
+ulog_trace_thread_( void );
+/**
+ * \brief Forgets process of calling thread, in the child after fork().
+ *
+ * The thread keeps its identifier; spans it logs from then on carry the
+ * identifier of the child.
+ */
+INDIRECT ULOG_EXPORT void
+ulog_trace_reset_( void );
+/**
+ * \brief Opens span of calling thread.
+ * \param name Name of the span, must outlive it.
+ * \return Depth of the span, zero for the outermost one.
+ */
+static inline unsigned
+ulog_trace_begin_( char const * const name )
+{
+    if( 0U == ulog_trace_.process ) { ( void ) ulog_trace_thread_(); }
+    if( ULOG_TRACE_DEPTH > ulog_trace_.depth )
+    {
+        ulog_trace_.name[ ulog_trace_.depth ] = name;
+    }
+    return ulog_trace_.depth++;
+}
+/**
+ * \brief Closes innermost span of calling thread.
+ * \return Name of the span, NULL if no span was open.
+ */
+static inline char const *
+ulog_trace_end_( void )
+{
+    if( 0U == ulog_trace_.depth ) { return NULL; }
+    if( 0U == ulog_trace_.process ) { ( void ) ulog_trace_thread_(); }
+    --ulog_trace_.depth;
+    return
+        ( ULOG_TRACE_DEPTH > ulog_trace_.depth )
+            ? ulog_trace_.name[ ulog_trace_.depth ]
+            : "";
+}
+/**
+ * \defgroup ULOG_TRACE Group of macros for spans.
+ *
+ * UTRACE_BEGIN( "name" ); opens span on calling thread, UTRACE_END();
+ * closes the innermost one. Spans nest and are always opened and closed,
+ * even if ULOG_TRACE_LEVEL is disabled, so nesting survives changes of
+ * verbosity; only enabled ones are logged. Defining ULOG_NO_TRACE before
+ * including this header compiles them out entirely.
+ *
+ * @{
+ */
+# ifdef ULOG_NO_TRACE
+#  define UTRACE_BEGIN( NAME ) (( void ) 0 )
+#  define UTRACE_END() (( void ) 0 )
+# else /* ULOG_NO_TRACE */
+#  define UTRACE_BEGIN( NAME ) \
+    do \
+    { \
+        char const * const ulog_name_ = ( NAME ); \
+        unsigned const ulog_depth_ = ulog_trace_begin_( ulog_name_ ); \
+        ULOG__( \
+            ULOG_TRACE_LEVEL, \
+            ULOG_TRACE_FORMAT_, \
+            'B', \
+            ulog_trace_.process, \
+            ulog_trace_.thread, \
+            ulog_depth_, \
+            ulog_name_ \
+        ); \
+    } \
+    while( 0 )
+#  define UTRACE_END() \
+    do \
+    { \
+        char const * const ulog_name_ = ulog_trace_end_(); \
+        if( NULL != ulog_name_ ) \
+        { \
+            ULOG__( \
+                ULOG_TRACE_LEVEL, \
+                ULOG_TRACE_FORMAT_, \
+                'E', \
+                ulog_trace_.process, \
+                ulog_trace_.thread, \
+                ulog_trace_.depth, \
+                ulog_name_ \
+            ); \
+        } \
+    } \
+    while( 0 )
+# endif /* ULOG_NO_TRACE */
+/**@}*/
+/**
+ * \brief Converts logged text into Chrome Trace Event JSON.
+ * \param input Stream of records, as written by a handler.
+ * \param output Receives JSON object with array of trace events.
+ * \return Status object.
+ *
+ * Spans become begin and end events of their threads, within their
+ * processes. Other records become instant events, named by their messages,
+ * of the process of the last span read before them. Lines without the
+ * standard header are skipped. Ends without logged beginning are skipped;
+ * spans whose ends weren't logged are ended by the end of their parent.
+ * Possible error codes:
+ * 1. ENODATA - NULL stream given,
+ * 2. ENOMEM - no memory for state of threads,
+ * 3. EIO - failure reading or writing stream.
+ */
+ULOG_EXPORT ulog_status
+ulog_trace_export( FILE * const input, FILE * const output );
+
+# ifdef __cplusplus
+}
+# endif /* __cplusplus */
+
+#endif /* ULOG_TRACE_H__ */
@@ -15,9 +15,12 @@
 
 # include <inttypes.h> /* PRIu64 */
 # include <stdarg.h> /* va_list */
+# include <stdbool.h> /* bool */
+# include <stddef.h> /* size_t */
 # include <stdint.h> /* uint64_t */
+# include <sys/uio.h> /* struct iovec */
 # include <ulog/status.h> /* ulog_status */
-# include <ulog/universal.h> /* INDIRECT, THREADUNSAFE */
+# include <ulog/universal.h> /* INDIRECT, THREADUNSAFE, ULOG_EXPORT */
 
 # ifdef __cplusplus
 extern "C" {
@@ -38,6 +41,10 @@ typedef enum
     DEBUG
 }
 ulog_level;
+/**
+ * \brief Number of log levels.
+ */
+# define ULOG_LEVELS 4U
 /**
  * \brief Returns single letter representation of log level.
  * \param level Log level.
@@ -50,7 +57,7 @@ ulog_level;
  * INFO - 'I'
  * DEBUG - 'D'
  */
-INDIRECT char
+INDIRECT ULOG_EXPORT char
 ulog_level_to_char_( ulog_level const level );
 /**
  * \brief Returns current time.
@@ -59,8 +66,17 @@ ulog_level_to_char_( ulog_level const level );
  * The time reported here is equal to the wall clock time, thus it's affected
  * by jumps resulting from changing the wall clock time.
  */
-INDIRECT uint64_t
+INDIRECT ULOG_EXPORT uint64_t
 ulog_current_time_( void );
+/**
+ * \brief Returns time elapsed since an unspecified point.
+ * \return Time in nanoseconds, zero if the clock isn't available.
+ *
+ * Unlike ulog_current_time_() it's immune to jumps of the wall clock, so
+ * it's what timeouts and latencies inside ulog framework are measured with.
+ */
+INDIRECT uint64_t
+ulog_monotonic_time_( void );
 /**
  * \brief Directs output of a log message to registered handlers.
  * \param level Log level.
@@ -70,8 +86,234 @@ ulog_current_time_( void );
  *
  * This function operates on static values. It's thread-safe.
  */
-INDIRECT void
+INDIRECT ULOG_EXPORT ULOG_COLD ULOG_FORMAT( 2, 3 ) void
 ulog_( ulog_level const level, char const * const format, ... );
+/**
+ * \brief Defines types of arguments, as passed through variadic call.
+ *
+ * Arguments of types narrower than int are promoted to int and float is
+ * promoted to double, as in any variadic call. Pointers to characters are
+ * assumed to point to strings, other pointers are stored as addresses.
+ */
+typedef enum
+{
+    /** Terminates list of types. */
+    ULOG_ARG_END,
+    /** int and all narrower integer types. */
+    ULOG_ARG_INT,
+    /** unsigned int. */
+    ULOG_ARG_UINT,
+    /** long. */
+    ULOG_ARG_LONG,
+    /** unsigned long. */
+    ULOG_ARG_ULONG,
+    /** long long. */
+    ULOG_ARG_LLONG,
+    /** unsigned long long. */
+    ULOG_ARG_ULLONG,
+    /** double and float. */
+    ULOG_ARG_DOUBLE,
+    /** long double. */
+    ULOG_ARG_LDOUBLE,
+    /** Pointer other than to characters. */
+    ULOG_ARG_POINTER,
+    /** Pointer to zero-terminated string. */
+    ULOG_ARG_STRING
+}
+ulog_arg_type;
+/**
+ * \brief Directs output of a log message along with types of its arguments.
+ * \param signature Types of arguments, terminated with ULOG_ARG_END.
+ * \param level Log level.
+ * \param format Formatting string, as in printf.
+ * \param ... Arguments to output, according to format, as in printf.
+ * \see ulog_arg_type
+ * \see ulog_
+ *
+ * Works like ulog_(), but lets binary handlers store arguments without
+ * parsing the format. Logging macros pass a static signature built at compile
+ * time when compiled as C11 or later by GCC or Clang.
+ */
+INDIRECT ULOG_EXPORT ULOG_COLD ULOG_FORMAT( 3, 4 ) void
+ulog_typed_(
+    unsigned char const * const signature,
+    ulog_level const level,
+    char const * const format,
+    ...
+);
+/**
+ * \brief Defines state of call site, as set by rules.
+ * \see ulog_obj_callsite_op
+ */
+typedef enum
+{
+    /** Call site logs according to verbosity. */
+    ULOG_CALLSITE_DEFAULT,
+    /** Call site logs regardless of verbosity. */
+    ULOG_CALLSITE_ON,
+    /** Call site never logs. */
+    ULOG_CALLSITE_OFF
+}
+ulog_callsite_state;
+/**
+ * \brief Definition of call site of logging macro.
+ *
+ * Each call site has its own static instance, which caches its state until
+ * rules change.
+ */
+typedef struct
+{
+    /** File name of the call site. */
+    char const * file;
+    /** Line number of the call site. */
+    unsigned line;
+    /** Generation of rules the state was evaluated against. */
+    unsigned generation;
+    /** State of the call site, one of ulog_callsite_state. */
+    int state;
+}
+ulog_callsite;
+/**
+ * \brief Directs output of a log message from given call site.
+ * \param site Call site of the message.
+ * \param signature Types of arguments, terminated with ULOG_ARG_END.
+ * \param level Log level.
+ * \param format Formatting string, as in printf.
+ * \param ... Arguments to output, according to format, as in printf.
+ * \see ulog_typed_
+ *
+ * Works like ulog_typed_(), but a call site enabled by rules logs even
+ * if level is more verbose than verbosity.
+ */
+INDIRECT ULOG_EXPORT ULOG_COLD ULOG_FORMAT( 4, 5 ) void
+ulog_site_(
+    ulog_callsite const * const site,
+    unsigned char const * const signature,
+    ulog_level const level,
+    char const * const format,
+    ...
+);
+/**
+ * \brief Evaluates rules for call site.
+ * \param site The call site.
+ * \param generation Generation of rules to evaluate.
+ */
+INDIRECT ULOG_EXPORT ULOG_COLD void
+ulog_callsite_update_( ulog_callsite * const site, unsigned const generation );
+/**
+ * \brief Size of ulog_fast_state, which is as large as a small page.
+ */
+# define ULOG_SHARED_SIZE 4096U
+/**
+ * \brief Value of ulog_fast_state's magic once it's shared by processes.
+ */
+# define ULOG_SHARED_MAGIC 0x756c6f67U
+/**
+ * \brief State of ulog framework consulted by logging macros.
+ *
+ * Logging macros read it inline, so a message which isn't going to be logged
+ * costs two loads and a compare, without any call into the library. All
+ * fields are changed without locks, so they can be changed from signal
+ * handlers and from other processes, when the page is shared.
+ * \see ulog_obj_share_op
+ */
+typedef struct
+{
+    /** The most verbose level passed to ulog_(), -1 if not initialized. */
+    int threshold;
+    /** Generation of call site rules, zero if there are none. */
+    unsigned generation;
+    /** ULOG_SHARED_MAGIC if the page is shared, zero otherwise. */
+    unsigned magic;
+    /** Reserved, zero. */
+    unsigned reserved;
+    /** Bits of call sites enabled by other processes, see shared.h. */
+    unsigned char enabled[ ULOG_SHARED_SIZE - 4U * sizeof( unsigned ) ];
+}
+ulog_fast_state;
+/**
+ * \brief Points to ulog_fast_state in use, updated by ulog_obj.
+ *
+ * It's private to the process, or the page shared with other processes.
+ * Changed atomically, only after the state it points to is filled in.
+ */
+INDIRECT extern ULOG_EXPORT ulog_fast_state * ulog_fast_;
+/**
+ * \brief Returns ulog_fast_state in use.
+ * \return The state ulog_fast_ points to.
+ */
+static inline ulog_fast_state const *
+ulog_fast_get_( void )
+{
+    return __atomic_load_n( &ulog_fast_, __ATOMIC_ACQUIRE );
+}
+/**
+ * \brief Checks whether message of given level should be passed to ulog_().
+ * \param level Log level.
+ * \return True if ulog_() may log the message, false if it surely won't.
+ *
+ * The state is read without ordering, so messages racing with a change of
+ * verbosity may be passed on. ulog_() checks verbosity again in such case.
+ */
+static inline bool
+ulog_enabled_( ulog_level const level )
+{
+    return
+        ( int ) level
+        <= __atomic_load_n(
+            &( ulog_fast_get_()->threshold ),
+            __ATOMIC_RELAXED
+        );
+}
+/**
+ * \brief Checks whether message from given call site should be logged.
+ * \param site The call site.
+ * \param level Log level.
+ * \return True if ulog_site_() may log the message, false otherwise.
+ *
+ * Unless there are any rules, it's the same as ulog_enabled_(). Otherwise
+ * the call site evaluates them once per their change.
+ */
+static inline bool
+ulog_site_enabled_( ulog_callsite * const site, ulog_level const level )
+{
+    unsigned const generation =
+        __atomic_load_n(
+            &( ulog_fast_get_()->generation ),
+            __ATOMIC_RELAXED
+        );
+    if( 0U == generation ) { return ulog_enabled_( level ); }
+    if(
+        generation
+        != __atomic_load_n( &( site->generation ), __ATOMIC_ACQUIRE )
+    )
+    {
+        ulog_callsite_update_( site, generation );
+    }
+    switch( __atomic_load_n( &( site->state ), __ATOMIC_RELAXED ))
+    {
+        case ULOG_CALLSITE_ON: return true;
+        case ULOG_CALLSITE_OFF: return false;
+        default: return ulog_enabled_( level );
+    }
+}
+/**
+ * \brief Inline equivalent of ulog_level_to_char_().
+ * \param level Log level.
+ * \return Single character representing level.
+ */
+static inline char
+ulog_level_char_( ulog_level const level )
+{
+    switch( level )
+    {
+        case ERROR: return 'E';
+        case WARNING: return 'W';
+        case INFO: return 'I';
+        case DEBUG: return 'D';
+        default: return '?';
+    }
+}
 /**
  * \defgroup ULOGGERS Group of logging macros.
  * \see ULOG_WRAPPERS
@@ -83,17 +325,175 @@ ulog_( ulog_level const level, char const * const format, ... );
  *
  * @{
  */
-# define ULOG____( LEVEL, FORMAT, ... ) \
-    ulog_( \
+/**
+ * \brief Format of the header prepended to each message by logging macros.
+ *
+ * The header takes, in order, the level character, current time, file name,
+ * function name and line number. Internal stages which need to know where
+ * a record originated (e.g. duplicate suppression) recognize formats which
+ * begin with this exact prefix.
+ */
+# define ULOG_HEADER_FORMAT_ "[%c][%" PRIu64 "][%s:%s:%u] "
+# if \
+    defined( __STDC_VERSION__ ) && ( 201112L <= __STDC_VERSION__ ) \
+    && defined( __GNUC__ )
+/**
+ * \brief Maps type of an argument to ulog_arg_type at compile time.
+ */
+#  define ULOG_ARG_TYPE_( ARG ) \
+    _Generic(( ARG ), \
+        _Bool: ULOG_ARG_INT, \
+        char: ULOG_ARG_INT, \
+        signed char: ULOG_ARG_INT, \
+        unsigned char: ULOG_ARG_INT, \
+        short: ULOG_ARG_INT, \
+        unsigned short: ULOG_ARG_INT, \
+        int: ULOG_ARG_INT, \
+        unsigned: ULOG_ARG_UINT, \
+        long: ULOG_ARG_LONG, \
+        unsigned long: ULOG_ARG_ULONG, \
+        long long: ULOG_ARG_LLONG, \
+        unsigned long long: ULOG_ARG_ULLONG, \
+        float: ULOG_ARG_DOUBLE, \
+        double: ULOG_ARG_DOUBLE, \
+        long double: ULOG_ARG_LDOUBLE, \
+        char *: ULOG_ARG_STRING, \
+        char const *: ULOG_ARG_STRING, \
+        default: ULOG_ARG_POINTER )
+/* applies ULOG_ARG_TYPE_ to each of up to 32 arguments */
+#  define ULOG_ARG_COUNT_( ... ) \
+    ULOG_ARG_COUNT__( \
+        __VA_ARGS__, \
+        32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17, 16, \
+        15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1 \
+    )
+#  define ULOG_ARG_COUNT__( \
+    _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, \
+    _16, _17, _18, _19, _20, _21, _22, _23, _24, _25, _26, _27, _28, \
+    _29, _30, _31, _32, N, ... \
+) N
+#  define ULOG_ARG_CONCAT_( A, B ) ULOG_ARG_CONCAT__( A, B )
+#  define ULOG_ARG_CONCAT__( A, B ) A ## B ## _
+#  define ULOG_ARG_TYPES_( ... ) \
+    ULOG_ARG_CONCAT_( ULOG_ARG_TYPES_, ULOG_ARG_COUNT_( __VA_ARGS__ )) \
+        ( __VA_ARGS__ )
+#  define ULOG_ARG_TYPES_1_( ARG ) ULOG_ARG_TYPE_( ARG )
+#  define ULOG_ARG_TYPES_2_( ARG, ... ) \
+    ULOG_ARG_TYPE_( ARG ), ULOG_ARG_TYPES_1_( __VA_ARGS__ )
+#  define ULOG_ARG_TYPES_3_( ARG, ... ) \
+    ULOG_ARG_TYPE_( ARG ), ULOG_ARG_TYPES_2_( __VA_ARGS__ )
+#  define ULOG_ARG_TYPES_4_( ARG, ... ) \
+    ULOG_ARG_TYPE_( ARG ), ULOG_ARG_TYPES_3_( __VA_ARGS__ )
+#  define ULOG_ARG_TYPES_5_( ARG, ... ) \
+    ULOG_ARG_TYPE_( ARG ), ULOG_ARG_TYPES_4_( __VA_ARGS__ )
+#  define ULOG_ARG_TYPES_6_( ARG, ... ) \
+    ULOG_ARG_TYPE_( ARG ), ULOG_ARG_TYPES_5_( __VA_ARGS__ )
+#  define ULOG_ARG_TYPES_7_( ARG, ... ) \
+    ULOG_ARG_TYPE_( ARG ), ULOG_ARG_TYPES_6_( __VA_ARGS__ )
+#  define ULOG_ARG_TYPES_8_( ARG, ... ) \
+    ULOG_ARG_TYPE_( ARG ), ULOG_ARG_TYPES_7_( __VA_ARGS__ )
+#  define ULOG_ARG_TYPES_9_( ARG, ... ) \
+    ULOG_ARG_TYPE_( ARG ), ULOG_ARG_TYPES_8_( __VA_ARGS__ )
+#  define ULOG_ARG_TYPES_10_( ARG, ... ) \
+    ULOG_ARG_TYPE_( ARG ), ULOG_ARG_TYPES_9_( __VA_ARGS__ )
+#  define ULOG_ARG_TYPES_11_( ARG, ... ) \
+    ULOG_ARG_TYPE_( ARG ), ULOG_ARG_TYPES_10_( __VA_ARGS__ )
+#  define ULOG_ARG_TYPES_12_( ARG, ... ) \
+    ULOG_ARG_TYPE_( ARG ), ULOG_ARG_TYPES_11_( __VA_ARGS__ )
+#  define ULOG_ARG_TYPES_13_( ARG, ... ) \
+    ULOG_ARG_TYPE_( ARG ), ULOG_ARG_TYPES_12_( __VA_ARGS__ )
+#  define ULOG_ARG_TYPES_14_( ARG, ... ) \
+    ULOG_ARG_TYPE_( ARG ), ULOG_ARG_TYPES_13_( __VA_ARGS__ )
+#  define ULOG_ARG_TYPES_15_( ARG, ... ) \
+    ULOG_ARG_TYPE_( ARG ), ULOG_ARG_TYPES_14_( __VA_ARGS__ )
+#  define ULOG_ARG_TYPES_16_( ARG, ... ) \
+    ULOG_ARG_TYPE_( ARG ), ULOG_ARG_TYPES_15_( __VA_ARGS__ )
+#  define ULOG_ARG_TYPES_17_( ARG, ... ) \
+    ULOG_ARG_TYPE_( ARG ), ULOG_ARG_TYPES_16_( __VA_ARGS__ )
+#  define ULOG_ARG_TYPES_18_( ARG, ... ) \
+    ULOG_ARG_TYPE_( ARG ), ULOG_ARG_TYPES_17_( __VA_ARGS__ )
+#  define ULOG_ARG_TYPES_19_( ARG, ... ) \
+    ULOG_ARG_TYPE_( ARG ), ULOG_ARG_TYPES_18_( __VA_ARGS__ )
+#  define ULOG_ARG_TYPES_20_( ARG, ... ) \
+    ULOG_ARG_TYPE_( ARG ), ULOG_ARG_TYPES_19_( __VA_ARGS__ )
+#  define ULOG_ARG_TYPES_21_( ARG, ... ) \
+    ULOG_ARG_TYPE_( ARG ), ULOG_ARG_TYPES_20_( __VA_ARGS__ )
+#  define ULOG_ARG_TYPES_22_( ARG, ... ) \
+    ULOG_ARG_TYPE_( ARG ), ULOG_ARG_TYPES_21_( __VA_ARGS__ )
+#  define ULOG_ARG_TYPES_23_( ARG, ... ) \
+    ULOG_ARG_TYPE_( ARG ), ULOG_ARG_TYPES_22_( __VA_ARGS__ )
+#  define ULOG_ARG_TYPES_24_( ARG, ... ) \
+    ULOG_ARG_TYPE_( ARG ), ULOG_ARG_TYPES_23_( __VA_ARGS__ )
+#  define ULOG_ARG_TYPES_25_( ARG, ... ) \
+    ULOG_ARG_TYPE_( ARG ), ULOG_ARG_TYPES_24_( __VA_ARGS__ )
+#  define ULOG_ARG_TYPES_26_( ARG, ... ) \
+    ULOG_ARG_TYPE_( ARG ), ULOG_ARG_TYPES_25_( __VA_ARGS__ )
+#  define ULOG_ARG_TYPES_27_( ARG, ... ) \
+    ULOG_ARG_TYPE_( ARG ), ULOG_ARG_TYPES_26_( __VA_ARGS__ )
+#  define ULOG_ARG_TYPES_28_( ARG, ... ) \
+    ULOG_ARG_TYPE_( ARG ), ULOG_ARG_TYPES_27_( __VA_ARGS__ )
+#  define ULOG_ARG_TYPES_29_( ARG, ... ) \
+    ULOG_ARG_TYPE_( ARG ), ULOG_ARG_TYPES_28_( __VA_ARGS__ )
+#  define ULOG_ARG_TYPES_30_( ARG, ... ) \
+    ULOG_ARG_TYPE_( ARG ), ULOG_ARG_TYPES_29_( __VA_ARGS__ )
+#  define ULOG_ARG_TYPES_31_( ARG, ... ) \
+    ULOG_ARG_TYPE_( ARG ), ULOG_ARG_TYPES_30_( __VA_ARGS__ )
+#  define ULOG_ARG_TYPES_32_( ARG, ... ) \
+    ULOG_ARG_TYPE_( ARG ), ULOG_ARG_TYPES_31_( __VA_ARGS__ )
+/* each call site gets its own static state and signature; a statement
+ * expression declares them, so that logging stays an expression of type
+ * void, as it is in C99 and C++, e.g. within ?: or comma operators */
+#  define ULOG_TYPED_( LEVEL, FORMAT, ... ) \
+    __extension__ \
+    ( { \
+        static ulog_callsite ulog_callsite_ = \
+        { \
+            .file = __FILE__, \
+            .line = __LINE__ \
+        }; \
+        if( ulog_site_enabled_( &ulog_callsite_, LEVEL )) \
+        { \
+            static unsigned char const ulog_signature_[] = \
+            { \
+                ULOG_ARG_TYPES_( __VA_ARGS__ ), \
+                ULOG_ARG_END \
+            }; \
+            ulog_site_( \
+                &ulog_callsite_, \
+                ulog_signature_, \
+                LEVEL, \
+                FORMAT, \
+                __VA_ARGS__ \
+            ); \
+        } \
+        ( void ) 0; \
+    } )
+#  define ULOG____( LEVEL, FORMAT, ... ) \
+    ULOG_TYPED_( \
         LEVEL, \
-        "[%c][%"PRIu64"][%s:%s:%u] " FORMAT "%c", \
-        ulog_level_to_char_(LEVEL), \
+        ULOG_HEADER_FORMAT_ FORMAT "%c", \
+        ulog_level_char_(LEVEL), \
         ulog_current_time_(), \
         __FILE__, \
         __func__, \
-        __LINE__, \
+        ( unsigned ) __LINE__, \
         __VA_ARGS__ \
     )
+# else /* C99, C++ or compiler without statement expressions */
+#  define ULOG____( LEVEL, FORMAT, ... ) \
+    ( ulog_enabled_( LEVEL ) \
+        ? ulog_( \
+            LEVEL, \
+            ULOG_HEADER_FORMAT_ FORMAT "%c", \
+            ulog_level_char_(LEVEL), \
+            ulog_current_time_(), \
+            __FILE__, \
+            __func__, \
+            ( unsigned ) __LINE__, \
+            __VA_ARGS__ \
+        ) \
+        : ( void ) 0 )
+# endif /* __STDC_VERSION__ */
 # define ULOG__( LEVEL, ... ) ULOG____( LEVEL, __VA_ARGS__, '\n' )
 /**@}*/
 /**
@@ -104,7 +504,8 @@ ulog_( ulog_level const level, char const * const format, ... );
  * The macros in this group wrap around logging macros. They provide convenient
  * and easy to use way of logging messages. They should be used in way similar
  * to printf, i.e. UDEBUG( "This is a debug message: %s" , "argument" );, with
- * an exception that string format must be a literal string.
+ * an exception that string format must be a literal string. Each of them is
+ * an expression of type void, so it may be an operand of ?: or comma.
  *
  * @{
  */
@@ -161,10 +562,19 @@ ulog_obj;
  * Cleanup frees resources used by ulog framework. The operations using this
  * type allocate or free resources for a static object, therefore they are
  * not thread-safe.
+ * Set up ulog framework survives fork(): before it, loggers finish handing
+ * records over and queued records are delivered, then logging waits until
+ * fork() returns. Records still queued are delivered by the parent only.
+ * The child gets the locks reinitialized and the threads of asynchronous
+ * delivery, of queued handlers and watching control file started again;
+ * the collector of a ring stays the parent, so the child writes into it.
+ * Thread calling fork() from a handler, which holds ulog's lock, deadlocks.
  * Possible status codes:
  * 1. setup:
  *    a. EINVAL - invalid ulog_obj object given;
  *    b. EALREADY - ulog framework already set up;
+ *    c. ENOMEM - cannot allocate memory for handler holder structures or
+ *       register handlers of fork();
  *    d. any status code returned by ulog_mutex's setup() operation.
  * 2. cleanup:
  *    a. EINVAL - invalid ulog_obj object given;
@@ -191,6 +601,51 @@ typedef void
     char const * const format,
     va_list args
 );
+/**
+ * \brief Definition of a log handler taking rendered message in pieces.
+ * \param level Log level.
+ * \param pieces Pieces of the message, to be written in order.
+ * \param count Number of pieces.
+ * \warning Handler implementations must be thread-safe.
+ * \see ulog_level
+ * \see ulog_obj_iovec_op
+ *
+ * Messages logged by wrapper macros are given as six pieces: level and
+ * time, file name, separator, function name, line and message body.
+ * File and function names point directly to strings given by the macros,
+ * the remaining pieces are rendered once per message and shared by all
+ * handlers of this type. Other messages are given as a single piece.
+ * Pieces are suitable for writev(), so no intermediate copy is needed.
+ * They are valid only until the handler returns.
+ */
+typedef void
+( * ulog_iovec_handler_fn )(
+    ulog_level const level,
+    struct iovec const * const pieces,
+    int const count
+);
+/**
+ * \brief Defines type of handler taking messages as binary records.
+ * \param level Log level.
+ * \param record Encoded record, starting with ulog_binary_header.
+ * \param size Size of the record in bytes.
+ * \warning Handler implementations must be thread-safe.
+ * \see ulog_binary_header
+ * \see ulog_binary_decode
+ *
+ * Arguments are copied into the record as they are, according to their
+ * types, without rendering the message. Messages logged without types of
+ * arguments, e.g. in asynchronous mode or from C99 and C++ code, are given
+ * as a record with format "%s" and the rendered message as its argument.
+ * Context of the logging thread follows the arguments, see
+ * ulog_binary_context(). The record is valid only until the handler returns.
+ */
+typedef void
+( * ulog_binary_handler_fn )(
+    ulog_level const level,
+    void const * const record,
+    size_t const size
+);
 /**
  * \brief Defines type of operations for adding or removing a log handler.
  * \param self The ulog_obj object on which we'll operate.
@@ -211,7 +666,8 @@ typedef void
  * 1. add:
  *    a. EINVAL - invalid ulog_obj given;
  *    b. ENOTCONN - ulog framework not initialized;
- *    c. ENOMEM - failed to allocate memory for handler holder structure;
+ *    c. ENOMEM - all handler holder structures preallocated by setup()
+ *       are in use;
  *    d. EEXIST - handler already is on the list of handlers;
  *    e. any status code returned by ulog_mutex's lock() and unlock();
  *    f. any status code returned by ulog_list_ctrl add();
@@ -235,30 +691,650 @@ typedef ulog_status
  * \see ulog_status
  * \see ulog_obj
  * \see ulog_level
- * \see ulog_mutex_op
  *
  * By default the minimum log level is set to DEBUG. This means all logs
  * will reach user-supplied handlers. By setting the minimum log level to
  * a higher value, all logs below it will be ignored and will never reach
  * user handlers. This allows easy setting of global log verbosity. This
- * operation is thread-safe.
+ * operation is thread-safe and takes no locks, so it may be called from
+ * signal handlers.
  * Possible error codes:
  * 1. EINVAL - invalid ulog_obj given;
  * 2. ENOTCONN - ulog framework not initialized;
- * 3. ENODATA - invalid value of verbosity given;
- * 4. any status code returned by ulog_mutex's lock() and unlock().
+ * 3. ENODATA - invalid value of verbosity given.
  */
 typedef ulog_status
 ( * ulog_obj_verbosity_op )(
     ulog_obj const * const self,
     ulog_level const verbosity
 );
+/**
+ * \brief Sets up suppression of consecutive duplicate log messages.
+ * \param self The ulog_obj object on which we'll operate.
+ * \param timeout Time in nanoseconds after which a summary is forced; zero
+ *        disables duplicate suppression.
+ * \return Status object.
+ * \see ulog_status
+ * \see ulog_obj
+ * \see ulog_mutex_op
+ *
+ * By default duplicate suppression is disabled. When enabled, each thread
+ * remembers the last message it logged, identified by a hash of its call
+ * site (file, function, line), level and rendered arguments; the time in
+ * the header is not part of it. Consecutive identical messages logged by
+ * the same thread are not passed to handlers. Instead, when a different
+ * message arrives, or when a duplicate arrives timeout nanoseconds after
+ * the original message or the previous summary, handlers receive a message
+ * "last message repeated N times" from the call site of the suppressed
+ * message. The state is a small fixed-size per-thread record, taken from
+ * a pool of ULOG_DEDUP_THREADS records allocated by the first call of this
+ * operation which enables it; threads logging while all records are taken
+ * aren't suppressed. Messages are rendered once, both to be compared and
+ * to be delivered. Records of all threads are listed: a summary pending in
+ * a thread which stopped logging is emitted by any other thread logging
+ * once timeout passes, and summaries of all threads are emitted by this
+ * operation and by cleanup(). This operation is thread-safe.
+ * Possible error codes:
+ * 1. EINVAL - invalid ulog_obj given;
+ * 2. ENOTCONN - ulog framework not initialized;
+ * 3. ENOMEM - cannot allocate records or none is left for calling thread;
+ * 4. any status code returned by ulog_mutex's lock() and unlock().
+ */
+typedef ulog_status
+( * ulog_obj_dedup_op )(
+    ulog_obj const * const self,
+    uint64_t const timeout
+);
+/**
+ * \brief Maximum size of a record rendered for asynchronous delivery.
+ *
+ * Includes terminating NUL; longer records are truncated.
+ */
+# define ULOG_RECORD_SIZE 512U
+/**
+ * \brief Defines what asynchronous logging does when its buffers are full.
+ */
+typedef enum
+{
+    /** Wait for a free buffer at most timeout, then drop the record. */
+    ULOG_BLOCK,
+    /** Drop the record being logged. */
+    ULOG_DROP_NEWEST,
+    /** Drop the oldest record still waiting for delivery. */
+    ULOG_DROP_OLDEST,
+    /** Write the record to overflow file, bypassing handlers. */
+    ULOG_SPILL
+}
+ulog_async_policy;
+/**
+ * \brief Configuration of asynchronous logging.
+ * \see ulog_async_policy
+ */
+typedef struct
+{
+    /** Number of records which may wait for delivery. */
+    size_t capacity;
+    /** Behaviour when capacity is exhausted. */
+    ulog_async_policy policy;
+    /** Nanoseconds to wait with ULOG_BLOCK; UINT64_MAX waits forever. */
+    uint64_t timeout;
+    /** Path of file to append spilled records to with ULOG_SPILL. */
+    char const * overflow;
+    /** Nanoseconds after which delivery is deemed stalled; zero never. */
+    uint64_t stall;
+}
+ulog_async_config;
+/**
+ * \brief Counters of asynchronous logging.
+ */
+typedef struct
+{
+    /** Records passed to handlers. */
+    uint64_t delivered;
+    /** Records lost because of back-pressure policy. */
+    uint64_t dropped;
+    /** Records written to overflow file. */
+    uint64_t spilled;
+    /** Deliveries which took at least stall nanoseconds. */
+    uint64_t stalls;
+    /** Whether delivery in progress takes at least stall nanoseconds. */
+    bool stalled;
+}
+ulog_async_counters;
+/**
+ * \brief Switches between synchronous and asynchronous logging.
+ * \param self The ulog_obj object on which we'll operate.
+ * \param config Configuration of asynchronous logging, or NULL to log
+ *        synchronously again.
+ * \return Status object.
+ * \see ulog_status
+ * \see ulog_obj
+ * \see ulog_async_config
+ * \see ulog_obj_counters_op
+ *
+ * By default each log message is passed to all handlers by the thread
+ * which logs it, under ulog_obj's mutex. In asynchronous mode the logging
+ * thread only renders the message into one of config->capacity buffers
+ * allocated by this operation and queues it without taking any lock. A
+ * background thread passes queued messages to handlers as a single "%s"
+ * argument. When all buffers are waiting for delivery, config->policy
+ * decides whether the logging thread waits (ULOG_BLOCK), loses the new
+ * message (ULOG_DROP_NEWEST), replaces the oldest queued one with it
+ * (ULOG_DROP_OLDEST) or appends it to config->overflow (ULOG_SPILL).
+ * Switching modes delivers all queued messages first. This operation
+ * changes resources used by logging threads, therefore it's not
+ * thread-safe.
+ * Possible error codes:
+ * 1. EINVAL - invalid ulog_obj or configuration given;
+ * 2. ENOTCONN - ulog framework not initialized;
+ * 3. any status code returned by ulog_async's setup() and cleanup().
+ */
+typedef THREADUNSAFE ulog_status
+( * ulog_obj_async_op )(
+    ulog_obj const * const self,
+    ulog_async_config const * const config
+);
+/**
+ * \brief Reads counters of asynchronous logging.
+ * \param self The ulog_obj object on which we'll operate.
+ * \param counters Receives values of counters.
+ * \return Status object.
+ * \see ulog_status
+ * \see ulog_obj
+ * \see ulog_async_counters
+ *
+ * Counters are updated atomically and may be read at any time. They
+ * describe the current asynchronous mode; synchronous logging reports
+ * zeros. This operation is thread-safe.
+ * Possible error codes:
+ * 1. EINVAL - invalid ulog_obj given;
+ * 2. ENOTCONN - ulog framework not initialized;
+ * 3. ENODATA - invalid pointer to counters given.
+ */
+typedef ulog_status
+( * ulog_obj_counters_op )(
+    ulog_obj const * const self,
+    ulog_async_counters * const counters
+);
+/**
+ * \brief Default number of handlers which may be registered at once.
+ */
+# define ULOG_DEFAULT_HANDLERS 16U
+/**
+ * \brief Configuration of resources preallocated by ulog framework.
+ * \see ulog_obj_configure_op
+ */
+typedef struct
+{
+    /** Maximum number of handlers registered at once. */
+    size_t handlers;
+    /** No longer used, handlers are always guarded by adaptive mutex. */
+    bool adaptive;
+    /** Whether to collect statistics. */
+    bool stats;
+    /** Interval of statistics reports in nanoseconds, zero disables them. */
+    uint64_t stats_period;
+}
+ulog_obj_config;
+/**
+ * \brief Sets limits of resources allocated by setup() operation.
+ * \param self The ulog_obj object on which we'll operate.
+ * \param config Resource limits.
+ * \return Status object.
+ * \see ulog_status
+ * \see ulog_obj
+ * \see ulog_obj_config
+ *
+ * All memory used by ulog framework is allocated by setup() (and, for
+ * asynchronous logging, by async()) according to the limits given here,
+ * which stay in effect until changed. Afterwards adding and removing
+ * handlers or logging messages doesn't call malloc() or free(). This
+ * operation may only be called before setup(); by default up to
+ * ULOG_DEFAULT_HANDLERS handlers may be registered. Handlers are guarded by
+ * adaptive mutex, which logging threads hold shared, so that they don't
+ * exclude each other; thus handlers may be called by several threads at
+ * once and must be thread-safe themselves. Setting stats flag
+ * makes ulog framework collect statistics, which may be read by stats()
+ * operation and, if stats_period is not zero, are also reported as INFO
+ * messages by the first call to ulog_() after each period. To measure
+ * their length, messages are then rendered once and given to handlers,
+ * files or asynchronous channel as text with format "%s", as handlers get
+ * them in asynchronous mode. Statistics are disabled by default. This operation changes static configuration,
+ * therefore it's not thread-safe.
+ * Possible error codes:
+ * 1. EINVAL - invalid ulog_obj or configuration given;
+ * 2. EBUSY - ulog framework already set up.
+ */
+typedef THREADUNSAFE ulog_status
+( * ulog_obj_configure_op )(
+    ulog_obj const * const self,
+    ulog_obj_config const * const config
+);
+/**
+ * \brief Number of buckets of handler latency histogram.
+ * \see ulog_stats_bucket_start
+ */
+# define ULOG_STATS_BUCKETS 128U
+/**
+ * \brief Statistics of a single handler.
+ */
+typedef struct
+{
+    /** The handler. */
+    ulog_handler_fn handler;
+    /** Number of calls. */
+    uint64_t calls;
+    /** Histogram of call latencies, in nanoseconds. */
+    uint64_t latency[ ULOG_STATS_BUCKETS ];
+}
+ulog_handler_stats;
+/**
+ * \brief Statistics of ulog framework.
+ * \see ulog_obj_stats_op
+ */
+typedef struct
+{
+    /** Messages accepted by verbosity filter, indexed by ulog_level. */
+    uint64_t messages[ ULOG_LEVELS ];
+    /** Messages rejected by verbosity filter. */
+    uint64_t suppressed;
+    /** Total length of messages delivered to handlers. */
+    uint64_t bytes;
+    /** Number of elements of handler array, replaced with number filled. */
+    size_t handlers;
+    /** Array receiving statistics of handlers, may be NULL if none fit. */
+    ulog_handler_stats * handler;
+}
+ulog_stats;
+/**
+ * \brief Reads statistics of ulog framework.
+ * \param self The ulog_obj object on which we'll operate.
+ * \param stats Receives statistics.
+ * \return Status object.
+ * \see ulog_status
+ * \see ulog_obj
+ * \see ulog_stats
+ *
+ * Statistics are collected since setup(), only if enabled by configure().
+ * Counters are kept per thread group and summed here, so concurrently
+ * logged messages may or may not be included. Before calling, handlers
+ * field must hold the number of elements of the handler array.
+ * Possible error codes:
+ * 1. EINVAL - invalid ulog_obj given;
+ * 2. ENOTCONN - ulog framework not initialized;
+ * 3. ENODATA - invalid pointer to statistics given;
+ * 4. ENOTSUP - statistics are disabled;
+ * 5. ENOBUFS - more handlers than elements of the array; the array is
+ *    filled anyway.
+ */
+typedef ulog_status
+( * ulog_obj_stats_op )(
+    ulog_obj const * const self,
+    ulog_stats * const stats
+);
+/**
+ * \brief Returns the lowest latency counted in histogram bucket.
+ * \param index Index of the bucket.
+ * \return Latency in nanoseconds.
+ * \see ulog_handler_stats
+ *
+ * Each power of two is split into four buckets, thus the bucket's range
+ * spans at most 25% of its lowest value. The last bucket also counts all
+ * latencies higher than its range.
+ */
+ULOG_EXPORT uint64_t
+ulog_stats_bucket_start( size_t const index );
+/**
+ * \brief Estimates latency percentile of handler calls.
+ * \param stats Statistics of the handler.
+ * \param fraction Requested percentile, e.g. 0.99.
+ * \return Start of bucket holding requested percentile, in nanoseconds.
+ */
+ULOG_EXPORT uint64_t
+ulog_stats_percentile(
+    ulog_handler_stats const * const stats,
+    double const fraction
+);
+/**
+ * \brief Adds handler called on its own thread.
+ * \param self The ulog_obj object on which we'll operate.
+ * \param handler Handler function.
+ * \param config Configuration of handler's queue.
+ * \return Status object.
+ * \see ulog_status
+ * \see ulog_obj
+ * \see ulog_async_config
+ *
+ * Works like add(), but messages are rendered into the handler's own
+ * queue, which is drained by the handler's own worker thread. Thus a slow
+ * handler holds up neither logging threads nor other handlers; when its
+ * queue fills up, config's policy decides which messages are lost. Each
+ * queue has its own capacity and policy. If config's stall is not zero,
+ * the handler's calls taking longer are reported by handler_counters().
+ * Removing the handler delivers messages still in its queue. Queue and
+ * worker are allocated here, unlike resources of add().
+ * Possible error codes:
+ * 1. EINVAL - invalid ulog_obj or queue configuration given;
+ * 2. ENOTCONN - ulog framework not initialized;
+ * 3. EEXIST - handler already registered;
+ * 4. ENOMEM - too many handlers or no memory for the queue;
+ * 5. EIO - failure opening overflow file or starting the worker.
+ */
+typedef ulog_status
+( * ulog_obj_add_async_op )(
+    ulog_obj const * const self,
+    ulog_handler_fn const handler,
+    ulog_async_config const * const config
+);
+/**
+ * \brief Reads counters of handler's queue.
+ * \param self The ulog_obj object on which we'll operate.
+ * \param handler Registered handler.
+ * \param counters Receives values of counters.
+ * \return Status object.
+ * \see ulog_status
+ * \see ulog_obj
+ * \see ulog_obj_add_async_op
+ * \see ulog_async_counters
+ *
+ * Counters of handlers added by add() are all zero.
+ * Possible error codes:
+ * 1. EINVAL - invalid ulog_obj given;
+ * 2. ENOTCONN - ulog framework not initialized;
+ * 3. ENODATA - invalid pointer to counters given;
+ * 4. ENOENT - handler not registered.
+ */
+typedef ulog_status
+( * ulog_obj_handler_counters_op )(
+    ulog_obj const * const self,
+    ulog_handler_fn const handler,
+    ulog_async_counters * const counters
+);
+/**
+ * \brief Defines type of operations for adding or removing iovec handler.
+ * \param self The ulog_obj object on which we'll operate.
+ * \param handler Handler for log messages.
+ * \return Status object.
+ * \see ulog_status
+ * \see ulog_obj
+ * \see ulog_iovec_handler_fn
+ * \see ulog_obj_op
+ *
+ * These operations work like add() and remove(), with the same error
+ * codes, but for handlers which take messages rendered into pieces.
+ * Bodies longer than ULOG_RECORD_SIZE are truncated. In asynchronous
+ * logging messages are already rendered, so they're given in one piece.
+ */
+typedef ulog_status
+( * ulog_obj_iovec_op )(
+    ulog_obj const * const self,
+    ulog_iovec_handler_fn const handler
+);
+/**
+ * \brief Defines type of operations on handlers taking binary records.
+ * \param self The ulog_obj object on which we'll operate.
+ * \param handler Handler for binary records.
+ * \return Status object.
+ * \see ulog_status
+ * \see ulog_obj
+ * \see ulog_binary_handler_fn
+ * \see ulog_obj_op
+ *
+ * These operations work like add() and remove(), with the same error
+ * codes, but for handlers which take binary records. Records longer than
+ * ULOG_RECORD_SIZE have their strings truncated.
+ */
+typedef ulog_status
+( * ulog_obj_binary_op )(
+    ulog_obj const * const self,
+    ulog_binary_handler_fn const handler
+);
+/**
+ * \brief Maximum number of call site rules.
+ */
+# define ULOG_CALLSITE_RULES 16U
+/**
+ * \brief Maximum length of file name in call site rule.
+ */
+# define ULOG_CALLSITE_PATTERN 64U
+/**
+ * \brief Defines type of operation setting state of call sites.
+ * \param self The ulog_obj object on which we'll operate.
+ * \param pattern File name, optionally followed by ':' and line number;
+ * NULL removes all rules.
+ * \param state State of matching call sites; ULOG_CALLSITE_DEFAULT removes
+ * rule with the same pattern.
+ * \return Status object.
+ * \see ulog_status
+ * \see ulog_obj
+ * \see ulog_callsite_state
+ *
+ * File name matches call sites whose file ends with it at path component
+ * boundary, "*" matches all call sites. When several rules match, the one
+ * set last wins. Call sites re-evaluate rules once after each change, until
+ * then they keep their previous state. Only call sites compiled by GCC or
+ * Clang as C11 or C++ have state; others always log according to
+ * verbosity.
+ * Possible error codes:
+ * 1. EINVAL - invalid ulog_obj given;
+ * 2. ENOTCONN - ulog framework not initialized;
+ * 3. ENODATA - invalid pattern or state given;
+ * 4. ENOBUFS - there are already ULOG_CALLSITE_RULES rules;
+ * 5. any status code returned by ulog_mutex's lock() and unlock().
+ */
+typedef ulog_status
+( * ulog_obj_callsite_op )(
+    ulog_obj const * const self,
+    char const * const pattern,
+    ulog_callsite_state const state
+);
+/**
+ * \brief Definition of control channels configuration.
+ * \see ulog_obj_control_op
+ */
+typedef struct
+{
+    /** Whether SIGUSR1 and SIGUSR2 step verbosity up and down. */
+    bool signals;
+    /** Control file watched for changes, NULL for none. */
+    char const * file;
+}
+ulog_control_config;
+/**
+ * \brief Defines type of operation setting up control channels.
+ * \param self The ulog_obj object on which we'll operate.
+ * \param config Channels to open, NULL to close all of them.
+ * \return Status object.
+ * \see THREADUNSAFE
+ * \see ulog_status
+ * \see ulog_obj
+ * \see ulog_control_config
+ *
+ * Lets verbosity and call sites be changed from outside of the process.
+ * SIGUSR1 makes verbosity one level more verbose, SIGUSR2 one level less;
+ * previous handlers of these signals are restored when channels are closed.
+ * Control file is read now and whenever it's written or replaced, on
+ * a thread of its own. Each of its lines is one of:
+ * 1. "verbosity LEVEL", where LEVEL is ERROR, WARNING, INFO or DEBUG,
+ * 2. "callsite PATTERN STATE", where STATE is on, off or default,
+ * 3. empty or starting with '#'.
+ * Call site rules are replaced by those in the file on each read. Invalid
+ * lines are skipped. Channels already open are closed first.
+ * Possible error codes:
+ * 1. EINVAL - invalid ulog_obj given;
+ * 2. ENOTCONN - ulog framework not initialized;
+ * 3. ENOTSUP - control file given, but not supported on this platform;
+ * 4. EIO - failure installing signal handlers, watching the file or
+ * starting the thread.
+ */
+typedef THREADUNSAFE ulog_status
+( * ulog_obj_control_op )(
+    ulog_obj const * const self,
+    ulog_control_config const * const config
+);
+/**
+ * \brief Defines type of operation sharing control with other processes.
+ * \param self The ulog_obj object on which we'll operate.
+ * \param name Name of shared memory object, as in shm_open(); NULL stops
+ * sharing.
+ * \return Status object.
+ * \see THREADUNSAFE
+ * \see ulog_status
+ * \see ulog_obj
+ * \see ulog_fast_state
+ *
+ * Maps named page of shared memory and points ulog_fast_ to it, creating it
+ * with current verbosity if it doesn't exist yet, so logging macros keep
+ * checking verbosity inline. While shared, verbosity is the one of the
+ * page: changing it changes it for all processes sharing the page, and
+ * statistics don't count messages suppressed by it. Call sites whose bits
+ * are set in the page log regardless of verbosity and rules, see shared.h
+ * and ulogctl. When sharing stops, the process keeps verbosity it had. Name
+ * already shared is replaced.
+ * Possible error codes:
+ * 1. EINVAL - invalid ulog_obj given;
+ * 2. ENOTCONN - ulog framework not initialized;
+ * 3. ENODATA - invalid name given;
+ * 4. EIO - failure opening or mapping the page, or it isn't ulog's.
+ */
+typedef THREADUNSAFE ulog_status
+( * ulog_obj_share_op )(
+    ulog_obj const * const self,
+    char const * const name
+);
+/**
+ * \brief Default nanoseconds after which collector skips unfinished record.
+ * \see ulog_ring_config
+ */
+# define ULOG_RING_TIMEOUT 1000000000U
+/**
+ * \brief Configuration of logging through ring shared by processes.
+ * \see ulog_obj_ring_op
+ */
+typedef struct
+{
+    /** Name of shared memory object, as in shm_open(). */
+    char const * name;
+    /** Number of records in the ring, rounded up to power of two. */
+    size_t capacity;
+    /** Whether this process collects records instead of writing them. */
+    bool collect;
+    /** Nanoseconds before unfinished record is skipped, zero for default. */
+    uint64_t timeout;
+}
+ulog_ring_config;
+/**
+ * \brief Defines type of operation logging through ring shared by processes.
+ * \param self The ulog_obj object on which we'll operate.
+ * \param config Ring to use, NULL to stop using it.
+ * \return Status object.
+ * \see THREADUNSAFE
+ * \see ulog_status
+ * \see ulog_obj
+ * \see ulog_ring_config
+ *
+ * Many processes, e.g. pre-forked workers, write records into one ring of
+ * shared memory and a single collector passes them to its handlers, so they
+ * form one ordered stream and producers do no I/O. Producers render each
+ * message straight into a slot reserved with a compare-and-swap, without
+ * locks or system calls, and never wait: when the ring is full, the message
+ * is dropped. Collector passes records to its handlers as a single "%s"
+ * argument on a thread of its own; its own messages go to handlers directly.
+ * A producer dying between reservation and commit of a record would stop
+ * collection, so such record is skipped after config->timeout. The ring is
+ * created by whichever process comes first; all of them must use the same
+ * capacity. Only one live collector may use a ring at a time. The ring
+ * outlives processes until its name is removed, e.g. with
+ * ulog_shared_remove(). Records queued by collector are delivered before
+ * it stops.
+ * Possible error codes:
+ * 1. EINVAL - invalid ulog_obj or configuration given;
+ * 2. ENOTCONN - ulog framework not initialized;
+ * 3. any status code returned by ulog_ring's setup() and cleanup().
+ */
+typedef THREADUNSAFE ulog_status
+( * ulog_obj_ring_op )(
+    ulog_obj const * const self,
+    ulog_ring_config const * const config
+);
+/**
+ * \brief Default number of bytes buffered by each thread writing its file.
+ * \see ulog_files_config
+ */
+# define ULOG_FILES_BUFFER ( 64U * 1024U )
+/**
+ * \brief Configuration of logging into file of each thread.
+ * \see ulog_obj_files_op
+ */
+typedef struct
+{
+    /** Beginning of paths of files, which end with ".<thread ID>.log". */
+    char const * base;
+    /** Bytes buffered by each thread, zero for ULOG_FILES_BUFFER. */
+    size_t buffer;
+    /** Whether buffers are compressed, paths end with ".<thread ID>.ulz". */
+    bool compress;
+    /** Whether records are interned, uncompressed paths end with ".uli". */
+    bool interned;
+}
+ulog_files_config;
+/**
+ * \brief Defines type of operation logging into file of each thread.
+ * \param self The ulog_obj object on which we'll operate.
+ * \param config Files to use, NULL to stop using them.
+ * \return Status object.
+ * \see THREADUNSAFE
+ * \see ulog_status
+ * \see ulog_obj
+ * \see ulog_files_config
+ *
+ * Each logging thread renders its records into a buffer of its own and
+ * writes them into a file of its own, e.g. "base.1234.log", opened with its
+ * first record. Threads don't contend for any buffer, descriptor or lock,
+ * so logging doesn't serialize them; records are ordered by time again with
+ * ulog_merge(). Records go to the files instead of handlers, ring and
+ * asynchronous channel. Buffer is written when it fills up and when its
+ * thread exits; buffers of all threads are written when the files stop
+ * being used, including by cleanup. Child process after fork() leaves
+ * files of the parent to it and opens its own.
+ * Compressed files trade processor time for disk bandwidth: full buffer is
+ * handed to a background thread, which writes it as a block made with
+ * ulog_compress_block(), while its thread fills a second buffer. Blocks are
+ * read back with ulog_decompress(), as ulog_grep() and ulog_merge() do.
+ * Interned files hold binary records encoded with ulog_intern_encode(), so
+ * that strings repeated by records are written once per checkpoint instead
+ * of rendered each time; they're read back as text by ulog-decode, as well
+ * as by ulog_grep() and ulog_merge(). Both may be compressed.
+ * Possible error codes:
+ * 1. EINVAL - invalid ulog_obj or configuration given;
+ * 2. ENOTCONN - ulog framework not initialized;
+ * 3. any status code returned by ulog_files' setup() and cleanup().
+ */
+typedef THREADUNSAFE ulog_status
+( * ulog_obj_files_op )(
+    ulog_obj const * const self,
+    ulog_files_config const * const config
+);
 /**
  * \brief Table of operations for ulog_obj.
  * \see ulog_obj_op_table
  * \see ulog_obj_ctrl_op
  * \see ulog_obj_op
  * \see ulog_obj_verbosity_op
+ * \see ulog_obj_dedup_op
+ * \see ulog_obj_async_op
+ * \see ulog_obj_counters_op
+ * \see ulog_obj_configure_op
+ * \see ulog_obj_stats_op
+ * \see ulog_obj_add_async_op
+ * \see ulog_obj_handler_counters_op
+ * \see ulog_obj_iovec_op
+ * \see ulog_obj_binary_op
+ * \see ulog_obj_callsite_op
+ * \see ulog_obj_control_op
+ * \see ulog_obj_share_op
+ * \see ulog_obj_ring_op
+ * \see ulog_obj_files_op
  */
 struct ulog_obj_op_table_struct
 {
@@ -272,12 +1348,44 @@ struct ulog_obj_op_table_struct
     ulog_obj_op const remove;
     /** Sets minimum log verbosity. */
     ulog_obj_verbosity_op const verbosity;
+    /** Sets up suppression of duplicate messages. */
+    ulog_obj_dedup_op const dedup;
+    /** Switches between synchronous and asynchronous logging. */
+    ulog_obj_async_op const async;
+    /** Reads counters of asynchronous logging. */
+    ulog_obj_counters_op const counters;
+    /** Sets limits of preallocated resources. */
+    ulog_obj_configure_op const configure;
+    /** Reads statistics. */
+    ulog_obj_stats_op const stats;
+    /** Adds handler called on its own thread. */
+    ulog_obj_add_async_op const add_async;
+    /** Reads counters of handler's queue. */
+    ulog_obj_handler_counters_op const handler_counters;
+    /** Adds handler taking messages in pieces. */
+    ulog_obj_iovec_op const add_iovec;
+    /** Removes handler taking messages in pieces. */
+    ulog_obj_iovec_op const remove_iovec;
+    /** Adds handler taking binary records. */
+    ulog_obj_binary_op const add_binary;
+    /** Removes handler taking binary records. */
+    ulog_obj_binary_op const remove_binary;
+    /** Sets state of call sites. */
+    ulog_obj_callsite_op const callsite;
+    /** Sets up control channels. */
+    ulog_obj_control_op const control;
+    /** Shares control with other processes. */
+    ulog_obj_share_op const share;
+    /** Logs through ring shared by processes. */
+    ulog_obj_ring_op const ring;
+    /** Logs into file of each thread. */
+    ulog_obj_files_op const files;
 };
 /**
  * \brief Returns the ulog_obj controlling ulog framework.
  * \return Pointer to singular static instance of ulog_obj.
  */
-ulog_obj const *
+ULOG_EXPORT ulog_obj const *
 ulog_obj_get( void );
 
 # ifdef __cplusplus
@@ -0,0 +1,517 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       C++ front-end of logging facilities.
+ * \date        2016/04/30 10:22:05 AM
+ * \file        ulog.hpp
+ * \version     1.0
+ *
+ * Including this header instead of ulog.h makes UERROR, UWARNING, UINFO and
+ * UDEBUG check their format against the arguments at compile time, then
+ * pass the arguments along with their types to the same ulog_site_() used
+ * by C code. Requires C++17.
+ **/
+
+#ifndef ULOG_HPP__
+# define ULOG_HPP__
+
+# include <ulog/context.h> /* ulog_context_pop, ulog_context_push */
+# include <ulog/trace.h> /* UTRACE_BEGIN, UTRACE_END */
+# include <ulog/ulog.h> /* ulog_site_, ulog_arg_type, ulog_level */
+
+# include <cstddef> /* std::nullptr_t, std::ptrdiff_t, std::size_t */
+# include <cstdint> /* std::intmax_t */
+# include <cstring> /* std::memcpy */
+# include <string> /* std::string */
+# include <string_view> /* std::string_view */
+# include <type_traits> /* std::decay_t, std::is_* */
+
+namespace ulog
+{
+namespace detail
+{
+
+/**
+ * \brief Always false, for static_assert depending on template parameter.
+ */
+template< typename T >
+constexpr bool unsupported = false;
+
+/**
+ * \brief Maps type of an argument to ulog_arg_type, after promotions.
+ * \return Type of argument as passed through variadic call.
+ *
+ * Strings, string views and pointers to characters are passed as strings,
+ * enumerations as their underlying type.
+ */
+template< typename T >
+constexpr ulog_arg_type
+type_of()
+{
+    using U = std::decay_t< T >;
+    if constexpr( std::is_enum_v< U > )
+    {
+        return type_of< std::underlying_type_t< U > >();
+    }
+    else if constexpr(
+        std::is_same_v< U, char * >
+        || std::is_same_v< U, char const * >
+        || std::is_same_v< U, std::string >
+        || std::is_same_v< U, std::string_view >
+    )
+    {
+        return ULOG_ARG_STRING;
+    }
+    else if constexpr(
+        std::is_pointer_v< U > || std::is_same_v< U, std::nullptr_t >
+    )
+    {
+        return ULOG_ARG_POINTER;
+    }
+    else if constexpr(
+        std::is_same_v< U, float > || std::is_same_v< U, double >
+    )
+    {
+        return ULOG_ARG_DOUBLE;
+    }
+    else if constexpr( std::is_same_v< U, long double > )
+    {
+        return ULOG_ARG_LDOUBLE;
+    }
+    else if constexpr(
+        std::is_integral_v< U > && ( sizeof( U ) < sizeof( int ))
+    )
+    {
+        return ULOG_ARG_INT;
+    }
+    else if constexpr( std::is_same_v< U, int > ) { return ULOG_ARG_INT; }
+    else if constexpr( std::is_same_v< U, unsigned > ) { return ULOG_ARG_UINT; }
+    else if constexpr( std::is_same_v< U, long > ) { return ULOG_ARG_LONG; }
+    else if constexpr( std::is_same_v< U, unsigned long > )
+    {
+        return ULOG_ARG_ULONG;
+    }
+    else if constexpr( std::is_same_v< U, long long > )
+    {
+        return ULOG_ARG_LLONG;
+    }
+    else if constexpr( std::is_same_v< U, unsigned long long > )
+    {
+        return ULOG_ARG_ULLONG;
+    }
+    else
+    {
+        static_assert( unsupported< T >, "type can't be logged" );
+        return ULOG_ARG_END;
+    }
+}
+
+/**
+ * \brief Returns size of a type passed as argument.
+ * \param type Type of argument.
+ * \return Size in bytes, zero for non-integer types.
+ */
+constexpr std::size_t
+integer_size( ulog_arg_type const type )
+{
+    switch( type )
+    {
+        case ULOG_ARG_INT: return sizeof( int );
+        case ULOG_ARG_UINT: return sizeof( unsigned );
+        case ULOG_ARG_LONG: return sizeof( long );
+        case ULOG_ARG_ULONG: return sizeof( unsigned long );
+        case ULOG_ARG_LLONG: return sizeof( long long );
+        case ULOG_ARG_ULLONG: return sizeof( unsigned long long );
+        default: return 0U;
+    }
+}
+
+/**
+ * \brief Returns size of integer expected by a length modifier.
+ * \param modifier Length modifier, e.g. "ll", possibly empty.
+ * \return Size in bytes, zero if modifier is unknown.
+ */
+constexpr std::size_t
+modifier_size( std::string_view const modifier )
+{
+    if( modifier.empty() || ( 'h' == modifier[ 0 ] )) { return sizeof( int ); }
+    if( "l" == modifier ) { return sizeof( long ); }
+    if(( "ll" == modifier ) || ( "q" == modifier ))
+    {
+        return sizeof( long long );
+    }
+    if( "j" == modifier ) { return sizeof( std::intmax_t ); }
+    if( "z" == modifier ) { return sizeof( std::size_t ); }
+    if( "t" == modifier ) { return sizeof( std::ptrdiff_t ); }
+    return 0U;
+}
+
+/**
+ * \brief Checks whether argument matches a conversion.
+ * \param conversion Conversion character, e.g. 'd'.
+ * \param modifier Length modifier, possibly empty.
+ * \param type Type of argument.
+ * \return True if printf would accept the argument.
+ */
+constexpr bool
+compatible(
+    char const conversion,
+    std::string_view const modifier,
+    ulog_arg_type const type
+)
+{
+    std::string_view const integers = "diouxXc";
+    std::string_view const floats = "fFeEgGaA";
+    if( std::string_view::npos != integers.find( conversion ))
+    {
+        return
+            ( 0U != integer_size( type ))
+            && ( modifier_size( modifier ) == integer_size( type ));
+    }
+    if( std::string_view::npos != floats.find( conversion ))
+    {
+        return ( "L" == modifier )
+            ? ( ULOG_ARG_LDOUBLE == type )
+            : (( modifier.empty() || ( "l" == modifier ))
+                && ( ULOG_ARG_DOUBLE == type ));
+    }
+    if( 's' == conversion )
+    {
+        return modifier.empty() && ( ULOG_ARG_STRING == type );
+    }
+    if( 'p' == conversion )
+    {
+        return modifier.empty() && ( ULOG_ARG_POINTER == type );
+    }
+    return false;
+}
+
+/**
+ * \brief Checks format against types of arguments.
+ * \param format Formatting string, as in printf.
+ * \param types Types of arguments.
+ * \param count Number of arguments.
+ * \return True if each conversion has matching argument and none is left.
+ *
+ * '*' width and precision take an int argument. %n isn't supported.
+ */
+constexpr bool
+matches(
+    std::string_view const format,
+    ulog_arg_type const * const types,
+    std::size_t const count
+)
+{
+    std::size_t argument = 0U;
+    std::size_t i = 0U;
+    while( i < format.size())
+    {
+        if( '%' != format[ i++ ] ) { continue; }
+        if(( i < format.size()) && ( '%' == format[ i ] ))
+        {
+            ++i;
+            continue;
+        }
+        std::string_view const flags = "-+ #0'";
+        while(
+            ( i < format.size()) && ( flags.npos != flags.find( format[ i ] ))
+        )
+        {
+            ++i;
+        }
+        for( int part = 0; part < 2; ++part )
+        {
+            if(( i < format.size()) && ( '*' == format[ i ] ))
+            {
+                if(
+                    ( count <= argument )
+                    || ( ULOG_ARG_INT != types[ argument ] )
+                )
+                {
+                    return false;
+                }
+                ++argument;
+                ++i;
+            }
+            while(
+                ( i < format.size())
+                && ( '0' <= format[ i ] )
+                && ( '9' >= format[ i ] )
+            )
+            {
+                ++i;
+            }
+            if(( 0 == part ) && ( i < format.size()) && ( '.' == format[ i ] ))
+            {
+                ++i;
+            }
+            else
+            {
+                break;
+            }
+        }
+        std::string_view const modifiers = "hlLqjzt";
+        std::size_t const start = i;
+        while(
+            ( i < format.size())
+            && ( modifiers.npos != modifiers.find( format[ i ] ))
+        )
+        {
+            ++i;
+        }
+        if(( format.size() <= i ) || ( count <= argument )) { return false; }
+        if(
+            !compatible(
+                format[ i ],
+                format.substr( start, i - start ),
+                types[ argument ]
+            )
+        )
+        {
+            return false;
+        }
+        ++argument;
+        ++i;
+    }
+    return count == argument;
+}
+
+/**
+ * \brief Checks format against types of arguments.
+ * \param format Formatting string, as in printf.
+ * \return True if format matches the arguments.
+ */
+template< typename... Args >
+constexpr bool
+matches( std::string_view const format )
+{
+    constexpr ulog_arg_type types[] = { type_of< Args >()..., ULOG_ARG_END };
+    return matches( format, types, sizeof...( Args ));
+}
+
+/**
+ * \brief Buffer for strings which have to be zero-terminated.
+ *
+ * Lives on the stack of the logging call, so string views are passed
+ * without any heap allocation. Strings which don't fit are truncated,
+ * those past a full arena are passed as empty strings.
+ */
+struct arena
+{
+    /** Storage for strings. */
+    char data[ ULOG_RECORD_SIZE ];
+    /** Bytes of storage in use. */
+    std::size_t used;
+};
+
+/**
+ * \brief Copies string view into arena as zero-terminated string.
+ * \param strings The arena.
+ * \param value String to copy.
+ * \return Pointer to zero-terminated copy.
+ */
+inline char const *
+store( arena & strings, std::string_view const value )
+{
+    static char const empty[] = "";
+    if( strings.used >= sizeof( strings.data ))
+    {
+        return empty;
+    }
+    std::size_t const room = sizeof( strings.data ) - strings.used - 1U;
+    std::size_t const length = ( value.size() < room ) ? value.size() : room;
+    char * const copy = strings.data + strings.used;
+    std::memcpy( copy, value.data(), length );
+    copy[ length ] = '\0';
+    strings.used += length + 1U;
+    return copy;
+}
+
+/**
+ * \brief Converts argument to the type passed through variadic call.
+ * \param value The argument.
+ * \param strings Arena for string views.
+ * \return Argument of type matching type_of< T >().
+ */
+template< typename T >
+inline auto
+pass( T const & value, [[maybe_unused]] arena & strings )
+{
+    using U = std::decay_t< T >;
+    if constexpr( std::is_same_v< U, std::string > )
+    {
+        return value.c_str();
+    }
+    else if constexpr( std::is_same_v< U, std::string_view > )
+    {
+        return store( strings, value );
+    }
+    else if constexpr( std::is_enum_v< U > )
+    {
+        using V = std::underlying_type_t< U >;
+        return pass( static_cast< V >( value ), strings );
+    }
+    else if constexpr(
+        std::is_integral_v< U > && ( sizeof( U ) < sizeof( int ))
+    )
+    {
+        return static_cast< int >( value );
+    }
+    else if constexpr( std::is_same_v< U, float > )
+    {
+        return static_cast< double >( value );
+    }
+    else if constexpr( std::is_same_v< U, std::nullptr_t > )
+    {
+        return static_cast< void const * >( value );
+    }
+    else
+    {
+        return value;
+    }
+}
+
+/**
+ * \brief Checks the format at compile time and logs the message.
+ * \param format Constexpr callable returning the formatting string.
+ * \param site Call site of the message.
+ * \param level Log level.
+ * \param args Arguments to output, according to format.
+ */
+template< typename Format, typename... Args >
+inline void
+emit(
+    Format const format,
+    ulog_callsite const * const site,
+    ulog_level const level,
+    Args const &... args
+)
+{
+    constexpr std::string_view text = format();
+    static_assert(
+        matches< Args... >( text ),
+        "format doesn't match types of arguments"
+    );
+    static constexpr unsigned char signature[] =
+    {
+        static_cast< unsigned char >( type_of< Args >())...,
+        ULOG_ARG_END
+    };
+    arena strings;
+    strings.used = 0U;
+    ulog_site_(
+        site,
+        signature,
+        level,
+        text.data(),
+        pass( args, strings )...
+    );
+}
+
+} // namespace detail
+
+/**
+ * \brief Keeps context pair pushed for its own lifetime.
+ * \see ulog_context_push
+ *
+ * If there's no space left in context the pair is silently skipped.
+ */
+class context_scope
+{
+public:
+    /**
+     * \brief Pushes pair on top of calling thread's context.
+     * \param key Key, copied into context.
+     * \param value Value, copied into context.
+     */
+    context_scope( char const * const key, char const * const value )
+        : pushed( ulog_status_success( ulog_context_push( key, value )))
+    {
+    }
+    /**
+     * \brief Pops the pair, if it was pushed.
+     */
+    ~context_scope()
+    {
+        if( pushed ) { static_cast< void >( ulog_context_pop()); }
+    }
+    context_scope( context_scope const & ) = delete;
+    context_scope & operator=( context_scope const & ) = delete;
+
+private:
+    bool const pushed;
+};
+
+} // namespace ulog
+
+# if defined( __GNUC__ )
+#  undef ULOG____
+/* each call site gets its own static state, as in C11, declared within
+ * a statement expression so that logging stays an expression */
+#  define ULOG____( LEVEL, FORMAT, ... ) \
+    __extension__ \
+    ( { \
+        static ulog_callsite ulog_callsite_ = { __FILE__, __LINE__, 0U, 0 }; \
+        if( ulog_site_enabled_( &ulog_callsite_, LEVEL )) \
+        { \
+            ::ulog::detail::emit( \
+                []() constexpr \
+                { \
+                    return ::std::string_view( \
+                        ULOG_HEADER_FORMAT_ FORMAT "%c" \
+                    ); \
+                }, \
+                &ulog_callsite_, \
+                LEVEL, \
+                ulog_level_char_( LEVEL ), \
+                ulog_current_time_(), \
+                __FILE__, \
+                __func__, \
+                static_cast< unsigned >( __LINE__ ), \
+                __VA_ARGS__ \
+            ); \
+        } \
+        static_cast< void >( 0 ); \
+    } )
+# endif /* __GNUC__ */
+
+namespace ulog
+{
+
+/**
+ * \brief Keeps span open for its own lifetime.
+ * \see UTRACE_SCOPE
+ */
+class trace_scope
+{
+public:
+    /**
+     * \brief Opens span on calling thread.
+     * \param name Name of the span, must outlive it.
+     */
+    explicit trace_scope( char const * const name )
+    {
+        UTRACE_BEGIN( name );
+        static_cast< void >( name );
+    }
+    /**
+     * \brief Closes the span.
+     */
+    ~trace_scope()
+    {
+        UTRACE_END();
+    }
+    trace_scope( trace_scope const & ) = delete;
+    trace_scope & operator=( trace_scope const & ) = delete;
+};
+
+} // namespace ulog
+
+# define ULOG_TRACE_SCOPE_( NAME, LINE ) \
+    ::ulog::trace_scope const ulog_trace_scope_ ## LINE( NAME )
+# define ULOG_TRACE_SCOPE__( NAME, LINE ) ULOG_TRACE_SCOPE_( NAME, LINE )
+/**
+ * \brief Opens span closed at the end of enclosing scope.
+ */
+# define UTRACE_SCOPE( NAME ) ULOG_TRACE_SCOPE__( NAME, __LINE__ )
+
+#endif /* ULOG_HPP__ */
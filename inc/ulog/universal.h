@@ -42,6 +42,62 @@ extern "C" {
  * a single keyworkd to grep for and even allows for additional functionality,
  * like logging, if the macro is expanded.
  */
+/**
+ * \brief Specifies that a variable has thread storage duration.
+ *
+ * Expands to C11 _Thread_local where available, otherwise to the __thread
+ * extension understood by gcc and clang. Each thread gets its own copy of
+ * the variable, so it can be used without locking.
+ */
+# ifndef THREADLOCAL
+#  if defined( __STDC_VERSION__ ) && ( 201112L <= __STDC_VERSION__ )
+#   define THREADLOCAL _Thread_local
+#  else /* C99 or C++ */
+#   define THREADLOCAL __thread
+#  endif /* __STDC_VERSION__ */
+# endif /* THREADLOCAL */
+/**
+ * \brief Marks a function as rarely called.
+ *
+ * Compilers supporting it move such functions, and the branches leading to
+ * their calls, out of the hot path. Elsewhere it's a no-op.
+ */
+# ifndef ULOG_COLD
+#  if defined( __GNUC__ )
+#   define ULOG_COLD __attribute__(( cold ))
+#  else /* __GNUC__ */
+#   define ULOG_COLD
+#  endif /* __GNUC__ */
+# endif /* ULOG_COLD */
+/**
+ * \brief Marks a function as taking printf-like format and arguments.
+ * \param FORMAT Position of the format parameter, counting from one.
+ * \param ARGS Position of the first argument to format.
+ *
+ * Lets compilers which support it check arguments against literal formats.
+ */
+# ifndef ULOG_FORMAT
+#  if defined( __GNUC__ )
+#   define ULOG_FORMAT( FORMAT, ARGS ) \
+    __attribute__(( format( printf, FORMAT, ARGS )))
+#  else /* __GNUC__ */
+#   define ULOG_FORMAT( FORMAT, ARGS )
+#  endif /* __GNUC__ */
+# endif /* ULOG_FORMAT */
+/**
+ * \brief Marks a symbol as part of the library's interface.
+ *
+ * When the library is built with -fvisibility=hidden only symbols marked with
+ * this macro are exported, so calls between its own functions bind locally
+ * instead of going through the procedure linkage table.
+ */
+# ifndef ULOG_EXPORT
+#  if defined( __GNUC__ ) && ( 4 <= __GNUC__ )
+#   define ULOG_EXPORT __attribute__(( visibility( "default" )))
+#  else /* __GNUC__ */
+#   define ULOG_EXPORT
+#  endif /* __GNUC__ */
+# endif /* ULOG_EXPORT */
 # ifndef UNUSED
 #  define UNUSED( VAR ) (( void ) ( VAR ))
 # endif /* UNUSED */
@@ -0,0 +1,697 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Implements asynchronous delivery of log records.
+ * \date        2016/02/20 11:27:33 AM
+ * \file        async.c
+ * \version     1.0
+ *
+ *
+ **/
+
+#define _DEFAULT_SOURCE /* for nanosleep */
+
+#include <ulog/async.h>
+#include <ulog/context.h> /* ulog_context, ulog_context_capture, etc. */
+#include <ulog/mutex.h> /* ulog_mutex_park_, ulog_mutex_unpark_ */
+#include <ulog/pool.h> /* ulog_pool */
+#include <ulog/queue.h> /* ulog_queue, ulog_queueable */
+#include <ulog/status.h> /* ulog_status, ulog_status_descriptive */
+#include <ulog/ulog.h> /* ulog_monotonic_time_ */
+#include <ulog/universal.h> /* THREADUNSAFE, UNUSED */
+
+#include <errno.h> /* EALREADY, EINVAL, EIO, ENOBUFS, ENODATA, etc. */
+#include <pthread.h> /* pthread_create, pthread_join, pthread_t */
+#include <stdbool.h> /* bool */
+#include <stddef.h> /* NULL, size_t */
+#include <stdint.h> /* UINT64_MAX, uint8_t, uint32_t, uint64_t */
+#include <stdio.h> /* FILE, fclose, fflush, fopen, vfprintf, vsnprintf */
+#include <stdlib.h> /* free, malloc */
+#include <time.h> /* nanosleep, struct timespec */
+
+/* flush sleeps between these bounds until records are delivered */
+#define IDLE_MINIMUM_NANOSECONDS 1000L
+#define IDLE_MAXIMUM_NANOSECONDS 1000000L
+
+typedef struct
+{
+    ulog_level level;
+    size_t length;
+    char text[ ULOG_RECORD_SIZE ];
+    /* context of producer, handed to sink on consumer thread */
+    ulog_context context;
+    ulog_queueable queue;
+}
+record;
+
+/*
+ * Counters written by producers and consumer are kept apart. Consumer
+ * parks on sleeping when the queue is empty, and producers wake it only if
+ * it's set; producers blocked for a free record park on freed, which the
+ * consumer bumps only if there are any.
+ */
+struct ulog_async_state_struct
+{
+    ulog_async_op_table const * op;
+    ulog_async_config config;
+    ulog_async_sink_fn sink;
+    void * userdata;
+    ulog_pool records;
+    ulog_queue pending;
+    FILE * overflow;
+    pthread_t consumer;
+    bool stop;
+    uint8_t separator_producers[ ULOG_CACHE_LINE ];
+    uint64_t accepted;
+    uint64_t reclaimed;
+    uint64_t dropped;
+    uint64_t spilled;
+    uint32_t blocked;
+    uint8_t separator_consumer[ ULOG_CACHE_LINE ];
+    uint64_t delivered;
+    uint64_t stalls;
+    /* start of delivery in progress, zero between deliveries */
+    uint64_t delivering;
+    uint8_t separator_parking[ ULOG_CACHE_LINE ];
+    uint32_t sleeping;
+    uint32_t freed;
+    uint8_t separator_end[ ULOG_CACHE_LINE ];
+};
+
+static inline bool
+valid( ulog_async const * const self );
+
+static inline ulog_status
+generic_invalid( ulog_async const * const self )
+{
+    UNUSED( self );
+    return ulog_status_descriptive( EINVAL, "invalid async object" );
+}
+
+static inline ulog_status
+generic_uninitialized( ulog_async const * const self )
+{
+    UNUSED( self );
+    return ulog_status_descriptive( EINVAL, "async object uninitialized" );
+}
+
+static inline ulog_status
+setup_already(
+    ulog_async * const self,
+    ulog_async_config const * const config,
+    ulog_async_sink_fn const sink,
+    void * const userdata
+)
+{
+    UNUSED( self );
+    UNUSED( config );
+    UNUSED( sink );
+    UNUSED( userdata );
+    return ulog_status_descriptive( EALREADY, "async already set up" );
+}
+
+static inline ulog_status
+cleanup_already( ulog_async * const self )
+{
+    UNUSED( self );
+    return ulog_status_descriptive( EALREADY, "async already cleaned up" );
+}
+
+static inline ulog_status
+submit_uninitialized(
+    ulog_async const * const self,
+    ulog_level const level,
+    char const * const format,
+    va_list args
+)
+{
+    UNUSED( level );
+    UNUSED( format );
+    UNUSED( args );
+    return generic_uninitialized( self );
+}
+
+static inline ulog_status
+counters_uninitialized(
+    ulog_async const * const self,
+    ulog_async_counters * const counters
+)
+{
+    UNUSED( counters );
+    return generic_uninitialized( self );
+}
+
+static inline ulog_status
+reset_uninitialized( ulog_async * const self )
+{
+    return generic_uninitialized( self );
+}
+
+static THREADUNSAFE ulog_status
+setup_safe(
+    ulog_async * const self,
+    ulog_async_config const * const config,
+    ulog_async_sink_fn const sink,
+    void * const userdata
+);
+static THREADUNSAFE ulog_status
+cleanup_safe( ulog_async * const self );
+static ulog_status
+submit_safe(
+    ulog_async const * const self,
+    ulog_level const level,
+    char const * const format,
+    va_list args
+);
+static ulog_status
+flush_safe( ulog_async const * const self );
+static ulog_status
+counters_safe(
+    ulog_async const * const self,
+    ulog_async_counters * const counters
+);
+static THREADUNSAFE ulog_status
+reset_safe( ulog_async * const self );
+
+static ulog_async_op_table const default_op =
+{
+    .setup = setup_safe,
+    .cleanup = cleanup_already,
+    .submit = submit_uninitialized,
+    .flush = generic_uninitialized,
+    .counters = counters_uninitialized,
+    .reset = reset_uninitialized
+};
+static ulog_async_op_table const setup_op =
+{
+    .setup = setup_already,
+    .cleanup = cleanup_safe,
+    .submit = submit_safe,
+    .flush = flush_safe,
+    .counters = counters_safe,
+    .reset = reset_safe
+};
+
+static ulog_async_state guard = { .op = &default_op };
+
+static inline record *
+get_record( ulog_queueable * const element )
+{
+    return ulog_queueable_get_container( element, record, queue );
+}
+
+static void
+idle( long * const nanoseconds )
+{
+    struct timespec const pause = { .tv_sec = 0, .tv_nsec = *nanoseconds };
+    UNUSED( nanosleep( &pause, NULL ));
+    *nanoseconds *= 2L;
+    if( IDLE_MAXIMUM_NANOSECONDS < *nanoseconds )
+    {
+        *nanoseconds = IDLE_MAXIMUM_NANOSECONDS;
+    }
+}
+
+/* called after queueing a record, or setting stop */
+static void
+wake_consumer( ulog_async_state * const state )
+{
+    __atomic_thread_fence( __ATOMIC_SEQ_CST );
+    if(
+        ( 0U != __atomic_load_n( &( state->sleeping ), __ATOMIC_RELAXED ))
+        && ( 0U
+            != __atomic_exchange_n(
+                &( state->sleeping ),
+                0U,
+                __ATOMIC_RELAXED
+            ))
+    )
+    {
+        ulog_mutex_unpark_( &( state->sleeping ), 1, false );
+    }
+}
+
+/* watchdog: readers of counters see how long the delivery is taking */
+static void
+deliver( ulog_async_state * const state, record const * const item )
+{
+    ulog_context const * const previous =
+        ulog_context_install( &( item->context ));
+    if( 0U == state->config.stall )
+    {
+        state->sink( state->userdata, item->level, item->text, item->length );
+        UNUSED( ulog_context_install( previous ));
+        return;
+    }
+    uint64_t const start = ulog_monotonic_time_();
+    __atomic_store_n( &( state->delivering ), start, __ATOMIC_RELAXED );
+    state->sink( state->userdata, item->level, item->text, item->length );
+    __atomic_store_n( &( state->delivering ), 0U, __ATOMIC_RELAXED );
+    UNUSED( ulog_context_install( previous ));
+    if( state->config.stall <= ( ulog_monotonic_time_() - start ))
+    {
+        __atomic_add_fetch( &( state->stalls ), 1U, __ATOMIC_RELAXED );
+    }
+}
+
+static void
+deliver_element(
+    ulog_async_state * const state,
+    ulog_queueable * const element
+)
+{
+    record * const item = get_record( element );
+    deliver( state, item );
+    UNUSED( state->records.op->release( &( state->records ), item ));
+    __atomic_add_fetch( &( state->delivered ), 1U, __ATOMIC_RELEASE );
+    if( ULOG_BLOCK != state->config.policy ) { return; }
+    /* record is free again, for one of producers blocked for it */
+    __atomic_thread_fence( __ATOMIC_SEQ_CST );
+    if( 0U != __atomic_load_n( &( state->blocked ), __ATOMIC_RELAXED ))
+    {
+        __atomic_add_fetch( &( state->freed ), 1U, __ATOMIC_RELAXED );
+        ulog_mutex_unpark_( &( state->freed ), 1, false );
+    }
+}
+
+static void *
+consume( void * const arg )
+{
+    ulog_async_state * const state = arg;
+    for( ;; )
+    {
+        ulog_queueable * element;
+        if( ulog_status_success(
+            state->pending.op->pop( &( state->pending ), &element )))
+        {
+            deliver_element( state, element );
+            continue;
+        }
+        /* producers are gone when stop is set, so the queue stays empty */
+        if( __atomic_load_n( &( state->stop ), __ATOMIC_ACQUIRE )) { break; }
+        /* announced before looking at the queue again, so that producers
+         * which queue a record meanwhile see it and wake the consumer */
+        __atomic_store_n( &( state->sleeping ), 1U, __ATOMIC_RELAXED );
+        __atomic_thread_fence( __ATOMIC_SEQ_CST );
+        bool const popped =
+            ulog_status_success(
+                state->pending.op->pop( &( state->pending ), &element )
+            );
+        if(
+            !popped
+            && !__atomic_load_n( &( state->stop ), __ATOMIC_ACQUIRE )
+        )
+        {
+            ulog_mutex_park_(
+                &( state->sleeping ),
+                1U,
+                UINT64_MAX,
+                false
+            );
+        }
+        __atomic_store_n( &( state->sleeping ), 0U, __ATOMIC_RELAXED );
+        if( popped ) { deliver_element( state, element ); }
+    }
+    return NULL;
+}
+
+static bool
+valid_config( ulog_async_config const * const config )
+{
+    if(( NULL == config ) || ( 0U == config->capacity )) { return false; }
+    switch( config->policy )
+    {
+        case ULOG_BLOCK: return true;
+        case ULOG_DROP_NEWEST: return true;
+        case ULOG_DROP_OLDEST: return true;
+        case ULOG_SPILL: return ( NULL != config->overflow );
+        default: return false;
+    }
+}
+
+static void
+release( ulog_async_state * const state )
+{
+    UNUSED( state->pending.op->cleanup( &( state->pending )));
+    UNUSED( state->records.op->cleanup( &( state->records )));
+    if( NULL != state->overflow ) { UNUSED( fclose( state->overflow )); }
+    free( state );
+}
+
+static THREADUNSAFE ulog_status
+setup_safe(
+    ulog_async * const self,
+    ulog_async_config const * const config,
+    ulog_async_sink_fn const sink,
+    void * const userdata
+)
+{
+    if( !valid_config( config ) || ( NULL == sink ))
+    {
+        return
+            ulog_status_descriptive( EINVAL, "invalid async configuration" );
+    }
+
+    ulog_async_state * const state = malloc( sizeof( ulog_async_state ));
+    if( NULL == state )
+    {
+        return ulog_status_descriptive(
+            ENOMEM,
+            "cannot allocate memory for async state"
+        );
+    }
+    /* one more record than capacity is being passed to sink */
+    size_t const records = config->capacity + 1U;
+    *state = ( ulog_async_state )
+    {
+        .op = &setup_op,
+        .config = *config,
+        .sink = sink,
+        .userdata = userdata,
+        .records = ulog_pool_get(),
+        .pending = ulog_queue_get()
+    };
+    ulog_status result =
+        state->records.op->setup(
+            &( state->records ),
+            sizeof( record ),
+            records
+        );
+    if( ulog_status_success( result ))
+    {
+        result =
+            state->pending.op->setup( &( state->pending ), records );
+    }
+    if( ulog_status_success( result ) && ( ULOG_SPILL == config->policy ))
+    {
+        state->overflow = fopen( config->overflow, "a" );
+        if( NULL == state->overflow )
+        {
+            result =
+                ulog_status_descriptive( EIO, "cannot open overflow file" );
+        }
+    }
+    if( !ulog_status_success( result ))
+    {
+        release( state );
+        return result;
+    }
+
+    if( 0 != pthread_create( &( state->consumer ), NULL, consume, state ))
+    {
+        release( state );
+        return
+            ulog_status_descriptive( EIO, "cannot start async consumer" );
+    }
+    self->state = state;
+    return ulog_status_descriptive( 0, "async set up successfully" );
+}
+
+static THREADUNSAFE ulog_status
+cleanup_safe( ulog_async * const self )
+{
+    ulog_async_state * const state = self->state;
+    __atomic_store_n( &( state->stop ), true, __ATOMIC_RELEASE );
+    wake_consumer( state );
+    UNUSED( pthread_join( state->consumer, NULL ));
+    release( state );
+    self->state = &guard;
+    return ulog_status_descriptive( 0, "async cleaned up successfully" );
+}
+
+/* consumer of the parent doesn't exist here; it delivers the records */
+static THREADUNSAFE ulog_status
+reset_safe( ulog_async * const self )
+{
+    ulog_async_state * const state = self->state;
+    ulog_async_config const config = state->config;
+    ulog_async_sink_fn const sink = state->sink;
+    void * const userdata = state->userdata;
+    release( state );
+    self->state = &guard;
+    return setup_safe( self, &config, sink, userdata );
+}
+
+static ulog_status
+drop( ulog_async_state * const state )
+{
+    __atomic_add_fetch( &( state->dropped ), 1U, __ATOMIC_RELAXED );
+    return ulog_status_descriptive( ENOBUFS, "record dropped" );
+}
+
+static ulog_status
+spill(
+    ulog_async_state * const state,
+    char const * const format,
+    va_list args
+)
+{
+    /* stdio serializes writers of the same stream */
+    UNUSED( vfprintf( state->overflow, format, args ));
+    UNUSED( fflush( state->overflow ));
+    __atomic_add_fetch( &( state->spilled ), 1U, __ATOMIC_RELAXED );
+    return ulog_status_descriptive( EOVERFLOW, "record spilled" );
+}
+
+static inline bool
+acquire( ulog_async_state * const state, record * * const item )
+{
+    void * block;
+    if( !ulog_status_success(
+        state->records.op->acquire( &( state->records ), &block )))
+    {
+        return false;
+    }
+    *item = block;
+    return true;
+}
+
+/* announced before trying again, so that consumer freeing a record
+ * meanwhile sees it and wakes a producer */
+static bool
+acquire_blocking( ulog_async_state * const state, record * * const item )
+{
+    uint64_t const timeout = state->config.timeout;
+    uint64_t const start = ulog_monotonic_time_();
+    for( ;; )
+    {
+        uint32_t const freed =
+            __atomic_load_n( &( state->freed ), __ATOMIC_RELAXED );
+        __atomic_add_fetch( &( state->blocked ), 1U, __ATOMIC_RELAXED );
+        __atomic_thread_fence( __ATOMIC_SEQ_CST );
+        bool const acquired = acquire( state, item );
+        uint64_t const elapsed = ulog_monotonic_time_() - start;
+        if( !acquired && ( timeout > elapsed ))
+        {
+            ulog_mutex_park_(
+                &( state->freed ),
+                freed,
+                ( UINT64_MAX == timeout ) ? UINT64_MAX : timeout - elapsed,
+                false
+            );
+        }
+        __atomic_sub_fetch( &( state->blocked ), 1U, __ATOMIC_RELAXED );
+        if( acquired ) { return true; }
+        if( timeout <= ( ulog_monotonic_time_() - start )) { return false; }
+    }
+}
+
+/*
+ * The oldest record is taken away from consumer and reused; if consumer
+ * got to all of them first, there's nothing to replace.
+ */
+static bool
+acquire_oldest( ulog_async_state * const state, record * * const item )
+{
+    if( acquire( state, item )) { return true; }
+    ulog_queueable * element;
+    if( !ulog_status_success(
+        state->pending.op->pop( &( state->pending ), &element )))
+    {
+        return false;
+    }
+    *item = get_record( element );
+    __atomic_add_fetch( &( state->reclaimed ), 1U, __ATOMIC_RELAXED );
+    UNUSED( drop( state ));
+    return true;
+}
+
+static ulog_status
+submit_safe(
+    ulog_async const * const self,
+    ulog_level const level,
+    char const * const format,
+    va_list args
+)
+{
+    ulog_async_state * const state = self->state;
+    record * item;
+    bool acquired = acquire( state, &item );
+    if( !acquired )
+    {
+        switch( state->config.policy )
+        {
+            case ULOG_BLOCK:
+                acquired = acquire_blocking( state, &item );
+                break;
+            case ULOG_DROP_OLDEST:
+                acquired = acquire_oldest( state, &item );
+                break;
+            case ULOG_SPILL:
+                return spill( state, format, args );
+            default:
+                break;
+        }
+    }
+    if( !acquired ) { return drop( state ); }
+
+    int const length =
+        vsnprintf( item->text, sizeof( item->text ), format, args );
+    item->level = level;
+    ulog_context_capture( &( item->context ));
+    item->length =
+        ( 0 > length ) ? 0U
+        : (( sizeof( item->text ) <= ( size_t ) length )
+            ? sizeof( item->text ) - 1U : ( size_t ) length );
+    if( 0 > length ) { item->text[ 0 ] = '\0'; }
+    item->queue = ulog_queueable_get();
+
+    __atomic_add_fetch( &( state->accepted ), 1U, __ATOMIC_RELAXED );
+    UNUSED( state->pending.op->push( &( state->pending ), &( item->queue )));
+    wake_consumer( state );
+    return ulog_status_descriptive( 0, "record queued" );
+}
+
+static ulog_status
+flush_safe( ulog_async const * const self )
+{
+    ulog_async_state * const state = self->state;
+    uint64_t const accepted =
+        __atomic_load_n( &( state->accepted ), __ATOMIC_ACQUIRE );
+    long pause = IDLE_MINIMUM_NANOSECONDS;
+    while(
+        ( __atomic_load_n( &( state->delivered ), __ATOMIC_ACQUIRE )
+          + __atomic_load_n( &( state->reclaimed ), __ATOMIC_ACQUIRE ))
+        < accepted
+    )
+    {
+        idle( &pause );
+    }
+    return ulog_status_descriptive( 0, "async records delivered" );
+}
+
+static ulog_status
+counters_safe(
+    ulog_async const * const self,
+    ulog_async_counters * const counters
+)
+{
+    if( NULL == counters )
+    {
+        return ulog_status_descriptive( ENODATA, "invalid counters pointer" );
+    }
+    ulog_async_state * const state = self->state;
+    uint64_t const delivering =
+        __atomic_load_n( &( state->delivering ), __ATOMIC_RELAXED );
+    uint64_t const now = ulog_monotonic_time_();
+    *counters = ( ulog_async_counters )
+    {
+        .delivered =
+            __atomic_load_n( &( state->delivered ), __ATOMIC_RELAXED ),
+        .dropped = __atomic_load_n( &( state->dropped ), __ATOMIC_RELAXED ),
+        .spilled = __atomic_load_n( &( state->spilled ), __ATOMIC_RELAXED ),
+        .stalls = __atomic_load_n( &( state->stalls ), __ATOMIC_RELAXED ),
+        .stalled =
+            ( 0U != delivering )
+            && ( state->config.stall <= ( now - delivering ))
+    };
+    return ulog_status_descriptive( 0, "async counters read" );
+}
+
+static inline THREADUNSAFE ulog_status
+setup(
+    ulog_async * const self,
+    ulog_async_config const * const config,
+    ulog_async_sink_fn const sink,
+    void * const userdata
+)
+{
+    if( !valid( self )) { return generic_invalid( self ); }
+    return self->state->op->setup( self, config, sink, userdata );
+}
+
+static inline THREADUNSAFE ulog_status
+cleanup( ulog_async * const self )
+{
+    if( !valid( self )) { return generic_invalid( self ); }
+    return self->state->op->cleanup( self );
+}
+
+static inline ulog_status
+submit(
+    ulog_async const * const self,
+    ulog_level const level,
+    char const * const format,
+    va_list args
+)
+{
+    if( !valid( self )) { return generic_invalid( self ); }
+    return self->state->op->submit( self, level, format, args );
+}
+
+static inline ulog_status
+flush( ulog_async const * const self )
+{
+    if( !valid( self )) { return generic_invalid( self ); }
+    return self->state->op->flush( self );
+}
+
+static inline ulog_status
+counters_(
+    ulog_async const * const self,
+    ulog_async_counters * const counters
+)
+{
+    if( !valid( self )) { return generic_invalid( self ); }
+    return self->state->op->counters( self, counters );
+}
+
+static inline THREADUNSAFE ulog_status
+reset( ulog_async * const self )
+{
+    if( !valid( self )) { return generic_invalid( self ); }
+    return self->state->op->reset( self );
+}
+
+static ulog_async_op_table const op =
+{
+    .setup = setup,
+    .cleanup = cleanup,
+    .submit = submit,
+    .flush = flush,
+    .counters = counters_,
+    .reset = reset
+};
+
+static inline bool
+valid( ulog_async const * const self )
+{
+    return
+        (
+            ( NULL != self )
+            && ( NULL != self->state )
+            && (
+                (( &guard == self->state ) && ( &default_op == guard.op ))
+                || (
+                    ( &guard != self->state )
+                    && ( &setup_op == self->state->op )
+                )
+            )
+            && ( &op == self->op )
+        );
+}
+
+ulog_async
+ulog_async_get( void )
+{
+    return ( ulog_async ) { .state = &guard, .op = &op };
+}
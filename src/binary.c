@@ -0,0 +1,612 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Implements binary encoding of log records.
+ * \date        2016/04/23 10:41:12 AM
+ * \file        binary.c
+ * \version     1.0
+ *
+ *
+ **/
+
+#include <ulog/binary.h>
+#include <ulog/universal.h> /* UNUSED */
+
+#include <errno.h> /* EINVAL, ENOTSUP */
+#include <stdbool.h> /* bool, false, true */
+#include <stddef.h> /* ptrdiff_t */
+#include <stdint.h> /* intmax_t, uint32_t, UINT8_MAX */
+#include <stdio.h> /* snprintf */
+#include <stdlib.h> /* strtoul */
+#include <string.h> /* memcpy, memmove, strchr, strcmp, strlen */
+
+static bool
+put(
+    unsigned char * const buffer,
+    size_t const size,
+    size_t * const offset,
+    void const * const value,
+    size_t const length
+)
+{
+    if( size - *offset < length ) { return false; }
+    memcpy( buffer + *offset, value, length );
+    *offset += length;
+    return true;
+}
+
+/* strings are cut to what fits, other arguments must fit whole */
+static bool
+put_string(
+    unsigned char * const buffer,
+    size_t const size,
+    size_t * const offset,
+    char const * const value
+)
+{
+    if( size - *offset < sizeof( uint32_t )) { return false; }
+    size_t const available = size - *offset - sizeof( uint32_t );
+    size_t const full = ( NULL == value ) ? 0U : strlen( value );
+    uint32_t const length =
+        ( uint32_t ) (( full < available ) ? full : available );
+    UNUSED( put( buffer, size, offset, &length, sizeof( length )));
+    return put( buffer, size, offset, value, length );
+}
+
+static bool
+put_argument(
+    unsigned char * const buffer,
+    size_t const size,
+    size_t * const offset,
+    unsigned char const type,
+    va_list * const args
+)
+{
+#define PUT( TYPE ) \
+    do \
+    { \
+        TYPE const value = va_arg( *args, TYPE ); \
+        return put( buffer, size, offset, &value, sizeof( value )); \
+    } \
+    while( 0 )
+
+    switch( type )
+    {
+        case ULOG_ARG_INT: PUT( int );
+        case ULOG_ARG_UINT: PUT( unsigned );
+        case ULOG_ARG_LONG: PUT( long );
+        case ULOG_ARG_ULONG: PUT( unsigned long );
+        case ULOG_ARG_LLONG: PUT( long long );
+        case ULOG_ARG_ULLONG: PUT( unsigned long long );
+        case ULOG_ARG_DOUBLE: PUT( double );
+        case ULOG_ARG_LDOUBLE: PUT( long double );
+        case ULOG_ARG_POINTER: PUT( void const * );
+        case ULOG_ARG_STRING:
+            return put_string(
+                buffer,
+                size,
+                offset,
+                va_arg( *args, char const * )
+            );
+        default: return false;
+    }
+#undef PUT
+}
+
+/* returns number of pairs stored, context is stored whole or not at all */
+static uint16_t
+put_context(
+    unsigned char * const buffer,
+    size_t const size,
+    size_t * const offset,
+    ulog_context const * const context
+)
+{
+    if(( NULL == context ) || ( 0U == context->count )) { return 0U; }
+    size_t const needed =
+        sizeof( context->used )
+        + context->count * sizeof( context->entry[ 0 ] )
+        + context->used;
+    if( size - *offset < needed ) { return 0U; }
+    UNUSED(
+        put( buffer, size, offset, &( context->used ), sizeof( context->used ))
+    );
+    UNUSED(
+        put(
+            buffer,
+            size,
+            offset,
+            context->entry,
+            context->count * sizeof( context->entry[ 0 ] )
+        )
+    );
+    UNUSED( put( buffer, size, offset, context->data, context->used ));
+    return context->count;
+}
+
+size_t
+ulog_binary_encode(
+    void * const buffer,
+    size_t const size,
+    ulog_level const level,
+    unsigned char const * const signature,
+    char const * const format,
+    va_list args,
+    ulog_context const * const context
+)
+{
+    unsigned char * const record = buffer;
+    size_t declared = 0U;
+    while(
+        ( UINT8_MAX > declared ) && ( ULOG_ARG_END != signature[ declared ] )
+    )
+    {
+        ++declared;
+    }
+    size_t const start = sizeof( ulog_binary_header ) + declared;
+    if( size < start ) { return 0U; }
+
+    va_list copy;
+    va_copy( copy, args );
+    size_t offset = start;
+    size_t count = 0U;
+    while(
+        ( count < declared )
+        && put_argument( record, size, &offset, signature[ count ], &copy )
+    )
+    {
+        ++count;
+    }
+    va_end( copy );
+
+    /* values of dropped arguments are gone, so are their types */
+    memmove(
+        record + sizeof( ulog_binary_header ) + count,
+        record + start,
+        offset - start
+    );
+    offset -= declared - count;
+    memcpy( record + sizeof( ulog_binary_header ), signature, count );
+    uint16_t const pairs = put_context( record, size, &offset, context );
+    ulog_binary_header const header =
+    {
+        .size = ( uint32_t ) offset,
+        .level = ( uint8_t ) level,
+        .count = ( uint8_t ) count,
+        .context = pairs,
+        .format = format
+    };
+    memcpy( record, &header, sizeof( header ));
+    return offset;
+}
+
+typedef struct
+{
+    unsigned char const * data;
+    size_t size;
+    size_t offset;
+}
+reader;
+
+static bool
+take( reader * const from, void * const value, size_t const length )
+{
+    if( from->size - from->offset < length ) { return false; }
+    memcpy( value, from->data + from->offset, length );
+    from->offset += length;
+    return true;
+}
+
+typedef struct
+{
+    char * text;
+    size_t length;
+    size_t used;
+}
+writer;
+
+static void
+advance( writer * const to, int const written )
+{
+    if( 0 > written ) { return; }
+    size_t const room = to->length - to->used - 1U;
+    to->used += (( size_t ) written < room ) ? ( size_t ) written : room;
+}
+
+static void
+append( writer * const to, char const * const text, size_t const length )
+{
+    size_t const room = to->length - to->used - 1U;
+    size_t const copied = ( length < room ) ? length : room;
+    memcpy( to->text + to->used, text, copied );
+    to->used += copied;
+    to->text[ to->used ] = '\0';
+}
+
+/* single conversion specification of a format, e.g. "%-8.3lu" */
+typedef struct
+{
+    char text[ 32U ];
+    /* offset of '.' in text, zero if there's no precision */
+    size_t precision;
+    /* length modifier, e.g. "ll", zero-terminated */
+    char modifier[ 4U ];
+    char conversion;
+}
+specification;
+
+static ulog_status
+parse(
+    char const * const format,
+    specification * const spec,
+    size_t * const length
+)
+{
+    size_t i = 1U;
+    while( '\0' != format[ i ] && NULL != strchr( "-+ #0'", format[ i ] ))
+    {
+        ++i;
+    }
+    while(( '0' <= format[ i ] ) && ( '9' >= format[ i ] )) { ++i; }
+    spec->precision = 0U;
+    if( '.' == format[ i ] )
+    {
+        spec->precision = i++;
+        while(( '0' <= format[ i ] ) && ( '9' >= format[ i ] )) { ++i; }
+    }
+    if( '*' == format[ i ] )
+    {
+        return ulog_status_descriptive( ENOTSUP, "variable width" );
+    }
+    size_t modifier = 0U;
+    while( '\0' != format[ i ] && NULL != strchr( "hlLqjzt", format[ i ] ))
+    {
+        if( sizeof( spec->modifier ) - 1U == modifier )
+        {
+            return ulog_status_descriptive( EINVAL, "invalid modifier" );
+        }
+        spec->modifier[ modifier++ ] = format[ i++ ];
+    }
+    spec->modifier[ modifier ] = '\0';
+    spec->conversion = format[ i++ ];
+    if( 'n' == spec->conversion )
+    {
+        return ulog_status_descriptive( ENOTSUP, "%n conversion" );
+    }
+    if(( '\0' == spec->conversion ) || ( sizeof( spec->text ) <= i ))
+    {
+        return ulog_status_descriptive( EINVAL, "invalid specification" );
+    }
+    memcpy( spec->text, format, i );
+    spec->text[ i ] = '\0';
+    *length = i;
+    return ulog_status_descriptive( 0, "specification parsed" );
+}
+
+/* size of integer argument expected by length modifier, zero if unknown */
+static size_t
+integer_size( char const * const modifier )
+{
+    switch( modifier[ 0 ] )
+    {
+        case '\0': return sizeof( int );
+        case 'h': return sizeof( int );
+        case 'l':
+            if( '\0' == modifier[ 1 ] ) { return sizeof( long ); }
+            return sizeof( long long );
+        case 'q': return sizeof( long long );
+        case 'j': return sizeof( intmax_t );
+        case 'z': return sizeof( size_t );
+        case 't': return sizeof( ptrdiff_t );
+        default: return 0U;
+    }
+}
+
+static bool
+compatible( specification const * const spec, unsigned char const type )
+{
+    char const * const modifier = spec->modifier;
+    switch( type )
+    {
+        case ULOG_ARG_INT:
+        case ULOG_ARG_UINT:
+            return
+                ( NULL != strchr( "diouxXc", spec->conversion ))
+                && ( sizeof( int ) == integer_size( modifier ));
+        case ULOG_ARG_LONG:
+        case ULOG_ARG_ULONG:
+            return
+                ( NULL != strchr( "diouxX", spec->conversion ))
+                && ( sizeof( long ) == integer_size( modifier ));
+        case ULOG_ARG_LLONG:
+        case ULOG_ARG_ULLONG:
+            return
+                ( NULL != strchr( "diouxX", spec->conversion ))
+                && ( sizeof( long long ) == integer_size( modifier ));
+        case ULOG_ARG_DOUBLE:
+            return
+                ( NULL != strchr( "fFeEgGaA", spec->conversion ))
+                && (
+                    ( 0 == strcmp( "", modifier ))
+                    || ( 0 == strcmp( "l", modifier ))
+                );
+        case ULOG_ARG_LDOUBLE:
+            return
+                ( NULL != strchr( "fFeEgGaA", spec->conversion ))
+                && ( 0 == strcmp( "L", modifier ));
+        case ULOG_ARG_POINTER:
+            return ( 'p' == spec->conversion ) && ( '\0' == modifier[ 0 ] );
+        case ULOG_ARG_STRING:
+            return ( 's' == spec->conversion ) && ( '\0' == modifier[ 0 ] );
+        default: return false;
+    }
+}
+
+/* strings aren't zero-terminated, so their length becomes the precision */
+static bool
+decode_string(
+    writer * const to,
+    reader * const from,
+    specification const * const spec
+)
+{
+    uint32_t size;
+    if(
+        !take( from, &size, sizeof( size ))
+        || ( from->size - from->offset < size )
+    )
+    {
+        return false;
+    }
+    size_t precision = size;
+    size_t cut = strlen( spec->text ) - 1U;
+    if( 0U != spec->precision )
+    {
+        unsigned long const given =
+            strtoul( spec->text + spec->precision + 1U, NULL, 10 );
+        if( given < precision ) { precision = given; }
+        cut = spec->precision;
+    }
+    char bounded[ sizeof( spec->text ) + 3U ];
+    memcpy( bounded, spec->text, cut );
+    memcpy( bounded + cut, ".*s", sizeof( ".*s" ));
+    advance(
+        to,
+        snprintf(
+            to->text + to->used,
+            to->length - to->used,
+            bounded,
+            ( int ) precision,
+            ( char const * ) ( from->data + from->offset )
+        )
+    );
+    from->offset += size;
+    return true;
+}
+
+static bool
+decode_argument(
+    writer * const to,
+    reader * const from,
+    specification const * const spec,
+    unsigned char const type
+)
+{
+#define RENDER( TYPE ) \
+    do \
+    { \
+        TYPE value; \
+        if( !take( from, &value, sizeof( value ))) { return false; } \
+        advance( \
+            to, \
+            snprintf( \
+                to->text + to->used, \
+                to->length - to->used, \
+                spec->text, \
+                value \
+            ) \
+        ); \
+        return true; \
+    } \
+    while( 0 )
+
+    switch( type )
+    {
+        case ULOG_ARG_INT: RENDER( int );
+        case ULOG_ARG_UINT: RENDER( unsigned );
+        case ULOG_ARG_LONG: RENDER( long );
+        case ULOG_ARG_ULONG: RENDER( unsigned long );
+        case ULOG_ARG_LLONG: RENDER( long long );
+        case ULOG_ARG_ULLONG: RENDER( unsigned long long );
+        case ULOG_ARG_DOUBLE: RENDER( double );
+        case ULOG_ARG_LDOUBLE: RENDER( long double );
+        case ULOG_ARG_POINTER: RENDER( void const * );
+        case ULOG_ARG_STRING: return decode_string( to, from, spec );
+        default: return false;
+    }
+#undef RENDER
+}
+
+ulog_status
+ulog_binary_decode(
+    void const * const record,
+    size_t const size,
+    char * const text,
+    size_t const length
+)
+{
+    ulog_binary_header header;
+    if(
+        ( NULL == record )
+        || ( NULL == text )
+        || ( 0U == length )
+        || ( sizeof( header ) > size )
+    )
+    {
+        return ulog_status_descriptive( EINVAL, "invalid record" );
+    }
+    memcpy( &header, record, sizeof( header ));
+    if(
+        ( size < header.size )
+        || ( sizeof( header ) + header.count > header.size )
+        || ( NULL == header.format )
+    )
+    {
+        return ulog_status_descriptive( EINVAL, "malformed record" );
+    }
+
+    unsigned char const * const types =
+        ( unsigned char const * ) record + sizeof( header );
+    reader from =
+    {
+        .data = record,
+        .size = header.size,
+        .offset = sizeof( header ) + header.count
+    };
+    writer to = { .text = text, .length = length, .used = 0U };
+    text[ 0 ] = '\0';
+    size_t argument = 0U;
+    char const * format = header.format;
+    while( '\0' != *format )
+    {
+        char const * const next = strchr( format, '%' );
+        if( NULL == next )
+        {
+            append( &to, format, strlen( format ));
+            break;
+        }
+        append( &to, format, ( size_t ) ( next - format ));
+        if( '%' == next[ 1 ] )
+        {
+            append( &to, "%", 1U );
+            format = next + 2;
+            continue;
+        }
+        specification spec;
+        size_t consumed = 0U;
+        ulog_status const parsed = parse( next, &spec, &consumed );
+        if( !ulog_status_success( parsed )) { return parsed; }
+        if(
+            ( header.count <= argument )
+            || !compatible( &spec, types[ argument ] )
+            || !decode_argument( &to, &from, &spec, types[ argument ] )
+        )
+        {
+            return ulog_status_descriptive( EINVAL, "mismatched argument" );
+        }
+        ++argument;
+        format = next + consumed;
+    }
+    return ulog_status_descriptive( 0, "record decoded" );
+}
+
+/* skips arguments by their types, strings by their stored length */
+static bool
+skip_argument( reader * const from, unsigned char const type )
+{
+    size_t length;
+    switch( type )
+    {
+        case ULOG_ARG_INT: length = sizeof( int ); break;
+        case ULOG_ARG_UINT: length = sizeof( unsigned ); break;
+        case ULOG_ARG_LONG: length = sizeof( long ); break;
+        case ULOG_ARG_ULONG: length = sizeof( unsigned long ); break;
+        case ULOG_ARG_LLONG: length = sizeof( long long ); break;
+        case ULOG_ARG_ULLONG: length = sizeof( unsigned long long ); break;
+        case ULOG_ARG_DOUBLE: length = sizeof( double ); break;
+        case ULOG_ARG_LDOUBLE: length = sizeof( long double ); break;
+        case ULOG_ARG_POINTER: length = sizeof( void const * ); break;
+        case ULOG_ARG_STRING:
+        {
+            uint32_t size;
+            if( !take( from, &size, sizeof( size ))) { return false; }
+            length = size;
+            break;
+        }
+        default: return false;
+    }
+    if( from->size - from->offset < length ) { return false; }
+    from->offset += length;
+    return true;
+}
+
+ulog_status
+ulog_binary_context(
+    void const * const record,
+    size_t const size,
+    ulog_context * const context
+)
+{
+    ulog_binary_header header;
+    if(
+        ( NULL == record )
+        || ( NULL == context )
+        || ( sizeof( header ) > size )
+    )
+    {
+        return ulog_status_descriptive( EINVAL, "invalid record" );
+    }
+    memcpy( &header, record, sizeof( header ));
+    context->count = 0U;
+    context->used = 0U;
+    if(
+        ( size < header.size )
+        || ( sizeof( header ) + header.count > header.size )
+        || ( ULOG_CONTEXT_ENTRIES < header.context )
+    )
+    {
+        return ulog_status_descriptive( EINVAL, "malformed record" );
+    }
+
+    unsigned char const * const types =
+        ( unsigned char const * ) record + sizeof( header );
+    reader from =
+    {
+        .data = record,
+        .size = header.size,
+        .offset = sizeof( header ) + header.count
+    };
+    for( size_t i = 0U; i < header.count; ++i )
+    {
+        if( !skip_argument( &from, types[ i ] ))
+        {
+            return ulog_status_descriptive( EINVAL, "malformed argument" );
+        }
+    }
+    if( 0U == header.context )
+    {
+        return ulog_status_descriptive( 0, "record has no context" );
+    }
+    uint16_t used;
+    if(
+        !take( &from, &used, sizeof( used ))
+        || ( ULOG_CONTEXT_SIZE < used )
+        || !take(
+            &from,
+            context->entry,
+            header.context * sizeof( context->entry[ 0 ] )
+        )
+        || !take( &from, context->data, used )
+    )
+    {
+        return ulog_status_descriptive( EINVAL, "malformed context" );
+    }
+    /* keys and values must end within data */
+    if(( 0U == used ) || ( '\0' != context->data[ used - 1U ] ))
+    {
+        return ulog_status_descriptive( EINVAL, "malformed context" );
+    }
+    for( size_t i = 0U; i < header.context; ++i )
+    {
+        size_t const key = context->entry[ i ];
+        if(
+            ( used <= key )
+            || ( used <= key + strlen( context->data + key ) + 1U )
+        )
+        {
+            return ulog_status_descriptive( EINVAL, "malformed context" );
+        }
+    }
+    context->count = header.context;
+    context->used = used;
+    return ulog_status_descriptive( 0, "context extracted" );
+}
@@ -0,0 +1,632 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Implements block compression of logged records.
+ * \date        2016/06/06 10:12:48 AM
+ * \file        compress.c
+ * \version     1.0
+ *
+ * Compressed data is a sequence of literals followed by a match, copied
+ * from up to 65535 bytes back, as in LZ4 blocks. Each sequence begins with
+ * a token, whose high nibble is number of literals and low nibble is length
+ * of match less four. Nibble of 15 is followed by bytes added to it, 255
+ * meaning another byte follows. Literals go next, then uint16_t offset of
+ * the match, lowest byte first. The last sequence has literals alone; the
+ * last five bytes are always literals, and no match starts within the last
+ * twelve bytes.
+ **/
+
+#define _POSIX_C_SOURCE 200809L /* for sysconf */
+
+#include <ulog/compress.h>
+#include <ulog/universal.h> /* UNUSED */
+
+#include <errno.h> /* EINVAL, ENOBUFS, ENODATA, ENOMEM */
+#include <pthread.h> /* pthread_create, pthread_join, pthread_t */
+#include <stdbool.h> /* bool */
+#include <stddef.h> /* NULL, size_t */
+#include <stdint.h> /* UINT8_MAX, uint32_t, uint64_t */
+#include <stdlib.h> /* calloc, free, malloc, realloc */
+#include <string.h> /* memcmp, memcpy, memset */
+#include <unistd.h> /* sysconf */
+
+#define MAGIC "ULZ1"
+#define MAGIC_SIZE ( sizeof( MAGIC ) - 1U )
+#define MINIMUM_MATCH 4U
+#define LAST_LITERALS 5U
+#define MATCH_LIMIT 12U
+#define WINDOW 65535U
+#define NIBBLE 15U
+#define HASH_BITS 12U
+/* data which doesn't match is stepped over faster after so many misses */
+#define SKIP_TRIGGER 6U
+
+typedef struct
+{
+    unsigned char * data;
+    size_t size;
+    size_t used;
+    bool fits;
+}
+writer;
+
+static void
+put( writer * const to, void const * const value, size_t const length )
+{
+    if( !to->fits || ( to->size - to->used < length ))
+    {
+        to->fits = false;
+        return;
+    }
+    memcpy( to->data + to->used, value, length );
+    to->used += length;
+}
+
+static void
+put_byte( writer * const to, unsigned const value )
+{
+    unsigned char const byte = ( unsigned char ) value;
+    put( to, &byte, sizeof( byte ));
+}
+
+static void
+put_length( writer * const to, size_t length )
+{
+    for( ; UINT8_MAX <= length; length -= UINT8_MAX )
+    {
+        put_byte( to, UINT8_MAX );
+    }
+    put_byte( to, ( unsigned ) length );
+}
+
+/* match is its length less MINIMUM_MATCH, ignored by the last literals */
+static void
+put_literals(
+    writer * const to,
+    unsigned char const * const literals,
+    size_t const length,
+    size_t const match
+)
+{
+    put_byte(
+        to,
+        ( unsigned ) ((( NIBBLE < length ) ? NIBBLE : length ) << 4U )
+        | ( unsigned ) (( NIBBLE < match ) ? NIBBLE : match )
+    );
+    if( NIBBLE <= length ) { put_length( to, length - NIBBLE ); }
+    put( to, literals, length );
+}
+
+static void
+put_match( writer * const to, size_t const offset, size_t const match )
+{
+    put_byte( to, ( unsigned ) ( offset & UINT8_MAX ));
+    put_byte( to, ( unsigned ) ( offset >> 8U ));
+    if( NIBBLE <= match ) { put_length( to, match - NIBBLE ); }
+}
+
+static inline uint32_t
+read_word( unsigned char const * const data )
+{
+    uint32_t word;
+    memcpy( &word, data, sizeof( word ));
+    return word;
+}
+
+static inline uint64_t
+read_long( unsigned char const * const data )
+{
+    uint64_t word;
+    memcpy( &word, data, sizeof( word ));
+    return word;
+}
+
+/* compares eight bytes at once while it can */
+static inline size_t
+match_length(
+    unsigned char const * const data,
+    size_t const candidate,
+    size_t const position,
+    size_t const end
+)
+{
+    size_t length = MINIMUM_MATCH;
+    while(
+        ( sizeof( uint64_t ) <= end - position - length )
+        && ( read_long( data + candidate + length )
+            == read_long( data + position + length ))
+    )
+    {
+        length += sizeof( uint64_t );
+    }
+    while(
+        ( end > position + length )
+        && ( data[ candidate + length ] == data[ position + length ])
+    )
+    {
+        ++length;
+    }
+    return length;
+}
+
+static inline uint32_t
+hash_word( uint32_t const word )
+{
+    return ( word * 2654435761U ) >> ( 32U - HASH_BITS );
+}
+
+/* returns size of compressed data, zero if it doesn't fit in capacity */
+static size_t
+compress_data(
+    unsigned char const * const data,
+    size_t const size,
+    unsigned char * const output,
+    size_t const capacity
+)
+{
+    writer to = { .data = output, .size = capacity, .used = 0U, .fits = true };
+    size_t anchor = 0U;
+    if( MATCH_LIMIT < size )
+    {
+        /* last position of each hashed word, misses are only slower */
+        uint32_t table[ 1U << HASH_BITS ];
+        memset( table, 0, sizeof( table ));
+        size_t const limit = size - MATCH_LIMIT;
+        size_t const end = size - LAST_LITERALS;
+        size_t misses = 0U;
+        for( size_t position = 0U; ( limit > position ) && to.fits; )
+        {
+            uint32_t const word = read_word( data + position );
+            uint32_t const hash = hash_word( word );
+            size_t const candidate = table[ hash ];
+            table[ hash ] = ( uint32_t ) position;
+            if(
+                ( position <= candidate )
+                || ( WINDOW < position - candidate )
+                || ( word != read_word( data + candidate ))
+            )
+            {
+                position += 1U + ( misses++ >> SKIP_TRIGGER );
+                continue;
+            }
+            misses = 0U;
+            size_t const length =
+                match_length( data, candidate, position, end );
+            put_literals(
+                &to,
+                data + anchor,
+                position - anchor,
+                length - MINIMUM_MATCH
+            );
+            put_match( &to, position - candidate, length - MINIMUM_MATCH );
+            position += length;
+            anchor = position;
+        }
+    }
+    put_literals( &to, data + anchor, size - anchor, 0U );
+    return to.fits ? to.used : 0U;
+}
+
+static bool
+take_length(
+    unsigned char const * const data,
+    size_t const size,
+    size_t * const position,
+    size_t * const length
+)
+{
+    for( ;; )
+    {
+        if( size <= *position ) { return false; }
+        unsigned const byte = data[ ( *position )++ ];
+        *length += byte;
+        if( UINT8_MAX != byte ) { return true; }
+    }
+}
+
+/* data must fill the output exactly */
+static bool
+decompress_data(
+    unsigned char const * const data,
+    size_t const size,
+    unsigned char * const output,
+    size_t const capacity
+)
+{
+    size_t input = 0U;
+    size_t used = 0U;
+    for( ;; )
+    {
+        if( size <= input ) { return false; }
+        unsigned const token = data[ input++ ];
+        size_t literals = token >> 4U;
+        if(
+            (( NIBBLE == literals )
+                && !take_length( data, size, &input, &literals ))
+            || ( size - input < literals )
+            || ( capacity - used < literals )
+        )
+        {
+            return false;
+        }
+        memcpy( output + used, data + input, literals );
+        input += literals;
+        used += literals;
+        if( size == input ) { break; }
+        if( 2U > size - input ) { return false; }
+        size_t const offset =
+            ( size_t ) data[ input ] | (( size_t ) data[ input + 1U ] << 8U );
+        input += 2U;
+        size_t match = token & NIBBLE;
+        if(
+            (( NIBBLE == match ) && !take_length( data, size, &input, &match ))
+            || ( 0U == offset )
+            || ( used < offset )
+            || ( capacity - used < match + MINIMUM_MATCH )
+        )
+        {
+            return false;
+        }
+        match += MINIMUM_MATCH;
+        unsigned char * const target = output + used;
+        unsigned char const * const source = target - offset;
+        /* overlapping match repeats the bytes just copied */
+        if( offset >= match ) { memcpy( target, source, match ); }
+        else
+        {
+            for( size_t i = 0U; i < match; ++i ) { target[ i ] = source[ i ]; }
+        }
+        used += match;
+    }
+    return capacity == used;
+}
+
+size_t
+ulog_compress_bound( size_t const size )
+{
+    return ULOG_COMPRESS_HEADER + size + size / UINT8_MAX + 16U;
+}
+
+ulog_status
+ulog_compress_block(
+    void const * const data,
+    size_t const size,
+    void * const block,
+    size_t const capacity,
+    size_t * const written
+)
+{
+    if(
+        (( NULL == data ) && ( 0U != size )) || ( NULL == block )
+        || ( NULL == written ) || ( ULOG_COMPRESS_MAXIMUM < size )
+    )
+    {
+        return ulog_status_descriptive( EINVAL, "invalid data to compress" );
+    }
+    if( ulog_compress_bound( size ) > capacity )
+    {
+        return ulog_status_descriptive( ENOBUFS, "block buffer too small" );
+    }
+    unsigned char * const bytes = block;
+    unsigned char * const stored_data = bytes + ULOG_COMPRESS_HEADER;
+    /* compressed data must be smaller, otherwise it's stored as it is */
+    size_t stored =
+        ( 0U == size )
+            ? 0U
+            : compress_data( data, size, stored_data, size - 1U );
+    if( 0U == stored )
+    {
+        if( 0U != size ) { memcpy( stored_data, data, size ); }
+        stored = size;
+    }
+    uint32_t const sizes[ 2U ] = { ( uint32_t ) size, ( uint32_t ) stored };
+    memcpy( bytes, MAGIC, MAGIC_SIZE );
+    memcpy( bytes + MAGIC_SIZE, sizes, sizeof( sizes ));
+    *written = ULOG_COMPRESS_HEADER + stored;
+    return ulog_status_descriptive( 0, "block compressed" );
+}
+
+bool
+ulog_compressed( void const * const data, size_t const size )
+{
+    return
+        ( NULL != data ) && ( ULOG_COMPRESS_HEADER <= size )
+        && ( 0 == memcmp( data, MAGIC, MAGIC_SIZE ));
+}
+
+static ulog_status
+read_header(
+    unsigned char const * const block,
+    size_t const size,
+    size_t * const original,
+    size_t * const stored
+)
+{
+    if( ULOG_COMPRESS_HEADER > size )
+    {
+        return ulog_status_descriptive( ENODATA, "block header incomplete" );
+    }
+    uint32_t sizes[ 2U ];
+    memcpy( sizes, block + MAGIC_SIZE, sizeof( sizes ));
+    if(
+        ( 0 != memcmp( block, MAGIC, MAGIC_SIZE ))
+        || ( ULOG_COMPRESS_MAXIMUM < sizes[ 0 ] )
+        || ( sizes[ 0 ] < sizes[ 1 ] )
+    )
+    {
+        return ulog_status_descriptive( EINVAL, "malformed block header" );
+    }
+    *original = sizes[ 0 ];
+    *stored = sizes[ 1 ];
+    if( size - ULOG_COMPRESS_HEADER < *stored )
+    {
+        return ulog_status_descriptive( ENODATA, "block incomplete" );
+    }
+    return ulog_status_descriptive( 0, "block header read" );
+}
+
+ulog_status
+ulog_decompress_block(
+    void const * const block,
+    size_t const size,
+    size_t * const consumed,
+    void * const data,
+    size_t const capacity,
+    size_t * const written
+)
+{
+    if(
+        ( NULL == block ) || ( NULL == consumed ) || ( NULL == written )
+        || (( NULL == data ) && ( 0U != capacity ))
+    )
+    {
+        return ulog_status_descriptive( EINVAL, "invalid block" );
+    }
+    unsigned char const * const bytes = block;
+    size_t original = 0U;
+    size_t stored = 0U;
+    ulog_status const header = read_header( bytes, size, &original, &stored );
+    if( !ulog_status_success( header )) { return header; }
+    *consumed = ULOG_COMPRESS_HEADER + stored;
+    *written = original;
+    if( capacity < original )
+    {
+        return ulog_status_descriptive( ENOBUFS, "data buffer too small" );
+    }
+    unsigned char const * const stored_data = bytes + ULOG_COMPRESS_HEADER;
+    if( stored == original )
+    {
+        if( 0U != original ) { memcpy( data, stored_data, original ); }
+    }
+    else if( !decompress_data( stored_data, stored, data, original ))
+    {
+        return ulog_status_descriptive( EINVAL, "malformed block" );
+    }
+    return ulog_status_descriptive( 0, "block decompressed" );
+}
+
+ulog_status
+ulog_decompress_next(
+    void const * const blocks,
+    size_t const size,
+    size_t * const offset,
+    void * * const data,
+    size_t * const capacity,
+    size_t * const length
+)
+{
+    if(
+        (( NULL == blocks ) && ( 0U != size )) || ( NULL == offset )
+        || ( NULL == data ) || ( NULL == capacity ) || ( NULL == length )
+        || ( size < *offset ) || ( *capacity < *length )
+    )
+    {
+        return ulog_status_descriptive( EINVAL, "invalid blocks" );
+    }
+    if( size == *offset )
+    {
+        return ulog_status_descriptive( ENODATA, "no block left" );
+    }
+    unsigned char const * const block =
+        ( unsigned char const * ) blocks + *offset;
+    size_t original = 0U;
+    size_t stored = 0U;
+    ulog_status const header =
+        read_header( block, size - *offset, &original, &stored );
+    if( !ulog_status_success( header )) { return header; }
+    if( *capacity - *length < original )
+    {
+        size_t grown = 2U * *capacity;
+        if( grown < *length + original ) { grown = *length + original; }
+        void * const resized = realloc( *data, grown );
+        if( NULL == resized )
+        {
+            return ulog_status_descriptive( ENOMEM, "cannot grow data" );
+        }
+        *data = resized;
+        *capacity = grown;
+    }
+    size_t consumed = 0U;
+    size_t written = 0U;
+    ulog_status const result =
+        ulog_decompress_block(
+            block,
+            size - *offset,
+            &consumed,
+            ( 0U == original ) ? NULL : ( unsigned char * ) *data + *length,
+            original,
+            &written
+        );
+    if( !ulog_status_success( result )) { return result; }
+    *offset += consumed;
+    *length += written;
+    return ulog_status_descriptive( 0, "block decompressed" );
+}
+
+/* block and place of its data in the output */
+typedef struct
+{
+    unsigned char const * block;
+    size_t size;
+    size_t offset;
+    size_t length;
+}
+span;
+
+/* shared by threads, which take spans in order */
+typedef struct
+{
+    span const * spans;
+    size_t count;
+    unsigned char * output;
+    size_t next;
+    bool failed;
+}
+work;
+
+static void *
+run( void * const arg )
+{
+    work * const self = arg;
+    for( ;; )
+    {
+        size_t const index =
+            __atomic_fetch_add( &( self->next ), 1U, __ATOMIC_RELAXED );
+        if( self->count <= index ) { break; }
+        span const * const item = self->spans + index;
+        size_t consumed = 0U;
+        size_t written = 0U;
+        if(
+            !ulog_status_success(
+                ulog_decompress_block(
+                    item->block,
+                    item->size,
+                    &consumed,
+                    self->output + item->offset,
+                    item->length,
+                    &written
+                )
+            )
+        )
+        {
+            __atomic_store_n( &( self->failed ), true, __ATOMIC_RELAXED );
+        }
+    }
+    return NULL;
+}
+
+static unsigned
+count_threads( unsigned const threads )
+{
+    if( 0U != threads ) { return threads; }
+    long const online = sysconf( _SC_NPROCESSORS_ONLN );
+    return ( 0L < online ) ? ( unsigned ) online : 1U;
+}
+
+/* spans may be NULL, to count blocks and their data first */
+static ulog_status
+find_spans(
+    unsigned char const * const blocks,
+    size_t const size,
+    span * const spans,
+    size_t * const count,
+    size_t * const length
+)
+{
+    *count = 0U;
+    *length = 0U;
+    for( size_t offset = 0U; size > offset; )
+    {
+        size_t original = 0U;
+        size_t stored = 0U;
+        ulog_status const header =
+            read_header( blocks + offset, size - offset, &original, &stored );
+        /* the last block may be still being written, it's left out */
+        if( ENODATA == ulog_status_to_int( header )) { break; }
+        if( !ulog_status_success( header )) { return header; }
+        if( NULL != spans )
+        {
+            spans[ *count ] = ( span )
+            {
+                .block = blocks + offset,
+                .size = ULOG_COMPRESS_HEADER + stored,
+                .offset = *length,
+                .length = original
+            };
+        }
+        ++( *count );
+        *length += original;
+        offset += ULOG_COMPRESS_HEADER + stored;
+    }
+    return ulog_status_descriptive( 0, "blocks found" );
+}
+
+ulog_status
+ulog_decompress(
+    void const * const blocks,
+    size_t const size,
+    unsigned const threads,
+    void * * const data,
+    size_t * const length
+)
+{
+    if(
+        (( NULL == blocks ) && ( 0U != size )) || ( NULL == data )
+        || ( NULL == length )
+    )
+    {
+        return ulog_status_descriptive( EINVAL, "invalid blocks" );
+    }
+    size_t count = 0U;
+    size_t total = 0U;
+    ulog_status result = find_spans( blocks, size, NULL, &count, &total );
+    if( !ulog_status_success( result )) { return result; }
+    span * const spans = calloc( count + 1U, sizeof( span ));
+    /* output is never empty, so that it can always be freed */
+    unsigned char * const output = malloc( total + 1U );
+    if(( NULL == spans ) || ( NULL == output ))
+    {
+        free( spans );
+        free( output );
+        return ulog_status_descriptive( ENOMEM, "cannot allocate output" );
+    }
+    UNUSED( find_spans( blocks, size, spans, &count, &total ));
+    work shared =
+    {
+        .spans = spans,
+        .count = count,
+        .output = output,
+        .next = 0U,
+        .failed = false
+    };
+    /* calling thread decompresses too, along with those which started */
+    unsigned const helpers =
+        ( count < count_threads( threads ))
+            ? ( unsigned ) count
+            : count_threads( threads );
+    pthread_t * const started =
+        ( 1U < helpers ) ? calloc( helpers - 1U, sizeof( pthread_t )) : NULL;
+    unsigned running = 0U;
+    while(( NULL != started ) && ( running < helpers - 1U ))
+    {
+        if( 0 != pthread_create( started + running, NULL, run, &shared ))
+        {
+            break;
+        }
+        ++running;
+    }
+    UNUSED( run( &shared ));
+    for( unsigned i = 0U; i < running; ++i )
+    {
+        UNUSED( pthread_join( started[ i ], NULL ));
+    }
+    free( started );
+    free( spans );
+    if( shared.failed )
+    {
+        free( output );
+        return ulog_status_descriptive( EINVAL, "malformed block" );
+    }
+    *data = output;
+    *length = total;
+    return ulog_status_descriptive( 0, "blocks decompressed" );
+}
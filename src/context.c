@@ -0,0 +1,106 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Implements thread-local context attached to log records.
+ * \date        2016/05/07 10:51:06 AM
+ * \file        context.c
+ * \version     1.0
+ *
+ *
+ **/
+
+#include <ulog/context.h>
+#include <ulog/universal.h> /* THREADLOCAL */
+
+#include <errno.h> /* ENOBUFS, ENODATA, ENOENT */
+#include <stdio.h> /* snprintf */
+#include <string.h> /* memcpy, strlen */
+
+static THREADLOCAL ulog_context own;
+/* context of record delivered on this thread, NULL outside of delivery */
+static THREADLOCAL ulog_context const * installed;
+
+ulog_status
+ulog_context_push( char const * const key, char const * const value )
+{
+    if(( NULL == key ) || ( NULL == value ))
+    {
+        return ulog_status_descriptive( ENODATA, "invalid context pair" );
+    }
+    size_t const key_size = strlen( key ) + 1U;
+    size_t const value_size = strlen( value ) + 1U;
+    if(
+        ( ULOG_CONTEXT_ENTRIES == own.count )
+        || ( ULOG_CONTEXT_SIZE - own.used < key_size + value_size )
+    )
+    {
+        return ulog_status_descriptive( ENOBUFS, "context is full" );
+    }
+    memcpy( own.data + own.used, key, key_size );
+    memcpy( own.data + own.used + key_size, value, value_size );
+    own.entry[ own.count++ ] = own.used;
+    own.used = ( uint16_t ) ( own.used + key_size + value_size );
+    return ulog_status_descriptive( 0, "context pair pushed" );
+}
+
+ulog_status
+ulog_context_pop( void )
+{
+    if( 0U == own.count )
+    {
+        return ulog_status_descriptive( ENOENT, "context is empty" );
+    }
+    own.used = own.entry[ --own.count ];
+    return ulog_status_descriptive( 0, "context pair popped" );
+}
+
+ulog_context const *
+ulog_context_get( void )
+{
+    return ( NULL == installed ) ? &own : installed;
+}
+
+size_t
+ulog_context_render(
+    ulog_context const * const context,
+    char * const text,
+    size_t const length
+)
+{
+    if( 0U == length ) { return 0U; }
+    text[ 0 ] = '\0';
+    size_t used = 0U;
+    for( size_t i = 0U; ( i < context->count ) && ( used + 1U < length ); ++i )
+    {
+        int const written =
+            snprintf(
+                text + used,
+                length - used,
+                "%s%s=%s",
+                ( 0U == i ) ? "" : " ",
+                ulog_context_key( context, i ),
+                ulog_context_value( context, i )
+            );
+        if( 0 > written ) { break; }
+        size_t const room = length - used - 1U;
+        used += (( size_t ) written < room ) ? ( size_t ) written : room;
+    }
+    return used;
+}
+
+void
+ulog_context_capture( ulog_context * const copy )
+{
+    ulog_context const * const context = ulog_context_get();
+    copy->count = context->count;
+    copy->used = context->used;
+    memcpy( copy->entry, context->entry, context->count * sizeof( uint16_t ));
+    memcpy( copy->data, context->data, context->used );
+}
+
+ulog_context const *
+ulog_context_install( ulog_context const * const context )
+{
+    ulog_context const * const previous = installed;
+    installed = context;
+    return previous;
+}
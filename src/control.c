@@ -0,0 +1,356 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Implements control of verbosity from outside of the process.
+ * \date        2016/05/21 10:40:18 AM
+ * \file        control.c
+ * \version     1.0
+ *
+ *
+ **/
+
+#define _POSIX_C_SOURCE 200809L /* for sigaction, strdup */
+
+#include <ulog/control.h>
+#include <ulog/status.h> /* ulog_status, ulog_status_descriptive */
+#include <ulog/ulog.h> /* ulog_obj_get, ulog_callsite_state */
+#include <ulog/universal.h> /* THREADUNSAFE, UNUSED */
+
+#include <errno.h> /* EIO, ENOMEM, ENOTSUP, errno */
+#include <fcntl.h> /* O_RDONLY, open */
+#include <poll.h> /* poll, struct pollfd */
+#include <pthread.h> /* pthread_create, pthread_join, pthread_t */
+#include <signal.h> /* SIGUSR1, SIGUSR2, sigaction */
+#include <stdbool.h> /* bool */
+#include <stddef.h> /* NULL, size_t */
+#include <stdio.h> /* sscanf */
+#include <stdlib.h> /* free */
+#include <string.h> /* memset, strchr, strcmp, strdup, strrchr */
+#include <strings.h> /* strcasecmp */
+#include <unistd.h> /* close, pipe, read, write */
+#ifdef HAVE_SYS_INOTIFY_H
+# include <sys/inotify.h> /* inotify_add_watch, inotify_init1, etc. */
+#endif /* HAVE_SYS_INOTIFY_H */
+
+typedef struct
+{
+    bool signals;
+    struct sigaction previous[ 2 ];
+    bool watching;
+    pthread_t watcher;
+    int inotify;
+    /* written to by ulog_control_stop() to wake watcher up */
+    int wake[ 2 ];
+    /* path of control file, split into directory and name */
+    char * path;
+    char const * name;
+}
+control_state;
+
+static control_state control;
+/* set before handlers are installed, read only by them */
+static ulog_control_step_fn step_;
+
+static int const signals[ 2 ] = { SIGUSR1, SIGUSR2 };
+
+static void
+on_signal( int const number )
+{
+    int const saved = errno;
+    step_(( SIGUSR1 == number ) ? 1 : -1 );
+    errno = saved;
+}
+
+static bool
+parse_level( char const * const text, ulog_level * const level )
+{
+    static char const * const names[ ULOG_LEVELS ] =
+    {
+        [ ERROR ] = "ERROR",
+        [ WARNING ] = "WARNING",
+        [ INFO ] = "INFO",
+        [ DEBUG ] = "DEBUG"
+    };
+    for( size_t i = 0U; i < ULOG_LEVELS; ++i )
+    {
+        if( 0 == strcasecmp( text, names[ i ] ))
+        {
+            *level = ( ulog_level ) i;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool
+parse_state( char const * const text, ulog_callsite_state * const state )
+{
+    if( 0 == strcasecmp( text, "on" )) { *state = ULOG_CALLSITE_ON; }
+    else if( 0 == strcasecmp( text, "off" )) { *state = ULOG_CALLSITE_OFF; }
+    else if( 0 == strcasecmp( text, "default" ))
+    {
+        *state = ULOG_CALLSITE_DEFAULT;
+    }
+    else { return false; }
+    return true;
+}
+
+static void
+apply_line( ulog_obj const * const ulog, char const * const line )
+{
+    char command[ 16U ];
+    char first[ ULOG_CALLSITE_PATTERN + 16U ];
+    char second[ 16U ];
+    int const fields =
+        sscanf( line, "%15s %79s %15s", command, first, second );
+    if(( 1 > fields ) || ( '#' == command[ 0 ])) { return; }
+    ulog_level level;
+    ulog_callsite_state state;
+    if(
+        ( 2 == fields )
+        && ( 0 == strcmp( command, "verbosity" ))
+        && parse_level( first, &level )
+    )
+    {
+        UNUSED( ulog->op->verbosity( ulog, level ));
+    }
+    else if(
+        ( 3 == fields )
+        && ( 0 == strcmp( command, "callsite" ))
+        && parse_state( second, &state )
+    )
+    {
+        UNUSED( ulog->op->callsite( ulog, first, state ));
+    }
+}
+
+static void
+apply_file( char const * const path )
+{
+    int const file = open( path, O_RDONLY );
+    if( -1 == file ) { return; }
+    char text[ ULOG_CONTROL_SIZE + 1U ];
+    size_t size = 0U;
+    for( ;; )
+    {
+        ssize_t const got = read( file, text + size, ULOG_CONTROL_SIZE - size );
+        if( 0 >= got ) { break; }
+        size += ( size_t ) got;
+    }
+    close( file );
+    text[ size ] = '\0';
+
+    ulog_obj const * const ulog = ulog_obj_get();
+    UNUSED( ulog->op->callsite( ulog, NULL, ULOG_CALLSITE_DEFAULT ));
+    for( char * line = text; NULL != line; )
+    {
+        char * const end = strchr( line, '\n' );
+        if( NULL != end ) { *end = '\0'; }
+        apply_line( ulog, line );
+        line = ( NULL == end ) ? NULL : end + 1;
+    }
+}
+
+#ifdef HAVE_SYS_INOTIFY_H
+
+static void *
+watch( void * const unused )
+{
+    UNUSED( unused );
+    union
+    {
+        struct inotify_event event;
+        char data[ 4096U ];
+    }
+    buffer;
+    struct pollfd descriptors[ 2 ] =
+    {
+        { .fd = control.inotify, .events = POLLIN },
+        { .fd = control.wake[ 0 ], .events = POLLIN }
+    };
+    for( ;; )
+    {
+        if( 0 > poll( descriptors, 2U, -1 ))
+        {
+            if( EINTR == errno ) { continue; }
+            break;
+        }
+        if( 0 != descriptors[ 1 ].revents ) { break; }
+        ssize_t const got = read( control.inotify, &buffer, sizeof( buffer ));
+        bool changed = false;
+        for( ssize_t offset = 0; offset < got; )
+        {
+            struct inotify_event const * const event =
+                ( struct inotify_event const * ) ( buffer.data + offset );
+            if(
+                ( 0U < event->len )
+                && ( 0 == strcmp( event->name, control.name ))
+            )
+            {
+                changed = true;
+            }
+            offset += ( ssize_t ) ( sizeof( *event ) + event->len );
+        }
+        if( changed ) { apply_file( control.path ); }
+    }
+    return NULL;
+}
+
+static ulog_status
+start_watching( char const * const file )
+{
+    control.path = strdup( file );
+    if( NULL == control.path )
+    {
+        return ulog_status_descriptive( ENOMEM, "cannot copy control file" );
+    }
+    apply_file( control.path );
+
+    /* directory is watched, so that replacing the file is noticed */
+    char * const slash = strrchr( control.path, '/' );
+    char const * const directory =
+        ( NULL == slash ) ? "." : ( slash == control.path ) ? "/" : NULL;
+    if( NULL != slash ) { *slash = '\0'; }
+    control.name = ( NULL == slash ) ? control.path : slash + 1;
+    control.inotify = inotify_init1( IN_CLOEXEC );
+    bool const watched =
+        ( -1 != control.inotify )
+        && ( -1 != inotify_add_watch(
+            control.inotify,
+            ( NULL == directory ) ? control.path : directory,
+            IN_CLOSE_WRITE | IN_MOVED_TO
+        ));
+    if( NULL != slash ) { *slash = '/'; }
+    if( watched && ( 0 == pipe( control.wake )))
+    {
+        if( 0 == pthread_create( &( control.watcher ), NULL, watch, NULL ))
+        {
+            control.watching = true;
+            return ulog_status_descriptive( 0, "control file watched" );
+        }
+        close( control.wake[ 0 ] );
+        close( control.wake[ 1 ] );
+    }
+    if( -1 != control.inotify ) { close( control.inotify ); }
+    free( control.path );
+    control.path = NULL;
+    return ulog_status_descriptive( EIO, "cannot watch control file" );
+}
+
+static void
+stop_watching( void )
+{
+    if( !control.watching ) { return; }
+    char const wake = 1;
+    UNUSED( write( control.wake[ 1 ], &wake, sizeof( wake )));
+    pthread_join( control.watcher, NULL );
+    close( control.wake[ 0 ] );
+    close( control.wake[ 1 ] );
+    close( control.inotify );
+    free( control.path );
+    control.path = NULL;
+    control.watching = false;
+}
+
+#else /* HAVE_SYS_INOTIFY_H */
+
+static ulog_status
+start_watching( char const * const file )
+{
+    UNUSED( file );
+    return ulog_status_descriptive( ENOTSUP, "cannot watch control file" );
+}
+
+static void
+stop_watching( void )
+{
+}
+
+#endif /* HAVE_SYS_INOTIFY_H */
+
+static void
+restore_signals( void )
+{
+    if( !control.signals ) { return; }
+    for( size_t i = 0U; i < 2U; ++i )
+    {
+        sigaction( signals[ i ], &( control.previous[ i ] ), NULL );
+    }
+    control.signals = false;
+}
+
+static ulog_status
+install_signals( void )
+{
+    struct sigaction action;
+    memset( &action, 0, sizeof( action ));
+    action.sa_handler = on_signal;
+    action.sa_flags = SA_RESTART;
+    sigemptyset( &( action.sa_mask ));
+    for( size_t i = 0U; i < 2U; ++i )
+    {
+        if( 0 != sigaction( signals[ i ], &action, &( control.previous[ i ] )))
+        {
+            while( 0U < i-- )
+            {
+                sigaction( signals[ i ], &( control.previous[ i ] ), NULL );
+            }
+            return
+                ulog_status_descriptive(
+                    EIO,
+                    "cannot install signal handlers"
+                );
+        }
+    }
+    control.signals = true;
+    return ulog_status_descriptive( 0, "signal handlers installed" );
+}
+
+THREADUNSAFE ulog_status
+ulog_control_start(
+    ulog_control_config const * const config,
+    ulog_control_step_fn const step
+)
+{
+    step_ = step;
+    if( config->signals )
+    {
+        ulog_status const installed = install_signals();
+        if( !ulog_status_success( installed )) { return installed; }
+    }
+    if( NULL != config->file )
+    {
+        ulog_status const watched = start_watching( config->file );
+        if( !ulog_status_success( watched ))
+        {
+            restore_signals();
+            return watched;
+        }
+    }
+    return ulog_status_descriptive( 0, "control channels open" );
+}
+
+THREADUNSAFE void
+ulog_control_stop( void )
+{
+    restore_signals();
+    stop_watching();
+}
+
+THREADUNSAFE ulog_status
+ulog_control_restart( void )
+{
+    if( !control.watching )
+    {
+        return ulog_status_descriptive( 0, "control file not watched" );
+    }
+    /* descriptors are the child's copies, the thread is the parent's */
+    char * const path = control.path;
+    close( control.wake[ 0 ] );
+    close( control.wake[ 1 ] );
+    close( control.inotify );
+    control.path = NULL;
+    control.watching = false;
+    ulog_status const watched = start_watching( path );
+    free( path );
+    return watched;
+}
@@ -0,0 +1,266 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Implements per-thread duplicate record suppression.
+ * \date        2016/02/07 14:31:02 PM
+ * \file        dedup.c
+ * \version     1.0
+ *
+ * The last record of each thread is kept in a node of its own, listed so
+ * that other threads can take its pending duplicates, e.g. at cleanup or
+ * once their timeout passes while the thread logs nothing. The owner and
+ * whoever takes its duplicates exclude each other with a spin lock of the
+ * node; the list has a spin lock too, taken when a thread starts or ends
+ * logging and by sweeps. Nodes come from a pool allocated along with the
+ * key of thread-local node, so that logging doesn't allocate.
+ **/
+
+#define _POSIX_C_SOURCE 200809L /* for pthread_key_create, sched_yield */
+
+#include <ulog/dedup.h>
+#include <ulog/pool.h> /* ulog_pool, ulog_pool_get */
+#include <ulog/status.h> /* ulog_status, ulog_status_descriptive */
+#include <ulog/universal.h> /* THREADLOCAL, UNUSED */
+
+#include <errno.h> /* EALREADY */
+#include <pthread.h> /* pthread_key_create, pthread_once, etc. */
+#include <sched.h> /* sched_yield */
+#include <stdbool.h> /* bool */
+#include <stddef.h> /* NULL, size_t */
+#include <stdint.h> /* uint8_t, uint32_t, uint64_t */
+
+/* FNV-1a, 64-bit variant */
+#define HASH_OFFSET_BASIS UINT64_C( 14695981039346656037 )
+#define HASH_PRIME UINT64_C( 1099511628211 )
+
+typedef struct dedup_thread_struct dedup_thread;
+
+/* last record seen by thread; repeated counts suppressed copies */
+struct dedup_thread_struct
+{
+    ulog_dedup_record last;
+    bool valid;
+    /* set when the thread exits, the next sweep frees the node */
+    bool exited;
+    uint32_t busy;
+    dedup_thread * previous;
+    dedup_thread * next;
+};
+
+static THREADLOCAL dedup_thread * own;
+static dedup_thread * threads;
+static uint32_t threads_busy;
+static pthread_once_t key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t key;
+static ulog_pool pool;
+static bool key_created;
+
+uint64_t
+ulog_dedup_hash( uint64_t const seed, void const * const data, size_t size )
+{
+    uint8_t const * byte = data;
+    uint64_t result = ( 0U == seed ) ? HASH_OFFSET_BASIS : seed;
+    while( 0U < size-- )
+    {
+        result ^= *( byte++ );
+        result *= HASH_PRIME;
+    }
+    return result;
+}
+
+static inline void
+acquire( uint32_t * const lock )
+{
+    while( 0U != __atomic_exchange_n( lock, 1U, __ATOMIC_ACQUIRE ))
+    {
+        UNUSED( sched_yield());
+    }
+}
+
+static inline void
+release( uint32_t * const lock )
+{
+    __atomic_store_n( lock, 0U, __ATOMIC_RELEASE );
+}
+
+/* destructor of thread-local key, called when thread exits */
+static void
+exit_thread( void * const value )
+{
+    dedup_thread * const item = value;
+    acquire( &( item->busy ));
+    item->exited = true;
+    release( &( item->busy ));
+    own = NULL;
+}
+
+static void
+create_key( void )
+{
+    pool = ulog_pool_get();
+    key_created =
+        ulog_status_success(
+            pool.op->setup( &pool, sizeof( dedup_thread ), ULOG_DEDUP_THREADS )
+        )
+        && ( 0 == pthread_key_create( &key, exit_thread ));
+}
+
+/* node of calling thread, listed on first use; NULL if it can't be */
+static dedup_thread *
+own_thread( void )
+{
+    if( NULL != own ) { return own; }
+    UNUSED( pthread_once( &key_once, create_key ));
+    if( !key_created ) { return NULL; }
+    void * block = NULL;
+    if( !ulog_status_success( pool.op->acquire( &pool, &block )))
+    {
+        return NULL;
+    }
+    dedup_thread * const item = block;
+    *item = ( dedup_thread ) { .valid = false };
+    if( 0 != pthread_setspecific( key, item ))
+    {
+        UNUSED( pool.op->release( &pool, item ));
+        return NULL;
+    }
+    acquire( &threads_busy );
+    item->next = threads;
+    if( NULL != threads ) { threads->previous = item; }
+    threads = item;
+    release( &threads_busy );
+    own = item;
+    return item;
+}
+
+static void
+unlink_thread( dedup_thread * const item )
+{
+    if( NULL != item->previous ) { item->previous->next = item->next; }
+    else { threads = item->next; }
+    if( NULL != item->next ) { item->next->previous = item->previous; }
+}
+
+static inline ulog_dedup_record
+take_pending( dedup_thread * const item, uint64_t const time )
+{
+    ulog_dedup_record const result = item->last;
+    item->last.repeated = 0U;
+    item->last.time = time;
+    return result;
+}
+
+ulog_status
+ulog_dedup_filter(
+    ulog_dedup_record const * const record,
+    uint64_t const timeout,
+    ulog_dedup_record * const flushed
+)
+{
+    flushed->repeated = 0U;
+    dedup_thread * const item = own_thread();
+    if( NULL == item ) { return ulog_status_descriptive( 0, "new record" ); }
+    acquire( &( item->busy ));
+    if( !( item->valid ) || ( record->hash != item->last.hash ))
+    {
+        if( item->valid ) { *flushed = take_pending( item, record->time ); }
+        item->last = *record;
+        item->last.repeated = 0U;
+        item->valid = true;
+        release( &( item->busy ));
+        return ulog_status_descriptive( 0, "new record" );
+    }
+
+    ++( item->last.repeated );
+    if( timeout <= ( record->time - item->last.time ))
+    {
+        *flushed = take_pending( item, record->time );
+    }
+    release( &( item->busy ));
+    return ulog_status_descriptive( EALREADY, "duplicate record suppressed" );
+}
+
+bool
+ulog_dedup_prepare( void )
+{
+    return NULL != own_thread();
+}
+
+void
+ulog_dedup_flush( ulog_dedup_record * const flushed )
+{
+    flushed->repeated = 0U;
+    dedup_thread * const item = own;
+    if( NULL == item ) { return; }
+    acquire( &( item->busy ));
+    *flushed = take_pending( item, 0U );
+    item->valid = false;
+    release( &( item->busy ));
+}
+
+size_t
+ulog_dedup_sweep(
+    uint64_t const now,
+    uint64_t const timeout,
+    ulog_dedup_record * const flushed,
+    size_t const capacity
+)
+{
+    size_t taken = 0U;
+    acquire( &threads_busy );
+    for( dedup_thread * item = threads; NULL != item; )
+    {
+        if( capacity == taken ) { break; }
+        dedup_thread * const next = item->next;
+        acquire( &( item->busy ));
+        bool const exited = item->exited;
+        if(
+            ( 0U != item->last.repeated )
+            && (
+                exited
+                || ( 0U == timeout )
+                || ( timeout <= now - item->last.time )
+            )
+        )
+        {
+            flushed[ taken++ ] = take_pending( item, now );
+        }
+        if( 0U == timeout ) { item->valid = false; }
+        release( &( item->busy ));
+        if( exited )
+        {
+            unlink_thread( item );
+            UNUSED( pool.op->release( &pool, item ));
+        }
+        item = next;
+    }
+    release( &threads_busy );
+    return taken;
+}
+
+void
+ulog_dedup_lock( void )
+{
+    acquire( &threads_busy );
+}
+
+void
+ulog_dedup_unlock( void )
+{
+    release( &threads_busy );
+}
+
+/* the list was locked by ulog_dedup_lock() before fork() */
+void
+ulog_dedup_reset( void )
+{
+    threads_busy = 0U;
+    for( dedup_thread * item = threads; NULL != item; item = item->next )
+    {
+        item->busy = 0U;
+        if( own != item )
+        {
+            item->last.repeated = 0U;
+            item->exited = true;
+        }
+    }
+}
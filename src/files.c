@@ -0,0 +1,820 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Implements files written by each thread on its own.
+ * \date        2016/06/02 10:31:08 AM
+ * \file        files.c
+ * \version     1.0
+ *
+ *
+ **/
+
+#define _DEFAULT_SOURCE /* for syscall */
+
+#include <ulog/files.h>
+#include <ulog/binary.h> /* ulog_binary_encode */
+#include <ulog/compress.h> /* ulog_compress_block, ulog_compress_bound */
+#include <ulog/context.h> /* ulog_context_get */
+#include <ulog/intern.h> /* ulog_intern_begin, ulog_intern_encode, etc. */
+#include <ulog/mutex.h> /* ulog_mutex, ulog_mutex_get, ulog_mutex_park_ */
+#include <ulog/status.h> /* ulog_status, ulog_status_descriptive */
+#include <ulog/universal.h> /* THREADUNSAFE, UNUSED */
+
+#include <errno.h> /* EALREADY, EINTR, EINVAL, EIO, ENOMEM */
+#include <fcntl.h> /* O_APPEND, O_CLOEXEC, O_CREAT, O_WRONLY, open */
+#include <limits.h> /* PATH_MAX */
+#include <pthread.h> /* pthread_create, pthread_getspecific, etc. */
+#include <stdbool.h> /* bool */
+#include <stddef.h> /* NULL, size_t */
+#include <stdint.h> /* UINT64_MAX, uint32_t */
+#include <stdarg.h> /* va_end, va_list, va_start */
+#include <stdio.h> /* snprintf, vsnprintf */
+#include <stdlib.h> /* free, malloc */
+#include <string.h> /* memcpy, strlen */
+#include <unistd.h> /* close, syscall, write */
+#ifdef __linux__
+# include <sys/syscall.h> /* SYS_gettid */
+#endif /* __linux__ */
+
+/* room left in path for ".<thread ID>.log" */
+#define SUFFIX_SIZE 32U
+/* states of spare buffer; the thread waiting for it to be compressed parks */
+#define SPARE_FREE 0U
+#define SPARE_PENDING 1U
+#define SPARE_WAITED 2U
+
+typedef struct thread_file_struct thread_file;
+
+/* owned by its thread, listed so that cleanup can reach it */
+struct thread_file_struct
+{
+    ulog_files_state * owner;
+    int file;
+    size_t size;
+    /* buffer being filled; the spare one may be compressed meanwhile */
+    char * filling;
+    char * spare;
+    size_t spare_size;
+    uint32_t pending;
+    bool failed;
+    thread_file * queued;
+    thread_file * previous;
+    thread_file * next;
+    ulog_intern_stream stream;
+    char buffer[];
+};
+
+struct ulog_files_state_struct
+{
+    ulog_files_op_table const * op;
+    pthread_key_t key;
+    /* guards the list, taken only when thread opens or closes its file */
+    ulog_mutex guard;
+    thread_file * files;
+    size_t buffer;
+    /* room the buffer must have left for the longest record */
+    size_t record;
+    bool interned;
+    /* spare buffers handed to compressing thread, also under the guard */
+    bool compress;
+    bool compressing;
+    bool stop;
+    /* set while compressing thread parks, for hand-off to know to wake it */
+    uint32_t sleeping;
+    thread_file * first_queued;
+    thread_file * last_queued;
+    pthread_t compressor;
+    unsigned char * block;
+    size_t block_size;
+    char base[];
+};
+
+static inline bool
+valid( ulog_files const * const self );
+
+static inline ulog_status
+generic_invalid( ulog_files const * const self )
+{
+    UNUSED( self );
+    return ulog_status_descriptive( EINVAL, "invalid files object" );
+}
+
+static inline ulog_status
+generic_uninitialized( ulog_files const * const self )
+{
+    UNUSED( self );
+    return ulog_status_descriptive( EINVAL, "files object uninitialized" );
+}
+
+static inline ulog_status
+setup_already(
+    ulog_files * const self,
+    ulog_files_config const * const config
+)
+{
+    UNUSED( self );
+    UNUSED( config );
+    return ulog_status_descriptive( EALREADY, "files already set up" );
+}
+
+static inline ulog_status
+cleanup_already( ulog_files * const self )
+{
+    UNUSED( self );
+    return ulog_status_descriptive( EALREADY, "files already cleaned up" );
+}
+
+static inline ulog_status
+submit_uninitialized(
+    ulog_files const * const self,
+    ulog_level const level,
+    unsigned char const * const signature,
+    char const * const format,
+    va_list args
+)
+{
+    UNUSED( level );
+    UNUSED( signature );
+    UNUSED( format );
+    UNUSED( args );
+    return generic_uninitialized( self );
+}
+
+static inline ulog_status
+reset_uninitialized( ulog_files * const self )
+{
+    return generic_uninitialized( self );
+}
+
+static THREADUNSAFE ulog_status
+setup_safe(
+    ulog_files * const self,
+    ulog_files_config const * const config
+);
+static THREADUNSAFE ulog_status
+cleanup_safe( ulog_files * const self );
+static ulog_status
+submit_safe(
+    ulog_files const * const self,
+    ulog_level const level,
+    unsigned char const * const signature,
+    char const * const format,
+    va_list args
+);
+static THREADUNSAFE ulog_status
+reset_safe( ulog_files * const self );
+
+static ulog_files_op_table const default_op =
+{
+    .setup = setup_safe,
+    .cleanup = cleanup_already,
+    .submit = submit_uninitialized,
+    .reset = reset_uninitialized
+};
+static ulog_files_op_table const setup_op =
+{
+    .setup = setup_already,
+    .cleanup = cleanup_safe,
+    .submit = submit_safe,
+    .reset = reset_safe
+};
+
+static ulog_files_state guard = { .op = &default_op };
+
+static unsigned long
+thread_id( void )
+{
+#ifdef __linux__
+    return ( unsigned long ) syscall( SYS_gettid );
+#else /* !__linux__ */
+    /* numbers threads in order of their first record instead */
+    static unsigned long last;
+    return __atomic_add_fetch( &last, 1U, __ATOMIC_RELAXED );
+#endif /* __linux__ */
+}
+
+static bool
+write_all( int const file, void const * const data, size_t const size )
+{
+    char const * position = data;
+    for( size_t left = size; 0U != left; )
+    {
+        ssize_t const written = write( file, position, left );
+        if( 0 > written )
+        {
+            if( EINTR == errno ) { continue; }
+            return false;
+        }
+        position += written;
+        left -= ( size_t ) written;
+    }
+    return true;
+}
+
+/* buffer is emptied even if it can't be written, so that logging goes on */
+static bool
+write_buffer( thread_file * const item )
+{
+    size_t const size = item->size;
+    item->size = 0U;
+    return write_all( item->file, item->filling, size );
+}
+
+/* called after queueing a buffer, or setting stop */
+static void
+wake_compressor( ulog_files_state * const state )
+{
+    uint32_t * const sleeping = &( state->sleeping );
+    __atomic_thread_fence( __ATOMIC_SEQ_CST );
+    if(
+        ( 0U != __atomic_load_n( sleeping, __ATOMIC_RELAXED ))
+        && ( 0U != __atomic_exchange_n( sleeping, 0U, __ATOMIC_RELAXED ))
+    )
+    {
+        ulog_mutex_unpark_( sleeping, 1, false );
+    }
+}
+
+static void
+wait_compressed( thread_file * const item )
+{
+    uint32_t pending = __atomic_load_n( &( item->pending ), __ATOMIC_ACQUIRE );
+    while( SPARE_FREE != pending )
+    {
+        /* marked waited, so that compressing thread knows to wake it */
+        if(
+            ( SPARE_PENDING == pending )
+            && !__atomic_compare_exchange_n(
+                &( item->pending ),
+                &pending,
+                SPARE_WAITED,
+                false,
+                __ATOMIC_ACQUIRE,
+                __ATOMIC_ACQUIRE
+            )
+        )
+        {
+            continue;
+        }
+        ulog_mutex_park_(
+            &( item->pending ),
+            SPARE_WAITED,
+            UINT64_MAX,
+            false
+        );
+        pending = __atomic_load_n( &( item->pending ), __ATOMIC_ACQUIRE );
+    }
+}
+
+/* thread goes on filling the spare buffer while the full one is compressed */
+static bool
+hand_off( ulog_files_state * const state, thread_file * const item )
+{
+    wait_compressed( item );
+    bool const failed =
+        __atomic_exchange_n( &( item->failed ), false, __ATOMIC_RELAXED );
+    if(( 0U == item->size ) || !( state->compressing ))
+    {
+        item->size = 0U;
+        return !failed && state->compressing;
+    }
+    char * const full = item->filling;
+    item->filling = item->spare;
+    item->spare = full;
+    item->spare_size = item->size;
+    item->size = 0U;
+    item->queued = NULL;
+    __atomic_store_n( &( item->pending ), SPARE_PENDING, __ATOMIC_RELAXED );
+    ulog_mutex const * const lock = &( state->guard );
+    UNUSED( lock->op->lock( lock ));
+    if( NULL == state->last_queued )
+    {
+        __atomic_store_n( &( state->first_queued ), item, __ATOMIC_RELAXED );
+    }
+    else { state->last_queued->queued = item; }
+    state->last_queued = item;
+    UNUSED( lock->op->unlock( lock ));
+    wake_compressor( state );
+    return !failed;
+}
+
+static bool
+flush( ulog_files_state * const state, thread_file * const item )
+{
+    return state->compress ? hand_off( state, item ) : write_buffer( item );
+}
+
+static thread_file *
+dequeue( ulog_files_state * const state )
+{
+    if( NULL == __atomic_load_n( &( state->first_queued ), __ATOMIC_RELAXED ))
+    {
+        return NULL;
+    }
+    ulog_mutex const * const lock = &( state->guard );
+    UNUSED( lock->op->lock( lock ));
+    thread_file * const item = state->first_queued;
+    __atomic_store_n(
+        &( state->first_queued ),
+        item->queued,
+        __ATOMIC_RELAXED
+    );
+    if( NULL == item->queued ) { state->last_queued = NULL; }
+    UNUSED( lock->op->unlock( lock ));
+    return item;
+}
+
+/* blocks of each file are written in order, as they're queued in order */
+static void *
+compress_buffers( void * const arg )
+{
+    ulog_files_state * const state = arg;
+    for( ;; )
+    {
+        thread_file * const item = dequeue( state );
+        if( NULL != item )
+        {
+            size_t written = 0U;
+            bool const stored =
+                ulog_status_success(
+                    ulog_compress_block(
+                        item->spare,
+                        item->spare_size,
+                        state->block,
+                        state->block_size,
+                        &written
+                    )
+                )
+                && write_all( item->file, state->block, written );
+            if( !stored )
+            {
+                __atomic_store_n( &( item->failed ), true, __ATOMIC_RELAXED );
+            }
+            if(
+                SPARE_WAITED
+                == __atomic_exchange_n(
+                    &( item->pending ),
+                    SPARE_FREE,
+                    __ATOMIC_RELEASE
+                )
+            )
+            {
+                ulog_mutex_unpark_( &( item->pending ), 1, false );
+            }
+            continue;
+        }
+        /* files are closed when stop is set, so nothing gets queued */
+        if( __atomic_load_n( &( state->stop ), __ATOMIC_ACQUIRE )) { break; }
+        /* announced before looking at the queue again, so that threads
+         * which queue a buffer meanwhile see it and wake this one */
+        __atomic_store_n( &( state->sleeping ), 1U, __ATOMIC_RELAXED );
+        __atomic_thread_fence( __ATOMIC_SEQ_CST );
+        thread_file * const * const first = &( state->first_queued );
+        if(
+            ( NULL == __atomic_load_n( first, __ATOMIC_RELAXED ))
+            && !__atomic_load_n( &( state->stop ), __ATOMIC_ACQUIRE )
+        )
+        {
+            ulog_mutex_park_(
+                &( state->sleeping ),
+                1U,
+                UINT64_MAX,
+                false
+            );
+        }
+        __atomic_store_n( &( state->sleeping ), 0U, __ATOMIC_RELAXED );
+    }
+    return NULL;
+}
+
+static void
+start_compressing( ulog_files_state * const state )
+{
+    state->first_queued = NULL;
+    state->last_queued = NULL;
+    state->stop = false;
+    state->sleeping = 0U;
+    state->compressing =
+        state->compress
+        && ( 0 == pthread_create(
+            &( state->compressor ),
+            NULL,
+            compress_buffers,
+            state
+        ));
+}
+
+static void
+link_file( ulog_files_state * const state, thread_file * const item )
+{
+    item->previous = NULL;
+    item->next = state->files;
+    if( NULL != state->files ) { state->files->previous = item; }
+    state->files = item;
+}
+
+static void
+unlink_file( ulog_files_state * const state, thread_file * const item )
+{
+    if( NULL != item->previous ) { item->previous->next = item->next; }
+    else { state->files = item->next; }
+    if( NULL != item->next ) { item->next->previous = item->previous; }
+}
+
+static void
+close_file( ulog_files_state * const state, thread_file * const item )
+{
+    UNUSED( flush( state, item ));
+    wait_compressed( item );
+    close( item->file );
+    free( item );
+}
+
+/* destructor of thread-local key, called when thread exits */
+static void
+exit_thread( void * const value )
+{
+    thread_file * const item = value;
+    ulog_files_state * const state = item->owner;
+    ulog_mutex const * const lock = &( state->guard );
+    UNUSED( lock->op->lock( lock ));
+    unlink_file( state, item );
+    UNUSED( lock->op->unlock( lock ));
+    close_file( state, item );
+}
+
+static ulog_status
+open_file( ulog_files_state * const state, thread_file * * const opened )
+{
+    size_t const buffers = state->compress ? 2U : 1U;
+    thread_file * const item =
+        malloc( sizeof( thread_file ) + buffers * state->buffer );
+    if( NULL == item )
+    {
+        return ulog_status_descriptive( ENOMEM, "cannot allocate buffer" );
+    }
+    char path[ PATH_MAX ];
+    UNUSED(
+        snprintf(
+            path,
+            sizeof( path ),
+            state->compress
+                ? "%s.%lu.ulz"
+                : ( state->interned ? "%s.%lu.uli" : "%s.%lu.log" ),
+            state->base,
+            thread_id()
+        )
+    );
+    item->owner = state;
+    item->size = 0U;
+    item->filling = item->buffer;
+    item->spare = item->buffer + state->buffer;
+    item->spare_size = 0U;
+    item->pending = SPARE_FREE;
+    item->failed = false;
+    item->queued = NULL;
+    /* file may hold streams of earlier threads with the same ID already */
+    if( state->interned )
+    {
+        UNUSED(
+            ulog_intern_begin(
+                &( item->stream ),
+                item->filling,
+                state->buffer,
+                &( item->size )
+            )
+        );
+    }
+    item->file =
+        open( path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644 );
+    if( -1 == item->file )
+    {
+        free( item );
+        return ulog_status_descriptive( EIO, "cannot open file of thread" );
+    }
+    if( 0 != pthread_setspecific( state->key, item ))
+    {
+        close( item->file );
+        free( item );
+        return ulog_status_descriptive( ENOMEM, "cannot keep file of thread" );
+    }
+    ulog_mutex const * const lock = &( state->guard );
+    UNUSED( lock->op->lock( lock ));
+    link_file( state, item );
+    UNUSED( lock->op->unlock( lock ));
+    *opened = item;
+    return ulog_status_descriptive( 0, "file of thread opened" );
+}
+
+static THREADUNSAFE ulog_status
+setup_safe(
+    ulog_files * const self,
+    ulog_files_config const * const config
+)
+{
+    size_t const length =
+        (( NULL == config ) || ( NULL == config->base ))
+            ? PATH_MAX
+            : strlen( config->base );
+    if(( 0U == length ) || ( PATH_MAX - SUFFIX_SIZE < length ))
+    {
+        return ulog_status_descriptive( EINVAL, "invalid files configuration" );
+    }
+    ulog_files_state * const state =
+        malloc( sizeof( ulog_files_state ) + length + 1U );
+    if( NULL == state )
+    {
+        return ulog_status_descriptive(
+            ENOMEM,
+            "cannot allocate memory for files state"
+        );
+    }
+    state->op = &setup_op;
+    state->files = NULL;
+    state->compress = config->compress;
+    state->compressing = false;
+    state->interned = config->interned;
+    state->record =
+        state->interned ? ULOG_INTERN_BUFFER : ULOG_RECORD_SIZE;
+    /* buffer holds at least one record, so that it's never split */
+    state->buffer =
+        ( 0U == config->buffer )
+            ? ULOG_FILES_BUFFER
+            : (( state->record > config->buffer )
+                ? state->record
+                : config->buffer );
+    memcpy( state->base, config->base, length + 1U );
+    state->block_size = ulog_compress_bound( state->buffer );
+    if( state->compress && ( ULOG_COMPRESS_MAXIMUM < state->buffer ))
+    {
+        free( state );
+        return ulog_status_descriptive( EINVAL, "buffer too large for block" );
+    }
+    state->block = state->compress ? malloc( state->block_size ) : NULL;
+    if( state->compress && ( NULL == state->block ))
+    {
+        free( state );
+        return ulog_status_descriptive(
+            ENOMEM,
+            "cannot allocate memory for block"
+        );
+    }
+    state->guard = ulog_mutex_get();
+    ulog_status const guarded = state->guard.op->setup( &( state->guard ));
+    if( !ulog_status_success( guarded ))
+    {
+        free( state->block );
+        free( state );
+        return guarded;
+    }
+    if( 0 != pthread_key_create( &( state->key ), exit_thread ))
+    {
+        UNUSED( state->guard.op->cleanup( &( state->guard )));
+        free( state->block );
+        free( state );
+        return ulog_status_descriptive( ENOMEM, "cannot create thread key" );
+    }
+    start_compressing( state );
+    if( state->compress && !( state->compressing ))
+    {
+        UNUSED( pthread_key_delete( state->key ));
+        UNUSED( state->guard.op->cleanup( &( state->guard )));
+        free( state->block );
+        free( state );
+        return ulog_status_descriptive( EIO, "cannot start compressing" );
+    }
+    self->state = state;
+    return ulog_status_descriptive( 0, "files set up successfully" );
+}
+
+static THREADUNSAFE ulog_status
+cleanup_safe( ulog_files * const self )
+{
+    ulog_files_state * const state = self->state;
+    /* destructors aren't called after the key is deleted */
+    UNUSED( pthread_key_delete( state->key ));
+    while( NULL != state->files )
+    {
+        thread_file * const item = state->files;
+        unlink_file( state, item );
+        close_file( state, item );
+    }
+    if( state->compressing )
+    {
+        __atomic_store_n( &( state->stop ), true, __ATOMIC_RELEASE );
+        wake_compressor( state );
+        UNUSED( pthread_join( state->compressor, NULL ));
+    }
+    UNUSED( state->guard.op->cleanup( &( state->guard )));
+    free( state->block );
+    free( state );
+    self->state = &guard;
+    return ulog_status_descriptive( 0, "files cleaned up successfully" );
+}
+
+/*
+ * Threads of the parent don't exist here, their buffers are the parent's;
+ * so is its compressing thread, a new one takes its place.
+ */
+static THREADUNSAFE ulog_status
+reset_safe( ulog_files * const self )
+{
+    ulog_files_state * const state = self->state;
+    UNUSED( pthread_setspecific( state->key, NULL ));
+    UNUSED( state->guard.op->reset( &( state->guard )));
+    while( NULL != state->files )
+    {
+        thread_file * const item = state->files;
+        unlink_file( state, item );
+        close( item->file );
+        free( item );
+    }
+    start_compressing( state );
+    if( state->compress && !( state->compressing ))
+    {
+        return ulog_status_descriptive( EIO, "cannot start compressing" );
+    }
+    return ulog_status_descriptive( 0, "files of parent dropped" );
+}
+
+static ULOG_FORMAT( 4, 5 ) size_t
+encode_formatted(
+    unsigned char * const record,
+    size_t const size,
+    ulog_level const level,
+    char const * const format,
+    ...
+)
+{
+    static unsigned char const text[] = { ULOG_ARG_STRING, ULOG_ARG_END };
+    va_list args;
+    va_start( args, format );
+    size_t const encoded =
+        ulog_binary_encode(
+            record,
+            size,
+            level,
+            text,
+            format,
+            args,
+            ulog_context_get()
+        );
+    va_end( args );
+    return encoded;
+}
+
+/* encoded as for binary handlers, messages of unknown types as their text */
+static ulog_status
+intern_record(
+    ulog_files_state const * const state,
+    thread_file * const item,
+    ulog_level const level,
+    unsigned char const * const signature,
+    char const * const format,
+    va_list args
+)
+{
+    unsigned char record[ ULOG_RECORD_SIZE ];
+    size_t size = 0U;
+    if( NULL != signature )
+    {
+        size =
+            ulog_binary_encode(
+                record,
+                sizeof( record ),
+                level,
+                signature,
+                format,
+                args,
+                ulog_context_get()
+            );
+    }
+    else
+    {
+        char text[ ULOG_RECORD_SIZE ];
+        UNUSED( vsnprintf( text, sizeof( text ), format, args ));
+        size = encode_formatted( record, sizeof( record ), level, "%s", text );
+    }
+    size_t written = 0U;
+    ulog_status const encoded =
+        ulog_intern_encode(
+            &( item->stream ),
+            record,
+            size,
+            item->filling + item->size,
+            state->buffer - item->size,
+            &written
+        );
+    item->size += written;
+    return encoded;
+}
+
+static ulog_status
+submit_safe(
+    ulog_files const * const self,
+    ulog_level const level,
+    unsigned char const * const signature,
+    char const * const format,
+    va_list args
+)
+{
+    ulog_files_state * const state = self->state;
+    thread_file * item = pthread_getspecific( state->key );
+    if( NULL == item )
+    {
+        ulog_status const opened = open_file( state, &item );
+        if( !ulog_status_success( opened )) { return opened; }
+    }
+    ulog_status result = ulog_status_descriptive( 0, "record buffered" );
+    if(
+        ( state->buffer - item->size < state->record )
+        && !flush( state, item )
+    )
+    {
+        result = ulog_status_descriptive( EIO, "cannot write file of thread" );
+    }
+    if( state->interned )
+    {
+        ulog_status const encoded =
+            intern_record( state, item, level, signature, format, args );
+        return ulog_status_success( encoded ) ? result : encoded;
+    }
+    int const length =
+        vsnprintf( item->filling + item->size, ULOG_RECORD_SIZE, format, args );
+    if( 0 < length )
+    {
+        item->size +=
+            ( ULOG_RECORD_SIZE <= ( size_t ) length )
+                ? ULOG_RECORD_SIZE - 1U
+                : ( size_t ) length;
+    }
+    return result;
+}
+
+static inline THREADUNSAFE ulog_status
+setup(
+    ulog_files * const self,
+    ulog_files_config const * const config
+)
+{
+    if( !valid( self )) { return generic_invalid( self ); }
+    return self->state->op->setup( self, config );
+}
+
+static inline THREADUNSAFE ulog_status
+cleanup( ulog_files * const self )
+{
+    if( !valid( self )) { return generic_invalid( self ); }
+    return self->state->op->cleanup( self );
+}
+
+static inline ulog_status
+submit(
+    ulog_files const * const self,
+    ulog_level const level,
+    unsigned char const * const signature,
+    char const * const format,
+    va_list args
+)
+{
+    if( !valid( self )) { return generic_invalid( self ); }
+    return self->state->op->submit( self, level, signature, format, args );
+}
+
+static inline THREADUNSAFE ulog_status
+reset( ulog_files * const self )
+{
+    if( !valid( self )) { return generic_invalid( self ); }
+    return self->state->op->reset( self );
+}
+
+static ulog_files_op_table const op =
+{
+    .setup = setup,
+    .cleanup = cleanup,
+    .submit = submit,
+    .reset = reset
+};
+
+static inline bool
+valid( ulog_files const * const self )
+{
+    return
+        (
+            ( NULL != self )
+            && ( NULL != self->state )
+            && (
+                (( &guard == self->state ) && ( &default_op == guard.op ))
+                || (
+                    ( &guard != self->state )
+                    && ( &setup_op == self->state->op )
+                )
+            )
+            && ( &op == self->op )
+        );
+}
+
+ulog_files
+ulog_files_get( void )
+{
+    return ( ulog_files ) { .state = &guard, .op = &op };
+}
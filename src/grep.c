@@ -0,0 +1,500 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Implements parallel search of logged records.
+ * \date        2016/05/30 10:03:26 AM
+ * \file        grep.c
+ * \version     1.0
+ *
+ *
+ **/
+
+#define _GNU_SOURCE /* for memmem, memrchr */
+
+#include <ulog/grep.h>
+#include <ulog/compress.h> /* ulog_compressed, ulog_decompress_next */
+#include <ulog/intern.h> /* ULOG_INTERN_BUFFER, ulog_intern_decode, etc. */
+#include <ulog/universal.h> /* UNUSED */
+
+#include <errno.h> /* EINVAL, EIO, ENODATA, ENOMEM */
+#include <fcntl.h> /* O_CLOEXEC, O_RDONLY, open */
+#include <limits.h> /* UCHAR_MAX */
+#include <pthread.h> /* pthread_create, pthread_join, pthread_t */
+#include <stdbool.h> /* bool */
+#include <stddef.h> /* NULL, size_t */
+#include <stdint.h> /* UINT64_MAX, uint64_t */
+#include <stdlib.h> /* calloc, free, realloc */
+#include <string.h> /* memchr, memcpy, memmem, memmove, memrchr, etc. */
+#include <sys/mman.h> /* mmap, munmap, posix_madvise */
+#include <sys/stat.h> /* fstat, struct stat */
+#include <unistd.h> /* close, sysconf */
+
+/* what records must have to match, shared by all searches */
+typedef struct
+{
+    char const * pattern;
+    size_t length;
+    bool level[ UCHAR_MAX + 1U ];
+    /* whether levels or time are restricted */
+    bool filtered;
+    uint64_t since;
+    uint64_t until;
+    bool interned;
+}
+criteria;
+
+/* chunk searched by one thread, matches kept until the round ends */
+typedef struct
+{
+    criteria const * criteria;
+    unsigned char const * begin;
+    unsigned char const * end;
+    unsigned char * buffer;
+    size_t size;
+    size_t capacity;
+    uint64_t matched;
+    /* ENOMEM for matches which couldn't be kept, EINVAL for bad record */
+    int error;
+    bool started;
+    pthread_t thread;
+}
+search;
+
+static bool
+keep( search * const self, unsigned char const * const data, size_t size )
+{
+    /* last line of the file, or truncated record, may lack its newline */
+    bool const newline = ( 0U == size ) || ( '\n' != data[ size - 1U ]);
+    size_t const needed = self->size + size + ( newline ? 1U : 0U );
+    if( self->capacity < needed )
+    {
+        size_t capacity = ( 0U == self->capacity ) ? 4096U : self->capacity;
+        while( capacity < needed ) { capacity *= 2U; }
+        unsigned char * const grown = realloc( self->buffer, capacity );
+        if( NULL == grown ) { return false; }
+        self->buffer = grown;
+        self->capacity = capacity;
+    }
+    memcpy( self->buffer + self->size, data, size );
+    self->size += size;
+    if( newline ) { self->buffer[ self->size++ ] = '\n'; }
+    ++( self->matched );
+    return true;
+}
+
+static bool
+in_time( criteria const * const criteria, uint64_t const time )
+{
+    return ( criteria->since <= time ) && ( criteria->until >= time );
+}
+
+/* parses "[%c][%" PRIu64 "]" at the start of line */
+static bool
+text_matches(
+    criteria const * const criteria,
+    unsigned char const * const line,
+    unsigned char const * const end
+)
+{
+    if( !criteria->filtered ) { return true; }
+    if(
+        ( 6 > end - line )
+        || ( '[' != line[ 0 ] ) || ( ']' != line[ 2 ] )
+        || ( '[' != line[ 3 ] )
+        || !criteria->level[ line[ 1 ]]
+    )
+    {
+        return false;
+    }
+    uint64_t time = 0U;
+    unsigned char const * digit = line + 4;
+    for( ; ( end > digit ) && ( '0' <= *digit ) && ( '9' >= *digit ); ++digit )
+    {
+        time = time * 10U + ( uint64_t ) ( *digit - '0' );
+    }
+    return
+        ( line + 4 != digit ) && ( end > digit ) && ( ']' == *digit )
+        && in_time( criteria, time );
+}
+
+static void
+search_text( search * const self )
+{
+    criteria const * const criteria = self->criteria;
+    unsigned char const * position = self->begin;
+    while( self->end > position )
+    {
+        unsigned char const * line = position;
+        if( 0U != criteria->length )
+        {
+            unsigned char const * const found =
+                memmem(
+                    position,
+                    ( size_t ) ( self->end - position ),
+                    criteria->pattern,
+                    criteria->length
+                );
+            if( NULL == found ) { return; }
+            unsigned char const * const previous =
+                memrchr( position, '\n', ( size_t ) ( found - position ));
+            line = ( NULL == previous ) ? position : previous + 1;
+        }
+        unsigned char const * const newline =
+            memchr( line, '\n', ( size_t ) ( self->end - line ));
+        unsigned char const * const next =
+            ( NULL == newline ) ? self->end : newline + 1;
+        if(
+            text_matches( criteria, line, next )
+            && !keep( self, line, ( size_t ) ( next - line ))
+        )
+        {
+            self->error = ENOMEM;
+            return;
+        }
+        position = next;
+    }
+}
+
+/* chunk starts where decoding may, so it has a dictionary of its own */
+static void
+search_interned( search * const self )
+{
+    criteria const * const criteria = self->criteria;
+    ulog_intern_dictionary dictionary = { .text = NULL };
+    char text[ ULOG_INTERN_BUFFER ];
+    unsigned char const * const line = ( unsigned char const * ) text;
+    for( unsigned char const * entry = self->begin; self->end > entry; )
+    {
+        size_t consumed = 0U;
+        ulog_status const decoded =
+            ulog_intern_decode(
+                &dictionary,
+                entry,
+                ( size_t ) ( self->end - entry ),
+                &consumed,
+                text,
+                sizeof( text )
+            );
+        /* the last record may be still being written, it ends the file */
+        if( ENODATA == ulog_status_to_int( decoded )) { break; }
+        if( !ulog_status_success( decoded ))
+        {
+            self->error =
+                ( ENOMEM == ulog_status_to_int( decoded )) ? ENOMEM : EINVAL;
+            break;
+        }
+        entry += consumed;
+        size_t const length = strlen( text );
+        if(
+            (
+                ( 0U == criteria->length )
+                || ( NULL != memmem(
+                    line,
+                    length,
+                    criteria->pattern,
+                    criteria->length
+                ))
+            )
+            && text_matches( criteria, line, line + length )
+            && !keep( self, line, length )
+        )
+        {
+            self->error = ENOMEM;
+            break;
+        }
+    }
+    ulog_intern_release( &dictionary );
+}
+
+static void *
+run( void * const arg )
+{
+    search * const self = arg;
+    if( self->criteria->interned ) { search_interned( self ); }
+    else { search_text( self ); }
+    return NULL;
+}
+
+/* chunk of text ends after a newline, chunk of records where decoding may
+ * start again */
+static unsigned char const *
+split(
+    criteria const * const criteria,
+    unsigned char const * const begin,
+    unsigned char const * const end,
+    size_t const chunk
+)
+{
+    size_t const left = ( size_t ) ( end - begin );
+    if( criteria->interned )
+    {
+        size_t offset = 0U;
+        while(( chunk > offset ) && ( left > offset ))
+        {
+            offset = ulog_intern_restart( begin, left, offset );
+        }
+        return begin + offset;
+    }
+    unsigned char const * const newline =
+        ( chunk >= left ) ? NULL : memchr( begin + chunk, '\n', left - chunk );
+    return ( NULL == newline ) ? end : newline + 1;
+}
+
+static unsigned
+count_threads( unsigned const threads )
+{
+    if( 0U != threads ) { return threads; }
+    long const online = sysconf( _SC_NPROCESSORS_ONLN );
+    return ( 0L < online ) ? ( unsigned ) online : 1U;
+}
+
+/* chunks are searched in rounds, one per thread, then written in order */
+static ulog_status
+search_mapped(
+    criteria const * const criteria,
+    unsigned char const * const begin,
+    unsigned char const * const end,
+    ulog_grep_config const * const config,
+    FILE * const output,
+    uint64_t * const matched
+)
+{
+    unsigned const threads = count_threads( config->threads );
+    size_t const chunk =
+        ( 0U == config->chunk ) ? ULOG_GREP_CHUNK : config->chunk;
+    search * const searches = calloc( threads, sizeof( search ));
+    if( NULL == searches )
+    {
+        return ulog_status_descriptive( ENOMEM, "cannot allocate searches" );
+    }
+    ulog_status result = ulog_status_descriptive( 0, "file searched" );
+    for( unsigned char const * position = begin; end > position; )
+    {
+        unsigned count = 0U;
+        for( ; ( threads > count ) && ( end > position ); ++count )
+        {
+            unsigned char const * const next =
+                split( criteria, position, end, chunk );
+            searches[ count ].criteria = criteria;
+            searches[ count ].begin = position;
+            searches[ count ].end = next;
+            position = next;
+        }
+        /* the first chunk is searched by calling thread, or any unstarted */
+        for( unsigned i = 1U; i < count; ++i )
+        {
+            searches[ i ].started =
+                ( 0 == pthread_create(
+                    &( searches[ i ].thread ),
+                    NULL,
+                    run,
+                    searches + i
+                ));
+        }
+        if( 0U != count ) { UNUSED( run( searches )); }
+        for( unsigned i = 1U; i < count; ++i )
+        {
+            search * const item = searches + i;
+            if( item->started ) { pthread_join( item->thread, NULL ); }
+            else { UNUSED( run( item )); }
+        }
+        for( unsigned i = 0U; i < count; ++i )
+        {
+            search * const item = searches + i;
+            if( ENOMEM == item->error )
+            {
+                result =
+                    ulog_status_descriptive( ENOMEM, "cannot keep matches" );
+            }
+            else if( 0 != item->error )
+            {
+                result = ulog_status_descriptive( EINVAL, "malformed record" );
+            }
+            else if(
+                ( 0U != item->size )
+                && ( 1U != fwrite( item->buffer, item->size, 1U, output ))
+            )
+            {
+                result = ulog_status_descriptive( EIO, "cannot write output" );
+            }
+            *matched += item->matched;
+            item->size = 0U;
+            item->matched = 0U;
+        }
+        if( !ulog_status_success( result )) { break; }
+    }
+    for( unsigned i = 0U; i < threads; ++i ) { free( searches[ i ].buffer ); }
+    free( searches );
+    return result;
+}
+
+/* end of the last whole line, or the last place where decoding may start,
+ * as blocks may end within a record */
+static unsigned char const *
+whole_records(
+    criteria const * const criteria,
+    unsigned char const * const begin,
+    unsigned char const * const end
+)
+{
+    size_t const size = ( size_t ) ( end - begin );
+    if( criteria->interned )
+    {
+        size_t last = 0U;
+        for(
+            size_t offset = 0U;
+            size > ( offset = ulog_intern_restart( begin, size, offset ));
+        )
+        {
+            last = offset;
+        }
+        return begin + last;
+    }
+    unsigned char const * const newline =
+        ( 0U != size ) ? memrchr( begin, '\n', size ) : NULL;
+    return ( NULL == newline ) ? begin : newline + 1;
+}
+
+/* blocks are decompressed into a window, which is searched once it holds
+ * a chunk for each thread; records split by its end are kept for the next */
+static ulog_status
+search_blocks(
+    criteria * const criteria,
+    unsigned char const * const blocks,
+    size_t const size,
+    ulog_grep_config const * const config,
+    FILE * const output,
+    uint64_t * const matched
+)
+{
+    size_t const wanted =
+        count_threads( config->threads )
+        * (( 0U == config->chunk ) ? ULOG_GREP_CHUNK : config->chunk );
+    void * window = NULL;
+    size_t capacity = 0U;
+    size_t length = 0U;
+    size_t block = 0U;
+    bool last = false;
+    ulog_status result = ulog_status_descriptive( 0, "file searched" );
+    while( !last && ulog_status_success( result ))
+    {
+        /* a block at least is taken, records may be longer than wanted */
+        do
+        {
+            ulog_status const taken =
+                ulog_decompress_next(
+                    blocks,
+                    size,
+                    &block,
+                    &window,
+                    &capacity,
+                    &length
+                );
+            /* the last block may be still being written, it ends the file */
+            last = !ulog_status_success( taken );
+            if( last && ( ENODATA != ulog_status_to_int( taken )))
+            {
+                result =
+                    ( ENOMEM == ulog_status_to_int( taken ))
+                        ? taken
+                        : ulog_status_descriptive( EINVAL, "malformed block" );
+            }
+        }
+        while( !last && ( wanted > length ));
+        if(( 0U == length ) || !ulog_status_success( result )) { break; }
+        /* the first block tells whether its records are interned */
+        if( ulog_interned( window, length )) { criteria->interned = true; }
+        unsigned char const * const begin = window;
+        unsigned char const * const end =
+            last
+                ? begin + length
+                : whole_records( criteria, begin, begin + length );
+        result = search_mapped( criteria, begin, end, config, output, matched );
+        length -= ( size_t ) ( end - begin );
+        if( 0U != length ) { memmove( window, end, length ); }
+    }
+    free( window );
+    return result;
+}
+
+static void
+set_criteria(
+    criteria * const criteria,
+    ulog_grep_config const * const config
+)
+{
+    criteria->pattern = config->pattern;
+    criteria->length =
+        ( NULL == config->pattern ) ? 0U : strlen( config->pattern );
+    for( size_t i = 0U; i <= UCHAR_MAX; ++i )
+    {
+        criteria->level[ i ] = ( NULL == config->levels );
+    }
+    for(
+        char const * level = config->levels;
+        ( NULL != level ) && ( '\0' != *level );
+        ++level
+    )
+    {
+        criteria->level[ ( unsigned char ) *level ] = true;
+    }
+    criteria->filtered =
+        ( 0U != config->since ) || ( 0U != config->until )
+        || ( NULL != config->levels );
+    criteria->since = config->since;
+    criteria->until = ( 0U == config->until ) ? UINT64_MAX : config->until;
+    criteria->interned = false;
+}
+
+ulog_status
+ulog_grep(
+    char const * const path,
+    ulog_grep_config const * const config,
+    FILE * const output,
+    uint64_t * const matched
+)
+{
+    if(( NULL == path ) || ( NULL == config ) || ( NULL == output ))
+    {
+        return ulog_status_descriptive( ENODATA, "invalid search arguments" );
+    }
+    uint64_t found = 0U;
+    if( NULL != matched ) { *matched = 0U; }
+    int const file = open( path, O_RDONLY | O_CLOEXEC );
+    struct stat status;
+    if(( -1 == file ) || ( 0 != fstat( file, &status )))
+    {
+        if( -1 != file ) { close( file ); }
+        return ulog_status_descriptive( EIO, "cannot open file" );
+    }
+    size_t const size = ( size_t ) status.st_size;
+    if( 0U == size )
+    {
+        close( file );
+        return ulog_status_descriptive( 0, "file empty" );
+    }
+    void * const mapped = mmap( NULL, size, PROT_READ, MAP_PRIVATE, file, 0 );
+    close( file );
+    if( MAP_FAILED == mapped )
+    {
+        return ulog_status_descriptive( EIO, "cannot map file" );
+    }
+    UNUSED( posix_madvise( mapped, size, POSIX_MADV_SEQUENTIAL ));
+    criteria criteria;
+    set_criteria( &criteria, config );
+    criteria.interned = ulog_interned( mapped, size );
+    unsigned char const * const begin = mapped;
+    ulog_status const result =
+        ulog_compressed( mapped, size )
+            ? search_blocks( &criteria, begin, size, config, output, &found )
+            : search_mapped(
+                &criteria,
+                begin,
+                begin + size,
+                config,
+                output,
+                &found
+            );
+    munmap( mapped, size );
+    if( NULL != matched ) { *matched = found; }
+    return result;
+}
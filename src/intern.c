@@ -0,0 +1,869 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Implements interning of strings repeated by binary records.
+ * \date        2016/06/03 10:02:51 AM
+ * \file        intern.c
+ * \version     1.0
+ *
+ * Interned stream is a sequence of entries, each beginning with uint8_t kind
+ * and uint32_t size of the whole entry. Definition holds uint32_t ID and
+ * the text, without terminating zero. Record holds level, count of
+ * arguments and of context pairs as the binary header does, then the
+ * format, types and arguments, then context unchanged. The format and
+ * string arguments are uint32_t ID with the highest bit set, or length
+ * followed by the characters. Time of records with the standard header is
+ * a varint, seven bits per byte from the lowest, the highest bit set in all
+ * bytes but the last. Checkpoint entries are records holding the whole
+ * time, if they have any, other records hold difference from the previous
+ * time, zigzag encoded so that small negative differences stay short.
+ * Marker of stream start holds the magic text alone. Nothing is aligned.
+ **/
+
+#define _POSIX_C_SOURCE 200809L /* for sched_yield */
+
+#include <ulog/intern.h>
+#include <ulog/binary.h> /* ulog_binary_decode, ulog_binary_header */
+#include <ulog/universal.h> /* UNUSED */
+
+#include <errno.h> /* EINVAL, ENOBUFS, ENODATA, ENOMEM */
+#include <sched.h> /* sched_yield */
+#include <stdbool.h> /* bool */
+#include <stddef.h> /* NULL, size_t */
+#include <stdint.h> /* UINT32_MAX, uint8_t, uint16_t, uint32_t, uint64_t */
+#include <stdlib.h> /* free, malloc, realloc */
+#include <string.h> /* memcmp, memcpy, memset, strlen, strncmp */
+
+#define KIND_DEFINITION 1U
+#define KIND_RECORD 2U
+#define KIND_CHECKPOINT 3U
+#define KIND_STREAM 4U
+#define ENTRY_HEADER ( sizeof( uint8_t ) + sizeof( uint32_t ))
+#define MAGIC "ulog-intern"
+#define MARKER_SIZE ( ENTRY_HEADER + sizeof( MAGIC ) - 1U )
+#define INTERNED 0x80000000U
+/* table is kept at most half full */
+#define SLOTS ( 2U * ULOG_INTERN_CAPACITY )
+/* arguments of the standard header holding time, file and function name */
+#define TIME_ARGUMENT 1U
+#define FILE_ARGUMENT 2U
+#define FUNCTION_ARGUMENT 3U
+/* longest varint of uint64_t */
+#define VARINT_SIZE 10U
+
+/* claimed by a thread, then filled in and published with its text */
+typedef struct
+{
+    uint32_t claimed;
+    uint32_t length;
+    /* zero if the string couldn't be interned */
+    uint32_t id;
+    uint64_t hash;
+    char const * text;
+}
+slot;
+
+static slot table[ SLOTS ];
+static uint32_t last_id;
+/* text of slots which couldn't be interned, never matched */
+static char const unusable[] = "";
+
+static uint64_t
+hash_text( char const * const text, size_t const length )
+{
+    uint64_t hash = 14695981039346656037U;
+    for( size_t i = 0U; i < length; ++i )
+    {
+        hash = ( hash ^ ( unsigned char ) text[ i ] ) * 1099511628211U;
+    }
+    return hash;
+}
+
+static void
+fill_slot(
+    slot * const item,
+    char const * const text,
+    size_t const length,
+    uint64_t const hash
+)
+{
+    char * const copy = malloc( length + 1U );
+    uint32_t const id =
+        ( NULL == copy )
+            ? 0U
+            : __atomic_add_fetch( &last_id, 1U, __ATOMIC_RELAXED );
+    item->hash = hash;
+    if(( 0U == id ) || ( ULOG_INTERN_CAPACITY <= id ))
+    {
+        free( copy );
+        item->id = 0U;
+        item->length = UINT32_MAX;
+        __atomic_store_n( &( item->text ), unusable, __ATOMIC_RELEASE );
+        return;
+    }
+    memcpy( copy, text, length );
+    copy[ length ] = '\0';
+    item->id = id;
+    item->length = ( uint32_t ) length;
+    __atomic_store_n( &( item->text ), copy, __ATOMIC_RELEASE );
+}
+
+/* returns ID of the text, zero if it can't be interned */
+static uint32_t
+intern( char const * const text, size_t const length )
+{
+    if( INTERNED <= length ) { return 0U; }
+    uint64_t const hash = hash_text( text, length );
+    for( size_t probe = 0U; probe < SLOTS; ++probe )
+    {
+        slot * const item = &( table[ ( hash + probe ) & ( SLOTS - 1U )]);
+        if( 0U == __atomic_load_n( &( item->claimed ), __ATOMIC_ACQUIRE ))
+        {
+            if(
+                ULOG_INTERN_CAPACITY - 1U
+                <= __atomic_load_n( &last_id, __ATOMIC_RELAXED )
+            )
+            {
+                return 0U;
+            }
+            uint32_t expected = 0U;
+            if(
+                __atomic_compare_exchange_n(
+                    &( item->claimed ),
+                    &expected,
+                    1U,
+                    false,
+                    __ATOMIC_ACQ_REL,
+                    __ATOMIC_ACQUIRE
+                )
+            )
+            {
+                fill_slot( item, text, length, hash );
+                return item->id;
+            }
+        }
+        /* other thread may be interning the same text right now */
+        char const * stored;
+        while(
+            NULL
+            == ( stored = __atomic_load_n( &( item->text ), __ATOMIC_ACQUIRE ))
+        )
+        {
+            UNUSED( sched_yield());
+        }
+        if(
+            ( hash == item->hash ) && ( length == item->length )
+            && ( 0 == memcmp( stored, text, length ))
+        )
+        {
+            return item->id;
+        }
+    }
+    return 0U;
+}
+
+typedef struct
+{
+    unsigned char const * data;
+    size_t size;
+    size_t offset;
+}
+reader;
+
+static bool
+take( reader * const from, void * const value, size_t const length )
+{
+    if( from->size - from->offset < length ) { return false; }
+    memcpy( value, from->data + from->offset, length );
+    from->offset += length;
+    return true;
+}
+
+typedef struct
+{
+    unsigned char * data;
+    size_t size;
+    size_t used;
+    bool fits;
+}
+writer;
+
+static void
+put( writer * const to, void const * const value, size_t const length )
+{
+    if( !to->fits || ( to->size - to->used < length ))
+    {
+        to->fits = false;
+        return;
+    }
+    memcpy( to->data + to->used, value, length );
+    to->used += length;
+}
+
+static void
+put_varint( writer * const to, uint64_t value )
+{
+    uint8_t bytes[ VARINT_SIZE ];
+    size_t length = 0U;
+    for( ; 0x80U <= value; value >>= 7U )
+    {
+        bytes[ length++ ] = ( uint8_t ) ( 0x80U | ( value & 0x7FU ));
+    }
+    bytes[ length++ ] = ( uint8_t ) value;
+    put( to, bytes, length );
+}
+
+static bool
+take_varint( reader * const from, uint64_t * const value )
+{
+    *value = 0U;
+    for( unsigned shift = 0U; VARINT_SIZE * 7U > shift; shift += 7U )
+    {
+        uint8_t byte;
+        if( !take( from, &byte, sizeof( byte ))) { return false; }
+        *value |= ( uint64_t ) ( byte & 0x7FU ) << shift;
+        if( 0x80U > byte ) { return true; }
+    }
+    return false;
+}
+
+/* maps differences around zero to small numbers */
+static uint64_t
+zigzag( uint64_t const difference )
+{
+    return ( difference << 1U ) ^ ( 0U - ( difference >> 63U ));
+}
+
+static uint64_t
+unzigzag( uint64_t const value )
+{
+    return ( value >> 1U ) ^ ( 0U - ( value & 1U ));
+}
+
+/* strings take their stored length and characters */
+static bool
+argument_size(
+    reader const * const from,
+    unsigned char const type,
+    size_t * const size
+)
+{
+    switch( type )
+    {
+        case ULOG_ARG_INT: *size = sizeof( int ); break;
+        case ULOG_ARG_UINT: *size = sizeof( unsigned ); break;
+        case ULOG_ARG_LONG: *size = sizeof( long ); break;
+        case ULOG_ARG_ULONG: *size = sizeof( unsigned long ); break;
+        case ULOG_ARG_LLONG: *size = sizeof( long long ); break;
+        case ULOG_ARG_ULLONG: *size = sizeof( unsigned long long ); break;
+        case ULOG_ARG_DOUBLE: *size = sizeof( double ); break;
+        case ULOG_ARG_LDOUBLE: *size = sizeof( long double ); break;
+        case ULOG_ARG_POINTER: *size = sizeof( void const * ); break;
+        case ULOG_ARG_STRING:
+        {
+            reader peek = *from;
+            uint32_t length;
+            if( !take( &peek, &length, sizeof( length ))) { return false; }
+            *size = sizeof( length ) + length;
+            break;
+        }
+        default: return false;
+    }
+    return from->size - from->offset >= *size;
+}
+
+/* IDs which the record uses, but the stream hasn't defined yet */
+typedef struct
+{
+    uint32_t id[ 3U ];
+    char const * text[ 3U ];
+    size_t length[ 3U ];
+    size_t count;
+}
+pending;
+
+static bool
+is_defined( ulog_intern_stream const * const stream, uint32_t const id )
+{
+    return 0U != ( stream->defined[ id / 8U ] & ( 1U << ( id % 8U )));
+}
+
+/* checkpoint defines all IDs again, as readers may start from it */
+static void
+require(
+    pending * const needed,
+    ulog_intern_stream const * const stream,
+    bool const checkpoint,
+    uint32_t const id,
+    char const * const text,
+    size_t const length
+)
+{
+    if(( 0U == id ) || ( !checkpoint && is_defined( stream, id ))) { return; }
+    for( size_t i = 0U; i < needed->count; ++i )
+    {
+        if( id == needed->id[ i ] ) { return; }
+    }
+    needed->id[ needed->count ] = id;
+    needed->text[ needed->count ] = text;
+    needed->length[ needed->count ] = length;
+    ++( needed->count );
+}
+
+static void
+put_reference(
+    writer * const to,
+    uint32_t const id,
+    char const * const text,
+    uint32_t const length
+)
+{
+    if( 0U != id )
+    {
+        uint32_t const reference = INTERNED | id;
+        put( to, &reference, sizeof( reference ));
+        return;
+    }
+    put( to, &length, sizeof( length ));
+    put( to, text, length );
+}
+
+static void
+put_entry_size( writer * const to, size_t const start )
+{
+    if( !to->fits ) { return; }
+    uint32_t const size = ( uint32_t ) ( to->used - start );
+    memcpy( to->data + start + sizeof( uint8_t ), &size, sizeof( size ));
+}
+
+static void
+put_definition(
+    writer * const to,
+    uint32_t const id,
+    char const * const text,
+    size_t const length
+)
+{
+    size_t const start = to->used;
+    uint8_t const kind = KIND_DEFINITION;
+    uint32_t const size = 0U;
+    put( to, &kind, sizeof( kind ));
+    put( to, &size, sizeof( size ));
+    put( to, &id, sizeof( id ));
+    put( to, text, length );
+    put_entry_size( to, start );
+}
+
+static bool
+is_time( unsigned char const type )
+{
+    return
+        (( ULOG_ARG_ULONG == type )
+            && ( sizeof( uint64_t ) == sizeof( unsigned long )))
+        || (( ULOG_ARG_ULLONG == type )
+            && ( sizeof( uint64_t ) == sizeof( unsigned long long )));
+}
+
+/* time, file and function name of the standard header are compacted */
+static bool
+has_header(
+    ulog_binary_header const * const header,
+    unsigned char const * const types
+)
+{
+    return
+        ( 0 == strncmp(
+            header->format,
+            ULOG_HEADER_FORMAT_,
+            sizeof( ULOG_HEADER_FORMAT_ ) - 1U
+        ))
+        && ( FUNCTION_ARGUMENT < header->count )
+        && is_time( types[ TIME_ARGUMENT ] )
+        && ( ULOG_ARG_STRING == types[ FILE_ARGUMENT ] )
+        && ( ULOG_ARG_STRING == types[ FUNCTION_ARGUMENT ] );
+}
+
+ulog_status
+ulog_intern_begin(
+    ulog_intern_stream * const stream,
+    void * const buffer,
+    size_t const capacity,
+    size_t * const written
+)
+{
+    if(( NULL == stream ) || ( NULL == buffer ) || ( NULL == written ))
+    {
+        return ulog_status_descriptive( EINVAL, "invalid stream" );
+    }
+    if( MARKER_SIZE > capacity )
+    {
+        return ulog_status_descriptive( ENOBUFS, "buffer too small" );
+    }
+    writer to = { .data = buffer, .size = capacity, .used = 0U, .fits = true };
+    uint8_t const kind = KIND_STREAM;
+    uint32_t const size = MARKER_SIZE;
+    put( &to, &kind, sizeof( kind ));
+    put( &to, &size, sizeof( size ));
+    put( &to, MAGIC, sizeof( MAGIC ) - 1U );
+    memset( stream, 0, sizeof( *stream ));
+    *written = to.used;
+    return ulog_status_descriptive( 0, "stream begun" );
+}
+
+ulog_status
+ulog_intern_encode(
+    ulog_intern_stream * const stream,
+    void const * const record,
+    size_t const size,
+    void * const buffer,
+    size_t const capacity,
+    size_t * const written
+)
+{
+    ulog_binary_header header;
+    if(
+        ( NULL == stream ) || ( NULL == record ) || ( NULL == buffer )
+        || ( NULL == written ) || ( sizeof( header ) > size )
+    )
+    {
+        return ulog_status_descriptive( EINVAL, "invalid record" );
+    }
+    memcpy( &header, record, sizeof( header ));
+    if(
+        ( size < header.size )
+        || ( sizeof( header ) + header.count > header.size )
+        || ( NULL == header.format )
+    )
+    {
+        return ulog_status_descriptive( EINVAL, "malformed record" );
+    }
+    unsigned char const * const types =
+        ( unsigned char const * ) record + sizeof( header );
+    size_t const arguments = sizeof( header ) + header.count;
+    bool const headed = has_header( &header, types );
+    /* record with time after checkpoint without it starts one of its own */
+    bool const checkpoint =
+        ( 0U == stream->since ) || ( headed && !( stream->timed ));
+
+    /* strings are interned while arguments are checked */
+    pending needed = { .count = 0U };
+    size_t const format_length = strlen( header.format );
+    uint32_t const format_id = intern( header.format, format_length );
+    require(
+        &needed,
+        stream,
+        checkpoint,
+        format_id,
+        header.format,
+        format_length
+    );
+    uint32_t string_id[ FUNCTION_ARGUMENT + 1U ] = { 0U };
+    uint64_t time = 0U;
+    reader from = { .data = record, .size = header.size, .offset = arguments };
+    for( size_t i = 0U; i < header.count; ++i )
+    {
+        size_t length = 0U;
+        if( !argument_size( &from, types[ i ], &length ))
+        {
+            return ulog_status_descriptive( EINVAL, "malformed argument" );
+        }
+        if( headed && ( TIME_ARGUMENT == i ))
+        {
+            memcpy( &time, from.data + from.offset, sizeof( time ));
+        }
+        if( headed && (( FILE_ARGUMENT == i ) || ( FUNCTION_ARGUMENT == i )))
+        {
+            char const * const text =
+                ( char const * ) from.data + from.offset + sizeof( uint32_t );
+            size_t const text_length = length - sizeof( uint32_t );
+            string_id[ i ] = intern( text, text_length );
+            require(
+                &needed,
+                stream,
+                checkpoint,
+                string_id[ i ],
+                text,
+                text_length
+            );
+        }
+        from.offset += length;
+    }
+
+    writer to = { .data = buffer, .size = capacity, .used = 0U, .fits = true };
+    for( size_t i = 0U; i < needed.count; ++i )
+    {
+        put_definition(
+            &to,
+            needed.id[ i ],
+            needed.text[ i ],
+            needed.length[ i ]
+        );
+    }
+    size_t const start = to.used;
+    uint8_t const kind = checkpoint ? KIND_CHECKPOINT : KIND_RECORD;
+    uint32_t const entry_size = 0U;
+    put( &to, &kind, sizeof( kind ));
+    put( &to, &entry_size, sizeof( entry_size ));
+    put( &to, &( header.level ), sizeof( header.level ));
+    put( &to, &( header.count ), sizeof( header.count ));
+    put( &to, &( header.context ), sizeof( header.context ));
+    put_reference( &to, format_id, header.format, ( uint32_t ) format_length );
+    put( &to, types, header.count );
+    from.offset = arguments;
+    for( size_t i = 0U; i < header.count; ++i )
+    {
+        size_t length = 0U;
+        UNUSED( argument_size( &from, types[ i ], &length ));
+        unsigned char const * const value = from.data + from.offset;
+        if( headed && ( TIME_ARGUMENT == i ))
+        {
+            put_varint( &to, checkpoint ? time : zigzag( time - stream->time ));
+        }
+        /* other strings are stored as literal references already */
+        else if(( ULOG_ARG_STRING == types[ i ] ) && ( FUNCTION_ARGUMENT >= i ))
+        {
+            put_reference(
+                &to,
+                string_id[ i ],
+                ( char const * ) value + sizeof( uint32_t ),
+                ( uint32_t ) ( length - sizeof( uint32_t ))
+            );
+        }
+        else
+        {
+            put( &to, value, length );
+        }
+        from.offset += length;
+    }
+    /* context follows arguments unchanged */
+    put( &to, from.data + from.offset, from.size - from.offset );
+    put_entry_size( &to, start );
+    if( !to.fits )
+    {
+        return ulog_status_descriptive( ENOBUFS, "buffer too small" );
+    }
+    if( checkpoint ) { memset( stream->defined, 0, sizeof( stream->defined )); }
+    for( size_t i = 0U; i < needed.count; ++i )
+    {
+        stream->defined[ needed.id[ i ] / 8U ] |=
+            ( uint8_t ) ( 1U << ( needed.id[ i ] % 8U ));
+    }
+    if( checkpoint ) { stream->timed = headed; }
+    if( headed ) { stream->time = time; }
+    stream->since = ( stream->since + 1U ) % ULOG_INTERN_CHECKPOINT;
+    *written = to.used;
+    return ulog_status_descriptive( 0, "record encoded" );
+}
+
+static ulog_status
+define(
+    ulog_intern_dictionary * const dictionary,
+    reader * const entry
+)
+{
+    uint32_t id;
+    if( !take( entry, &id, sizeof( id )) || ( 0U == id ) || ( INTERNED <= id ))
+    {
+        return ulog_status_descriptive( EINVAL, "malformed definition" );
+    }
+    if( dictionary->count <= id )
+    {
+        size_t count = ( 0U == dictionary->count ) ? 64U : dictionary->count;
+        while( count <= id ) { count *= 2U; }
+        char * * const grown =
+            realloc( dictionary->text, count * sizeof( char * ));
+        if( NULL == grown )
+        {
+            return ulog_status_descriptive( ENOMEM, "cannot grow dictionary" );
+        }
+        memset(
+            grown + dictionary->count,
+            0,
+            ( count - dictionary->count ) * sizeof( char * )
+        );
+        dictionary->text = grown;
+        dictionary->count = count;
+    }
+    size_t const length = entry->size - entry->offset;
+    char * const text = malloc( length + 1U );
+    if( NULL == text )
+    {
+        return ulog_status_descriptive( ENOMEM, "cannot keep definition" );
+    }
+    memcpy( text, entry->data + entry->offset, length );
+    text[ length ] = '\0';
+    free( dictionary->text[ id ]);
+    dictionary->text[ id ] = text;
+    return ulog_status_descriptive( 0, "string defined" );
+}
+
+/* finds text of reference, copying literal one to storage */
+static bool
+resolve(
+    ulog_intern_dictionary const * const dictionary,
+    reader * const entry,
+    char const * * const text,
+    uint32_t * const length,
+    char * const storage,
+    size_t const size
+)
+{
+    uint32_t reference;
+    if( !take( entry, &reference, sizeof( reference ))) { return false; }
+    if( 0U != ( INTERNED & reference ))
+    {
+        uint32_t const id = reference & ~INTERNED;
+        if(( dictionary->count <= id ) || ( NULL == dictionary->text[ id ]))
+        {
+            return false;
+        }
+        *text = dictionary->text[ id ];
+        *length = ( uint32_t ) strlen( *text );
+        return true;
+    }
+    if(
+        ( size <= reference )
+        || !take( entry, storage, reference )
+    )
+    {
+        return false;
+    }
+    storage[ reference ] = '\0';
+    *text = storage;
+    *length = reference;
+    return true;
+}
+
+/* the binary record is rebuilt with format of this process */
+static ulog_status
+decode_record(
+    ulog_intern_dictionary * const dictionary,
+    bool const checkpoint,
+    reader * const entry,
+    char * const text,
+    size_t const length
+)
+{
+    ulog_binary_header header;
+    unsigned char record[ ULOG_INTERN_BUFFER ];
+    char format[ ULOG_INTERN_BUFFER ];
+    char string[ ULOG_INTERN_BUFFER ];
+    uint32_t format_length = 0U;
+    if(
+        !take( entry, &( header.level ), sizeof( header.level ))
+        || !take( entry, &( header.count ), sizeof( header.count ))
+        || !take( entry, &( header.context ), sizeof( header.context ))
+        || !resolve(
+            dictionary,
+            entry,
+            &( header.format ),
+            &format_length,
+            format,
+            sizeof( format )
+        )
+        || ( entry->size - entry->offset < header.count )
+    )
+    {
+        return ulog_status_descriptive( EINVAL, "malformed record entry" );
+    }
+    unsigned char const * const types = entry->data + entry->offset;
+    entry->offset += header.count;
+    bool const headed = has_header( &header, types );
+    uint64_t time = dictionary->time;
+    writer to =
+    {
+        .data = record,
+        .size = sizeof( record ),
+        .used = sizeof( header ),
+        .fits = true
+    };
+    put( &to, types, header.count );
+    for( size_t i = 0U; i < header.count; ++i )
+    {
+        if( ULOG_ARG_STRING == types[ i ] )
+        {
+            char const * value = NULL;
+            uint32_t value_length = 0U;
+            if(
+                !resolve(
+                    dictionary,
+                    entry,
+                    &value,
+                    &value_length,
+                    string,
+                    sizeof( string )
+                )
+            )
+            {
+                return ulog_status_descriptive( EINVAL, "malformed string" );
+            }
+            put( &to, &value_length, sizeof( value_length ));
+            put( &to, value, value_length );
+            continue;
+        }
+        if( headed && ( TIME_ARGUMENT == i ))
+        {
+            uint64_t stored = 0U;
+            if(
+                !take_varint( entry, &stored )
+                || ( !checkpoint && !( dictionary->timed ))
+            )
+            {
+                return ulog_status_descriptive( EINVAL, "malformed time" );
+            }
+            time = checkpoint ? stored : time + unzigzag( stored );
+            put( &to, &time, sizeof( time ));
+            continue;
+        }
+        size_t size = 0U;
+        if( !argument_size( entry, types[ i ], &size ))
+        {
+            return ulog_status_descriptive( EINVAL, "malformed argument" );
+        }
+        put( &to, entry->data + entry->offset, size );
+        entry->offset += size;
+    }
+    put( &to, entry->data + entry->offset, entry->size - entry->offset );
+    if( !to.fits )
+    {
+        return ulog_status_descriptive( EINVAL, "record too large" );
+    }
+    if( headed )
+    {
+        dictionary->time = time;
+        dictionary->timed = true;
+    }
+    header.size = ( uint32_t ) to.used;
+    memcpy( record, &header, sizeof( header ));
+    return ulog_binary_decode( record, to.used, text, length );
+}
+
+ulog_status
+ulog_intern_decode(
+    ulog_intern_dictionary * const dictionary,
+    void const * const data,
+    size_t const size,
+    size_t * const consumed,
+    char * const text,
+    size_t const length
+)
+{
+    if(
+        ( NULL == dictionary ) || ( NULL == data ) || ( NULL == consumed )
+        || ( NULL == text ) || ( 0U == length )
+    )
+    {
+        return ulog_status_descriptive( EINVAL, "invalid stream" );
+    }
+    unsigned char const * const bytes = data;
+    *consumed = 0U;
+    while( ENTRY_HEADER <= size - *consumed )
+    {
+        uint8_t const kind = bytes[ *consumed ];
+        uint32_t entry_size;
+        memcpy( &entry_size, bytes + *consumed + 1U, sizeof( entry_size ));
+        if( ENTRY_HEADER > entry_size )
+        {
+            return ulog_status_descriptive( EINVAL, "malformed entry" );
+        }
+        if( size - *consumed < entry_size ) { break; }
+        reader entry =
+        {
+            .data = bytes + *consumed,
+            .size = entry_size,
+            .offset = ENTRY_HEADER
+        };
+        ulog_status result;
+        if( KIND_DEFINITION == kind ) { result = define( dictionary, &entry ); }
+        else if( KIND_STREAM == kind )
+        {
+            result =
+                ulog_interned( entry.data, entry.size )
+                    ? ulog_status_descriptive( 0, "stream begun" )
+                    : ulog_status_descriptive( EINVAL, "malformed marker" );
+            /* strings of the previous stream aren't used by this one */
+            ulog_intern_release( dictionary );
+        }
+        else if(( KIND_RECORD == kind ) || ( KIND_CHECKPOINT == kind ))
+        {
+            result =
+                decode_record(
+                    dictionary,
+                    KIND_CHECKPOINT == kind,
+                    &entry,
+                    text,
+                    length
+                );
+        }
+        else { result = ulog_status_descriptive( EINVAL, "unknown entry" ); }
+        if( !ulog_status_success( result )) { return result; }
+        *consumed += entry_size;
+        if(( KIND_RECORD == kind ) || ( KIND_CHECKPOINT == kind ))
+        {
+            return result;
+        }
+    }
+    return ulog_status_descriptive( ENODATA, "no whole record" );
+}
+
+bool
+ulog_interned( void const * const data, size_t const size )
+{
+    unsigned char const * const bytes = data;
+    return
+        ( NULL != data ) && ( MARKER_SIZE <= size )
+        && ( KIND_STREAM == bytes[ 0 ] )
+        && ( 0 == memcmp( bytes + ENTRY_HEADER, MAGIC, sizeof( MAGIC ) - 1U ));
+}
+
+size_t
+ulog_intern_restart(
+    void const * const data,
+    size_t const size,
+    size_t const from
+)
+{
+    unsigned char const * const bytes = data;
+    /* definitions preceding a checkpoint belong to it */
+    size_t definitions = from;
+    for(
+        size_t offset = from;
+        ( NULL != data ) && ( size >= offset )
+        && ( ENTRY_HEADER <= size - offset );
+    )
+    {
+        uint8_t const kind = bytes[ offset ];
+        size_t const start =
+            ( KIND_CHECKPOINT == kind ) ? definitions : offset;
+        if(
+            (( KIND_STREAM == kind ) || ( KIND_CHECKPOINT == kind ))
+            && ( from < start )
+        )
+        {
+            return start;
+        }
+        uint32_t entry_size;
+        memcpy( &entry_size, bytes + offset + 1U, sizeof( entry_size ));
+        if(( ENTRY_HEADER > entry_size ) || ( size - offset < entry_size ))
+        {
+            break;
+        }
+        offset += entry_size;
+        if( KIND_DEFINITION != kind ) { definitions = offset; }
+    }
+    return size;
+}
+
+void
+ulog_intern_release( ulog_intern_dictionary * const dictionary )
+{
+    if( NULL == dictionary ) { return; }
+    for( size_t i = 0U; i < dictionary->count; ++i )
+    {
+        free( dictionary->text[ i ]);
+    }
+    free( dictionary->text );
+    dictionary->text = NULL;
+    dictionary->count = 0U;
+    dictionary->time = 0U;
+    dictionary->timed = false;
+}
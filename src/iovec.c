@@ -0,0 +1,84 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Implements rendering of log records into scattered pieces.
+ * \date        2016/04/09 10:37:21 AM
+ * \file        iovec.c
+ * \version     1.0
+ *
+ *
+ **/
+
+#include <ulog/iovec.h>
+#include <ulog/ulog.h> /* ULOG_HEADER_FORMAT_ */
+
+#include <inttypes.h> /* PRIu64 */
+#include <stdint.h> /* uint64_t */
+#include <stdio.h> /* snprintf, vsnprintf */
+#include <string.h> /* strlen, strncmp */
+
+static char const separator[] = ":";
+
+static size_t
+clamp( int const length, size_t const size )
+{
+    if( 0 > length ) { return 0U; }
+    return ( size <= ( size_t ) length ) ? size - 1U : ( size_t ) length;
+}
+
+static void
+set( struct iovec * const piece, char const * const data, size_t const size )
+{
+    /* writev() doesn't modify the data, iovec just isn't const-qualified */
+    piece->iov_base = ( void * ) data;
+    piece->iov_len = size;
+}
+
+void
+ulog_iovec_render(
+    ulog_iovec_record * const record,
+    char * const body,
+    size_t const size,
+    char const * const format,
+    va_list args
+)
+{
+    size_t const header = sizeof( ULOG_HEADER_FORMAT_ ) - 1U;
+    if( 0 != strncmp( format, ULOG_HEADER_FORMAT_, header ))
+    {
+        set( &( record->piece[ 0 ] ), body, clamp(
+            vsnprintf( body, size, format, args ),
+            size
+        ));
+        record->count = 1;
+        return;
+    }
+
+    char const level = ( char ) va_arg( args, int );
+    uint64_t const time = va_arg( args, uint64_t );
+    char const * const file = va_arg( args, char const * );
+    char const * const function = va_arg( args, char const * );
+    unsigned const line = va_arg( args, unsigned );
+
+    set( &( record->piece[ 0 ] ), record->prefix, clamp(
+        snprintf(
+            record->prefix,
+            sizeof( record->prefix ),
+            "[%c][%" PRIu64 "][",
+            level,
+            time
+        ),
+        sizeof( record->prefix )
+    ));
+    set( &( record->piece[ 1 ] ), file, strlen( file ));
+    set( &( record->piece[ 2 ] ), separator, sizeof( separator ) - 1U );
+    set( &( record->piece[ 3 ] ), function, strlen( function ));
+    set( &( record->piece[ 4 ] ), record->suffix, clamp(
+        snprintf( record->suffix, sizeof( record->suffix ), ":%u] ", line ),
+        sizeof( record->suffix )
+    ));
+    set( &( record->piece[ 5 ] ), body, clamp(
+        vsnprintf( body, size, format + header, args ),
+        size
+    ));
+    record->count = ( int ) ULOG_IOVEC_PIECES;
+}
@@ -0,0 +1,383 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Implements merge of logged records by time.
+ * \date        2016/06/01 10:12:47 AM
+ * \file        merge.c
+ * \version     1.0
+ *
+ *
+ **/
+
+#define _POSIX_C_SOURCE 200809L /* for posix_madvise */
+
+#include <ulog/merge.h>
+#include <ulog/compress.h> /* ulog_compressed, ulog_decompress_next */
+#include <ulog/intern.h> /* ULOG_INTERN_BUFFER, ulog_intern_decode, etc. */
+#include <ulog/universal.h> /* UNUSED */
+
+#include <errno.h> /* EINVAL, EIO, ENODATA, ENOMEM */
+#include <fcntl.h> /* O_CLOEXEC, O_RDONLY, open */
+#include <stdbool.h> /* bool */
+#include <stddef.h> /* NULL, size_t */
+#include <stdint.h> /* uint64_t */
+#include <stdio.h> /* EOF, FILE, fputc, fputs, fwrite */
+#include <stdlib.h> /* calloc, free */
+#include <string.h> /* memchr, memmove, strlen */
+#include <sys/mman.h> /* mmap, munmap, posix_madvise */
+#include <sys/stat.h> /* fstat, struct stat */
+#include <unistd.h> /* close */
+
+/* mapped file, with its current record; blocks of a compressed one are
+ * decompressed one by one into a window, which keeps the current record;
+ * records of an interned one are decoded into text */
+typedef struct
+{
+    void * mapped;
+    size_t size;
+    bool compressed;
+    size_t block;
+    void * window;
+    size_t capacity;
+    int error;
+    unsigned char const * record;
+    unsigned char const * next;
+    unsigned char const * end;
+    uint64_t time;
+    bool interned;
+    ulog_intern_dictionary dictionary;
+    char text[ ULOG_INTERN_BUFFER ];
+}
+source;
+
+/* parses "[%c][%" PRIu64 "]" at the start of line */
+static bool
+header_time(
+    unsigned char const * const line,
+    unsigned char const * const end,
+    uint64_t * const time
+)
+{
+    if(
+        ( 6 > end - line )
+        || ( '[' != line[ 0 ] ) || ( ']' != line[ 2 ] )
+        || ( '[' != line[ 3 ] )
+    )
+    {
+        return false;
+    }
+    uint64_t value = 0U;
+    unsigned char const * digit = line + 4;
+    for( ; ( end > digit ) && ( '0' <= *digit ) && ( '9' >= *digit ); ++digit )
+    {
+        value = value * 10U + ( uint64_t ) ( *digit - '0' );
+    }
+    if(( line + 4 == digit ) || ( end <= digit ) || ( ']' != *digit ))
+    {
+        return false;
+    }
+    *time = value;
+    return true;
+}
+
+/* moves current record to the start of window, then next block after it */
+static bool
+take_block( source * const self )
+{
+    if( !( self->compressed ) || ( 0 != self->error )) { return false; }
+    size_t length = ( size_t ) ( self->end - self->record );
+    if( 0U != length ) { memmove( self->window, self->record, length ); }
+    ulog_status const taken =
+        ulog_decompress_next(
+            self->mapped,
+            self->size,
+            &( self->block ),
+            &( self->window ),
+            &( self->capacity ),
+            &length
+        );
+    if( NULL != self->window )
+    {
+        self->record = self->window;
+        self->end = self->record + length;
+    }
+    /* the last block may be still being written, it ends the file */
+    if( ENODATA == ulog_status_to_int( taken )) { self->compressed = false; }
+    else if( !ulog_status_success( taken ))
+    {
+        self->error = ulog_status_to_int( taken );
+    }
+    return ulog_status_success( taken );
+}
+
+/* record is decoded whole, so blocks are taken until it is */
+static bool
+advance_interned( source * const self )
+{
+    for( ;; )
+    {
+        size_t consumed = 0U;
+        ulog_status const decoded =
+            ulog_intern_decode(
+                &( self->dictionary ),
+                self->next,
+                ( size_t ) ( self->end - self->next ),
+                &consumed,
+                self->text,
+                sizeof( self->text )
+            );
+        self->record = self->next + consumed;
+        if( ENODATA == ulog_status_to_int( decoded ))
+        {
+            /* record split by the end of block continues in the next one */
+            if( !take_block( self )) { return false; }
+            self->next = self->record;
+            continue;
+        }
+        if( !ulog_status_success( decoded ))
+        {
+            self->error = EINVAL;
+            return false;
+        }
+        self->next = self->record;
+        size_t const length = strlen( self->text );
+        unsigned char const * const line = ( unsigned char const * ) self->text;
+        /* records without the standard header follow the one before */
+        UNUSED( header_time( line, line + length, &( self->time )));
+        return true;
+    }
+}
+
+/* record spans its header line and lines without header after it */
+static bool
+advance( source * const self )
+{
+    if( self->interned ) { return advance_interned( self ); }
+    self->record = self->next;
+    /* lines are parsed whole, so blocks are taken until their newline */
+    size_t line = 0U;
+    for( ;; )
+    {
+        unsigned char const * const start = self->record + line;
+        unsigned char const * const newline =
+            ( self->end > start )
+                ? memchr( start, '\n', ( size_t ) ( self->end - start ))
+                : NULL;
+        if(( NULL == newline ) && take_block( self )) { continue; }
+        if( self->end <= start ) { break; }
+        uint64_t time = 0U;
+        /* lines starting the file precede all records */
+        if( header_time( start, self->end, &time ))
+        {
+            if( 0U != line ) { break; }
+            self->time = time;
+        }
+        unsigned char const * const after =
+            ( NULL == newline ) ? self->end : newline + 1;
+        line = ( size_t ) ( after - self->record );
+    }
+    self->next = self->record + line;
+    return self->next > self->record;
+}
+
+static ulog_status
+source_failure( source const * const self )
+{
+    return
+        ( ENOMEM == self->error )
+            ? ulog_status_descriptive( ENOMEM, "cannot allocate window" )
+            : ulog_status_descriptive( EINVAL, "malformed block or record" );
+}
+
+/* earlier time first, then earlier file, so that merging is stable */
+static bool
+precedes(
+    source const * const sources,
+    size_t const first,
+    size_t const second
+)
+{
+    return
+        ( sources[ first ].time < sources[ second ].time )
+        || (
+            ( sources[ first ].time == sources[ second ].time )
+            && ( first < second )
+        );
+}
+
+static void
+sift_down(
+    source const * const sources,
+    size_t * const heap,
+    size_t const count,
+    size_t position
+)
+{
+    for( ;; )
+    {
+        size_t const left = 2U * position + 1U;
+        size_t const right = left + 1U;
+        size_t least = position;
+        if(( count > left ) && precedes( sources, heap[ left ], heap[ least ]))
+        {
+            least = left;
+        }
+        if(
+            ( count > right )
+            && precedes( sources, heap[ right ], heap[ least ])
+        )
+        {
+            least = right;
+        }
+        if( least == position ) { return; }
+        size_t const swapped = heap[ position ];
+        heap[ position ] = heap[ least ];
+        heap[ least ] = swapped;
+        position = least;
+    }
+}
+
+static ulog_status
+open_source( source * const self, char const * const path )
+{
+    int const file = ( NULL == path ) ? -1 : open( path, O_RDONLY | O_CLOEXEC );
+    struct stat status;
+    if(( -1 == file ) || ( 0 != fstat( file, &status )))
+    {
+        if( -1 != file ) { close( file ); }
+        return ulog_status_descriptive( EIO, "cannot open file" );
+    }
+    self->size = ( size_t ) status.st_size;
+    if( 0U == self->size )
+    {
+        close( file );
+        return ulog_status_descriptive( 0, "file empty" );
+    }
+    void * const mapped =
+        mmap( NULL, self->size, PROT_READ, MAP_PRIVATE, file, 0 );
+    close( file );
+    if( MAP_FAILED == mapped )
+    {
+        return ulog_status_descriptive( EIO, "cannot map file" );
+    }
+    UNUSED( posix_madvise( mapped, self->size, POSIX_MADV_SEQUENTIAL ));
+    self->mapped = mapped;
+    self->next = mapped;
+    self->compressed = ulog_compressed( mapped, self->size );
+    /* window of compressed file is empty until its first block is taken */
+    self->record = self->next;
+    self->end = self->next + ( self->compressed ? 0U : self->size );
+    /* the first block tells whether its records are interned */
+    if( self->compressed && take_block( self )) { self->next = self->record; }
+    self->interned =
+        ulog_interned( self->next, ( size_t ) ( self->end - self->next ));
+    return ulog_status_descriptive( 0, "file mapped" );
+}
+
+static ulog_status
+write_record( source const * const self, FILE * const output )
+{
+    /* last line of the file, or truncated text, may lack its newline */
+    bool written = false;
+    if( self->interned )
+    {
+        size_t const length = strlen( self->text );
+        written =
+            ( EOF != fputs( self->text, output ))
+            && (
+                (( 0U != length ) && ( '\n' == self->text[ length - 1U ]))
+                || ( EOF != fputc( '\n', output ))
+            );
+    }
+    else
+    {
+        size_t const size = ( size_t ) ( self->next - self->record );
+        written =
+            ( 1U == fwrite( self->record, size, 1U, output ))
+            && (
+                ( '\n' == self->next[ -1 ])
+                || ( EOF != fputc( '\n', output ))
+            );
+    }
+    return
+        written
+            ? ulog_status_descriptive( 0, "record written" )
+            : ulog_status_descriptive( EIO, "cannot write output" );
+}
+
+static ulog_status
+merge_sources(
+    source * const sources,
+    size_t * const heap,
+    size_t const count,
+    FILE * const output,
+    uint64_t * const merged
+)
+{
+    size_t filled = 0U;
+    for( size_t i = 0U; i < count; ++i )
+    {
+        if( advance( sources + i )) { heap[ filled++ ] = i; }
+        if( 0 != sources[ i ].error ) { return source_failure( sources + i ); }
+    }
+    for( size_t i = filled / 2U; 0U < i--; )
+    {
+        sift_down( sources, heap, filled, i );
+    }
+    while( 0U != filled )
+    {
+        source * const earliest = sources + heap[ 0 ];
+        ulog_status const written = write_record( earliest, output );
+        if( !ulog_status_success( written )) { return written; }
+        ++( *merged );
+        if( !advance( earliest )) { heap[ 0 ] = heap[ --filled ]; }
+        if( 0 != earliest->error ) { return source_failure( earliest ); }
+        sift_down( sources, heap, filled, 0U );
+    }
+    return ulog_status_descriptive( 0, "files merged" );
+}
+
+ulog_status
+ulog_merge(
+    char const * const * const paths,
+    size_t const count,
+    FILE * const output,
+    uint64_t * const merged
+)
+{
+    if(( NULL == paths ) || ( NULL == output ))
+    {
+        return ulog_status_descriptive( ENODATA, "invalid merge arguments" );
+    }
+    uint64_t written = 0U;
+    if( NULL != merged ) { *merged = 0U; }
+    source * const sources = calloc( count, sizeof( source ));
+    size_t * const heap = calloc( count, sizeof( size_t ));
+    if(( 0U != count ) && (( NULL == sources ) || ( NULL == heap )))
+    {
+        free( sources );
+        free( heap );
+        return ulog_status_descriptive( ENOMEM, "cannot allocate sources" );
+    }
+    ulog_status result = ulog_status_descriptive( 0, "files merged" );
+    for( size_t i = 0U; ( count > i ) && ulog_status_success( result ); ++i )
+    {
+        result = open_source( sources + i, paths[ i ]);
+    }
+    if( ulog_status_success( result ))
+    {
+        result = merge_sources( sources, heap, count, output, &written );
+    }
+    for( size_t i = 0U; i < count; ++i )
+    {
+        if( NULL != sources[ i ].mapped )
+        {
+            munmap( sources[ i ].mapped, sources[ i ].size );
+        }
+        free( sources[ i ].window );
+        ulog_intern_release( &( sources[ i ].dictionary ));
+    }
+    free( sources );
+    free( heap );
+    if( NULL != merged ) { *merged = written; }
+    return result;
+}
@@ -3,19 +3,46 @@
  * \brief       C99/C11 implementation of simple mutex wrapper.
  * \date        2015/08/29 17:16:23 AM
  * \file        mutex.c
- * \version     1.2
+ * \version     1.3
  *
+ * Besides the plain wrapper this file provides an adaptive mutex, which
+ * spins for a while before parking the thread on a futex (on Linux; other
+ * systems sleep briefly instead). The spin limit is tuned per mutex
+ * according to how long the recent acquisitions took.
  *
+ * Shared locking of adaptive mutex is a distributed reader lock: each
+ * thread announces itself in one of several reader slots, each on its own
+ * cache line, so readers don't contend with each other. Writer takes the
+ * exclusive lock, raises writer flag and waits for all slots to drain.
+ * Until the mutex is locked shared for the first time writers skip that,
+ * and unlock wakes parked readers only if there are any.
+ * Plain mutex degenerates shared locking to exclusive one.
+ *
+ * Uncontended exclusive locking, and shared locking while no writer is
+ * in, are inlined by mutex.h, which sees only ulog_mutex_fast leading the
+ * state of every mutex and the reader slot index of the calling thread.
  **/
 
+#define _DEFAULT_SOURCE /* for nanosleep, syscall */
+
 #include <ulog/mutex.h>
+#include <ulog/queue.h> /* ULOG_CACHE_LINE */
 #include <ulog/status.h> /* ulog_status, ulog_status_descriptive */
-#include <ulog/universal.h> /* THREADUNSAFE, UNUSED */
+#include <ulog/universal.h> /* THREADLOCAL, THREADUNSAFE, UNUSED */
 
 #include <errno.h> /* EALREADY, EBUSY, EINVAL, EIO, ENOMEM */
+#include <sched.h> /* sched_yield */
 #include <stdbool.h> /* bool */
 #include <stddef.h> /* NULL */
+#include <stdint.h> /* UINT64_MAX, uint8_t, uint32_t, uint64_t */
 #include <stdlib.h> /* free, malloc */
+#include <limits.h> /* INT_MAX */
+#include <time.h> /* nanosleep, struct timespec, time_t */
+#ifdef __linux__
+# include <linux/futex.h> /* FUTEX_WAIT, FUTEX_WAKE, etc. */
+# include <sys/syscall.h> /* SYS_futex */
+# include <unistd.h> /* syscall */
+#endif /* __linux__ */
 #if __STDC_NO_THREADS__
 # include <pthread.h>
 #else /* !__STDC_NO_THREADS__ */
@@ -36,12 +63,52 @@ typedef
 #endif /* __STDC_NO_THREADS__ */
 mutex_obj;
 
+/* values of the adaptive mutex word */
+typedef enum
+{
+    UNLOCKED = ULOG_MUTEX_UNLOCKED,
+    LOCKED = ULOG_MUTEX_LOCKED,
+    CONTENDED = 2U,
+    /* of plain mutexes and guards, fast paths never match it */
+    FOREIGN = 3U
+}
+adaptive_word;
+
+/* without futex, parked threads check again this often */
+#define PARK_NANOSECONDS 100000U
+#define NANOSECONDS_IN_SECOND 1000000000U
+
+/* bounds of the number of spins before parking */
+#define ADAPTIVE_SPIN_MIN 16U
+#define ADAPTIVE_SPIN_MAX 1024U
+
+/* readers in one slot share a cache line, slots don't */
+typedef struct
+{
+    uint32_t count;
+    uint8_t padding[ ULOG_CACHE_LINE - sizeof( uint32_t ) ];
+}
+reader_slot;
+
 struct ulog_mutex_state_struct
 {
+    /* has to come first, for inline fast paths of mutex.h */
+    ulog_mutex_fast fast;
     mutex_obj mutex;
+    /* used only by adaptive mutex, instead of the mutex above */
+    uint32_t spin;
+    /* readers parked on writer flag, for unlock to know whom to wake */
+    uint32_t parked;
     ulog_mutex_op_table const * op;
+    uint8_t separator_readers[ ULOG_CACHE_LINE ];
+    /* ULOG_MUTEX_READER_SLOTS elements, allocated only by adaptive mutex */
+    reader_slot readers[];
 };
 
+/* reader slot of calling thread, assigned round robin on first use */
+THREADLOCAL unsigned ulog_mutex_reader_;
+static unsigned reader_next;
+
 typedef
 #if __STDC_NO_THREADS__
     pthread_mutexattr_t const *
@@ -184,6 +251,12 @@ cleanup_already( ulog_mutex * const self )
     return generic_already( self, "mutex already cleaned up" );
 }
 
+static inline ulog_status
+reset_uninitialized( ulog_mutex * const self )
+{
+    return generic_uninitialized( self );
+}
+
 static inline ulog_status
 generic_operation(
     ulog_mutex const * const self,
@@ -207,20 +280,28 @@ static inline ulog_status
 lock_safe( ulog_mutex const * const self );
 static inline ulog_status
 unlock_safe( ulog_mutex const * const self );
+static THREADUNSAFE ulog_status
+reset_safe( ulog_mutex * const self );
 
 static ulog_mutex_op_table const default_op =
 {
     .setup = setup_safe,
     .cleanup = cleanup_already,
     .lock = generic_uninitialized,
-    .unlock = generic_uninitialized
+    .unlock = generic_uninitialized,
+    .lock_shared = generic_uninitialized,
+    .unlock_shared = generic_uninitialized,
+    .reset = reset_uninitialized
 };
 static ulog_mutex_op_table const setup_op =
 {
     .setup = setup_already,
     .cleanup = cleanup_safe,
     .lock = lock_safe,
-    .unlock = unlock_safe
+    .unlock = unlock_safe,
+    .lock_shared = lock_safe,
+    .unlock_shared = unlock_safe,
+    .reset = reset_safe
 };
 /*
  * it would be nice to have an additional "locked" state
@@ -229,7 +310,11 @@ static ulog_mutex_op_table const setup_op =
  * instead of blocking the calling thread
  */
 
-static ulog_mutex_state guard = { .op = &default_op };
+static ulog_mutex_state guard =
+{
+    .fast = { .word = FOREIGN },
+    .op = &default_op
+};
 
 static THREADUNSAFE ulog_status
 setup_safe( ulog_mutex * const self )
@@ -243,6 +328,7 @@ setup_safe( ulog_mutex * const self )
         );
     }
     self->state = state;
+    self->state->fast = ( ulog_mutex_fast ) { .word = FOREIGN };
     self->state->op = &setup_op;
 
     ulog_status const result =
@@ -287,6 +373,284 @@ unlock_safe( ulog_mutex const * const self )
     return generic_operation( self, &( generic_arg[ UNLOCK ] ));
 }
 
+/* owner may not exist after fork, so the mutex is initialized over */
+static THREADUNSAFE ulog_status
+reset_safe( ulog_mutex * const self )
+{
+    return generic_operation( self, &( generic_arg[ SETUP ] ));
+}
+
+static THREADUNSAFE ulog_status
+setup_adaptive( ulog_mutex * const self );
+static THREADUNSAFE ulog_status
+cleanup_adaptive( ulog_mutex * const self );
+static inline ulog_status
+lock_adaptive( ulog_mutex const * const self );
+static inline ulog_status
+unlock_adaptive( ulog_mutex const * const self );
+static inline ulog_status
+lock_shared_adaptive( ulog_mutex const * const self );
+static inline ulog_status
+unlock_shared_adaptive( ulog_mutex const * const self );
+static THREADUNSAFE ulog_status
+reset_adaptive( ulog_mutex * const self );
+
+static ulog_mutex_op_table const adaptive_default_op =
+{
+    .setup = setup_adaptive,
+    .cleanup = cleanup_already,
+    .lock = generic_uninitialized,
+    .unlock = generic_uninitialized,
+    .lock_shared = generic_uninitialized,
+    .unlock_shared = generic_uninitialized,
+    .reset = reset_uninitialized
+};
+static ulog_mutex_op_table const adaptive_setup_op =
+{
+    .setup = setup_already,
+    .cleanup = cleanup_adaptive,
+    .lock = lock_adaptive,
+    .unlock = unlock_adaptive,
+    .lock_shared = lock_shared_adaptive,
+    .unlock_shared = unlock_shared_adaptive,
+    .reset = reset_adaptive
+};
+
+static ulog_mutex_state adaptive_guard =
+{
+    .fast = { .word = FOREIGN },
+    .op = &adaptive_default_op
+};
+
+static inline void
+relax( void )
+{
+#if defined( __x86_64__ ) || defined( __i386__ )
+    __builtin_ia32_pause();
+#endif /* __x86_64__ || __i386__ */
+}
+
+static __attribute__(( noinline, cold )) void
+lock_contended( ulog_mutex_state * const state )
+{
+    /* spin limit follows recent spin counts, as in glibc's adaptive mutex */
+    uint32_t const limit =
+        2U * __atomic_load_n( &( state->spin ), __ATOMIC_RELAXED )
+        + ADAPTIVE_SPIN_MIN;
+    uint32_t * const word = &( state->fast.word );
+    uint32_t spins = 0U;
+    uint32_t expected = UNLOCKED;
+    for( ; spins < limit; ++spins )
+    {
+        if(
+            ( UNLOCKED == __atomic_load_n( word, __ATOMIC_RELAXED ))
+            && __atomic_compare_exchange_n(
+                word,
+                &expected,
+                LOCKED,
+                false,
+                __ATOMIC_ACQUIRE,
+                __ATOMIC_RELAXED
+            )
+        )
+        {
+            break;
+        }
+        expected = UNLOCKED;
+        relax();
+    }
+    int32_t const spin =
+        ( int32_t ) __atomic_load_n( &( state->spin ), __ATOMIC_RELAXED );
+    uint32_t const next =
+        ( uint32_t ) ( spin + (( int32_t ) spins - spin ) / 8 );
+    __atomic_store_n(
+        &( state->spin ),
+        ( next > ADAPTIVE_SPIN_MAX ) ? ADAPTIVE_SPIN_MAX : next,
+        __ATOMIC_RELAXED
+    );
+    if( spins < limit ) { return; }
+
+    /* mark the mutex contended, so that unlock knows to wake us up */
+    while( UNLOCKED != __atomic_exchange_n( word, CONTENDED, __ATOMIC_ACQUIRE ))
+    {
+        ulog_mutex_park_( word, CONTENDED, UINT64_MAX, false );
+    }
+}
+
+static inline void
+lock_word( ulog_mutex_state * const state )
+{
+    uint32_t expected = UNLOCKED;
+    if(
+        !__atomic_compare_exchange_n(
+            &( state->fast.word ),
+            &expected,
+            LOCKED,
+            false,
+            __ATOMIC_ACQUIRE,
+            __ATOMIC_RELAXED
+        )
+    )
+    {
+        lock_contended( state );
+    }
+}
+
+static inline void
+unlock_word( ulog_mutex_state * const state )
+{
+    uint32_t * const word = &( state->fast.word );
+    if( CONTENDED == __atomic_exchange_n( word, UNLOCKED, __ATOMIC_RELEASE ))
+    {
+        ulog_mutex_unpark_( word, 1, false );
+    }
+}
+
+static THREADUNSAFE ulog_status
+setup_adaptive( ulog_mutex * const self )
+{
+    ulog_mutex_state * const state =
+        malloc(
+            sizeof( ulog_mutex_state )
+            + ULOG_MUTEX_READER_SLOTS * sizeof( reader_slot )
+        );
+    if( NULL == state )
+    {
+        return ulog_status_descriptive(
+            ENOMEM,
+            "cannot allocate memory for mutex state"
+        );
+    }
+    state->spin = 0U;
+    state->op = &adaptive_setup_op;
+    self->state = state;
+    return reset_adaptive( self );
+}
+
+/* readers which announced themselves may not exist after fork either */
+static THREADUNSAFE ulog_status
+reset_adaptive( ulog_mutex * const self )
+{
+    ulog_mutex_state * const state = self->state;
+    state->fast.word = UNLOCKED;
+    state->fast.shared = 0U;
+    state->fast.writer = 0U;
+    state->fast.readers = &( state->readers[ 0 ].count );
+    state->parked = 0U;
+    for( unsigned i = 0U; i < ULOG_MUTEX_READER_SLOTS; ++i )
+    {
+        state->readers[ i ].count = 0U;
+    }
+    return ulog_status_descriptive( 0, generic_arg[ SETUP ].success );
+}
+
+static THREADUNSAFE ulog_status
+cleanup_adaptive( ulog_mutex * const self )
+{
+    /* same as with plain mutex, wait for the current owner to finish */
+    self->op->lock( self );
+    self->op->unlock( self );
+    free( self->state );
+    self->state = &adaptive_guard;
+    return ulog_status_descriptive( 0, generic_arg[ CLEANUP ].success );
+}
+
+static inline ulog_status
+lock_adaptive( ulog_mutex const * const self )
+{
+    ulog_mutex_state * const state = self->state;
+    lock_word( state );
+    /* the flag is raised only under the lock, so it's stable now */
+    if( 0U != __atomic_load_n( &( state->fast.shared ), __ATOMIC_RELAXED ))
+    {
+        /* writers are already excluded, now keep new readers out and drain */
+        __atomic_store_n( &( state->fast.writer ), 1U, __ATOMIC_SEQ_CST );
+        for( unsigned i = 0U; i < ULOG_MUTEX_READER_SLOTS; ++i )
+        {
+            uint32_t * const count = &( state->readers[ i ].count );
+            unsigned spins = 0U;
+            while( 0U != __atomic_load_n( count, __ATOMIC_SEQ_CST ))
+            {
+                if( ADAPTIVE_SPIN_MIN > spins ) { ++spins; relax(); }
+                else { UNUSED( sched_yield()); }
+            }
+        }
+    }
+    return ulog_status_descriptive( 0, generic_arg[ LOCK ].success );
+}
+
+static inline ulog_status
+unlock_adaptive( ulog_mutex const * const self )
+{
+    ulog_mutex_state * const state = self->state;
+    if( 0U != __atomic_load_n( &( state->fast.shared ), __ATOMIC_RELAXED ))
+    {
+        /* pairs with reader counting itself parked before checking flag */
+        __atomic_store_n( &( state->fast.writer ), 0U, __ATOMIC_SEQ_CST );
+        if( 0U != __atomic_load_n( &( state->parked ), __ATOMIC_SEQ_CST ))
+        {
+            ulog_mutex_unpark_( &( state->fast.writer ), INT_MAX, false );
+        }
+    }
+    unlock_word( state );
+    return ulog_status_descriptive( 0, generic_arg[ UNLOCK ].success );
+}
+
+/* exclusive lock skips readers until the first of them comes */
+static __attribute__(( noinline, cold )) void
+share( ulog_mutex_state * const state )
+{
+    lock_word( state );
+    __atomic_store_n( &( state->fast.shared ), 1U, __ATOMIC_RELAXED );
+    unlock_word( state );
+}
+
+static inline reader_slot *
+own_slot( ulog_mutex_state * const state )
+{
+    if( 0U == ulog_mutex_reader_ )
+    {
+        ulog_mutex_reader_ =
+            __atomic_fetch_add( &reader_next, 1U, __ATOMIC_RELAXED )
+            % ULOG_MUTEX_READER_SLOTS + 1U;
+    }
+    return &( state->readers[ ulog_mutex_reader_ - 1U ] );
+}
+
+static inline ulog_status
+lock_shared_adaptive( ulog_mutex const * const self )
+{
+    ulog_mutex_state * const state = self->state;
+    if( 0U == __atomic_load_n( &( state->fast.shared ), __ATOMIC_ACQUIRE ))
+    {
+        share( state );
+    }
+    uint32_t * const count = &( own_slot( state )->count );
+    uint32_t * const writer = &( state->fast.writer );
+    for( ;; )
+    {
+        /* pairs with writer raising its flag before checking the slots */
+        UNUSED( __atomic_fetch_add( count, 1U, __ATOMIC_SEQ_CST ));
+        if( 0U == __atomic_load_n( writer, __ATOMIC_SEQ_CST )) { break; }
+        UNUSED( __atomic_fetch_sub( count, 1U, __ATOMIC_RELEASE ));
+        UNUSED( __atomic_fetch_add( &( state->parked ), 1U, __ATOMIC_SEQ_CST ));
+        while( 0U != __atomic_load_n( writer, __ATOMIC_SEQ_CST ))
+        {
+            ulog_mutex_park_( writer, 1U, UINT64_MAX, false );
+        }
+        UNUSED( __atomic_fetch_sub( &( state->parked ), 1U, __ATOMIC_RELAXED ));
+    }
+    return ulog_status_descriptive( 0, "mutex locked for reading" );
+}
+
+static inline ulog_status
+unlock_shared_adaptive( ulog_mutex const * const self )
+{
+    uint32_t * const count = &( own_slot( self->state )->count );
+    UNUSED( __atomic_fetch_sub( count, 1U, __ATOMIC_RELEASE ));
+    return ulog_status_descriptive( 0, "mutex unlocked for reading" );
+}
+
 static inline THREADUNSAFE ulog_status
 setup( ulog_mutex * const self )
 {
@@ -315,12 +679,36 @@ unlock( ulog_mutex const * const self )
     return self->state->op->unlock( self );
 }
 
+static inline ulog_status
+lock_shared( ulog_mutex const * const self )
+{
+    if( !valid( self )) { return generic_invalid( self ); }
+    return self->state->op->lock_shared( self );
+}
+
+static inline ulog_status
+unlock_shared( ulog_mutex const * const self )
+{
+    if( !valid( self )) { return generic_invalid( self ); }
+    return self->state->op->unlock_shared( self );
+}
+
+static inline THREADUNSAFE ulog_status
+reset( ulog_mutex * const self )
+{
+    if( !valid( self )) { return generic_invalid( self ); }
+    return self->state->op->reset( self );
+}
+
 static ulog_mutex_op_table const op =
 {
     .setup = setup,
     .cleanup = cleanup,
     .lock = lock,
-    .unlock = unlock
+    .unlock = unlock,
+    .lock_shared = lock_shared,
+    .unlock_shared = unlock_shared,
+    .reset = reset
 };
 
 static inline bool
@@ -350,3 +738,157 @@ ulog_mutex_get( void )
     return ( ulog_mutex ) { .state = &guard, .op = &op };
 }
 
+
+static inline bool
+adaptive_valid( ulog_mutex const * const self );
+
+static inline THREADUNSAFE ulog_status
+adaptive_setup( ulog_mutex * const self )
+{
+    if( !adaptive_valid( self )) { return generic_invalid( self ); }
+    return self->state->op->setup( self );
+}
+
+static inline THREADUNSAFE ulog_status
+adaptive_cleanup( ulog_mutex * const self )
+{
+    if( !adaptive_valid( self )) { return generic_invalid( self ); }
+    return self->state->op->cleanup( self );
+}
+
+static inline ulog_status
+adaptive_lock( ulog_mutex const * const self )
+{
+    if( !adaptive_valid( self )) { return generic_invalid( self ); }
+    return self->state->op->lock( self );
+}
+
+static inline ulog_status
+adaptive_unlock( ulog_mutex const * const self )
+{
+    if( !adaptive_valid( self )) { return generic_invalid( self ); }
+    return self->state->op->unlock( self );
+}
+
+static inline ulog_status
+adaptive_lock_shared( ulog_mutex const * const self )
+{
+    if( !adaptive_valid( self )) { return generic_invalid( self ); }
+    return self->state->op->lock_shared( self );
+}
+
+static inline ulog_status
+adaptive_unlock_shared( ulog_mutex const * const self )
+{
+    if( !adaptive_valid( self )) { return generic_invalid( self ); }
+    return self->state->op->unlock_shared( self );
+}
+
+static inline THREADUNSAFE ulog_status
+adaptive_reset( ulog_mutex * const self )
+{
+    if( !adaptive_valid( self )) { return generic_invalid( self ); }
+    return self->state->op->reset( self );
+}
+
+static ulog_mutex_op_table const adaptive_op =
+{
+    .setup = adaptive_setup,
+    .cleanup = adaptive_cleanup,
+    .lock = adaptive_lock,
+    .unlock = adaptive_unlock,
+    .lock_shared = adaptive_lock_shared,
+    .unlock_shared = adaptive_unlock_shared,
+    .reset = adaptive_reset
+};
+
+static inline bool
+adaptive_valid( ulog_mutex const * const self )
+{
+    return
+        (
+            ( NULL != self )
+            && (
+                (
+                    ( &adaptive_guard == self->state )
+                    && ( &adaptive_default_op == self->state->op )
+                )
+                || (
+                    ( NULL != self->state )
+                    && ( &adaptive_guard != self->state )
+                    && ( &adaptive_setup_op == self->state->op )
+                )
+            )
+            && ( &adaptive_op == self->op )
+        );
+}
+
+ulog_mutex
+ulog_mutex_get_adaptive( void )
+{
+    return ( ulog_mutex ) { .state = &adaptive_guard, .op = &adaptive_op };
+}
+
+void
+ulog_mutex_park_(
+    uint32_t * const word,
+    uint32_t const value,
+    uint64_t const nanoseconds,
+    bool const shared
+)
+{
+#ifdef __linux__
+    struct timespec const timeout =
+    {
+        .tv_sec = ( time_t ) ( nanoseconds / NANOSECONDS_IN_SECOND ),
+        .tv_nsec = ( long ) ( nanoseconds % NANOSECONDS_IN_SECOND )
+    };
+    /* spurious wake-ups, EAGAIN and ETIMEDOUT are handled by the callers */
+    UNUSED(
+        syscall(
+            SYS_futex,
+            word,
+            shared ? FUTEX_WAIT : FUTEX_WAIT_PRIVATE,
+            value,
+            ( UINT64_MAX == nanoseconds ) ? NULL : &timeout,
+            NULL,
+            0
+        )
+    );
+#else /* !__linux__ */
+    UNUSED( word );
+    UNUSED( value );
+    UNUSED( shared );
+    struct timespec const pause =
+    {
+        .tv_sec = 0,
+        .tv_nsec =
+            ( long ) (( PARK_NANOSECONDS < nanoseconds )
+                ? PARK_NANOSECONDS
+                : nanoseconds )
+    };
+    UNUSED( nanosleep( &pause, NULL ));
+#endif /* __linux__ */
+}
+
+void
+ulog_mutex_unpark_( uint32_t * const word, int const count, bool const shared )
+{
+#ifdef __linux__
+    UNUSED(
+        syscall(
+            SYS_futex,
+            word,
+            shared ? FUTEX_WAKE : FUTEX_WAKE_PRIVATE,
+            count,
+            NULL,
+            NULL,
+            0
+        )
+    );
+#else /* !__linux__ */
+    UNUSED( word );
+    UNUSED( count );
+    UNUSED( shared );
+#endif /* __linux__ */
+}
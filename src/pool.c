@@ -0,0 +1,278 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Implements fixed-size block pool.
+ * \date        2016/02/27 10:30:44 AM
+ * \file        pool.c
+ * \version     1.0
+ *
+ * Free blocks are kept in ulog_queue, which provides lock-free access
+ * without the ABA problems of a naive free-list stack.
+ **/
+
+#include <ulog/pool.h>
+#include <ulog/queue.h> /* ulog_queue, ulog_queueable */
+#include <ulog/status.h> /* ulog_status, ulog_status_descriptive */
+#include <ulog/universal.h> /* THREADUNSAFE, UNUSED */
+
+#include <errno.h> /* EALREADY, EINVAL, ENODATA, ENOMEM */
+#include <stdbool.h> /* bool */
+#include <stddef.h> /* NULL, size_t */
+#include <stdint.h> /* uint8_t */
+#include <stdlib.h> /* free, malloc */
+
+/* each block is preceded by header keeping it in the free queue */
+typedef struct
+{
+    ulog_queueable queue;
+}
+header;
+
+#define ROUND_UP( SIZE ) \
+    (((( SIZE ) + ULOG_POOL_ALIGNMENT - 1U ) / ULOG_POOL_ALIGNMENT ) \
+        * ULOG_POOL_ALIGNMENT )
+#define HEADER_SIZE ROUND_UP( sizeof( header ))
+
+struct ulog_pool_state_struct
+{
+    ulog_pool_op_table const * op;
+    uint8_t * arena;
+    size_t stride;
+    size_t count;
+    ulog_queue free_blocks;
+};
+
+static inline bool
+valid( ulog_pool const * const self );
+
+static inline ulog_status
+generic_invalid( ulog_pool const * const self )
+{
+    UNUSED( self );
+    return ulog_status_descriptive( EINVAL, "invalid pool object" );
+}
+
+static inline ulog_status
+generic_uninitialized( ulog_pool const * const self )
+{
+    UNUSED( self );
+    return ulog_status_descriptive( EINVAL, "pool object uninitialized" );
+}
+
+static inline ulog_status
+setup_already(
+    ulog_pool * const self,
+    size_t const size,
+    size_t const count
+)
+{
+    UNUSED( self );
+    UNUSED( size );
+    UNUSED( count );
+    return ulog_status_descriptive( EALREADY, "pool already set up" );
+}
+
+static inline ulog_status
+cleanup_already( ulog_pool * const self )
+{
+    UNUSED( self );
+    return ulog_status_descriptive( EALREADY, "pool already cleaned up" );
+}
+
+static inline ulog_status
+acquire_uninitialized( ulog_pool const * const self, void * * const block )
+{
+    UNUSED( block );
+    return generic_uninitialized( self );
+}
+
+static inline ulog_status
+release_uninitialized( ulog_pool const * const self, void * const block )
+{
+    UNUSED( block );
+    return generic_uninitialized( self );
+}
+
+static THREADUNSAFE ulog_status
+setup_safe( ulog_pool * const self, size_t const size, size_t const count );
+static THREADUNSAFE ulog_status
+cleanup_safe( ulog_pool * const self );
+static ulog_status
+acquire_safe( ulog_pool const * const self, void * * const block );
+static ulog_status
+release_safe( ulog_pool const * const self, void * const block );
+
+static ulog_pool_op_table const default_op =
+{
+    .setup = setup_safe,
+    .cleanup = cleanup_already,
+    .acquire = acquire_uninitialized,
+    .release = release_uninitialized
+};
+static ulog_pool_op_table const setup_op =
+{
+    .setup = setup_already,
+    .cleanup = cleanup_safe,
+    .acquire = acquire_safe,
+    .release = release_safe
+};
+
+static ulog_pool_state guard = { .op = &default_op };
+
+static THREADUNSAFE ulog_status
+setup_safe( ulog_pool * const self, size_t const size, size_t const count )
+{
+    if(( 0U == size ) || ( 0U == count ))
+    {
+        return ulog_status_descriptive( EINVAL, "invalid pool dimensions" );
+    }
+
+    ulog_pool_state * const state = malloc( sizeof( ulog_pool_state ));
+    if( NULL == state )
+    {
+        return ulog_status_descriptive(
+            ENOMEM,
+            "cannot allocate memory for pool state"
+        );
+    }
+    state->op = &setup_op;
+    state->stride = HEADER_SIZE + ROUND_UP( size );
+    state->count = count;
+    state->arena = malloc( state->stride * count );
+    state->free_blocks = ulog_queue_get();
+
+    ulog_status const result =
+        ( NULL == state->arena )
+        ? ulog_status_descriptive( ENOMEM, "cannot allocate pool arena" )
+        : state->free_blocks.op->setup( &( state->free_blocks ), count );
+    if( !ulog_status_success( result ))
+    {
+        free( state->arena );
+        free( state );
+        return result;
+    }
+    for( size_t i = 0U; i < count; ++i )
+    {
+        header * const item = ( header * ) ( state->arena + i * state->stride );
+        item->queue = ulog_queueable_get();
+        UNUSED(
+            state->free_blocks.op->push(
+                &( state->free_blocks ),
+                &( item->queue )
+            )
+        );
+    }
+    self->state = state;
+    return ulog_status_descriptive( 0, "pool set up successfully" );
+}
+
+static THREADUNSAFE ulog_status
+cleanup_safe( ulog_pool * const self )
+{
+    ulog_pool_state * const state = self->state;
+    UNUSED( state->free_blocks.op->cleanup( &( state->free_blocks )));
+    free( state->arena );
+    free( state );
+    self->state = &guard;
+    return ulog_status_descriptive( 0, "pool cleaned up successfully" );
+}
+
+static ulog_status
+acquire_safe( ulog_pool const * const self, void * * const block )
+{
+    if( NULL == block )
+    {
+        return ulog_status_descriptive( ENODATA, "invalid block pointer" );
+    }
+    ulog_queue const * const free_blocks = &( self->state->free_blocks );
+    ulog_queueable * element;
+    if( !ulog_status_success( free_blocks->op->pop( free_blocks, &element )))
+    {
+        return ulog_status_descriptive( ENOMEM, "pool exhausted" );
+    }
+    *block =
+        (( uint8_t * ) ulog_queueable_get_container( element, header, queue ))
+        + HEADER_SIZE;
+    return ulog_status_descriptive( 0, "block acquired" );
+}
+
+static ulog_status
+release_safe( ulog_pool const * const self, void * const block )
+{
+    if( NULL == block )
+    {
+        return ulog_status_descriptive( ENODATA, "invalid block pointer" );
+    }
+    ulog_pool_state * const state = self->state;
+    uint8_t * const start = (( uint8_t * ) block ) - HEADER_SIZE;
+    if(
+        ( start < state->arena )
+        || ( start >= ( state->arena + state->stride * state->count ))
+        || ( 0U != (( size_t ) ( start - state->arena )) % state->stride )
+    )
+    {
+        return ulog_status_descriptive( ENODATA, "block not from this pool" );
+    }
+    header * const item = ( header * ) start;
+    return
+        state->free_blocks.op->push( &( state->free_blocks ), &( item->queue ));
+}
+
+static inline THREADUNSAFE ulog_status
+setup( ulog_pool * const self, size_t const size, size_t const count )
+{
+    if( !valid( self )) { return generic_invalid( self ); }
+    return self->state->op->setup( self, size, count );
+}
+
+static inline THREADUNSAFE ulog_status
+cleanup( ulog_pool * const self )
+{
+    if( !valid( self )) { return generic_invalid( self ); }
+    return self->state->op->cleanup( self );
+}
+
+static inline ulog_status
+acquire( ulog_pool const * const self, void * * const block )
+{
+    if( !valid( self )) { return generic_invalid( self ); }
+    return self->state->op->acquire( self, block );
+}
+
+static inline ulog_status
+release( ulog_pool const * const self, void * const block )
+{
+    if( !valid( self )) { return generic_invalid( self ); }
+    return self->state->op->release( self, block );
+}
+
+static ulog_pool_op_table const op =
+{
+    .setup = setup,
+    .cleanup = cleanup,
+    .acquire = acquire,
+    .release = release
+};
+
+static inline bool
+valid( ulog_pool const * const self )
+{
+    return
+        (
+            ( NULL != self )
+            && ( NULL != self->state )
+            && (
+                (( &guard == self->state ) && ( &default_op == guard.op ))
+                || (
+                    ( &guard != self->state )
+                    && ( &setup_op == self->state->op )
+                )
+            )
+            && ( &op == self->op )
+        );
+}
+
+ulog_pool
+ulog_pool_get( void )
+{
+    return ( ulog_pool ) { .state = &guard, .op = &op };
+}
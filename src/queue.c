@@ -0,0 +1,333 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Implements bounded lock-free queue.
+ * \date        2016/02/13 12:03:51 PM
+ * \file        queue.c
+ * \version     1.0
+ *
+ * Based on the bounded queue design by Dmitry Vyukov: each slot carries
+ * a sequence number telling whether it's ready to be written or read at
+ * given position, so producers and consumers only contend on the slot
+ * and on their own position counter.
+ **/
+
+#include <ulog/queue.h>
+#include <ulog/status.h> /* ulog_status, ulog_status_descriptive */
+#include <ulog/universal.h> /* THREADUNSAFE, UNUSED */
+
+#include <errno.h> /* EAGAIN, EALREADY, EINVAL, ENODATA, ENOENT, ENOMEM */
+#include <stdbool.h> /* bool */
+#include <stddef.h> /* NULL, size_t */
+#include <stdint.h> /* int64_t, uint8_t, uint64_t */
+#include <stdlib.h> /* free, malloc */
+
+typedef struct
+{
+    uint64_t sequence;
+    ulog_queueable * element;
+}
+slot;
+
+/* positions are written by different threads, keep them apart */
+struct ulog_queue_state_struct
+{
+    ulog_queue_op_table const * op;
+    uint64_t mask;
+    uint8_t separator_tail[ ULOG_CACHE_LINE ];
+    uint64_t tail;
+    uint8_t separator_head[ ULOG_CACHE_LINE ];
+    uint64_t head;
+    uint8_t separator_slots[ ULOG_CACHE_LINE ];
+    slot slots[];
+};
+
+static inline bool
+valid( ulog_queue const * const self );
+
+static inline ulog_status
+generic_invalid( ulog_queue const * const self )
+{
+    UNUSED( self );
+    return ulog_status_descriptive( EINVAL, "invalid queue object" );
+}
+
+static inline ulog_status
+generic_uninitialized( ulog_queue const * const self )
+{
+    UNUSED( self );
+    return ulog_status_descriptive( EINVAL, "queue object uninitialized" );
+}
+
+static inline ulog_status
+generic_invalid_element( ulog_queue const * const self )
+{
+    UNUSED( self );
+    return ulog_status_descriptive( ENODATA, "invalid queueable object" );
+}
+
+static inline ulog_status
+setup_already( ulog_queue * const self, size_t const capacity )
+{
+    UNUSED( self );
+    UNUSED( capacity );
+    return ulog_status_descriptive( EALREADY, "queue already set up" );
+}
+
+static inline ulog_status
+cleanup_already( ulog_queue * const self )
+{
+    UNUSED( self );
+    return ulog_status_descriptive( EALREADY, "queue already cleaned up" );
+}
+
+static inline ulog_status
+push_uninitialized(
+    ulog_queue const * const self,
+    ulog_queueable * const element
+)
+{
+    UNUSED( element );
+    return generic_uninitialized( self );
+}
+
+static inline ulog_status
+pop_uninitialized(
+    ulog_queue const * const self,
+    ulog_queueable * * const element
+)
+{
+    UNUSED( element );
+    return generic_uninitialized( self );
+}
+
+static THREADUNSAFE ulog_status
+setup_safe( ulog_queue * const self, size_t const capacity );
+static THREADUNSAFE ulog_status
+cleanup_safe( ulog_queue * const self );
+static ulog_status
+push_safe( ulog_queue const * const self, ulog_queueable * const element );
+static ulog_status
+pop_safe( ulog_queue const * const self, ulog_queueable * * const element );
+
+static ulog_queue_op_table const default_op =
+{
+    .setup = setup_safe,
+    .cleanup = cleanup_already,
+    .push = push_uninitialized,
+    .pop = pop_uninitialized
+};
+static ulog_queue_op_table const setup_op =
+{
+    .setup = setup_already,
+    .cleanup = cleanup_safe,
+    .push = push_safe,
+    .pop = pop_safe
+};
+
+static ulog_queue_state guard = { .op = &default_op };
+
+static THREADUNSAFE ulog_status
+setup_safe( ulog_queue * const self, size_t const capacity )
+{
+    if( 0U == capacity )
+    {
+        return ulog_status_descriptive( EINVAL, "queue capacity is zero" );
+    }
+    size_t size = 1U;
+    while( size < capacity ) { size <<= 1U; }
+
+    ulog_queue_state * const state =
+        malloc( sizeof( ulog_queue_state ) + size * sizeof( slot ));
+    if( NULL == state )
+    {
+        return ulog_status_descriptive(
+            ENOMEM,
+            "cannot allocate memory for queue state"
+        );
+    }
+    state->op = &setup_op;
+    state->mask = size - 1U;
+    state->tail = 0U;
+    state->head = 0U;
+    for( size_t i = 0U; i < size; ++i )
+    {
+        state->slots[ i ].sequence = i;
+        state->slots[ i ].element = NULL;
+    }
+    self->state = state;
+    return ulog_status_descriptive( 0, "queue set up successfully" );
+}
+
+static THREADUNSAFE ulog_status
+cleanup_safe( ulog_queue * const self )
+{
+    free( self->state );
+    self->state = &guard;
+    return ulog_status_descriptive( 0, "queue cleaned up successfully" );
+}
+
+/*
+ * Slot at given position is free for producer if its sequence equals the
+ * position and ready for consumer if it equals position + 1. Sequence
+ * lower than that means the queue wrapped around: it's full for producer
+ * and empty for consumer. Higher means another thread took the position.
+ */
+static ulog_status
+push_safe( ulog_queue const * const self, ulog_queueable * const element )
+{
+    if( NULL == element ) { return generic_invalid_element( self ); }
+
+    ulog_queue_state * const state = self->state;
+    uint64_t position = __atomic_load_n( &( state->tail ), __ATOMIC_RELAXED );
+    slot * target;
+    for( ;; )
+    {
+        target = &( state->slots[ position & state->mask ] );
+        int64_t const difference = ( int64_t ) (
+            __atomic_load_n( &( target->sequence ), __ATOMIC_ACQUIRE )
+            - position
+        );
+        if( 0 == difference )
+        {
+            if( __atomic_compare_exchange_n(
+                &( state->tail ),
+                &position,
+                position + 1U,
+                true,
+                __ATOMIC_RELAXED,
+                __ATOMIC_RELAXED
+            )) { break; }
+        }
+        else if( 0 > difference )
+        {
+            return ulog_status_descriptive( EAGAIN, "queue is full" );
+        }
+        else
+        {
+            position = __atomic_load_n( &( state->tail ), __ATOMIC_RELAXED );
+        }
+    }
+
+    element->sequence = position;
+    target->element = element;
+    __atomic_store_n( &( target->sequence ), position + 1U, __ATOMIC_RELEASE );
+    return ulog_status_descriptive( 0, "element pushed to queue" );
+}
+
+static ulog_status
+pop_safe( ulog_queue const * const self, ulog_queueable * * const element )
+{
+    if( NULL == element ) { return generic_invalid_element( self ); }
+
+    ulog_queue_state * const state = self->state;
+    uint64_t position = __atomic_load_n( &( state->head ), __ATOMIC_RELAXED );
+    slot * target;
+    for( ;; )
+    {
+        target = &( state->slots[ position & state->mask ] );
+        int64_t const difference = ( int64_t ) (
+            __atomic_load_n( &( target->sequence ), __ATOMIC_ACQUIRE )
+            - ( position + 1U )
+        );
+        if( 0 == difference )
+        {
+            if( __atomic_compare_exchange_n(
+                &( state->head ),
+                &position,
+                position + 1U,
+                true,
+                __ATOMIC_RELAXED,
+                __ATOMIC_RELAXED
+            )) { break; }
+        }
+        else if( 0 > difference )
+        {
+            return ulog_status_descriptive( ENOENT, "queue is empty" );
+        }
+        else
+        {
+            position = __atomic_load_n( &( state->head ), __ATOMIC_RELAXED );
+        }
+    }
+
+    *element = target->element;
+    __atomic_store_n(
+        &( target->sequence ),
+        position + state->mask + 1U,
+        __ATOMIC_RELEASE
+    );
+    return ulog_status_descriptive( 0, "element popped from queue" );
+}
+
+static inline THREADUNSAFE ulog_status
+setup( ulog_queue * const self, size_t const capacity )
+{
+    if( !valid( self )) { return generic_invalid( self ); }
+    return self->state->op->setup( self, capacity );
+}
+
+static inline THREADUNSAFE ulog_status
+cleanup( ulog_queue * const self )
+{
+    if( !valid( self )) { return generic_invalid( self ); }
+    return self->state->op->cleanup( self );
+}
+
+static inline ulog_status
+push( ulog_queue const * const self, ulog_queueable * const element )
+{
+    if( !valid( self )) { return generic_invalid( self ); }
+    return self->state->op->push( self, element );
+}
+
+static inline ulog_status
+pop( ulog_queue const * const self, ulog_queueable * * const element )
+{
+    if( !valid( self )) { return generic_invalid( self ); }
+    return self->state->op->pop( self, element );
+}
+
+static ulog_queue_op_table const op =
+{
+    .setup = setup,
+    .cleanup = cleanup,
+    .push = push,
+    .pop = pop
+};
+
+static inline bool
+valid( ulog_queue const * const self )
+{
+    return
+        (
+            ( NULL != self )
+            && ( NULL != self->state )
+            && (
+                (( &guard == self->state ) && ( &default_op == guard.op ))
+                || (
+                    ( &guard != self->state )
+                    && ( &setup_op == self->state->op )
+                )
+            )
+            && ( &op == self->op )
+        );
+}
+
+ulog_queueable
+ulog_queueable_get( void )
+{
+    return ( ulog_queueable ) { .sequence = 0U };
+}
+
+ulog_queue
+ulog_queue_get( void )
+{
+    return ( ulog_queue ) { .state = &guard, .op = &op };
+}
+
+void
+ulog_queueable_compile_time_check( ulog_queueable const element )
+{
+    UNUSED( element );
+    /* Exists only to validate macro argument at compile time. */
+}
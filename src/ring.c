@@ -0,0 +1,898 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Implements ring of records shared by processes.
+ * \date        2016/05/28 11:52:40 AM
+ * \file        ring.c
+ * \version     1.0
+ *
+ *
+ **/
+
+#define _DEFAULT_SOURCE /* for kill, nanosleep, shm_open */
+
+#include <ulog/ring.h>
+#include <ulog/mutex.h> /* ulog_mutex_park_, ulog_mutex_unpark_ */
+#include <ulog/queue.h> /* ULOG_CACHE_LINE */
+#include <ulog/status.h> /* ulog_status, ulog_status_descriptive */
+#include <ulog/ulog.h> /* ulog_monotonic_time_ */
+#include <ulog/universal.h> /* THREADUNSAFE, UNUSED */
+
+#include <errno.h> /* EALREADY, EBUSY, EINVAL, EIO, ENOBUFS, etc. */
+#include <fcntl.h> /* O_CREAT, O_RDWR */
+#include <pthread.h> /* pthread_create, pthread_join, pthread_t */
+#include <signal.h> /* kill */
+#include <stdbool.h> /* bool */
+#include <stddef.h> /* NULL, size_t */
+#include <stdint.h> /* UINT64_MAX, int32_t, uint8_t, uint32_t, uint64_t */
+#include <stdio.h> /* vsnprintf */
+#include <stdlib.h> /* free, malloc */
+#include <sys/mman.h> /* mmap, munmap, shm_open */
+#include <sys/stat.h> /* fstat, struct stat */
+#include <time.h> /* nanosleep, struct timespec */
+#include <unistd.h> /* close, ftruncate, getpid */
+
+/* collector sleeps between these bounds while a record isn't committed */
+#define IDLE_MINIMUM_NANOSECONDS 1000L
+#define IDLE_MAXIMUM_NANOSECONDS 1000000L
+/* magic of ring being filled in by the process which created it */
+#define RING_FILLING 0x524e4721U
+#define RING_MAGIC 0x52494e47U
+/* how long to wait for other process to fill ring in, in milliseconds */
+#define RING_WAIT 1000U
+/* sequence of slot abandoned by collector, its producer may still write */
+#define SLOT_POISONED ( UINT64_C( 1 ) << 63U )
+/* added to the above by the producer once it's done with the slot */
+#define SLOT_RELEASED ( UINT64_C( 1 ) << 62U )
+
+typedef struct
+{
+    /*
+     * position of the slot when free, plus one when committed; poisoned
+     * slot is skipped by producers and collector until it's released
+     */
+    uint64_t sequence;
+    uint32_t level;
+    uint32_t length;
+    char text[ ULOG_RECORD_SIZE ];
+}
+slot;
+
+/*
+ * Lives in shared memory; producers and collector write apart. Collector
+ * parks on sleeping when the ring is empty, and producers of any process
+ * wake it only if it's set.
+ */
+typedef struct
+{
+    uint32_t magic;
+    /* process collecting from the ring, zero if none */
+    int32_t collector;
+    uint64_t capacity;
+    uint8_t separator_producers[ ULOG_CACHE_LINE ];
+    uint64_t head;
+    uint64_t written;
+    uint64_t dropped;
+    uint8_t separator_collector[ ULOG_CACHE_LINE ];
+    uint64_t tail;
+    uint64_t collected;
+    uint64_t abandoned;
+    uint8_t separator_parking[ ULOG_CACHE_LINE ];
+    uint32_t sleeping;
+    uint8_t separator_end[ ULOG_CACHE_LINE ];
+    slot slots[];
+}
+ring_header;
+
+struct ulog_ring_state_struct
+{
+    ulog_ring_op_table const * op;
+    ring_header * ring;
+    size_t size;
+    uint64_t mask;
+    uint64_t timeout;
+    ulog_async_sink_fn sink;
+    void * userdata;
+    bool collect;
+    pthread_t collector;
+    bool stop;
+    /* when collector began waiting for uncommitted record, zero if not */
+    uint64_t waiting;
+};
+
+static inline bool
+valid( ulog_ring const * const self );
+
+static inline ulog_status
+generic_invalid( ulog_ring const * const self )
+{
+    UNUSED( self );
+    return ulog_status_descriptive( EINVAL, "invalid ring object" );
+}
+
+static inline ulog_status
+generic_uninitialized( ulog_ring const * const self )
+{
+    UNUSED( self );
+    return ulog_status_descriptive( EINVAL, "ring object uninitialized" );
+}
+
+static inline ulog_status
+setup_already(
+    ulog_ring * const self,
+    ulog_ring_config const * const config,
+    ulog_async_sink_fn const sink,
+    void * const userdata
+)
+{
+    UNUSED( self );
+    UNUSED( config );
+    UNUSED( sink );
+    UNUSED( userdata );
+    return ulog_status_descriptive( EALREADY, "ring already set up" );
+}
+
+static inline ulog_status
+cleanup_already( ulog_ring * const self )
+{
+    UNUSED( self );
+    return ulog_status_descriptive( EALREADY, "ring already cleaned up" );
+}
+
+static inline ulog_status
+reserve_uninitialized(
+    ulog_ring const * const self,
+    ulog_ring_reservation * const reservation
+)
+{
+    UNUSED( reservation );
+    return generic_uninitialized( self );
+}
+
+static inline ulog_status
+commit_uninitialized(
+    ulog_ring const * const self,
+    ulog_ring_reservation const * const reservation,
+    ulog_level const level,
+    size_t const length
+)
+{
+    UNUSED( reservation );
+    UNUSED( level );
+    UNUSED( length );
+    return generic_uninitialized( self );
+}
+
+static inline ulog_status
+submit_uninitialized(
+    ulog_ring const * const self,
+    ulog_level const level,
+    char const * const format,
+    va_list args
+)
+{
+    UNUSED( level );
+    UNUSED( format );
+    UNUSED( args );
+    return generic_uninitialized( self );
+}
+
+static inline ulog_status
+counters_uninitialized(
+    ulog_ring const * const self,
+    ulog_ring_counters * const counters
+)
+{
+    UNUSED( counters );
+    return generic_uninitialized( self );
+}
+
+static inline ulog_status
+reset_uninitialized( ulog_ring * const self )
+{
+    return generic_uninitialized( self );
+}
+
+static THREADUNSAFE ulog_status
+setup_safe(
+    ulog_ring * const self,
+    ulog_ring_config const * const config,
+    ulog_async_sink_fn const sink,
+    void * const userdata
+);
+static THREADUNSAFE ulog_status
+cleanup_safe( ulog_ring * const self );
+static ulog_status
+reserve_safe(
+    ulog_ring const * const self,
+    ulog_ring_reservation * const reservation
+);
+static ulog_status
+commit_safe(
+    ulog_ring const * const self,
+    ulog_ring_reservation const * const reservation,
+    ulog_level const level,
+    size_t const length
+);
+static ulog_status
+submit_safe(
+    ulog_ring const * const self,
+    ulog_level const level,
+    char const * const format,
+    va_list args
+);
+static ulog_status
+counters_safe(
+    ulog_ring const * const self,
+    ulog_ring_counters * const counters
+);
+static THREADUNSAFE ulog_status
+reset_safe( ulog_ring * const self );
+
+static ulog_ring_op_table const default_op =
+{
+    .setup = setup_safe,
+    .cleanup = cleanup_already,
+    .reserve = reserve_uninitialized,
+    .commit = commit_uninitialized,
+    .submit = submit_uninitialized,
+    .counters = counters_uninitialized,
+    .reset = reset_uninitialized
+};
+static ulog_ring_op_table const setup_op =
+{
+    .setup = setup_already,
+    .cleanup = cleanup_safe,
+    .reserve = reserve_safe,
+    .commit = commit_safe,
+    .submit = submit_safe,
+    .counters = counters_safe,
+    .reset = reset_safe
+};
+
+static ulog_ring_state guard = { .op = &default_op };
+
+static void
+idle( long * const nanoseconds )
+{
+    struct timespec const pause = { .tv_sec = 0, .tv_nsec = *nanoseconds };
+    UNUSED( nanosleep( &pause, NULL ));
+    *nanoseconds *= 2L;
+    if( IDLE_MAXIMUM_NANOSECONDS < *nanoseconds )
+    {
+        *nanoseconds = IDLE_MAXIMUM_NANOSECONDS;
+    }
+}
+
+/* called after committing a record, or setting stop */
+static void
+wake_collector( ring_header * const ring )
+{
+    __atomic_thread_fence( __ATOMIC_SEQ_CST );
+    if(
+        ( 0U != __atomic_load_n( &( ring->sleeping ), __ATOMIC_RELAXED ))
+        && ( 0U
+            != __atomic_exchange_n( &( ring->sleeping ), 0U, __ATOMIC_RELAXED ))
+    )
+    {
+        /* futex is shared by processes, as is the ring */
+        ulog_mutex_unpark_( &( ring->sleeping ), 1, true );
+    }
+}
+
+/*
+ * Passes record at tail to sink, or skips it if its producer didn't commit
+ * it in time. Returns false if there's nothing to do now.
+ */
+static bool
+collect_one( ulog_ring_state * const state )
+{
+    ring_header * const ring = state->ring;
+    uint64_t const tail = __atomic_load_n( &( ring->tail ), __ATOMIC_RELAXED );
+    slot * const item = &( ring->slots[ tail & state->mask ]);
+    uint64_t sequence =
+        __atomic_load_n( &( item->sequence ), __ATOMIC_ACQUIRE );
+    if( tail + 1U == sequence )
+    {
+        size_t const length =
+            ( ULOG_RECORD_SIZE <= item->length )
+                ? ULOG_RECORD_SIZE - 1U
+                : item->length;
+        item->text[ length ] = '\0';
+        state->sink(
+            state->userdata,
+            ( ulog_level ) item->level,
+            item->text,
+            length
+        );
+        __atomic_add_fetch( &( ring->collected ), 1U, __ATOMIC_RELAXED );
+        __atomic_store_n(
+            &( item->sequence ),
+            tail + state->mask + 1U,
+            __ATOMIC_RELEASE
+        );
+    }
+    else if( __atomic_load_n( &( ring->head ), __ATOMIC_ACQUIRE ) <= tail )
+    {
+        return false;
+    }
+    else if( tail < sequence )
+    {
+        /* producers skipped the slot in this lap, it's poisoned or was */
+    }
+    else
+    {
+        /* reserved, but not committed yet: producer is slow or dead */
+        uint64_t const now = ulog_monotonic_time_();
+        if( 0U == state->waiting )
+        {
+            state->waiting = now;
+            return false;
+        }
+        if( state->timeout > now - state->waiting ) { return false; }
+        /* the producer may still write, so the slot isn't reused until */
+        if(
+            !__atomic_compare_exchange_n(
+                &( item->sequence ),
+                &sequence,
+                SLOT_POISONED | tail,
+                false,
+                __ATOMIC_ACQ_REL,
+                __ATOMIC_ACQUIRE
+            )
+        )
+        {
+            /* committed meanwhile, so it's collected next time */
+            return true;
+        }
+        __atomic_add_fetch( &( ring->abandoned ), 1U, __ATOMIC_RELAXED );
+    }
+    state->waiting = 0U;
+    __atomic_store_n( &( ring->tail ), tail + 1U, __ATOMIC_RELEASE );
+    return true;
+}
+
+static void *
+collect( void * const arg )
+{
+    ulog_ring_state * const state = arg;
+    ring_header * const ring = state->ring;
+    long pause = IDLE_MINIMUM_NANOSECONDS;
+    for( ;; )
+    {
+        if( collect_one( state ))
+        {
+            pause = IDLE_MINIMUM_NANOSECONDS;
+            continue;
+        }
+        if( __atomic_load_n( &( state->stop ), __ATOMIC_ACQUIRE )) { break; }
+        /* record reserved, but not committed, is waited for with timeout */
+        if( 0U != state->waiting )
+        {
+            idle( &pause );
+            continue;
+        }
+        /* announced before looking at the ring again, so that producers
+         * which commit a record meanwhile see it and wake the collector */
+        __atomic_store_n( &( ring->sleeping ), 1U, __ATOMIC_RELAXED );
+        __atomic_thread_fence( __ATOMIC_SEQ_CST );
+        if(
+            ( __atomic_load_n( &( ring->head ), __ATOMIC_RELAXED )
+                <= __atomic_load_n( &( ring->tail ), __ATOMIC_RELAXED ))
+            && !__atomic_load_n( &( state->stop ), __ATOMIC_ACQUIRE )
+        )
+        {
+            ulog_mutex_park_(
+                &( ring->sleeping ),
+                1U,
+                UINT64_MAX,
+                true
+            );
+        }
+        __atomic_store_n( &( ring->sleeping ), 0U, __ATOMIC_RELAXED );
+    }
+    return NULL;
+}
+
+static uint64_t
+round_capacity( size_t const capacity )
+{
+    uint64_t result = 1U;
+    while( result < capacity ) { result <<= 1U; }
+    return result;
+}
+
+/* the first process to map new ring fills it in, others wait for it */
+static ulog_status
+fill_ring( ring_header * const ring, uint64_t const capacity )
+{
+    uint32_t magic = 0U;
+    if(
+        __atomic_compare_exchange_n(
+            &( ring->magic ),
+            &magic,
+            RING_FILLING,
+            false,
+            __ATOMIC_ACQUIRE,
+            __ATOMIC_ACQUIRE
+        )
+    )
+    {
+        ring->capacity = capacity;
+        for( uint64_t i = 0U; i < capacity; ++i )
+        {
+            ring->slots[ i ].sequence = i;
+        }
+        __atomic_store_n( &( ring->magic ), RING_MAGIC, __ATOMIC_RELEASE );
+        return ulog_status_descriptive( 0, "ring created" );
+    }
+    struct timespec const pause = { .tv_sec = 0, .tv_nsec = 1000000L };
+    for( unsigned i = 0U; ( RING_FILLING == magic ) && ( RING_WAIT > i ); ++i )
+    {
+        UNUSED( nanosleep( &pause, NULL ));
+        magic = __atomic_load_n( &( ring->magic ), __ATOMIC_ACQUIRE );
+    }
+    if(( RING_MAGIC != magic ) || ( capacity != ring->capacity ))
+    {
+        return ulog_status_descriptive( EIO, "not a ring of this capacity" );
+    }
+    return ulog_status_descriptive( 0, "ring found" );
+}
+
+static ulog_status
+map_ring( ulog_ring_state * const state, char const * const name )
+{
+    int const file = shm_open( name, O_RDWR | O_CREAT, 0600 );
+    if( -1 == file )
+    {
+        return ulog_status_descriptive( EIO, "cannot open ring" );
+    }
+    /* racing creators both extend it to the same size */
+    struct stat status;
+    bool const sized =
+        ( 0 == fstat( file, &status ))
+        && (
+            (( off_t ) state->size == status.st_size )
+            || (
+                ( 0 == status.st_size )
+                && ( 0 == ftruncate( file, ( off_t ) state->size ))
+            )
+        );
+    void * const mapped =
+        sized
+            ? mmap(
+                NULL,
+                state->size,
+                PROT_READ | PROT_WRITE,
+                MAP_SHARED,
+                file,
+                0
+            )
+            : MAP_FAILED;
+    close( file );
+    if( MAP_FAILED == mapped )
+    {
+        return ulog_status_descriptive( EIO, "cannot map ring" );
+    }
+    state->ring = mapped;
+    ulog_status const filled = fill_ring( state->ring, state->mask + 1U );
+    if( !ulog_status_success( filled ))
+    {
+        munmap( mapped, state->size );
+    }
+    return filled;
+}
+
+/* collector which died is replaced */
+static bool
+claim_collector( ring_header * const ring )
+{
+    int32_t const self = ( int32_t ) getpid();
+    int32_t current = __atomic_load_n( &( ring->collector ), __ATOMIC_ACQUIRE );
+    for( ;; )
+    {
+        if(
+            ( 0 != current )
+            && (( 0 == kill(( pid_t ) current, 0 )) || ( EPERM == errno ))
+        )
+        {
+            return false;
+        }
+        if(
+            __atomic_compare_exchange_n(
+                &( ring->collector ),
+                &current,
+                self,
+                false,
+                __ATOMIC_ACQ_REL,
+                __ATOMIC_ACQUIRE
+            )
+        )
+        {
+            return true;
+        }
+    }
+}
+
+static THREADUNSAFE ulog_status
+setup_safe(
+    ulog_ring * const self,
+    ulog_ring_config const * const config,
+    ulog_async_sink_fn const sink,
+    void * const userdata
+)
+{
+    if(
+        ( NULL == config ) || ( NULL == config->name )
+        || ( 0U == config->capacity )
+        || (( SIZE_MAX - sizeof( ring_header )) / sizeof( slot )
+            < round_capacity( config->capacity ))
+        || ( config->collect && ( NULL == sink ))
+    )
+    {
+        return ulog_status_descriptive( EINVAL, "invalid ring configuration" );
+    }
+    ulog_ring_state * const state = malloc( sizeof( ulog_ring_state ));
+    if( NULL == state )
+    {
+        return ulog_status_descriptive(
+            ENOMEM,
+            "cannot allocate memory for ring state"
+        );
+    }
+    uint64_t const capacity = round_capacity( config->capacity );
+    *state = ( ulog_ring_state )
+    {
+        .op = &setup_op,
+        .size = sizeof( ring_header ) + ( size_t ) capacity * sizeof( slot ),
+        .mask = capacity - 1U,
+        .timeout =
+            ( 0U == config->timeout ) ? ULOG_RING_TIMEOUT : config->timeout,
+        .sink = sink,
+        .userdata = userdata,
+        .collect = config->collect
+    };
+    ulog_status const mapped = map_ring( state, config->name );
+    if( !ulog_status_success( mapped ))
+    {
+        free( state );
+        return mapped;
+    }
+    if( state->collect )
+    {
+        ulog_status result =
+            ulog_status_descriptive( 0, "ring set up successfully" );
+        if( !claim_collector( state->ring ))
+        {
+            result =
+                ulog_status_descriptive( EBUSY, "ring has other collector" );
+        }
+        else if(
+            0 != pthread_create( &( state->collector ), NULL, collect, state )
+        )
+        {
+            __atomic_store_n(
+                &( state->ring->collector ),
+                0,
+                __ATOMIC_RELEASE
+            );
+            result =
+                ulog_status_descriptive( EIO, "cannot start ring collector" );
+        }
+        if( !ulog_status_success( result ))
+        {
+            munmap( state->ring, state->size );
+            free( state );
+            return result;
+        }
+    }
+    self->state = state;
+    return ulog_status_descriptive( 0, "ring set up successfully" );
+}
+
+static THREADUNSAFE ulog_status
+cleanup_safe( ulog_ring * const self )
+{
+    ulog_ring_state * const state = self->state;
+    if( state->collect )
+    {
+        __atomic_store_n( &( state->stop ), true, __ATOMIC_RELEASE );
+        wake_collector( state->ring );
+        UNUSED( pthread_join( state->collector, NULL ));
+        __atomic_store_n( &( state->ring->collector ), 0, __ATOMIC_RELEASE );
+    }
+    munmap( state->ring, state->size );
+    free( state );
+    self->state = &guard;
+    return ulog_status_descriptive( 0, "ring cleaned up successfully" );
+}
+
+/* collector thread of the parent doesn't exist here, the parent collects */
+static THREADUNSAFE ulog_status
+reset_safe( ulog_ring * const self )
+{
+    ulog_ring_state * const state = self->state;
+    state->collect = false;
+    state->stop = false;
+    state->waiting = 0U;
+    return ulog_status_descriptive( 0, "ring produced into" );
+}
+
+static ulog_status
+reserve_safe(
+    ulog_ring const * const self,
+    ulog_ring_reservation * const reservation
+)
+{
+    if( NULL == reservation )
+    {
+        return ulog_status_descriptive( ENODATA, "invalid reservation" );
+    }
+    ulog_ring_state * const state = self->state;
+    ring_header * const ring = state->ring;
+    uint64_t position = __atomic_load_n( &( ring->head ), __ATOMIC_RELAXED );
+    for( ;; )
+    {
+        slot * const item = &( ring->slots[ position & state->mask ]);
+        uint64_t const sequence =
+            __atomic_load_n( &( item->sequence ), __ATOMIC_ACQUIRE );
+        if( sequence == position )
+        {
+            if(
+                __atomic_compare_exchange_n(
+                    &( ring->head ),
+                    &position,
+                    position + 1U,
+                    true,
+                    __ATOMIC_RELAXED,
+                    __ATOMIC_RELAXED
+                )
+            )
+            {
+                *reservation = ( ulog_ring_reservation )
+                {
+                    .position = position,
+                    .text = item->text,
+                    .size = sizeof( item->text )
+                };
+                return ulog_status_descriptive( 0, "slot reserved" );
+            }
+        }
+        else if( 0U != ( SLOT_POISONED & sequence ))
+        {
+            /* skip the slot in this lap, the one who does owns it now */
+            if(
+                __atomic_compare_exchange_n(
+                    &( ring->head ),
+                    &position,
+                    position + 1U,
+                    true,
+                    __ATOMIC_ACQUIRE,
+                    __ATOMIC_RELAXED
+                )
+                && ( 0U != ( SLOT_RELEASED & sequence ))
+            )
+            {
+                /* producer is done with it, so it's free in the next lap */
+                __atomic_store_n(
+                    &( item->sequence ),
+                    position + state->mask + 1U,
+                    __ATOMIC_RELEASE
+                );
+            }
+            position = __atomic_load_n( &( ring->head ), __ATOMIC_RELAXED );
+        }
+        else if( sequence < position )
+        {
+            /* slot still holds record of previous lap */
+            __atomic_add_fetch( &( ring->dropped ), 1U, __ATOMIC_RELAXED );
+            return ulog_status_descriptive( ENOBUFS, "record dropped" );
+        }
+        else
+        {
+            position = __atomic_load_n( &( ring->head ), __ATOMIC_RELAXED );
+        }
+    }
+}
+
+static ulog_status
+commit_safe(
+    ulog_ring const * const self,
+    ulog_ring_reservation const * const reservation,
+    ulog_level const level,
+    size_t const length
+)
+{
+    ulog_ring_state * const state = self->state;
+    ring_header * const ring = state->ring;
+    slot * const item =
+        ( NULL == reservation )
+            ? NULL
+            : &( ring->slots[ reservation->position & state->mask ]);
+    if(( NULL == item ) || ( item->text != reservation->text ))
+    {
+        return ulog_status_descriptive( ENODATA, "invalid reservation" );
+    }
+    item->level = ( uint32_t ) level;
+    item->length =
+        ( uint32_t ) (( sizeof( item->text ) <= length )
+            ? sizeof( item->text ) - 1U
+            : length );
+    uint64_t expected = reservation->position;
+    if(
+        !__atomic_compare_exchange_n(
+            &( item->sequence ),
+            &expected,
+            reservation->position + 1U,
+            false,
+            __ATOMIC_RELEASE,
+            __ATOMIC_RELAXED
+        )
+    )
+    {
+        if(( SLOT_POISONED | reservation->position ) != expected )
+        {
+            return ulog_status_descriptive( ENODATA, "invalid reservation" );
+        }
+        /* the slot is skipped until released, its next lap gets it then */
+        __atomic_store_n(
+            &( item->sequence ),
+            SLOT_RELEASED | expected,
+            __ATOMIC_RELEASE
+        );
+        return ulog_status_descriptive( ETIMEDOUT, "slot taken by collector" );
+    }
+    __atomic_add_fetch( &( ring->written ), 1U, __ATOMIC_RELAXED );
+    wake_collector( ring );
+    return ulog_status_descriptive( 0, "record committed" );
+}
+
+static ulog_status
+submit_safe(
+    ulog_ring const * const self,
+    ulog_level const level,
+    char const * const format,
+    va_list args
+)
+{
+    ulog_ring_reservation reservation;
+    ulog_status const reserved = reserve_safe( self, &reservation );
+    if( !ulog_status_success( reserved )) { return reserved; }
+    int const length =
+        vsnprintf( reservation.text, reservation.size, format, args );
+    if( 0 > length ) { reservation.text[ 0 ] = '\0'; }
+    return
+        commit_safe(
+            self,
+            &reservation,
+            level,
+            ( 0 > length ) ? 0U : ( size_t ) length
+        );
+}
+
+static ulog_status
+counters_safe(
+    ulog_ring const * const self,
+    ulog_ring_counters * const counters
+)
+{
+    if( NULL == counters )
+    {
+        return ulog_status_descriptive( ENODATA, "invalid counters pointer" );
+    }
+    ring_header * const ring = self->state->ring;
+    *counters = ( ulog_ring_counters )
+    {
+        .written = __atomic_load_n( &( ring->written ), __ATOMIC_RELAXED ),
+        .dropped = __atomic_load_n( &( ring->dropped ), __ATOMIC_RELAXED ),
+        .collected =
+            __atomic_load_n( &( ring->collected ), __ATOMIC_RELAXED ),
+        .abandoned =
+            __atomic_load_n( &( ring->abandoned ), __ATOMIC_RELAXED )
+    };
+    return ulog_status_descriptive( 0, "ring counters read" );
+}
+
+static inline THREADUNSAFE ulog_status
+setup(
+    ulog_ring * const self,
+    ulog_ring_config const * const config,
+    ulog_async_sink_fn const sink,
+    void * const userdata
+)
+{
+    if( !valid( self )) { return generic_invalid( self ); }
+    return self->state->op->setup( self, config, sink, userdata );
+}
+
+static inline THREADUNSAFE ulog_status
+cleanup( ulog_ring * const self )
+{
+    if( !valid( self )) { return generic_invalid( self ); }
+    return self->state->op->cleanup( self );
+}
+
+static inline ulog_status
+reserve(
+    ulog_ring const * const self,
+    ulog_ring_reservation * const reservation
+)
+{
+    if( !valid( self )) { return generic_invalid( self ); }
+    return self->state->op->reserve( self, reservation );
+}
+
+static inline ulog_status
+commit(
+    ulog_ring const * const self,
+    ulog_ring_reservation const * const reservation,
+    ulog_level const level,
+    size_t const length
+)
+{
+    if( !valid( self )) { return generic_invalid( self ); }
+    return self->state->op->commit( self, reservation, level, length );
+}
+
+static inline ulog_status
+submit(
+    ulog_ring const * const self,
+    ulog_level const level,
+    char const * const format,
+    va_list args
+)
+{
+    if( !valid( self )) { return generic_invalid( self ); }
+    return self->state->op->submit( self, level, format, args );
+}
+
+static inline ulog_status
+counters_(
+    ulog_ring const * const self,
+    ulog_ring_counters * const counters
+)
+{
+    if( !valid( self )) { return generic_invalid( self ); }
+    return self->state->op->counters( self, counters );
+}
+
+static inline THREADUNSAFE ulog_status
+reset( ulog_ring * const self )
+{
+    if( !valid( self )) { return generic_invalid( self ); }
+    return self->state->op->reset( self );
+}
+
+static ulog_ring_op_table const op =
+{
+    .setup = setup,
+    .cleanup = cleanup,
+    .reserve = reserve,
+    .commit = commit,
+    .submit = submit,
+    .counters = counters_,
+    .reset = reset
+};
+
+static inline bool
+valid( ulog_ring const * const self )
+{
+    return
+        (
+            ( NULL != self )
+            && ( NULL != self->state )
+            && (
+                (( &guard == self->state ) && ( &default_op == guard.op ))
+                || (
+                    ( &guard != self->state )
+                    && ( &setup_op == self->state->op )
+                )
+            )
+            && ( &op == self->op )
+        );
+}
+
+ulog_ring
+ulog_ring_get( void )
+{
+    return ( ulog_ring ) { .state = &guard, .op = &op };
+}
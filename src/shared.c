@@ -0,0 +1,292 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Implements control of logging shared by processes.
+ * \date        2016/05/24 19:40:07 PM
+ * \file        shared.c
+ * \version     1.0
+ *
+ *
+ **/
+
+#define _POSIX_C_SOURCE 200809L /* for nanosleep, shm_open */
+
+#include <ulog/shared.h>
+
+#include <errno.h> /* EIO, ENODATA */
+#include <fcntl.h> /* O_CREAT, O_RDWR */
+#include <limits.h> /* NAME_MAX */
+#include <stdint.h> /* uint32_t */
+#include <string.h> /* strchr, strlen, strrchr */
+#include <sys/mman.h> /* mmap, munmap, shm_open, shm_unlink */
+#include <sys/stat.h> /* fstat, struct stat */
+#include <time.h> /* nanosleep */
+#include <unistd.h> /* close, ftruncate */
+
+/* magic of page being filled in by the process which created it */
+#define SHARED_FILLING 0x554c4f47U
+/* how long to wait for other process to fill page in, in milliseconds */
+#define SHARED_WAIT 1000U
+
+static bool
+valid_name( char const * const name )
+{
+    return
+        ( NULL != name )
+        && ( '/' == name[ 0 ] )
+        && ( NULL == strchr( name + 1, '/' ))
+        && ( 1U < strlen( name ))
+        && ( NAME_MAX > strlen( name ));
+}
+
+static ulog_status
+open_page( char const * const name, int * const file )
+{
+    if( !valid_name( name ))
+    {
+        return ulog_status_descriptive( ENODATA, "invalid shared page name" );
+    }
+    *file = shm_open( name, O_RDWR | O_CREAT, 0600 );
+    if( -1 == *file )
+    {
+        return ulog_status_descriptive( EIO, "cannot open shared page" );
+    }
+    /* racing creators both extend it to the same size */
+    struct stat status;
+    if(
+        ( 0 != fstat( *file, &status ))
+        || (
+            ( ULOG_SHARED_SIZE > ( unsigned long ) status.st_size )
+            && ( 0 != ftruncate( *file, ( off_t ) ULOG_SHARED_SIZE ))
+        )
+    )
+    {
+        close( *file );
+        return ulog_status_descriptive( EIO, "cannot size shared page" );
+    }
+    return ulog_status_descriptive( 0, "shared page opened" );
+}
+
+/* the first process to map new page fills it in, others wait for it */
+static ulog_status
+fill_page( ulog_fast_state * const page, ulog_level const verbosity )
+{
+    unsigned magic = 0U;
+    if(
+        __atomic_compare_exchange_n(
+            &( page->magic ),
+            &magic,
+            SHARED_FILLING,
+            false,
+            __ATOMIC_ACQUIRE,
+            __ATOMIC_ACQUIRE
+        )
+    )
+    {
+        __atomic_store_n(
+            &( page->threshold ),
+            ( int ) verbosity,
+            __ATOMIC_RELAXED
+        );
+        __atomic_store_n( &( page->generation ), 1U, __ATOMIC_RELAXED );
+        __atomic_store_n(
+            &( page->magic ),
+            ULOG_SHARED_MAGIC,
+            __ATOMIC_RELEASE
+        );
+        return ulog_status_descriptive( 0, "shared page created" );
+    }
+    struct timespec const pause = { .tv_sec = 0, .tv_nsec = 1000000L };
+    for(
+        unsigned i = 0U;
+        ( SHARED_FILLING == magic ) && ( SHARED_WAIT > i );
+        ++i
+    )
+    {
+        ( void ) nanosleep( &pause, NULL );
+        magic = __atomic_load_n( &( page->magic ), __ATOMIC_ACQUIRE );
+    }
+    if( ULOG_SHARED_MAGIC != magic )
+    {
+        return ulog_status_descriptive( EIO, "not a ulog shared page" );
+    }
+    return ulog_status_descriptive( 0, "shared page found" );
+}
+
+static ulog_status
+map_page(
+    char const * const name,
+    ulog_level const verbosity,
+    int * const file,
+    ulog_fast_state ** const page
+)
+{
+    ulog_status const opened = open_page( name, file );
+    if( !ulog_status_success( opened )) { return opened; }
+    void * const mapped =
+        mmap(
+            NULL,
+            ULOG_SHARED_SIZE,
+            PROT_READ | PROT_WRITE,
+            MAP_SHARED,
+            *file,
+            0
+        );
+    if( MAP_FAILED == mapped )
+    {
+        close( *file );
+        return ulog_status_descriptive( EIO, "cannot map shared page" );
+    }
+    *page = mapped;
+    ulog_status const filled = fill_page( *page, verbosity );
+    if( !ulog_status_success( filled ))
+    {
+        munmap( mapped, ULOG_SHARED_SIZE );
+        close( *file );
+    }
+    return filled;
+}
+
+ulog_status
+ulog_shared_open( char const * const name, ulog_fast_state ** const page )
+{
+    if( NULL == page )
+    {
+        return ulog_status_descriptive( ENODATA, "invalid page pointer" );
+    }
+    int file = -1;
+    ulog_status const mapped = map_page( name, DEBUG, &file, page );
+    if( ulog_status_success( mapped )) { close( file ); }
+    return mapped;
+}
+
+void
+ulog_shared_close( ulog_fast_state * const page )
+{
+    if( NULL != page ) { munmap( page, ULOG_SHARED_SIZE ); }
+}
+
+ulog_status
+ulog_shared_remove( char const * const name )
+{
+    if( !valid_name( name ))
+    {
+        return ulog_status_descriptive( ENODATA, "invalid shared page name" );
+    }
+    if( 0 != shm_unlink( name ))
+    {
+        return ulog_status_descriptive( EIO, "cannot remove shared page" );
+    }
+    return ulog_status_descriptive( 0, "shared page removed" );
+}
+
+ulog_status
+ulog_shared_verbosity(
+    ulog_fast_state * const page,
+    ulog_level const verbosity
+)
+{
+    switch( verbosity )
+    {
+        case ERROR: break;
+        case WARNING: break;
+        case INFO: break;
+        case DEBUG: break;
+        default:
+            return ulog_status_descriptive( ENODATA, "invalid verbosity" );
+    }
+    __atomic_store_n(
+        &( page->threshold ),
+        ( int ) verbosity,
+        __ATOMIC_RELEASE
+    );
+    return ulog_status_descriptive( 0, "shared verbosity set" );
+}
+
+/* FNV-1a of file name without directories and of line */
+size_t
+ulog_shared_bit( char const * const file, unsigned const line )
+{
+    char const * const slash = strrchr( file, '/' );
+    uint32_t hash = 2166136261U;
+    for(
+        char const * c = ( NULL == slash ) ? file : slash + 1;
+        '\0' != *c;
+        ++c
+    )
+    {
+        hash = ( hash ^ ( unsigned char ) *c ) * 16777619U;
+    }
+    for( unsigned i = 0U; i < 4U; ++i )
+    {
+        hash = ( hash ^ (( line >> ( 8U * i )) & 0xffU )) * 16777619U;
+    }
+    return ( size_t ) ( hash % ULOG_SHARED_BITS );
+}
+
+bool
+ulog_shared_enabled(
+    ulog_fast_state const * const page,
+    char const * const file,
+    unsigned const line
+)
+{
+    size_t const bit = ulog_shared_bit( file, line );
+    unsigned char const byte =
+        __atomic_load_n( &( page->enabled[ bit / 8U ] ), __ATOMIC_RELAXED );
+    return 0U != ( byte & ( 1U << ( bit % 8U )));
+}
+
+void
+ulog_shared_enable(
+    ulog_fast_state * const page,
+    char const * const file,
+    unsigned const line,
+    bool const enabled
+)
+{
+    size_t const bit = ulog_shared_bit( file, line );
+    unsigned char const mask = ( unsigned char ) ( 1U << ( bit % 8U ));
+    if( enabled )
+    {
+        __atomic_fetch_or(
+            &( page->enabled[ bit / 8U ] ),
+            mask,
+            __ATOMIC_RELAXED
+        );
+    }
+    else
+    {
+        __atomic_fetch_and(
+            &( page->enabled[ bit / 8U ] ),
+            ( unsigned char ) ~mask,
+            __ATOMIC_RELAXED
+        );
+    }
+    /* zero generation would mean there are no rules, so it's skipped */
+    if(
+        0U
+        == __atomic_add_fetch( &( page->generation ), 1U, __ATOMIC_RELEASE )
+    )
+    {
+        __atomic_add_fetch( &( page->generation ), 1U, __ATOMIC_RELEASE );
+    }
+}
+
+ulog_status
+ulog_shared_attach_(
+    char const * const name,
+    ulog_level const verbosity,
+    ulog_fast_state ** const page
+)
+{
+    int file = -1;
+    ulog_status const mapped = map_page( name, verbosity, &file, page );
+    if( ulog_status_success( mapped )) { close( file ); }
+    return mapped;
+}
+
+void
+ulog_shared_detach_( ulog_fast_state * const page )
+{
+    ulog_shared_close( page );
+}
@@ -0,0 +1,196 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Implements striped counters backing ulog statistics.
+ * \date        2016/03/26 10:41:52 AM
+ * \file        stats.c
+ * \version     1.0
+ *
+ * Latency histogram is log-linear: each power of two is split into four
+ * buckets, so the relative error of a reported value is at most 25%.
+ * Latencies below eight nanoseconds get a bucket each.
+ **/
+
+#include <ulog/stats.h>
+#include <ulog/ulog.h> /* ulog_handler_stats, ulog_stats */
+#include <ulog/universal.h> /* THREADLOCAL, UNUSED */
+
+#include <stdbool.h> /* bool */
+#include <stddef.h> /* NULL, size_t */
+#include <stdint.h> /* uint64_t */
+#include <string.h> /* memset */
+
+#define LINEAR_BUCKETS 8U
+#define SUB_BUCKETS_BITS 2U
+#define SUB_BUCKETS ( 1U << SUB_BUCKETS_BITS )
+/* index of the lowest power of two split into sub-buckets */
+#define FIRST_SPLIT 3U
+
+static THREADLOCAL unsigned stripe_index;
+static THREADLOCAL bool stripe_assigned;
+static unsigned stripe_next;
+
+unsigned
+ulog_stats_stripe_index( void )
+{
+    if( !stripe_assigned )
+    {
+        stripe_index =
+            __atomic_fetch_add( &stripe_next, 1U, __ATOMIC_RELAXED )
+            % ULOG_STATS_STRIPES;
+        stripe_assigned = true;
+    }
+    return stripe_index;
+}
+
+size_t
+ulog_stats_bucket( uint64_t const latency )
+{
+    if( LINEAR_BUCKETS > latency ) { return ( size_t ) latency; }
+    unsigned const exponent = 63U - ( unsigned ) __builtin_clzll( latency );
+    size_t const sub =
+        ( size_t ) (( latency >> ( exponent - SUB_BUCKETS_BITS ))
+            & ( SUB_BUCKETS - 1U ));
+    size_t const result =
+        LINEAR_BUCKETS + ( exponent - FIRST_SPLIT ) * SUB_BUCKETS + sub;
+    return
+        ( ULOG_STATS_BUCKETS > result ) ? result : ( ULOG_STATS_BUCKETS - 1U );
+}
+
+uint64_t
+ulog_stats_bucket_start( size_t const index )
+{
+    if( LINEAR_BUCKETS > index ) { return ( uint64_t ) index; }
+    size_t const exponent =
+        FIRST_SPLIT + ( index - LINEAR_BUCKETS ) / SUB_BUCKETS;
+    uint64_t const sub = ( index - LINEAR_BUCKETS ) % SUB_BUCKETS;
+    return ( SUB_BUCKETS + sub ) << ( exponent - SUB_BUCKETS_BITS );
+}
+
+uint64_t
+ulog_stats_percentile(
+    ulog_handler_stats const * const stats,
+    double const fraction
+)
+{
+    if(( NULL == stats ) || ( 0U == stats->calls )) { return 0U; }
+    uint64_t const rank = ( uint64_t ) ( fraction * ( double ) stats->calls );
+    uint64_t seen = 0U;
+    for( size_t i = 0U; i < ULOG_STATS_BUCKETS; ++i )
+    {
+        seen += stats->latency[ i ];
+        if( seen > rank ) { return ulog_stats_bucket_start( i ); }
+    }
+    return ulog_stats_bucket_start( ULOG_STATS_BUCKETS - 1U );
+}
+
+void
+ulog_stats_messages_reset( ulog_stats_messages * const counters )
+{
+    memset( counters, 0, sizeof( ulog_stats_messages ));
+}
+
+void
+ulog_stats_handler_reset( ulog_stats_handler * const counters )
+{
+    memset( counters, 0, sizeof( ulog_stats_handler ));
+}
+
+/* threads may share a stripe, hence atomic, but relaxed is enough */
+static inline void
+increment( uint64_t * const counter, uint64_t const value )
+{
+    UNUSED( __atomic_fetch_add( counter, value, __ATOMIC_RELAXED ));
+}
+
+static inline uint64_t
+load( uint64_t const * const counter )
+{
+    return __atomic_load_n( counter, __ATOMIC_RELAXED );
+}
+
+void
+ulog_stats_count_message(
+    ulog_stats_messages * const counters,
+    ulog_level const level
+)
+{
+    if( ULOG_LEVELS <= ( unsigned ) level ) { return; }
+    increment(
+        &( counters->stripe[ ulog_stats_stripe_index() ].messages[ level ] ),
+        1U
+    );
+}
+
+void
+ulog_stats_count_suppressed( ulog_stats_messages * const counters )
+{
+    increment(
+        &( counters->stripe[ ulog_stats_stripe_index() ].suppressed ),
+        1U
+    );
+}
+
+void
+ulog_stats_count_bytes(
+    ulog_stats_messages * const counters,
+    uint64_t const bytes
+)
+{
+    increment(
+        &( counters->stripe[ ulog_stats_stripe_index() ].bytes ),
+        bytes
+    );
+}
+
+void
+ulog_stats_count_call(
+    ulog_stats_handler * const counters,
+    uint64_t const latency
+)
+{
+    ulog_stats_handler_stripe * const stripe =
+        &( counters->stripe[ ulog_stats_stripe_index() ] );
+    increment( &( stripe->calls ), 1U );
+    increment( &( stripe->latency[ ulog_stats_bucket( latency ) ] ), 1U );
+}
+
+void
+ulog_stats_messages_read(
+    ulog_stats_messages const * const counters,
+    ulog_stats * const result
+)
+{
+    memset( result->messages, 0, sizeof( result->messages ));
+    result->suppressed = 0U;
+    result->bytes = 0U;
+    for( unsigned i = 0U; i < ULOG_STATS_STRIPES; ++i )
+    {
+        ulog_stats_stripe const * const stripe = &( counters->stripe[ i ] );
+        for( unsigned level = 0U; level < ULOG_LEVELS; ++level )
+        {
+            result->messages[ level ] += load( &( stripe->messages[ level ] ));
+        }
+        result->suppressed += load( &( stripe->suppressed ));
+        result->bytes += load( &( stripe->bytes ));
+    }
+}
+
+void
+ulog_stats_handler_read(
+    ulog_stats_handler const * const counters,
+    ulog_handler_stats * const result
+)
+{
+    result->calls = 0U;
+    memset( result->latency, 0, sizeof( result->latency ));
+    for( unsigned i = 0U; i < ULOG_STATS_STRIPES; ++i )
+    {
+        ulog_stats_handler_stripe const * const stripe =
+            &( counters->stripe[ i ] );
+        result->calls += load( &( stripe->calls ));
+        for( size_t j = 0U; j < ULOG_STATS_BUCKETS; ++j )
+        {
+            result->latency[ j ] += load( &( stripe->latency[ j ] ));
+        }
+    }
+}
@@ -0,0 +1,378 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Implements spans and their export to Chrome Trace Event JSON.
+ * \date        2016/05/14 10:22:03 AM
+ * \file        trace.c
+ * \version     1.0
+ *
+ *
+ **/
+
+#define _POSIX_C_SOURCE 200809L /* for getline, getpid */
+
+#include <ulog/trace.h>
+#include <ulog/universal.h> /* THREADLOCAL */
+
+#include <errno.h> /* EIO, ENODATA, ENOMEM */
+#include <inttypes.h> /* PRIu64, SCNu64 */
+#include <stdbool.h> /* bool */
+#include <stddef.h> /* NULL, size_t */
+#include <stdint.h> /* uint64_t */
+#include <stdio.h> /* FILE, fprintf, fputc, getline, sscanf */
+#include <stdlib.h> /* free, realloc */
+#include <string.h> /* strcspn, strlen, strstr */
+#include <unistd.h> /* getpid */
+
+/* threads tracked by exporter at first, more are made room for as needed */
+#define THREADS_INITIAL 8U
+
+THREADLOCAL ulog_trace_state ulog_trace_;
+
+/* identifiers of threads start from one, zero means not assigned yet */
+static unsigned threads;
+
+unsigned
+ulog_trace_thread_( void )
+{
+    if( 0U == ulog_trace_.thread )
+    {
+        ulog_trace_.thread =
+            __atomic_add_fetch( &threads, 1U, __ATOMIC_RELAXED );
+    }
+    ulog_trace_.process = ( unsigned long ) getpid();
+    return ulog_trace_.thread;
+}
+
+void
+ulog_trace_reset_( void )
+{
+    ulog_trace_.process = 0U;
+}
+
+typedef struct
+{
+    char level;
+    uint64_t time;
+    char const * location;
+    size_t location_length;
+    char const * body;
+}
+record;
+
+/* depths of spans of a thread which were begun and not ended yet */
+typedef struct
+{
+    unsigned long process;
+    unsigned thread;
+    unsigned * depth;
+    size_t count;
+    size_t capacity;
+}
+open_spans;
+
+/* threads are looked up by their identifiers, as logged, not indexed */
+typedef struct
+{
+    FILE * output;
+    open_spans * thread;
+    size_t threads;
+    size_t capacity;
+    size_t last;
+    /* process of the last span, instant events are shown in it */
+    unsigned long process;
+    bool first;
+}
+exporter;
+
+static bool
+parse_record( char * const line, record * const result )
+{
+    int consumed = 0;
+    if(
+        ( 2 > sscanf(
+            line,
+            "[%c][%" SCNu64 "][%n",
+            &( result->level ),
+            &( result->time ),
+            &consumed
+        ))
+        || ( 0 == consumed )
+    )
+    {
+        return false;
+    }
+    char * const end = strstr( line + consumed, "] " );
+    if( NULL == end ) { return false; }
+    result->location = line + consumed;
+    result->location_length = ( size_t ) ( end - result->location );
+    result->body = end + 2;
+    line[ strcspn( line, "\n" ) ] = '\0';
+    return true;
+}
+
+static void
+write_string(
+    FILE * const output,
+    char const * const text,
+    size_t const length
+)
+{
+    fputc( '"', output );
+    for( size_t i = 0U; i < length; ++i )
+    {
+        unsigned char const c = ( unsigned char ) text[ i ];
+        if(( '"' == c ) || ( '\\' == c ))
+        {
+            fputc( '\\', output );
+            fputc( c, output );
+        }
+        else if( 0x20U > c )
+        {
+            fprintf( output, "\\u%04x", c );
+        }
+        else
+        {
+            fputc( c, output );
+        }
+    }
+    fputc( '"', output );
+}
+
+static void
+write_event(
+    exporter * const self,
+    record const * const event,
+    char const phase,
+    unsigned long const process,
+    unsigned const thread,
+    char const * const name
+)
+{
+    fputs( self->first ? "\n" : ",\n", self->output );
+    self->first = false;
+    fputs( "{\"name\":", self->output );
+    write_string( self->output, name, strlen( name ));
+    fprintf(
+        self->output,
+        ",\"cat\":\"%s\",\"ph\":\"%c\",\"ts\":%" PRIu64 ".%03u,"
+        "\"pid\":%lu,\"tid\":%u",
+        ( 'i' == phase ) ? "log" : "span",
+        phase,
+        event->time / 1000U,
+        ( unsigned ) ( event->time % 1000U ),
+        process,
+        thread
+    );
+    if( 'i' == phase )
+    {
+        fputs( ",\"s\":\"p\",\"args\":{\"level\":", self->output );
+        write_string( self->output, &( event->level ), 1U );
+        fputs( ",\"location\":", self->output );
+        write_string(
+            self->output,
+            event->location,
+            event->location_length
+        );
+        fputc( '}', self->output );
+    }
+    fputc( '}', self->output );
+}
+
+/* threads are few and spans of one come in runs, search starts at last */
+static open_spans *
+spans_of(
+    exporter * const self,
+    unsigned long const process,
+    unsigned const thread
+)
+{
+    for( size_t i = 0U; i < self->threads; ++i )
+    {
+        size_t const index = ( self->last + i ) % self->threads;
+        open_spans * const spans = self->thread + index;
+        if(( process == spans->process ) && ( thread == spans->thread ))
+        {
+            self->last = index;
+            return spans;
+        }
+    }
+    if( self->threads == self->capacity )
+    {
+        size_t const capacity =
+            ( 0U == self->capacity )
+                ? THREADS_INITIAL
+                : 2U * self->capacity;
+        open_spans * const grown =
+            realloc( self->thread, capacity * sizeof( open_spans ));
+        if( NULL == grown ) { return NULL; }
+        self->thread = grown;
+        self->capacity = capacity;
+    }
+    self->last = self->threads++;
+    open_spans * const spans = self->thread + self->last;
+    *spans =
+        ( open_spans )
+        {
+            .process = process,
+            .thread = thread,
+            .depth = NULL,
+            .count = 0U,
+            .capacity = 0U
+        };
+    return spans;
+}
+
+/* ends open spans at least as deep as given one, as their ends were lost */
+static void
+close_spans(
+    exporter * const self,
+    open_spans * const spans,
+    record const * const event,
+    unsigned const depth
+)
+{
+    while(
+        ( 0U < spans->count )
+        && ( depth <= spans->depth[ spans->count - 1U ])
+    )
+    {
+        --( spans->count );
+        write_event( self, event, 'E', spans->process, spans->thread, "" );
+    }
+}
+
+static ulog_status
+export_span(
+    exporter * const self,
+    record const * const event,
+    char const phase,
+    unsigned long const process,
+    unsigned const thread,
+    unsigned const depth,
+    char const * const name
+)
+{
+    open_spans * const spans = spans_of( self, process, thread );
+    if( NULL == spans )
+    {
+        return ulog_status_descriptive( ENOMEM, "cannot track thread" );
+    }
+    self->process = process;
+    if( 'B' == phase )
+    {
+        close_spans( self, spans, event, depth );
+        if( spans->count == spans->capacity )
+        {
+            size_t const capacity =
+                ( 0U == spans->capacity )
+                    ? ULOG_TRACE_DEPTH
+                    : 2U * spans->capacity;
+            unsigned * const grown =
+                realloc( spans->depth, capacity * sizeof( unsigned ));
+            if( NULL == grown )
+            {
+                return ulog_status_descriptive( ENOMEM, "cannot track span" );
+            }
+            spans->depth = grown;
+            spans->capacity = capacity;
+        }
+        spans->depth[ spans->count++ ] = depth;
+        write_event( self, event, 'B', process, thread, name );
+        return ulog_status_descriptive( 0, "span begun" );
+    }
+    size_t open = spans->count;
+    while(( 0U < open ) && ( depth < spans->depth[ open - 1U ])) { --open; }
+    if(( 0U < open ) && ( depth == spans->depth[ open - 1U ]))
+    {
+        close_spans( self, spans, event, depth + 1U );
+        --( spans->count );
+        write_event( self, event, 'E', process, thread, name );
+    }
+    return ulog_status_descriptive( 0, "span ended" );
+}
+
+static ulog_status
+export_record( exporter * const self, record const * const event )
+{
+    char phase = '\0';
+    unsigned long process = 0U;
+    unsigned thread = 0U;
+    unsigned depth = 0U;
+    int consumed = 0;
+    if(
+        ( 4 == sscanf(
+            event->body,
+            "trace %c %lu %u %u %n",
+            &phase,
+            &process,
+            &thread,
+            &depth,
+            &consumed
+        ))
+        && ( 0 != consumed )
+        && (( 'B' == phase ) || ( 'E' == phase ))
+    )
+    {
+        return
+            export_span(
+                self,
+                event,
+                phase,
+                process,
+                thread,
+                depth,
+                event->body + consumed
+            );
+    }
+    write_event( self, event, 'i', self->process, 0U, event->body );
+    return ulog_status_descriptive( 0, "message exported" );
+}
+
+ulog_status
+ulog_trace_export( FILE * const input, FILE * const output )
+{
+    if(( NULL == input ) || ( NULL == output ))
+    {
+        return ulog_status_descriptive( ENODATA, "invalid stream" );
+    }
+    exporter self =
+    {
+        .output = output,
+        .thread = NULL,
+        .threads = 0U,
+        .capacity = 0U,
+        .last = 0U,
+        .process = 0U,
+        .first = true
+    };
+    ulog_status result = ulog_status_descriptive( 0, "trace exported" );
+    char * line = NULL;
+    size_t size = 0U;
+    fputs( "{\"traceEvents\":[", output );
+    while( -1 != getline( &line, &size, input ))
+    {
+        record event;
+        if( !parse_record( line, &event )) { continue; }
+        ulog_status const exported = export_record( &self, &event );
+        if( !ulog_status_success( exported ))
+        {
+            result = exported;
+            break;
+        }
+    }
+    fputs( "\n],\"displayTimeUnit\":\"ns\"}\n", output );
+    free( line );
+    for( size_t i = 0U; i < self.threads; ++i )
+    {
+        free( self.thread[ i ].depth );
+    }
+    free( self.thread );
+    if(
+        ulog_status_success( result )
+        && ( ferror( input ) || ferror( output ))
+    )
+    {
+        result = ulog_status_descriptive( EIO, "cannot export trace" );
+    }
+    return result;
+}
@@ -11,42 +11,101 @@
 #define _POSIX_C_SOURCE 201509L /* for clock_gettime */
 
 #include <ulog/ulog.h>
+#include <ulog/async.h> /* ulog_async */
+#include <ulog/binary.h> /* ulog_binary_encode */
+#include <ulog/context.h> /* ulog_context_get */
+#include <ulog/control.h> /* ulog_control_restart, ulog_control_start, etc. */
+#include <ulog/dedup.h> /* ulog_dedup_* */
+#include <ulog/files.h> /* ulog_files */
+#include <ulog/iovec.h> /* ulog_iovec_record, ulog_iovec_render */
 #include <ulog/listable.h> /* ulog_listable */
-#include <ulog/mutex.h> /* ulog_mutex */
+#include <ulog/mutex.h> /* ulog_mutex, ulog_mutex_lock, etc. */
+#include <ulog/pool.h> /* ulog_pool */
+#include <ulog/ring.h> /* ulog_ring */
+#include <ulog/shared.h> /* ulog_shared_attach_, ulog_shared_detach_ */
+#include <ulog/stats.h> /* ulog_stats_* */
 #include <ulog/status.h> /* ulog_status */
+#include <ulog/trace.h> /* ulog_trace_reset_ */
 #include <ulog/universal.h> /* THREADUNSAFE, UNUSED */
 
 #include <assert.h> /* assert */
 #include <errno.h> /* EALREADY, EINVAL, etc. */
+#include <inttypes.h> /* PRIu64 */
+#include <limits.h> /* UINT_MAX */
+#include <pthread.h> /* pthread_atfork */
 #include <stdbool.h> /* bool */
 #include <stddef.h> /* NULL */
 #include <stdint.h> /* uint64_t */
-#include <stdlib.h> /* malloc, free */
+#include <stdio.h> /* vsnprintf */
+#include <stdlib.h> /* strtoul */
+#include <string.h> /* memcpy, strcmp, strlen, strncmp, strrchr */
 #include <time.h> /* clock_gettime, struct timespec */
 
 #define NANOSECONDS_IN_MICROSECOND 1000U
 #define MICROSECONDS_IN_MILLISECOND 1000U
 #define MILLISECONDS_IN_SECOND 1000U
+/* summaries of duplicates taken at once by a sweep */
+#define DEDUP_SWEEP 8U
+
+/* call sites whose file ends with pattern, and line if not zero, match */
+typedef struct
+{
+    char pattern[ ULOG_CALLSITE_PATTERN ];
+    unsigned line;
+    ulog_callsite_state state;
+}
+callsite_rule;
 
 struct ulog_obj_private_struct
 {
+    /* changed only atomically, as it may be changed by signal handlers */
     ulog_level verbosity;
+    /* read when logging, so changed only atomically as well */
+    uint64_t dedup;
+    /* time of the last sweep of duplicates pending in other threads */
+    uint64_t dedup_swept;
+    bool asynchronous;
+    ulog_async channel;
+    /* producers write records into ring, collector reads them from it */
+    bool producing;
+    bool collecting;
+    ulog_ring ring;
+    /* each thread writes records into a file of its own */
+    bool filing;
+    ulog_files files;
+    ulog_obj_config config;
+    ulog_pool handler_pool;
+    ulog_pool stats_pool;
+    ulog_stats_messages stats;
+    uint64_t stats_reported;
     ulog_list_ctrl handlers;
     ulog_mutex guard;
+    /* held shared while handing record to channel or ring, whole by fork() */
+    ulog_mutex gate;
+    callsite_rule rules[ ULOG_CALLSITE_RULES ];
+    size_t rule_count;
+    /* last generation of rules, also when there are none now */
+    unsigned generation;
+    bool controlled;
+    /* page ulog_fast_ points to while shared, holding verbosity instead */
+    ulog_fast_state * shared;
+    /* page shared before, loggers may still read it until cleanup */
+    ulog_fast_state * retired;
     ulog_obj_op_table const * op;
 };
 
+/* state of this process, unless it shares one with others */
+static ulog_fast_state fast_private = { .threshold = -1 };
+
+INDIRECT ulog_fast_state * ulog_fast_ = &fast_private;
+
+/* the static instance, used directly to avoid calls through ulog_obj_get() */
+static ulog_obj const object;
+
 INDIRECT char
 ulog_level_to_char_( ulog_level const level )
 {
-    switch( level )
-    {
-        case ERROR: return 'E';
-        case WARNING: return 'W';
-        case INFO: return 'I';
-        case DEBUG: return 'D';
-        default: return '?';
-    }
+    return ulog_level_char_( level );
 }
 
 static uint64_t
@@ -72,9 +131,30 @@ ulog_current_time_( void )
     return 0U;
 }
 
+INDIRECT uint64_t
+ulog_monotonic_time_( void )
+{
+    struct timespec result;
+
+    if( 0 == clock_gettime( CLOCK_MONOTONIC, &result ))
+    {
+        return from_timespec( result );
+    }
+
+    return 0U;
+}
+
+/* exactly one of handler, iovec and binary is set */
 typedef struct
 {
     ulog_handler_fn handler;
+    ulog_iovec_handler_fn iovec;
+    ulog_binary_handler_fn binary;
+    /* NULL unless statistics are enabled */
+    ulog_stats_handler * stats;
+    /* delivers messages to the handler on its own thread, if queued */
+    ulog_async queue;
+    bool queued;
     ulog_listable list;
 }
 handler_list_element;
@@ -93,9 +173,220 @@ typedef struct
     ulog_level level;
     char const * format;
     va_list args;
+    /* types of arguments, NULL if unknown */
+    unsigned char const * signature;
+    /* rendered on demand of the first iovec handler */
+    ulog_iovec_record const * pieces;
+    /* encoded on demand of the first binary handler, zero until then */
+    size_t encoded;
+    /* whether statistics measure the message, by rendering it once */
+    bool measure;
+    /* set once rendered as text, along with its whole length */
+    bool rendered;
+    size_t length;
 }
 callback_userdata;
 
+/* handlers may keep pointer to text only until they return */
+static THREADLOCAL char rendered_text[ ULOG_RECORD_SIZE ];
+
+/* text is truncated to buffer, NULL is returned then */
+static char const *
+render_text( callback_userdata * const data )
+{
+    if( !( data->rendered ))
+    {
+        va_list args;
+        va_copy( args, data->args );
+        int const length =
+            vsnprintf(
+                rendered_text,
+                sizeof( rendered_text ),
+                data->format,
+                args
+            );
+        va_end( args );
+        data->rendered = true;
+        data->length = ( 0 > length ) ? 0U : ( size_t ) length;
+        if( 0 > length ) { rendered_text[ 0 ] = '\0'; }
+    }
+    return
+        ( sizeof( rendered_text ) > data->length ) ? rendered_text : NULL;
+}
+
+/* text rendered for statistics or duplicate suppression isn't rendered again */
+static inline char const *
+shared_text( callback_userdata * const data )
+{
+    return ( data->measure || data->rendered ) ? render_text( data ) : NULL;
+}
+
+/* iovec handlers may keep pointers to pieces only until they return */
+static THREADLOCAL ulog_iovec_record rendered_pieces;
+static THREADLOCAL char rendered_body[ ULOG_RECORD_SIZE ];
+
+static ulog_iovec_record const *
+render_pieces( callback_userdata * const data )
+{
+    if( NULL == data->pieces )
+    {
+        va_list args;
+        va_copy( args, data->args );
+        ulog_iovec_render(
+            &rendered_pieces,
+            rendered_body,
+            sizeof( rendered_body ),
+            data->format,
+            args
+        );
+        va_end( args );
+        data->pieces = &rendered_pieces;
+    }
+    return data->pieces;
+}
+
+/* binary handlers may keep pointer to record only until they return */
+static THREADLOCAL unsigned char encoded_record[ ULOG_RECORD_SIZE ];
+
+static ULOG_FORMAT( 3, 4 ) size_t
+encode_formatted(
+    ulog_level const level,
+    unsigned char const * const signature,
+    char const * const format,
+    ...
+)
+{
+    va_list args;
+    va_start( args, format );
+    size_t const size =
+        ulog_binary_encode(
+            encoded_record,
+            sizeof( encoded_record ),
+            level,
+            signature,
+            format,
+            args,
+            ulog_context_get()
+        );
+    va_end( args );
+    return size;
+}
+
+/* messages of unknown types are encoded as rendered text */
+static size_t
+encode_record( callback_userdata * const data )
+{
+    static unsigned char const text[] = { ULOG_ARG_STRING, ULOG_ARG_END };
+    if( 0U != data->encoded ) { return data->encoded; }
+    va_list args;
+    va_copy( args, data->args );
+    if( NULL != data->signature )
+    {
+        data->encoded =
+            ulog_binary_encode(
+                encoded_record,
+                sizeof( encoded_record ),
+                data->level,
+                data->signature,
+                data->format,
+                args,
+                ulog_context_get()
+            );
+    }
+    else
+    {
+        /* long text is encoded truncated */
+        UNUSED( render_text( data ));
+        data->encoded =
+            encode_formatted( data->level, text, "%s", rendered_text );
+    }
+    va_end( args );
+    return data->encoded;
+}
+
+static void
+call_binary_handler(
+    handler_list_element const * const item,
+    ulog_level const level,
+    size_t const size
+)
+{
+    if( NULL == item->stats )
+    {
+        item->binary( level, encoded_record, size );
+        return;
+    }
+    uint64_t const start = ulog_monotonic_time_();
+    item->binary( level, encoded_record, size );
+    ulog_stats_count_call( item->stats, ulog_monotonic_time_() - start );
+}
+
+static void
+call_iovec_handler(
+    handler_list_element const * const item,
+    ulog_level const level,
+    ulog_iovec_record const * const pieces
+)
+{
+    if( NULL == item->stats )
+    {
+        item->iovec( level, pieces->piece, pieces->count );
+        return;
+    }
+    uint64_t const start = ulog_monotonic_time_();
+    item->iovec( level, pieces->piece, pieces->count );
+    ulog_stats_count_call( item->stats, ulog_monotonic_time_() - start );
+}
+
+static void
+call_handler(
+    handler_list_element const * const item,
+    ulog_level const level,
+    char const * const format,
+    va_list args
+)
+{
+    if( NULL == item->stats )
+    {
+        item->handler( level, format, args );
+        return;
+    }
+    uint64_t const start = ulog_monotonic_time_();
+    item->handler( level, format, args );
+    ulog_stats_count_call( item->stats, ulog_monotonic_time_() - start );
+}
+
+static void
+call_or_queue(
+    handler_list_element const * const item,
+    ulog_level const level,
+    char const * const format,
+    va_list args
+)
+{
+    if( item->queued )
+    {
+        UNUSED(
+            item->queue.op->submit( &( item->queue ), level, format, args )
+        );
+    }
+    else { call_handler( item, level, format, args ); }
+}
+
+static ULOG_FORMAT( 3, 4 ) void
+call_or_queue_formatted(
+    handler_list_element const * const item,
+    ulog_level const level,
+    char const * const format,
+    ...
+)
+{
+    va_list args;
+    va_start( args, format );
+    call_or_queue( item, level, format, args );
+    va_end( args );
+}
+
 /*
  * since we control what gets added to the pointer list,
  * we can omit most of the error checks
@@ -107,229 +398,1647 @@ handler_callback( ulog_listable * const element, void * const userdata )
         get_handler_list_element( element );
     callback_userdata * data = userdata;
 
+    if( NULL != item->iovec )
+    {
+        call_iovec_handler( item, data->level, render_pieces( data ));
+        return ulog_status_descriptive( 0, "handler executed successfully" );
+    }
+    if( NULL != item->binary )
+    {
+        call_binary_handler( item, data->level, encode_record( data ));
+        return ulog_status_descriptive( 0, "handler executed successfully" );
+    }
+    /* rendered text is shared by handlers, rather than rendered by each */
+    char const * const text = shared_text( data );
+    if( NULL != text )
+    {
+        call_or_queue_formatted( item, data->level, "%s", text );
+        return ulog_status_descriptive( 0, "handler executed successfully" );
+    }
     va_list args;
     va_copy( args, data->args );
-    item->handler( data->level, data->format, args );
+    call_or_queue( item, data->level, data->format, args );
     va_end( args );
     return ulog_status_descriptive( 0, "handler executed successfully" );
 }
 
-/* uses static variable log, won't modify it, except for using mutex */
-INDIRECT void
-ulog_( ulog_level const level, char const * const format, ... )
+static ULOG_FORMAT( 3, 4 ) void
+call_handler_formatted(
+    handler_list_element const * const item,
+    ulog_level const level,
+    char const * const format,
+    ...
+)
 {
-    ulog_obj const * const ulog = ulog_obj_get();
-    if( !is_initialized( ulog )) { return; }
-    if( level > ulog->state->verbosity ) { return; }
+    va_list args;
+    va_start( args, format );
+    call_handler( item, level, format, args );
+    va_end( args );
+}
 
-    callback_userdata data = { .level = level, .format = format };
-    va_start( data.args, format );
+/* called from worker thread of handler's own queue, without any lock */
+static void
+queue_sink(
+    void * const userdata,
+    ulog_level const level,
+    char const * const text,
+    size_t const length
+)
+{
+    UNUSED( length );
+    call_handler_formatted( userdata, level, "%s", text );
+}
 
-    ulog_status result = ulog->state->guard.op->lock( &( ulog->state->guard ));
-    if( !ulog_status_success( result )) { goto guard_failure; }
-    result =
+static void
+run_handlers( ulog_obj const * const ulog, callback_userdata * const data )
+{
+    /* handler list is only read here, loggers don't exclude each other */
+    ulog_mutex const * const guard = &( ulog->state->guard );
+    if( !ulog_mutex_lock_shared( guard )) { return; }
+    UNUSED(
         ulog->state->handlers.op->foreach(
             &( ulog->state->handlers ),
             handler_callback,
-            &data
-        );
-    UNUSED( ulog->state->guard.op->unlock( &( ulog->state->guard )));
-guard_failure:
+            data
+        )
+    );
+    UNUSED( ulog_mutex_unlock_shared( guard ));
+}
+
+static ULOG_FORMAT( 3, 4 ) void
+run_handlers_formatted(
+    ulog_obj const * const ulog,
+    ulog_level const level,
+    char const * const format,
+    ...
+)
+{
+    callback_userdata data = { .level = level, .format = format };
+    va_start( data.args, format );
+    run_handlers( ulog, &data );
     va_end( data.args );
 }
 
-static inline ulog_status
-generic_invalid( ulog_obj const * const self )
+/* called from consumer thread of asynchronous channel or ring collector */
+static void
+async_sink(
+    void * const userdata,
+    ulog_level const level,
+    char const * const text,
+    size_t const length
+)
 {
-    UNUSED( self );
-    return ulog_status_descriptive( EINVAL, "invalid ulog_obj object" );
+    UNUSED( userdata );
+    UNUSED( length );
+    run_handlers_formatted( &object, level, "%s", text );
 }
 
-static inline ulog_status
-generic_uninitialized( ulog_obj const * const self )
+/* files, ring or asynchronous channel render messages themselves */
+static void
+submit( ulog_obj const * const ulog, callback_userdata * const data )
 {
-    UNUSED( self );
-    return
-        ulog_status_descriptive( ENOTCONN, "ulog framework not initialized" );
+    /* files of threads need no quiescing for fork(), so not the gate */
+    if( ulog->state->filing )
+    {
+        UNUSED(
+            ulog->state->files.op->submit(
+                &( ulog->state->files ),
+                data->level,
+                data->signature,
+                data->format,
+                data->args
+            )
+        );
+        return;
+    }
+    ulog_mutex const * const gate = &( ulog->state->gate );
+    if( !ulog_mutex_lock_shared( gate )) { return; }
+    if( ulog->state->producing )
+    {
+        UNUSED(
+            ulog->state->ring.op->submit(
+                &( ulog->state->ring ),
+                data->level,
+                data->format,
+                data->args
+            )
+        );
+    }
+    else
+    {
+        UNUSED(
+            ulog->state->channel.op->submit(
+                &( ulog->state->channel ),
+                data->level,
+                data->format,
+                data->args
+            )
+        );
+    }
+    UNUSED( ulog_mutex_unlock_shared( gate ));
 }
 
-static inline ulog_status
-generic_ulog_obj_op_uninitialized(
-    ulog_obj const * const self,
-    ulog_handler_fn const handler
+static ULOG_FORMAT( 3, 4 ) void
+submit_formatted(
+    ulog_obj const * const ulog,
+    ulog_level const level,
+    char const * const format,
+    ...
 )
 {
-    UNUSED( handler );
-    return generic_uninitialized( self );
+    callback_userdata data = { .level = level, .format = format };
+    va_start( data.args, format );
+    submit( ulog, &data );
+    va_end( data.args );
 }
 
-static inline ulog_status
-verbosity_uninitialized(
-    ulog_obj const * const self,
-    ulog_level const verbosity
-)
+static void
+deliver( ulog_obj const * const ulog, callback_userdata * const data )
 {
-    UNUSED( verbosity );
-    return generic_uninitialized( self );
+    if(
+        !ulog->state->filing && !ulog->state->producing
+        && !ulog->state->asynchronous
+    )
+    {
+        run_handlers( ulog, data );
+        return;
+    }
+    /* rendered text is submitted, rather than rendered again */
+    char const * const text = shared_text( data );
+    if( NULL != text ) { submit_formatted( ulog, data->level, "%s", text ); }
+    else { submit( ulog, data ); }
 }
 
-static inline ulog_status
-generic_already( ulog_obj const * const self, char const * const message )
+static ULOG_FORMAT( 3, 4 ) void
+deliver_formatted(
+    ulog_obj const * const ulog,
+    ulog_level const level,
+    char const * const format,
+    ...
+)
 {
-    UNUSED( self );
-    return ulog_status_descriptive( EALREADY, message );
+    callback_userdata data = { .level = level, .format = format };
+    va_start( data.args, format );
+    deliver( ulog, &data );
+    va_end( data.args );
 }
 
-static inline ulog_status
-setup_already( ulog_obj const * const self )
+static void
+report_repeated(
+    ulog_obj const * const ulog,
+    ulog_dedup_record const * const flushed
+)
 {
-    return generic_already( self, "ulog framework already set up" );
+    if( 0U == flushed->repeated ) { return; }
+    if( NULL == flushed->file )
+    {
+        deliver_formatted(
+            ulog,
+            flushed->level,
+            "last message repeated %u times%c",
+            flushed->repeated,
+            '\n'
+        );
+        return;
+    }
+    deliver_formatted(
+        ulog,
+        flushed->level,
+        ULOG_HEADER_FORMAT_ "last message repeated %u times%c",
+        ulog_level_to_char_( flushed->level ),
+        ulog_current_time_(),
+        flushed->file,
+        flushed->function,
+        flushed->line,
+        flushed->repeated,
+        '\n'
+    );
 }
 
-static inline ulog_status
-cleanup_already( ulog_obj const * const self )
+/* timeout of zero takes duplicates pending in all threads, for good */
+static void
+report_swept(
+    ulog_obj const * const ulog,
+    uint64_t const now,
+    uint64_t const timeout
+)
 {
-    return generic_already( self, "ulog framework already cleaned up" );
+    ulog_dedup_record flushed[ DEDUP_SWEEP ];
+    size_t taken = DEDUP_SWEEP;
+    while( DEDUP_SWEEP == taken )
+    {
+        taken = ulog_dedup_sweep( now, timeout, flushed, DEDUP_SWEEP );
+        for( size_t i = 0U; i < taken; ++i )
+        {
+            report_repeated( ulog, flushed + i );
+        }
+    }
 }
 
-static ulog_status
-adding_callback( ulog_listable * const element, void * const userdata )
+/* threads which stopped logging have their duplicates reported by others */
+static void
+sweep_if_due(
+    ulog_obj const * const ulog,
+    uint64_t const now,
+    uint64_t const timeout
+)
 {
-    handler_list_element const * const item =
-        get_handler_list_element( element );
-    handler_list_element const * const addition = userdata;
+    uint64_t * const swept = &( ulog->state->dedup_swept );
+    uint64_t last = __atomic_load_n( swept, __ATOMIC_RELAXED );
+    if(
+        ( timeout > now - last )
+        || !__atomic_compare_exchange_n(
+            swept,
+            &last,
+            now,
+            false,
+            __ATOMIC_RELAXED,
+            __ATOMIC_RELAXED
+        )
+    )
+    {
+        return;
+    }
+    report_swept( ulog, now, timeout );
+}
 
+static inline bool
+has_header( char const * const format )
+{
     return
-        ( item->handler == addition->handler ) ?
-            ulog_status_descriptive( EEXIST, "handler already on list")
-            : ulog_status_descriptive( 0, "handler can be added to list" );
+        ( 0 == strncmp(
+            format,
+            ULOG_HEADER_FORMAT_,
+            sizeof( ULOG_HEADER_FORMAT_ ) - 1U
+        ));
 }
 
-static ulog_status
-add_internal( ulog_obj const * const self, ulog_handler_fn const handler )
+/*
+ * Identifies the record by its call site and rendered text, skipping the
+ * time from the standard header, so that repeated calls of the same logging
+ * macro with the same arguments give the same hash. The format pointer
+ * stands in for call site of messages without standard header. The text is
+ * rendered once, for delivery as well; text longer than the buffer counts
+ * as far as it fits there, along with its whole length.
+ */
+static ulog_dedup_record
+identify( callback_userdata * const data )
 {
-    handler_list_element * const element =
-        malloc( sizeof( handler_list_element ));
-    if( NULL == element )
+    ulog_dedup_record result = { .level = data->level };
+    /* "[L][" precedes digits of time */
+    size_t skipped = 0U;
+    if( has_header( data->format ))
     {
-        return
-          ulog_status_descriptive(
-              ENOMEM,
-              "cannot allocate handler list element"
-          );
+        va_list args;
+        va_copy( args, data->args );
+        UNUSED( va_arg( args, int ));
+        result.time = va_arg( args, uint64_t );
+        result.file = va_arg( args, char const * );
+        result.function = va_arg( args, char const * );
+        result.line = va_arg( args, unsigned );
+        va_end( args );
+        skipped = 4U;
     }
+    else { result.time = ulog_current_time_(); }
+    UNUSED( render_text( data ));
+    size_t const stored =
+        ( sizeof( rendered_text ) > data->length )
+            ? data->length
+            : sizeof( rendered_text ) - 1U;
+    if( stored < skipped ) { skipped = stored; }
+    while(
+        ( 0U != skipped ) && ( stored > skipped )
+        && ( '0' <= rendered_text[ skipped ])
+        && ( '9' >= rendered_text[ skipped ])
+    )
+    {
+        ++skipped;
+    }
+    size_t const length = data->length - skipped;
 
-    element->handler = handler;
-    element->list = ulog_listable_get();
+    uint64_t hash =
+        ulog_dedup_hash( 0U, &( data->level ), sizeof( ulog_level ));
+    hash = ulog_dedup_hash( hash, &( data->format ), sizeof( char * ));
+    hash = ulog_dedup_hash( hash, &( result.file ), sizeof( char * ));
+    hash = ulog_dedup_hash( hash, &( result.function ), sizeof( char * ));
+    hash = ulog_dedup_hash( hash, &( result.line ), sizeof( unsigned ));
+    hash = ulog_dedup_hash( hash, &length, sizeof( size_t ));
+    result.hash =
+        ulog_dedup_hash( hash, rendered_text + skipped, stored - skipped );
+    return result;
+}
 
-    ulog_status result =
-        self->state->guard.op->lock( &( self->state->guard ));
-    if( !ulog_status_success( result ))
+/*
+ * Takes length from rendering done for delivery; the message is rendered
+ * just to be measured only if nothing rendered it, e.g. no handlers took
+ * it or binary ones took its arguments as they are.
+ */
+static void
+count_bytes( ulog_obj const * const ulog, callback_userdata * const data )
+{
+    size_t length = data->length;
+    if( !( data->rendered ) && ( NULL != data->pieces ))
     {
-        free( element );
-        return result;
+        for( int i = 0; i < data->pieces->count; ++i )
+        {
+            length += data->pieces->piece[ i ].iov_len;
+        }
     }
-    result = self->state->handlers.op->foreach(
-            &( self->state->handlers ),
-            adding_callback,
-            element
-        );
-    /* if handler already exists result will be EEXIST */
-    if(
-        ( ulog_status_success( result ))
-        || ( ENOENT == ulog_status_to_int( result ))
-    )
+    else if( !( data->rendered ))
     {
-        result =
-            self->state->handlers.op->add(
-                &( self->state->handlers ),
-                &( element->list )
-            );
+        va_list args;
+        va_copy( args, data->args );
+        int const measured = vsnprintf( NULL, 0U, data->format, args );
+        va_end( args );
+        length = ( 0 > measured ) ? 0U : ( size_t ) measured;
     }
-    UNUSED( self->state->guard.op->unlock( &( self->state->guard )));
-    if( !ulog_status_success( result )) {
-      free( element );
-      return result;
+    if( 0U < length )
+    {
+        ulog_stats_count_bytes( &( ulog->state->stats ), ( uint64_t ) length );
     }
-    return ulog_status_descriptive( 0, "handler added successfully" );
 }
 
-/*
- * handler is what we search for
- * element will be list element containing handler, returned from foreach
- */
 typedef struct
 {
-    ulog_handler_fn handler;
-    ulog_listable * element;
+    size_t index;
+    size_t seen;
+    ulog_handler_stats * result;
 }
-removal_userdata;
+handler_stats_userdata;
 
 static ulog_status
-removal_callback( ulog_listable * const element, void * const userdata )
+handler_stats_callback( ulog_listable * const element, void * const userdata )
 {
     handler_list_element const * const item =
         get_handler_list_element( element );
-    removal_userdata * const data = userdata;
-
-    /* exactly one element will be equal */
-    if( item->handler == data->handler ) { data->element = element; }
-    return ulog_status_descriptive( 0, "handled list element" );
+    handler_stats_userdata * const data = userdata;
+    if( data->seen++ != data->index )
+    {
+        return ulog_status_descriptive( 0, "not the requested handler" );
+    }
+    data->result->handler = item->handler;
+    ulog_stats_handler_read( item->stats, data->result );
+    return ulog_status_descriptive( EALREADY, "handler found" );
 }
 
-static ulog_status
-remove_internal( ulog_obj const * const self, ulog_handler_fn const handler )
+/* reads statistics of handler at given position on the list */
+static bool
+handler_stats(
+    ulog_obj const * const ulog,
+    size_t const index,
+    ulog_handler_stats * const result
+)
 {
+    handler_stats_userdata data =
+    {
+        .index = index,
+        .seen = 0U,
+        .result = result
+    };
+    ulog_mutex const * const guard = &( ulog->state->guard );
+    if( !ulog_status_success( guard->op->lock_shared( guard )))
+    {
+        return false;
+    }
+    ulog_status const found =
+        ulog->state->handlers.op->foreach(
+            &( ulog->state->handlers ),
+            handler_stats_callback,
+            &data
+        );
+    UNUSED( guard->op->unlock_shared( guard ));
+    return ( EALREADY == ulog_status_to_int( found ));
+}
+
+/*
+ * Reports are delivered like ordinary messages, so no lock may be held
+ * while doing that; hence handlers are looked up one at a time.
+ */
+static void
+report_stats_if_due( ulog_obj const * const ulog )
+{
+    uint64_t const period = ulog->state->config.stats_period;
+    if( 0U == period ) { return; }
+    uint64_t const now = ulog_monotonic_time_();
+    uint64_t last =
+        __atomic_load_n( &( ulog->state->stats_reported ), __ATOMIC_RELAXED );
+    if(
+        ( period > ( now - last ))
+        || !__atomic_compare_exchange_n(
+            &( ulog->state->stats_reported ),
+            &last,
+            now,
+            false,
+            __ATOMIC_RELAXED,
+            __ATOMIC_RELAXED
+        )
+    )
+    {
+        return;
+    }
+
+    ulog_stats totals;
+    ulog_stats_messages_read( &( ulog->state->stats ), &totals );
+    deliver_formatted(
+        ulog,
+        INFO,
+        "ulog stats: error %" PRIu64 " warning %" PRIu64 " info %" PRIu64
+        " debug %" PRIu64 " suppressed %" PRIu64 " bytes %" PRIu64 "%c",
+        totals.messages[ ERROR ],
+        totals.messages[ WARNING ],
+        totals.messages[ INFO ],
+        totals.messages[ DEBUG ],
+        totals.suppressed,
+        totals.bytes,
+        '\n'
+    );
+    ulog_handler_stats handler;
+    for( size_t i = 0U; handler_stats( ulog, i, &handler ); ++i )
+    {
+        deliver_formatted(
+            ulog,
+            INFO,
+            "ulog stats: handler %zu calls %" PRIu64 " p50 %" PRIu64
+            "ns p99 %" PRIu64 "ns p999 %" PRIu64 "ns%c",
+            i,
+            handler.calls,
+            ulog_stats_percentile( &handler, 0.5 ),
+            ulog_stats_percentile( &handler, 0.99 ),
+            ulog_stats_percentile( &handler, 0.999 ),
+            '\n'
+        );
+    }
+}
+
+static inline ulog_level
+current_verbosity( ulog_obj const * const ulog )
+{
+    if( ulog->state->shared )
+    {
+        return
+            ( ulog_level ) __atomic_load_n(
+                &( ulog->state->shared->threshold ),
+                __ATOMIC_RELAXED
+            );
+    }
+    return __atomic_load_n( &( ulog->state->verbosity ), __ATOMIC_RELAXED );
+}
+
+/* call site state is current only while there are rules */
+static inline bool
+permitted(
+    ulog_obj const * const ulog,
+    ulog_callsite const * const site,
+    ulog_level const level
+)
+{
+    if( level <= current_verbosity( ulog )) { return true; }
+    return
+        ( NULL != site )
+        && (
+            0U
+            != __atomic_load_n(
+                &( ulog_fast_get_()->generation ),
+                __ATOMIC_RELAXED
+            )
+        )
+        && ( ULOG_CALLSITE_ON
+            == __atomic_load_n( &( site->state ), __ATOMIC_RELAXED ));
+}
+
+/* uses static variable log, won't modify it, except for using mutex */
+static void
+log_message(
+    ulog_callsite const * const site,
+    unsigned char const * const signature,
+    ulog_level const level,
+    char const * const format,
+    va_list args
+)
+{
+    ulog_obj const * const ulog = &object;
+    if( !is_initialized( ulog )) { return; }
+    bool const stats = ulog->state->config.stats;
+    if( !permitted( ulog, site, level ))
+    {
+        if( stats ) { ulog_stats_count_suppressed( &( ulog->state->stats )); }
+        return;
+    }
+
+    callback_userdata data =
+    {
+        .level = level,
+        .format = format,
+        .signature = signature,
+        .measure = stats
+    };
+    va_copy( data.args, args );
+    if( stats ) { ulog_stats_count_message( &( ulog->state->stats ), level ); }
+
+    uint64_t const timeout =
+        __atomic_load_n( &( ulog->state->dedup ), __ATOMIC_RELAXED );
+    if( 0U != timeout )
+    {
+        ulog_dedup_record const record = identify( &data );
+        ulog_dedup_record flushed;
+        ulog_status const fresh =
+            ulog_dedup_filter( &record, timeout, &flushed );
+        report_repeated( ulog, &flushed );
+        sweep_if_due( ulog, record.time, timeout );
+        if( !ulog_status_success( fresh )) { goto suppressed; }
+    }
+    deliver( ulog, &data );
+    if( stats ) { count_bytes( ulog, &data ); }
+suppressed:
+    va_end( data.args );
+    if( stats ) { report_stats_if_due( ulog ); }
+}
+
+INDIRECT void
+ulog_( ulog_level const level, char const * const format, ... )
+{
+    va_list args;
+    va_start( args, format );
+    log_message( NULL, NULL, level, format, args );
+    va_end( args );
+}
+
+INDIRECT void
+ulog_typed_(
+    unsigned char const * const signature,
+    ulog_level const level,
+    char const * const format,
+    ...
+)
+{
+    va_list args;
+    va_start( args, format );
+    log_message( NULL, signature, level, format, args );
+    va_end( args );
+}
+
+INDIRECT void
+ulog_site_(
+    ulog_callsite const * const site,
+    unsigned char const * const signature,
+    ulog_level const level,
+    char const * const format,
+    ...
+)
+{
+    va_list args;
+    va_start( args, format );
+    log_message( site, signature, level, format, args );
+    va_end( args );
+}
+
+static bool
+matches( callsite_rule const * const rule, ulog_callsite const * const site )
+{
+    if(( 0U != rule->line ) && ( rule->line != site->line )) { return false; }
+    if( 0 == strcmp( rule->pattern, "*" )) { return true; }
+    size_t const file = strlen( site->file );
+    size_t const pattern = strlen( rule->pattern );
+    return
+        ( pattern <= file )
+        && ( 0 == strcmp( site->file + file - pattern, rule->pattern ))
+        && (( pattern == file ) || ( '/' == site->file[ file - pattern - 1U ]));
+}
+
+/*
+ * The lock is taken once per call site after each change of rules. Fence
+ * pairs with release of generation, so bits of shared page set before it are
+ * visible.
+ */
+INDIRECT void
+ulog_callsite_update_( ulog_callsite * const site, unsigned const generation )
+{
+    ulog_obj const * const ulog = &object;
+    if( !is_initialized( ulog )) { return; }
+    __atomic_thread_fence( __ATOMIC_ACQUIRE );
+    ulog_mutex const * const guard = &( ulog->state->guard );
+    if( !ulog_mutex_lock_shared( guard )) { return; }
+    ulog_callsite_state state = ULOG_CALLSITE_DEFAULT;
+    for( size_t i = 0U; i < ulog->state->rule_count; ++i )
+    {
+        if( matches( &( ulog->state->rules[ i ] ), site ))
+        {
+            state = ulog->state->rules[ i ].state;
+        }
+    }
+    if(
+        ulog->state->shared
+        && ulog_shared_enabled( ulog->state->shared, site->file, site->line )
+    )
+    {
+        state = ULOG_CALLSITE_ON;
+    }
+    UNUSED( ulog_mutex_unlock_shared( guard ));
+    __atomic_store_n( &( site->state ), ( int ) state, __ATOMIC_RELAXED );
+    __atomic_store_n( &( site->generation ), generation, __ATOMIC_RELEASE );
+}
+
+static inline ulog_status
+generic_invalid( ulog_obj const * const self )
+{
+    UNUSED( self );
+    return ulog_status_descriptive( EINVAL, "invalid ulog_obj object" );
+}
+
+static inline ulog_status
+generic_uninitialized( ulog_obj const * const self )
+{
+    UNUSED( self );
+    return
+        ulog_status_descriptive( ENOTCONN, "ulog framework not initialized" );
+}
+
+static inline ulog_status
+generic_ulog_obj_op_uninitialized(
+    ulog_obj const * const self,
+    ulog_handler_fn const handler
+)
+{
+    UNUSED( handler );
+    return generic_uninitialized( self );
+}
+
+static inline ulog_status
+verbosity_uninitialized(
+    ulog_obj const * const self,
+    ulog_level const verbosity
+)
+{
+    UNUSED( verbosity );
+    return generic_uninitialized( self );
+}
+
+static inline ulog_status
+dedup_uninitialized( ulog_obj const * const self, uint64_t const timeout )
+{
+    UNUSED( timeout );
+    return generic_uninitialized( self );
+}
+
+static inline ulog_status
+async_uninitialized(
+    ulog_obj const * const self,
+    ulog_async_config const * const config
+)
+{
+    UNUSED( config );
+    return generic_uninitialized( self );
+}
+
+static inline ulog_status
+counters_uninitialized(
+    ulog_obj const * const self,
+    ulog_async_counters * const counters
+)
+{
+    UNUSED( counters );
+    return generic_uninitialized( self );
+}
+
+static inline ulog_status
+add_async_uninitialized(
+    ulog_obj const * const self,
+    ulog_handler_fn const handler,
+    ulog_async_config const * const config
+)
+{
+    UNUSED( handler );
+    UNUSED( config );
+    return generic_uninitialized( self );
+}
+
+static inline ulog_status
+handler_counters_uninitialized(
+    ulog_obj const * const self,
+    ulog_handler_fn const handler,
+    ulog_async_counters * const counters
+)
+{
+    UNUSED( handler );
+    UNUSED( counters );
+    return generic_uninitialized( self );
+}
+
+static inline ulog_status
+iovec_uninitialized(
+    ulog_obj const * const self,
+    ulog_iovec_handler_fn const handler
+)
+{
+    UNUSED( handler );
+    return generic_uninitialized( self );
+}
+
+static inline ulog_status
+binary_uninitialized(
+    ulog_obj const * const self,
+    ulog_binary_handler_fn const handler
+)
+{
+    UNUSED( handler );
+    return generic_uninitialized( self );
+}
+
+static inline ulog_status
+callsite_uninitialized(
+    ulog_obj const * const self,
+    char const * const pattern,
+    ulog_callsite_state const state
+)
+{
+    UNUSED( pattern );
+    UNUSED( state );
+    return generic_uninitialized( self );
+}
+
+static inline ulog_status
+control_uninitialized(
+    ulog_obj const * const self,
+    ulog_control_config const * const config
+)
+{
+    UNUSED( config );
+    return generic_uninitialized( self );
+}
+
+static inline THREADUNSAFE ulog_status
+share_uninitialized( ulog_obj const * const self, char const * const name )
+{
+    UNUSED( name );
+    return generic_uninitialized( self );
+}
+
+static inline THREADUNSAFE ulog_status
+ring_uninitialized(
+    ulog_obj const * const self,
+    ulog_ring_config const * const config
+)
+{
+    UNUSED( config );
+    return generic_uninitialized( self );
+}
+
+static inline THREADUNSAFE ulog_status
+files_uninitialized(
+    ulog_obj const * const self,
+    ulog_files_config const * const config
+)
+{
+    UNUSED( config );
+    return generic_uninitialized( self );
+}
+
+static inline ulog_status
+stats_uninitialized( ulog_obj const * const self, ulog_stats * const stats )
+{
+    UNUSED( stats );
+    return generic_uninitialized( self );
+}
+
+static inline ulog_status
+generic_already( ulog_obj const * const self, char const * const message )
+{
+    UNUSED( self );
+    return ulog_status_descriptive( EALREADY, message );
+}
+
+static inline ulog_status
+setup_already( ulog_obj const * const self )
+{
+    return generic_already( self, "ulog framework already set up" );
+}
+
+static inline ulog_status
+cleanup_already( ulog_obj const * const self )
+{
+    return generic_already( self, "ulog framework already cleaned up" );
+}
+
+static ulog_status
+adding_callback( ulog_listable * const element, void * const userdata )
+{
+    handler_list_element const * const item =
+        get_handler_list_element( element );
+    handler_list_element const * const addition = userdata;
+
+    return
+        (( item->handler == addition->handler )
+            && ( item->iovec == addition->iovec )
+            && ( item->binary == addition->binary )) ?
+            ulog_status_descriptive( EEXIST, "handler already on list")
+            : ulog_status_descriptive( 0, "handler can be added to list" );
+}
+
+static void
+release_handler_list_element(
+    ulog_obj const * const self,
+    handler_list_element * const element
+)
+{
+    /* delivers what's still queued, so it mustn't be called under lock */
+    if( element->queued )
+    {
+        UNUSED( element->queue.op->cleanup( &( element->queue )));
+    }
+    if( NULL != element->stats )
+    {
+        UNUSED(
+            self->state->stats_pool.op->release(
+                &( self->state->stats_pool ),
+                element->stats
+            )
+        );
+    }
+    UNUSED(
+        self->state->handler_pool.op->release(
+            &( self->state->handler_pool ),
+            element
+        )
+    );
+}
+
+static ulog_status
+add_element(
+    ulog_obj const * const self,
+    ulog_handler_fn const handler,
+    ulog_iovec_handler_fn const iovec,
+    ulog_binary_handler_fn const binary,
+    ulog_async_config const * const config
+)
+{
+    void * block;
+    if( !ulog_status_success(
+        self->state->handler_pool.op->acquire(
+            &( self->state->handler_pool ),
+            &block
+        )
+    ))
+    {
+        return
+          ulog_status_descriptive(
+              ENOMEM,
+              "no free handler list element"
+          );
+    }
+    handler_list_element * const element = block;
+
+    element->handler = handler;
+    element->iovec = iovec;
+    element->binary = binary;
+    element->stats = NULL;
+    element->queue = ulog_async_get();
+    element->queued = false;
+    element->list = ulog_listable_get();
+    if( self->state->config.stats )
+    {
+        /* both pools have the same size, so this can't fail */
+        void * stats;
+        UNUSED(
+            self->state->stats_pool.op->acquire(
+                &( self->state->stats_pool ),
+                &stats
+            )
+        );
+        element->stats = stats;
+        ulog_stats_handler_reset( element->stats );
+    }
+    if( NULL != config )
+    {
+        /* worker starts before the element is visible to loggers */
+        ulog_status const queue_status =
+            element->queue.op->setup(
+                &( element->queue ),
+                config,
+                queue_sink,
+                element
+            );
+        if( !ulog_status_success( queue_status ))
+        {
+            release_handler_list_element( self, element );
+            return queue_status;
+        }
+        element->queued = true;
+    }
+
+    ulog_status result =
+        self->state->guard.op->lock( &( self->state->guard ));
+    if( !ulog_status_success( result ))
+    {
+        release_handler_list_element( self, element );
+        return result;
+    }
+    result = self->state->handlers.op->foreach(
+            &( self->state->handlers ),
+            adding_callback,
+            element
+        );
+    /* if handler already exists result will be EEXIST */
+    if(
+        ( ulog_status_success( result ))
+        || ( ENOENT == ulog_status_to_int( result ))
+    )
+    {
+        result =
+            self->state->handlers.op->add(
+                &( self->state->handlers ),
+                &( element->list )
+            );
+    }
+    UNUSED( self->state->guard.op->unlock( &( self->state->guard )));
+    if( !ulog_status_success( result )) {
+      release_handler_list_element( self, element );
+      return result;
+    }
+    return ulog_status_descriptive( 0, "handler added successfully" );
+}
+
+static ulog_status
+add_internal( ulog_obj const * const self, ulog_handler_fn const handler )
+{
+    return add_element( self, handler, NULL, NULL, NULL );
+}
+
+static ulog_status
+add_async_internal(
+    ulog_obj const * const self,
+    ulog_handler_fn const handler,
+    ulog_async_config const * const config
+)
+{
+    if( NULL == config )
+    {
+        return ulog_status_descriptive( EINVAL, "invalid queue configuration" );
+    }
+    return add_element( self, handler, NULL, NULL, config );
+}
+
+/*
+ * handler is what we search for
+ * element will be list element containing handler, returned from foreach
+ */
+typedef struct
+{
+    ulog_handler_fn handler;
+    ulog_iovec_handler_fn iovec;
+    ulog_binary_handler_fn binary;
+    ulog_listable * element;
+}
+removal_userdata;
+
+static ulog_status
+removal_callback( ulog_listable * const element, void * const userdata )
+{
+    handler_list_element const * const item =
+        get_handler_list_element( element );
+    removal_userdata * const data = userdata;
+
+    /* exactly one element will be equal */
+    if(
+        ( item->handler == data->handler )
+        && ( item->iovec == data->iovec )
+        && ( item->binary == data->binary )
+    )
+    {
+        data->element = element;
+    }
+    return ulog_status_descriptive( 0, "handled list element" );
+}
+
+static ulog_status
+remove_element(
+    ulog_obj const * const self,
+    ulog_handler_fn const handler,
+    ulog_iovec_handler_fn const iovec,
+    ulog_binary_handler_fn const binary
+)
+{
+    removal_userdata data =
+    {
+        .handler = handler,
+        .iovec = iovec,
+        .binary = binary,
+        .element = NULL
+    };
+
+    ulog_status result = self->state->guard.op->lock( &( self->state->guard ));
+    if( !ulog_status_success( result )) { return result; }
+    result = self->state->handlers.op->foreach(
+        &( self->state->handlers ),
+        removal_callback,
+        &data
+    );
+    if( ulog_status_success( result ))
+    {
+        /* data.pointer now contains pointer to remove from list */
+        result = self->state->handlers.op->remove(
+            &( self->state->handlers ),
+            data.element
+        );
+    }
+    UNUSED( self->state->guard.op->unlock( &( self->state->guard )));
+    if( !ulog_status_success( result )) { return result; }
+    release_handler_list_element(
+        self,
+        get_handler_list_element( data.element )
+    );
+    return ulog_status_descriptive( 0, "handler removed successfully" );
+}
+
+static ulog_status
+remove_internal( ulog_obj const * const self, ulog_handler_fn const handler )
+{
+    return remove_element( self, handler, NULL, NULL );
+}
+
+static ulog_status
+add_iovec_internal(
+    ulog_obj const * const self,
+    ulog_iovec_handler_fn const handler
+)
+{
+    return add_element( self, NULL, handler, NULL, NULL );
+}
+
+static ulog_status
+remove_iovec_internal(
+    ulog_obj const * const self,
+    ulog_iovec_handler_fn const handler
+)
+{
+    return remove_element( self, NULL, handler, NULL );
+}
+
+static ulog_status
+add_binary_internal(
+    ulog_obj const * const self,
+    ulog_binary_handler_fn const handler
+)
+{
+    return add_element( self, NULL, NULL, handler, NULL );
+}
+
+static ulog_status
+remove_binary_internal(
+    ulog_obj const * const self,
+    ulog_binary_handler_fn const handler
+)
+{
+    return remove_element( self, NULL, NULL, handler );
+}
+
+static ulog_status
+handler_counters_internal(
+    ulog_obj const * const self,
+    ulog_handler_fn const handler,
+    ulog_async_counters * const counters
+)
+{
+    if( NULL == counters )
+    {
+        return ulog_status_descriptive( ENODATA, "invalid counters pointer" );
+    }
     removal_userdata data =
     {
         .handler = handler,
+        .iovec = NULL,
+        .binary = NULL,
         .element = NULL
     };
+    ulog_mutex const * const guard = &( self->state->guard );
+    ulog_status result = guard->op->lock_shared( guard );
+    if( !ulog_status_success( result )) { return result; }
+    UNUSED(
+        self->state->handlers.op->foreach(
+            &( self->state->handlers ),
+            removal_callback,
+            &data
+        )
+    );
+    if( NULL == data.element )
+    {
+        result = ulog_status_descriptive( ENOENT, "handler not registered" );
+    }
+    else if( !get_handler_list_element( data.element )->queued )
+    {
+        *counters = ( ulog_async_counters ) { .delivered = 0U };
+        result = ulog_status_descriptive( 0, "handler is called directly" );
+    }
+    else
+    {
+        ulog_async const * const queue =
+            &( get_handler_list_element( data.element )->queue );
+        result = queue->op->counters( queue, counters );
+    }
+    UNUSED( guard->op->unlock_shared( guard ));
+    return result;
+}
+
+/*
+ * Statistics count suppressed messages, so then everything reaches ulog_().
+ * Verbosity is read again after publishing, so if it was changed meanwhile
+ * the last one to publish corrects threshold of the others.
+ */
+static void
+publish_threshold( ulog_obj const * const self )
+{
+    ulog_level verbosity =
+        __atomic_load_n( &( self->state->verbosity ), __ATOMIC_ACQUIRE );
+    for( ;; )
+    {
+        int const threshold =
+            self->state->config.stats ? ( int ) DEBUG : ( int ) verbosity;
+        __atomic_store_n(
+            &( fast_private.threshold ),
+            threshold,
+            __ATOMIC_RELEASE
+        );
+        ulog_level const current =
+            __atomic_load_n( &( self->state->verbosity ), __ATOMIC_ACQUIRE );
+        if( current == verbosity ) { break; }
+        verbosity = current;
+    }
+}
+
+static ulog_status
+verbosity_internal( ulog_obj const * const self, ulog_level const verbosity )
+{
+    if( self->state->shared )
+    {
+        return ulog_shared_verbosity( self->state->shared, verbosity );
+    }
+    switch( verbosity )
+    {
+        case ERROR: break;
+        case WARNING: break;
+        case INFO: break;
+        case DEBUG: break;
+        default:
+            return ulog_status_descriptive( ENODATA, "invalid verbosity" );
+    }
+    __atomic_store_n(
+        &( self->state->verbosity ),
+        verbosity,
+        __ATOMIC_RELEASE
+    );
+    publish_threshold( self );
+    return ulog_status_descriptive( 0, "verbosity level set up successfully" );
+}
+
+static inline ulog_level
+step_level( int const level, int const levels )
+{
+    return
+        ( level + levels < ( int ) ERROR ) ? ERROR
+        : ( level + levels > ( int ) DEBUG ) ? DEBUG
+        : ( ulog_level ) ( level + levels );
+}
+
+/* called from signal handlers, so it only uses atomics */
+static void
+step_verbosity( int const levels )
+{
+    ulog_obj const * const self = &object;
+    if( !is_initialized( self )) { return; }
+    if( self->state->shared )
+    {
+        int * const shared = &( self->state->shared->threshold );
+        int threshold = __atomic_load_n( shared, __ATOMIC_RELAXED );
+        while(
+            !__atomic_compare_exchange_n(
+                shared,
+                &threshold,
+                ( int ) step_level( threshold, levels ),
+                false,
+                __ATOMIC_RELEASE,
+                __ATOMIC_RELAXED
+            )
+        );
+        return;
+    }
+    ulog_level current =
+        __atomic_load_n( &( self->state->verbosity ), __ATOMIC_RELAXED );
+    ulog_level stepped;
+    do
+    {
+        stepped = step_level(( int ) current, levels );
+    }
+    while(
+        !__atomic_compare_exchange_n(
+            &( self->state->verbosity ),
+            &current,
+            stepped,
+            false,
+            __ATOMIC_RELEASE,
+            __ATOMIC_RELAXED
+        )
+    );
+    publish_threshold( self );
+}
+
+/*
+ * Zero generation means there are no rules, so it's skipped. Shared page
+ * always has generation, so it's raised past both its own and the one of
+ * this process, and call sites never keep state of other page.
+ */
+static void
+publish_rules( ulog_obj const * const self )
+{
+    if( self->state->shared )
+    {
+        unsigned * const shared = &( self->state->shared->generation );
+        unsigned current = __atomic_load_n( shared, __ATOMIC_RELAXED );
+        unsigned next;
+        do
+        {
+            next =
+                (
+                    ( current > self->state->generation )
+                        ? current
+                        : self->state->generation
+                ) + 1U;
+            if( 0U == next ) { next = 1U; }
+        }
+        while(
+            !__atomic_compare_exchange_n(
+                shared,
+                &current,
+                next,
+                false,
+                __ATOMIC_RELEASE,
+                __ATOMIC_RELAXED
+            )
+        );
+        self->state->generation = next;
+        return;
+    }
+    if( 0U == ++( self->state->generation )) { ++( self->state->generation ); }
+    __atomic_store_n(
+        &( fast_private.generation ),
+        ( 0U == self->state->rule_count ) ? 0U : self->state->generation,
+        __ATOMIC_RELEASE
+    );
+}
+
+static bool
+parse_pattern(
+    char const * const pattern,
+    char * const file,
+    unsigned * const line
+)
+{
+    size_t length = strlen( pattern );
+    *line = 0U;
+    char const * const colon = strrchr( pattern, ':' );
+    if( NULL != colon )
+    {
+        char * end = NULL;
+        unsigned long const number = strtoul( colon + 1, &end, 10 );
+        if(
+            ( colon + 1 == end ) || ( '\0' != *end )
+            || ( 0UL == number ) || ( UINT_MAX < number )
+        )
+        {
+            return false;
+        }
+        *line = ( unsigned ) number;
+        length = ( size_t ) ( colon - pattern );
+    }
+    if(( 0U == length ) || ( ULOG_CALLSITE_PATTERN <= length ))
+    {
+        return false;
+    }
+    memcpy( file, pattern, length );
+    file[ length ] = '\0';
+    return true;
+}
+
+static ulog_status
+callsite_internal(
+    ulog_obj const * const self,
+    char const * const pattern,
+    ulog_callsite_state const state
+)
+{
+    callsite_rule rule = { .state = state };
+    if(
+        (
+            ( NULL != pattern )
+            && !parse_pattern( pattern, rule.pattern, &( rule.line ))
+        )
+        || (
+            ( ULOG_CALLSITE_DEFAULT != state )
+            && ( ULOG_CALLSITE_ON != state )
+            && ( ULOG_CALLSITE_OFF != state )
+        )
+    )
+    {
+        return ulog_status_descriptive( ENODATA, "invalid call site rule" );
+    }
+
+    ulog_mutex const * const guard = &( self->state->guard );
+    ulog_status result = guard->op->lock( guard );
+    if( !ulog_status_success( result )) { return result; }
+    callsite_rule * const rules = self->state->rules;
+    size_t kept = 0U;
+    for( size_t i = 0U; i < self->state->rule_count; ++i )
+    {
+        bool const same =
+            ( NULL == pattern )
+            || (
+                ( rules[ i ].line == rule.line )
+                && ( 0 == strcmp( rules[ i ].pattern, rule.pattern ))
+            );
+        if( !same ) { rules[ kept++ ] = rules[ i ]; }
+    }
+    result = ulog_status_descriptive( 0, "call site rule set" );
+    if(( NULL != pattern ) && ( ULOG_CALLSITE_DEFAULT != state ))
+    {
+        if( ULOG_CALLSITE_RULES == kept )
+        {
+            result =
+                ulog_status_descriptive( ENOBUFS, "too many call site rules" );
+        }
+        else
+        {
+            rules[ kept++ ] = rule;
+        }
+    }
+    self->state->rule_count = kept;
+    publish_rules( self );
+    UNUSED( guard->op->unlock( guard ));
+    return result;
+}
+
+static THREADUNSAFE ulog_status
+control_internal(
+    ulog_obj const * const self,
+    ulog_control_config const * const config
+)
+{
+    if( self->state->controlled )
+    {
+        ulog_control_stop();
+        self->state->controlled = false;
+    }
+    if( NULL == config )
+    {
+        return ulog_status_descriptive( 0, "control channels closed" );
+    }
+    ulog_status const result = ulog_control_start( config, step_verbosity );
+    if( !ulog_status_success( result )) { return result; }
+    self->state->controlled = true;
+    return result;
+}
+
+/*
+ * Loggers follow ulog_fast_ to whichever page it points to, so the page is
+ * filled in before it's published. A page no longer shared may still be
+ * read by loggers which loaded the pointer before, so it stays mapped until
+ * the next page is retired, or until cleanup.
+ */
+static THREADUNSAFE ulog_status
+share_internal( ulog_obj const * const self, char const * const name )
+{
+    ulog_fast_state * const page = self->state->shared;
+    if( NULL != page )
+    {
+        ulog_level const verbosity = current_verbosity( self );
+        unsigned const generation =
+            __atomic_load_n( &( page->generation ), __ATOMIC_RELAXED );
+        self->state->shared = NULL;
+        if( generation > self->state->generation )
+        {
+            self->state->generation = generation;
+        }
+        __atomic_store_n(
+            &( self->state->verbosity ),
+            verbosity,
+            __ATOMIC_RELEASE
+        );
+        publish_threshold( self );
+        publish_rules( self );
+        __atomic_store_n( &ulog_fast_, &fast_private, __ATOMIC_RELEASE );
+        ulog_shared_detach_( self->state->retired );
+        self->state->retired = page;
+    }
+    if( NULL == name )
+    {
+        return ulog_status_descriptive( 0, "control no longer shared" );
+    }
+    ulog_fast_state * attached = NULL;
+    ulog_status const result =
+        ulog_shared_attach_( name, current_verbosity( self ), &attached );
+    if( !ulog_status_success( result )) { return result; }
+    self->state->shared = attached;
+    publish_rules( self );
+    __atomic_store_n( &ulog_fast_, attached, __ATOMIC_RELEASE );
+    return result;
+}
+
+static ulog_status
+dedup_internal( ulog_obj const * const self, uint64_t const timeout )
+{
+    report_swept( self, ulog_current_time_(), 0U );
+    /* so that the calling thread doesn't allocate when it logs */
+    if(( 0U != timeout ) && !ulog_dedup_prepare())
+    {
+        return ulog_status_descriptive( ENOMEM, "cannot list thread" );
+    }
+
+    ulog_status result =
+        self->state->guard.op->lock( &( self->state->guard ));
+    if( !ulog_status_success( result )) { return result; }
+    __atomic_store_n( &( self->state->dedup ), timeout, __ATOMIC_RELAXED );
+    result = self->state->guard.op->unlock( &( self->state->guard ));
+    if( !ulog_status_success( result )) { return result; }
+    return ulog_status_descriptive( 0, "duplicate suppression set up" );
+}
+
+static THREADUNSAFE ulog_status
+configure_internal(
+    ulog_obj const * const self,
+    ulog_obj_config const * const config
+)
+{
+    if(
+        ( NULL == config )
+        || ( 0U == config->handlers )
+        || ( !config->stats && ( 0U != config->stats_period ))
+    )
+    {
+        return ulog_status_descriptive( EINVAL, "invalid configuration" );
+    }
+    self->state->config = *config;
+    return ulog_status_descriptive( 0, "ulog framework configured" );
+}
+
+static inline ulog_status
+configure_already(
+    ulog_obj const * const self,
+    ulog_obj_config const * const config
+)
+{
+    UNUSED( self );
+    UNUSED( config );
+    return
+        ulog_status_descriptive(
+            EBUSY,
+            "cannot configure ulog framework which is set up"
+        );
+}
+
+static THREADUNSAFE ulog_status
+synchronous( ulog_obj const * const self )
+{
+    if( !self->state->asynchronous )
+    {
+        return ulog_status_descriptive( 0, "logging already synchronous" );
+    }
+    ulog_status const result =
+        self->state->channel.op->cleanup( &( self->state->channel ));
+    if( !ulog_status_success( result )) { return result; }
+    self->state->asynchronous = false;
+    return ulog_status_descriptive( 0, "logging is synchronous" );
+}
 
-    ulog_status result = self->state->guard.op->lock( &( self->state->guard ));
+static THREADUNSAFE ulog_status
+async_internal(
+    ulog_obj const * const self,
+    ulog_async_config const * const config
+)
+{
+    ulog_status result = synchronous( self );
+    if( !ulog_status_success( result ) || ( NULL == config )) { return result; }
+
+    self->state->channel = ulog_async_get();
+    result =
+        self->state->channel.op->setup(
+            &( self->state->channel ),
+            config,
+            async_sink,
+            NULL
+        );
     if( !ulog_status_success( result )) { return result; }
-    result = self->state->handlers.op->foreach(
-        &( self->state->handlers ),
-        removal_callback,
-        &data
-    );
-    if( ulog_status_success( result ))
+    self->state->asynchronous = true;
+    return ulog_status_descriptive( 0, "logging is asynchronous" );
+}
+
+static THREADUNSAFE ulog_status
+ring_internal(
+    ulog_obj const * const self,
+    ulog_ring_config const * const config
+)
+{
+    if( self->state->producing || self->state->collecting )
     {
-        /* data.pointer now contains pointer to remove from list */
-        result = self->state->handlers.op->remove(
-            &( self->state->handlers ),
-            data.element
+        ulog_status const result =
+            self->state->ring.op->cleanup( &( self->state->ring ));
+        if( !ulog_status_success( result )) { return result; }
+        self->state->producing = false;
+        self->state->collecting = false;
+    }
+    if( NULL == config )
+    {
+        return ulog_status_descriptive( 0, "ring no longer used" );
+    }
+    self->state->ring = ulog_ring_get();
+    ulog_status const result =
+        self->state->ring.op->setup(
+            &( self->state->ring ),
+            config,
+            async_sink,
+            NULL
         );
-        if( ulog_status_success( result ))
-        {
-            free( get_handler_list_element( data.element ));
-        }
+    if( !ulog_status_success( result )) { return result; }
+    self->state->producing = !config->collect;
+    self->state->collecting = config->collect;
+    return result;
+}
+
+static THREADUNSAFE ulog_status
+files_internal(
+    ulog_obj const * const self,
+    ulog_files_config const * const config
+)
+{
+    if( self->state->filing )
+    {
+        ulog_status const result =
+            self->state->files.op->cleanup( &( self->state->files ));
+        if( !ulog_status_success( result )) { return result; }
+        self->state->filing = false;
     }
-    UNUSED( self->state->guard.op->unlock( &( self->state->guard )));
+    if( NULL == config )
+    {
+        return ulog_status_descriptive( 0, "files no longer used" );
+    }
+    self->state->files = ulog_files_get();
+    ulog_status const result =
+        self->state->files.op->setup( &( self->state->files ), config );
     if( !ulog_status_success( result )) { return result; }
-    return ulog_status_descriptive( 0, "handler removed successfully" );
+    self->state->filing = true;
+    return result;
 }
 
 static ulog_status
-verbosity_internal( ulog_obj const * const self, ulog_level const verbosity )
+counters_internal(
+    ulog_obj const * const self,
+    ulog_async_counters * const counters
+)
 {
-    switch( verbosity )
+    if( NULL == counters )
     {
-        case ERROR: break;
-        case WARNING: break;
-        case INFO: break;
-        case DEBUG: break;
-        default:
-            return ulog_status_descriptive( ENODATA, "invalid verbosity" );
+        return ulog_status_descriptive( ENODATA, "invalid counters pointer" );
+    }
+    if( !self->state->asynchronous )
+    {
+        *counters = ( ulog_async_counters ) { .delivered = 0U };
+        return ulog_status_descriptive( 0, "logging is synchronous" );
     }
+    return
+        self->state->channel.op->counters(
+            &( self->state->channel ),
+            counters
+        );
+}
 
-    ulog_status result =
-        self->state->guard.op->lock( &( self->state->guard ));
-    if( !ulog_status_success( result )) { return result; }
-    self->state->verbosity = verbosity;
-    result = self->state->guard.op->unlock( &( self->state->guard ));
-    if( !ulog_status_success( result )) { return result; }
-    return ulog_status_descriptive( 0, "verbosity level set up successfully" );
+static ulog_status
+stats_internal( ulog_obj const * const self, ulog_stats * const stats )
+{
+    if( NULL == stats )
+    {
+        return ulog_status_descriptive( ENODATA, "invalid statistics pointer" );
+    }
+    if( !self->state->config.stats )
+    {
+        return ulog_status_descriptive( ENOTSUP, "statistics are disabled" );
+    }
+    ulog_stats_messages_read( &( self->state->stats ), stats );
+    size_t const capacity = ( NULL == stats->handler ) ? 0U : stats->handlers;
+    size_t filled = 0U;
+    while(
+        ( filled < capacity )
+        && handler_stats( self, filled, &( stats->handler[ filled ] ))
+    )
+    {
+        ++filled;
+    }
+    stats->handlers = filled;
+    ulog_handler_stats extra;
+    if( handler_stats( self, filled, &extra ))
+    {
+        return
+            ulog_status_descriptive(
+                ENOBUFS,
+                "too many handlers for given array"
+            );
+    }
+    return ulog_status_descriptive( 0, "statistics read" );
 }
 
 static THREADUNSAFE ulog_status
@@ -343,7 +2052,23 @@ static ulog_obj_op_table const default_state =
     .cleanup = cleanup_already,
     .add = generic_ulog_obj_op_uninitialized,
     .remove = generic_ulog_obj_op_uninitialized,
-    .verbosity = verbosity_uninitialized
+    .verbosity = verbosity_uninitialized,
+    .dedup = dedup_uninitialized,
+    .async = async_uninitialized,
+    .counters = counters_uninitialized,
+    .configure = configure_internal,
+    .stats = stats_uninitialized,
+    .add_async = add_async_uninitialized,
+    .handler_counters = handler_counters_uninitialized,
+    .add_iovec = iovec_uninitialized,
+    .remove_iovec = iovec_uninitialized,
+    .add_binary = binary_uninitialized,
+    .remove_binary = binary_uninitialized,
+    .callsite = callsite_uninitialized,
+    .control = control_uninitialized,
+    .share = share_uninitialized,
+    .ring = ring_uninitialized,
+    .files = files_uninitialized
 };
 static ulog_obj_op_table const setup_state =
 {
@@ -351,7 +2076,23 @@ static ulog_obj_op_table const setup_state =
     .cleanup = cleanup_internal,
     .add = add_internal,
     .remove = remove_internal,
-    .verbosity = verbosity_internal
+    .verbosity = verbosity_internal,
+    .dedup = dedup_internal,
+    .async = async_internal,
+    .counters = counters_internal,
+    .configure = configure_already,
+    .stats = stats_internal,
+    .add_async = add_async_internal,
+    .handler_counters = handler_counters_internal,
+    .add_iovec = add_iovec_internal,
+    .remove_iovec = remove_iovec_internal,
+    .add_binary = add_binary_internal,
+    .remove_binary = remove_binary_internal,
+    .callsite = callsite_internal,
+    .control = control_internal,
+    .share = share_internal,
+    .ring = ring_internal,
+    .files = files_internal
 };
 
 static inline bool
@@ -360,17 +2101,205 @@ is_initialized( ulog_obj const * const self )
     return ( &setup_state == self->state->op );
 }
 
+static ulog_status
+flushing_callback( ulog_listable * const element, void * const userdata )
+{
+    UNUSED( userdata );
+    handler_list_element const * const item =
+        get_handler_list_element( element );
+    if( item->queued ) { UNUSED( item->queue.op->flush( &( item->queue ))); }
+    return ulog_status_descriptive( 0, "handler queue flushed" );
+}
+
+static ulog_status
+restarting_callback( ulog_listable * const element, void * const userdata )
+{
+    UNUSED( userdata );
+    handler_list_element * const item = get_handler_list_element( element );
+    /* handler is called directly if its worker cannot be started again */
+    if(
+        item->queued
+        && !ulog_status_success( item->queue.op->reset( &( item->queue )))
+    )
+    {
+        item->queued = false;
+    }
+    return ulog_status_descriptive( 0, "handler queue restarted" );
+}
+
+/*
+ * Queues are flushed first, as their consumers need the guard to deliver;
+ * records queued after that stay for the parent to deliver. Holding gate
+ * and guard, no thread is in the middle of changing any of them. The list
+ * of duplicate suppression comes last, as loggers take it without holding
+ * either, while handlers logging again take it under the guard.
+ */
+static void
+prepare_fork( void )
+{
+    ulog_obj const * const self = &object;
+    if( !is_initialized( self )) { return; }
+    if( self->state->asynchronous )
+    {
+        UNUSED( self->state->channel.op->flush( &( self->state->channel )));
+    }
+    ulog_mutex * const guard = &( self->state->guard );
+    if( ulog_mutex_lock_shared( guard ))
+    {
+        UNUSED(
+            self->state->handlers.op->foreach(
+                &( self->state->handlers ),
+                flushing_callback,
+                NULL
+            )
+        );
+        UNUSED( ulog_mutex_unlock_shared( guard ));
+    }
+    UNUSED( ulog_mutex_lock( &( self->state->gate )));
+    UNUSED( ulog_mutex_lock( guard ));
+    ulog_dedup_lock();
+}
+
+static void
+resume_parent( void )
+{
+    ulog_obj const * const self = &object;
+    if( !is_initialized( self )) { return; }
+    ulog_dedup_unlock();
+    UNUSED( ulog_mutex_unlock( &( self->state->guard )));
+    UNUSED( ulog_mutex_unlock( &( self->state->gate )));
+}
+
+/* the calling thread is the only one in the child, nothing runs alongside */
+static void
+resume_child( void )
+{
+    ulog_obj const * const self = &object;
+    /* spans outlive setup, the forking thread keeps its open ones */
+    ulog_trace_reset_();
+    if( !is_initialized( self )) { return; }
+    UNUSED( self->state->guard.op->reset( &( self->state->guard )));
+    UNUSED( self->state->gate.op->reset( &( self->state->gate )));
+    ulog_dedup_reset();
+    if(
+        self->state->asynchronous
+        && !ulog_status_success(
+            self->state->channel.op->reset( &( self->state->channel ))
+        )
+    )
+    {
+        self->state->asynchronous = false;
+    }
+    UNUSED(
+        self->state->handlers.op->foreach(
+            &( self->state->handlers ),
+            restarting_callback,
+            NULL
+        )
+    );
+    if( self->state->collecting )
+    {
+        UNUSED( self->state->ring.op->reset( &( self->state->ring )));
+        self->state->collecting = false;
+        self->state->producing = true;
+    }
+    if( self->state->filing )
+    {
+        UNUSED( self->state->files.op->reset( &( self->state->files )));
+    }
+    if( self->state->controlled )
+    {
+        UNUSED( ulog_control_restart());
+    }
+}
+
+/* handlers stay registered after cleanup, doing nothing until next setup */
+static bool fork_handled;
+
 static THREADUNSAFE ulog_status
 setup_internal( ulog_obj const * const self )
 {
-    self->state->guard = ulog_mutex_get();
+    if( !fork_handled )
+    {
+        if( 0 != pthread_atfork( prepare_fork, resume_parent, resume_child ))
+        {
+            return
+                ulog_status_descriptive(
+                    ENOMEM,
+                    "cannot register fork handlers"
+                );
+        }
+        fork_handled = true;
+    }
+
+    self->state->gate = ulog_mutex_get_adaptive();
+    ulog_status const gate_status =
+        self->state->gate.op->setup( &( self->state->gate ));
+    if( !ulog_status_success( gate_status )) { return gate_status; }
+
+    /* loggers take it shared, its reader slots keep them from contending */
+    self->state->guard = ulog_mutex_get_adaptive();
     ulog_status const guard_status =
         self->state->guard.op->setup( &( self->state->guard ));
-    if( !ulog_status_success( guard_status )) { return guard_status; }
+    if( !ulog_status_success( guard_status ))
+    {
+        UNUSED( self->state->gate.op->cleanup( &( self->state->gate )));
+        return guard_status;
+    }
+
+    self->state->handler_pool = ulog_pool_get();
+    ulog_status const pool_status =
+        self->state->handler_pool.op->setup(
+            &( self->state->handler_pool ),
+            sizeof( handler_list_element ),
+            self->state->config.handlers
+        );
+    if( !ulog_status_success( pool_status ))
+    {
+        UNUSED( self->state->guard.op->cleanup( &( self->state->guard )));
+        UNUSED( self->state->gate.op->cleanup( &( self->state->gate )));
+        return pool_status;
+    }
+
+    self->state->stats_pool = ulog_pool_get();
+    if( self->state->config.stats )
+    {
+        ulog_status const stats_status =
+            self->state->stats_pool.op->setup(
+                &( self->state->stats_pool ),
+                sizeof( ulog_stats_handler ),
+                self->state->config.handlers
+            );
+        if( !ulog_status_success( stats_status ))
+        {
+            UNUSED(
+                self->state->handler_pool.op->cleanup(
+                    &( self->state->handler_pool )
+                )
+            );
+            UNUSED( self->state->guard.op->cleanup( &( self->state->guard )));
+            UNUSED( self->state->gate.op->cleanup( &( self->state->gate )));
+            return stats_status;
+        }
+    }
+    ulog_stats_messages_reset( &( self->state->stats ));
+    self->state->stats_reported = ulog_monotonic_time_();
 
     self->state->handlers = ulog_list_ctrl_get();
-    self->state->verbosity = DEBUG;
+    __atomic_store_n( &( self->state->verbosity ), DEBUG, __ATOMIC_RELEASE );
+    __atomic_store_n( &( self->state->dedup ), 0U, __ATOMIC_RELEASE );
+    self->state->dedup_swept = 0U;
+    self->state->asynchronous = false;
+    self->state->producing = false;
+    self->state->collecting = false;
+    self->state->filing = false;
+    self->state->rule_count = 0U;
+    self->state->controlled = false;
+    self->state->shared = NULL;
+    self->state->retired = NULL;
     self->state->op = &setup_state;
+    publish_threshold( self );
+    publish_rules( self );
 
     return ulog_status_descriptive( 0, "ulog framework set up successfully" );
 }
@@ -378,19 +2307,45 @@ setup_internal( ulog_obj const * const self )
 static THREADUNSAFE ulog_status
 cleanup_internal( ulog_obj const * const self )
 {
-    ulog_status result =
-        self->state->guard.op->lock( &( self->state->guard ));
+    UNUSED( control_internal( self, NULL ));
+    UNUSED( share_internal( self, NULL ));
+    report_swept( self, ulog_current_time_(), 0U );
+
+    /* after the last report of duplicates, so that it's written too */
+    ulog_status result = files_internal( self, NULL );
+    if( !ulog_status_success( result )) { return result; }
+    result = ring_internal( self, NULL );
     if( !ulog_status_success( result )) { return result; }
+    result = synchronous( self );
+    if( !ulog_status_success( result )) { return result; }
+    /* handlers are released outside the lock, as their queues drain */
     ulog_list_ctrl * const ctrl = &( self->state->handlers );
-    ulog_listable * element = ctrl->head;
-    while( ulog_status_success( ctrl->op->remove( ctrl, ctrl->head )))
+    for( ;; )
     {
-        free( get_handler_list_element( element ));
-        element = ctrl->head;
+        result = self->state->guard.op->lock( &( self->state->guard ));
+        if( !ulog_status_success( result )) { return result; }
+        ulog_listable * const element = ctrl->head;
+        bool const removed =
+            ulog_status_success( ctrl->op->remove( ctrl, element ));
+        UNUSED( self->state->guard.op->unlock( &( self->state->guard )));
+        if( !removed ) { break; }
+        release_handler_list_element(
+            self,
+            get_handler_list_element( element )
+        );
     }
-    UNUSED( self->state->guard.op->unlock( &( self->state->guard )));
     result = self->state->guard.op->cleanup( &( self->state->guard ));
     if( !ulog_status_success( result )) { return result; }
+    UNUSED( self->state->gate.op->cleanup( &( self->state->gate )));
+    UNUSED(
+        self->state->handler_pool.op->cleanup( &( self->state->handler_pool ))
+    );
+    /* fails harmlessly if statistics are disabled */
+    UNUSED( self->state->stats_pool.op->cleanup( &( self->state->stats_pool )));
+    __atomic_store_n( &( fast_private.threshold ), -1, __ATOMIC_RELEASE );
+    __atomic_store_n( &( fast_private.generation ), 0U, __ATOMIC_RELEASE );
+    ulog_shared_detach_( self->state->retired );
+    self->state->retired = NULL;
     self->state->op = &default_state;
     return
         ulog_status_descriptive( 0, "ulog framework cleaned up successfully" );
@@ -421,7 +2376,7 @@ add( ulog_obj const * const self, ulog_handler_fn const handler )
 }
 
 static inline ulog_status
-remove( ulog_obj const * const self, ulog_handler_fn const handler )
+remove_( ulog_obj const * const self, ulog_handler_fn const handler )
 {
     if( !valid( self )) { return generic_invalid( self ); }
     return self->state->op->remove( self, handler );
@@ -434,16 +2389,187 @@ verbosity_( ulog_obj const * const self, ulog_level const verbosity )
     return self->state->op->verbosity( self, verbosity );
 }
 
+static inline ulog_status
+dedup( ulog_obj const * const self, uint64_t const timeout )
+{
+    if( !valid( self )) { return generic_invalid( self ); }
+    return self->state->op->dedup( self, timeout );
+}
+
+static inline THREADUNSAFE ulog_status
+async( ulog_obj const * const self, ulog_async_config const * const config )
+{
+    if( !valid( self )) { return generic_invalid( self ); }
+    return self->state->op->async( self, config );
+}
+
+static inline ulog_status
+counters_(
+    ulog_obj const * const self,
+    ulog_async_counters * const counters
+)
+{
+    if( !valid( self )) { return generic_invalid( self ); }
+    return self->state->op->counters( self, counters );
+}
+
+static inline THREADUNSAFE ulog_status
+configure(
+    ulog_obj const * const self,
+    ulog_obj_config const * const config
+)
+{
+    if( !valid( self )) { return generic_invalid( self ); }
+    return self->state->op->configure( self, config );
+}
+
+static inline ulog_status
+stats_( ulog_obj const * const self, ulog_stats * const stats )
+{
+    if( !valid( self )) { return generic_invalid( self ); }
+    return self->state->op->stats( self, stats );
+}
+
+static inline ulog_status
+add_async(
+    ulog_obj const * const self,
+    ulog_handler_fn const handler,
+    ulog_async_config const * const config
+)
+{
+    if( !valid( self )) { return generic_invalid( self ); }
+    return self->state->op->add_async( self, handler, config );
+}
+
+static inline ulog_status
+handler_counters(
+    ulog_obj const * const self,
+    ulog_handler_fn const handler,
+    ulog_async_counters * const counters
+)
+{
+    if( !valid( self )) { return generic_invalid( self ); }
+    return self->state->op->handler_counters( self, handler, counters );
+}
+
+static inline ulog_status
+add_iovec( ulog_obj const * const self, ulog_iovec_handler_fn const handler )
+{
+    if( !valid( self )) { return generic_invalid( self ); }
+    return self->state->op->add_iovec( self, handler );
+}
+
+static inline ulog_status
+remove_iovec(
+    ulog_obj const * const self,
+    ulog_iovec_handler_fn const handler
+)
+{
+    if( !valid( self )) { return generic_invalid( self ); }
+    return self->state->op->remove_iovec( self, handler );
+}
+
+static inline ulog_status
+add_binary( ulog_obj const * const self, ulog_binary_handler_fn const handler )
+{
+    if( !valid( self )) { return generic_invalid( self ); }
+    return self->state->op->add_binary( self, handler );
+}
+
+static inline ulog_status
+remove_binary(
+    ulog_obj const * const self,
+    ulog_binary_handler_fn const handler
+)
+{
+    if( !valid( self )) { return generic_invalid( self ); }
+    return self->state->op->remove_binary( self, handler );
+}
+
+static inline ulog_status
+callsite(
+    ulog_obj const * const self,
+    char const * const pattern,
+    ulog_callsite_state const state
+)
+{
+    if( !valid( self )) { return generic_invalid( self ); }
+    return self->state->op->callsite( self, pattern, state );
+}
+
+static inline THREADUNSAFE ulog_status
+control(
+    ulog_obj const * const self,
+    ulog_control_config const * const config
+)
+{
+    if( !valid( self )) { return generic_invalid( self ); }
+    return self->state->op->control( self, config );
+}
+
+static inline THREADUNSAFE ulog_status
+share( ulog_obj const * const self, char const * const name )
+{
+    if( !valid( self )) { return generic_invalid( self ); }
+    return self->state->op->share( self, name );
+}
+
+static inline THREADUNSAFE ulog_status
+ring(
+    ulog_obj const * const self,
+    ulog_ring_config const * const config
+)
+{
+    if( !valid( self )) { return generic_invalid( self ); }
+    return self->state->op->ring( self, config );
+}
+
+static inline THREADUNSAFE ulog_status
+files(
+    ulog_obj const * const self,
+    ulog_files_config const * const config
+)
+{
+    if( !valid( self )) { return generic_invalid( self ); }
+    return self->state->op->files( self, config );
+}
+
 static ulog_obj_op_table const op_table =
 {
     .setup = setup,
     .cleanup = cleanup,
     .add = add,
-    .remove = remove,
-    .verbosity = verbosity_
+    .remove = remove_,
+    .verbosity = verbosity_,
+    .dedup = dedup,
+    .async = async,
+    .counters = counters_,
+    .configure = configure,
+    .stats = stats_,
+    .add_async = add_async,
+    .handler_counters = handler_counters,
+    .add_iovec = add_iovec,
+    .remove_iovec = remove_iovec,
+    .add_binary = add_binary,
+    .remove_binary = remove_binary,
+    .callsite = callsite,
+    .control = control,
+    .share = share,
+    .ring = ring,
+    .files = files
 };
 
-static ulog_obj_private state = { .op = &default_state };
+static ulog_obj_private state =
+{
+    .config = { .handlers = ULOG_DEFAULT_HANDLERS },
+    .op = &default_state
+};
+
+static ulog_obj const object =
+{
+    .state = &state,
+    .op = &op_table
+};
 
 static inline bool
 valid( ulog_obj const * const self )
@@ -462,12 +2588,6 @@ ulog_obj_get( void )
     assert( WARNING < INFO );
     assert( INFO < DEBUG );
 
-    static ulog_obj const ulog =
-    {
-        .state = &state,
-        .op = &op_table
-    };
-
-    return &ulog;
+    return &object;
 }
 
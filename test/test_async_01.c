@@ -0,0 +1,92 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Test asynchronous logging #01
+ * \date        2016/02/21 13:05:48 PM
+ * \file        test_async_01.c
+ * \version     1.0
+ *
+ *
+ **/
+
+#include <ulog/status.h>
+#include <ulog/ulog.h>
+
+#include <assert.h> /* assert */
+#include <errno.h> /* EINVAL, ENODATA, ENOTCONN */
+#include <pthread.h> /* pthread_equal, pthread_self, pthread_t */
+#include <stdarg.h> /* va_list */
+#include <stddef.h> /* NULL */
+#include <stdio.h> /* vsnprintf */
+#include <string.h> /* strstr */
+
+static unsigned calls;
+static pthread_t caller;
+static char last[ 256U ];
+
+void
+log_to_buffer(
+    ulog_level const level,
+    char const * const format,
+    va_list args
+)
+{
+    ( void ) level;
+    ++calls;
+    caller = pthread_self();
+    ( void ) vsnprintf( last, sizeof( last ), format, args );
+}
+
+int
+main( void )
+{
+    ulog_obj const * const ulog = ulog_obj_get();
+    ulog_async_config config =
+    {
+        .capacity = 16U,
+        .policy = ULOG_BLOCK,
+        .timeout = UINT64_MAX
+    };
+    ulog_async_counters counters;
+
+    assert( ENOTCONN == ulog_status_to_int( ulog->op->async( ulog, NULL )));
+    assert( ENOTCONN == ulog_status_to_int(
+            ulog->op->counters( ulog, &counters )));
+    assert( ulog_status_success( ulog->op->setup( ulog )));
+    assert( ulog_status_success( ulog->op->add( ulog, log_to_buffer )));
+    assert( ENODATA == ulog_status_to_int(
+            ulog->op->counters( ulog, NULL )));
+
+    /* synchronous by default, counters stay zero */
+    UINFO( "sync %d", 1 );
+    assert( 1U == calls );
+    assert( pthread_equal( caller, pthread_self()));
+    assert( ulog_status_success( ulog->op->counters( ulog, &counters )));
+    assert( 0U == counters.delivered );
+
+    config.capacity = 0U;
+    assert( EINVAL == ulog_status_to_int( ulog->op->async( ulog, &config )));
+    config.capacity = 16U;
+    config.policy = ULOG_SPILL;
+    assert( EINVAL == ulog_status_to_int( ulog->op->async( ulog, &config )));
+    config.policy = ULOG_BLOCK;
+
+    assert( ulog_status_success( ulog->op->async( ulog, &config )));
+    for( int i = 0; i < 100; ++i ) { UINFO( "async %d", i ); }
+
+    /* switching back to synchronous delivers everything */
+    assert( ulog_status_success( ulog->op->async( ulog, NULL )));
+    assert( 101U == calls );
+    assert( !pthread_equal( caller, pthread_self()));
+    assert( NULL != strstr( last, "async 99" ));
+
+    /* cleanup delivers everything too */
+    assert( ulog_status_success( ulog->op->async( ulog, &config )));
+    for( int i = 0; i < 100; ++i ) { UWARNING( "again %d", i ); }
+    assert( ulog_status_success( ulog->op->counters( ulog, &counters )));
+    assert( 0U == counters.dropped );
+    assert( 0U == counters.spilled );
+    assert( ulog_status_success( ulog->op->cleanup( ulog )));
+    assert( 201U == calls );
+    assert( NULL != strstr( last, "again 99" ));
+    return 0;
+}
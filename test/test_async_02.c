@@ -0,0 +1,129 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Test back-pressure policies of asynchronous logging #02
+ * \date        2016/02/21 14:37:10 PM
+ * \file        test_async_02.c
+ * \version     1.0
+ *
+ *
+ **/
+
+#define _POSIX_C_SOURCE 200809L /* for nanosleep */
+
+#include <ulog/status.h>
+#include <ulog/ulog.h>
+
+#include <assert.h> /* assert */
+#include <stdarg.h> /* va_list */
+#include <stdbool.h> /* bool */
+#include <stddef.h> /* NULL */
+#include <stdio.h> /* FILE, fclose, fgets, fopen, remove, vsnprintf */
+#include <string.h> /* strstr */
+#include <time.h> /* nanosleep */
+
+#define CAPACITY 4U
+
+static bool open_gate;
+static bool waiting;
+static unsigned calls;
+static char first[ 256U ];
+
+static void
+pause_briefly( void )
+{
+    struct timespec const pause = { .tv_sec = 0, .tv_nsec = 100000L };
+    ( void ) nanosleep( &pause, NULL );
+}
+
+/* holds the consumer thread in the handler until gate is opened */
+void
+log_behind_gate(
+    ulog_level const level,
+    char const * const format,
+    va_list args
+)
+{
+    ( void ) level;
+    if( 0U == calls++ ) { ( void ) vsnprintf( first, 256U, format, args ); }
+    __atomic_store_n( &waiting, true, __ATOMIC_RELEASE );
+    while( !__atomic_load_n( &open_gate, __ATOMIC_ACQUIRE ))
+    {
+        pause_briefly();
+    }
+}
+
+/* one record held by consumer, CAPACITY waiting, rest under pressure */
+static void
+fill( ulog_obj const * const ulog, ulog_async_config const * const config )
+{
+    calls = 0U;
+    __atomic_store_n( &open_gate, false, __ATOMIC_RELEASE );
+    __atomic_store_n( &waiting, false, __ATOMIC_RELEASE );
+    assert( ulog_status_success( ulog->op->async( ulog, config )));
+    UINFO( "held" );
+    while( !__atomic_load_n( &waiting, __ATOMIC_ACQUIRE )) { pause_briefly(); }
+    for( unsigned i = 0U; i < ( 2U * CAPACITY ); ++i ) { UINFO( "%u", i ); }
+}
+
+static void
+drain( ulog_obj const * const ulog, ulog_async_counters * const counters )
+{
+    __atomic_store_n( &open_gate, true, __ATOMIC_RELEASE );
+    assert( ulog_status_success( ulog->op->counters( ulog, counters )));
+    assert( ulog_status_success( ulog->op->async( ulog, NULL )));
+}
+
+int
+main( void )
+{
+    ulog_obj const * const ulog = ulog_obj_get();
+    ulog_async_config config = { .capacity = CAPACITY };
+    ulog_async_counters counters;
+    char const * const overflow = "test_async_02.overflow";
+    ( void ) remove( overflow );
+
+    assert( ulog_status_success( ulog->op->setup( ulog )));
+    assert( ulog_status_success( ulog->op->add( ulog, log_behind_gate )));
+
+    config.policy = ULOG_DROP_NEWEST;
+    fill( ulog, &config );
+    drain( ulog, &counters );
+    assert( CAPACITY == counters.dropped );
+    assert( 0U == counters.spilled );
+    assert(( 1U + CAPACITY ) == calls );
+
+    config.policy = ULOG_DROP_OLDEST;
+    fill( ulog, &config );
+    drain( ulog, &counters );
+    assert( CAPACITY == counters.dropped );
+    assert(( 1U + CAPACITY ) == calls );
+
+    /* waits a short time, then gives up */
+    config.policy = ULOG_BLOCK;
+    config.timeout = 1000000U;
+    fill( ulog, &config );
+    drain( ulog, &counters );
+    assert( CAPACITY == counters.dropped );
+    assert(( 1U + CAPACITY ) == calls );
+
+    config.policy = ULOG_SPILL;
+    config.overflow = overflow;
+    fill( ulog, &config );
+    drain( ulog, &counters );
+    assert( 0U == counters.dropped );
+    assert( CAPACITY == counters.spilled );
+    assert(( 1U + CAPACITY ) == calls );
+    assert( NULL != strstr( first, "held" ));
+
+    FILE * const spilled = fopen( overflow, "r" );
+    assert( NULL != spilled );
+    char line[ 256U ];
+    unsigned lines = 0U;
+    while( NULL != fgets( line, sizeof( line ), spilled )) { ++lines; }
+    assert( CAPACITY == lines );
+    ( void ) fclose( spilled );
+    ( void ) remove( overflow );
+
+    assert( ulog_status_success( ulog->op->cleanup( ulog )));
+    return 0;
+}
@@ -0,0 +1,127 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Test handlers with their own queues #03
+ * \date        2016/04/02 10:48:33 AM
+ * \file        test_async_03.c
+ * \version     1.0
+ *
+ *
+ **/
+
+#define _POSIX_C_SOURCE 200809L /* for nanosleep */
+
+#include <ulog/status.h>
+#include <ulog/ulog.h>
+
+#include <assert.h> /* assert */
+#include <errno.h> /* EEXIST, EINVAL, ENODATA, ENOENT, ENOTCONN */
+#include <pthread.h> /* pthread_equal, pthread_self, pthread_t */
+#include <stdarg.h> /* va_list */
+#include <stdbool.h> /* bool */
+#include <stddef.h> /* NULL */
+#include <stdint.h> /* UINT64_MAX */
+#include <time.h> /* nanosleep */
+
+#define CAPACITY 4U
+#define MESSAGES 100U
+
+static bool open_gate;
+static bool waiting;
+static unsigned fast_calls;
+static unsigned slow_calls;
+static pthread_t slow_caller;
+
+static void
+pause_briefly( void )
+{
+    struct timespec const pause = { .tv_sec = 0, .tv_nsec = 100000L };
+    ( void ) nanosleep( &pause, NULL );
+}
+
+void
+log_fast( ulog_level const level, char const * const format, va_list args )
+{
+    ( void ) level;
+    ( void ) format;
+    ( void ) args;
+    ++fast_calls;
+}
+
+/* stands for a sink on stalled storage until gate is opened */
+void
+log_slow( ulog_level const level, char const * const format, va_list args )
+{
+    ( void ) level;
+    ( void ) format;
+    ( void ) args;
+    ++slow_calls;
+    slow_caller = pthread_self();
+    __atomic_store_n( &waiting, true, __ATOMIC_RELEASE );
+    while( !__atomic_load_n( &open_gate, __ATOMIC_ACQUIRE ))
+    {
+        pause_briefly();
+    }
+}
+
+int
+main( void )
+{
+    ulog_obj const * const ulog = ulog_obj_get();
+    ulog_async_config const config =
+    {
+        .capacity = CAPACITY,
+        .policy = ULOG_DROP_NEWEST,
+        .stall = 1000000U
+    };
+    ulog_async_counters counters;
+
+    assert( ENOTCONN == ulog_status_to_int(
+            ulog->op->add_async( ulog, log_slow, &config )));
+    assert( ulog_status_success( ulog->op->setup( ulog )));
+    assert( EINVAL == ulog_status_to_int(
+            ulog->op->add_async( ulog, log_slow, NULL )));
+    assert( ulog_status_success( ulog->op->add( ulog, log_fast )));
+    assert( ulog_status_success(
+            ulog->op->add_async( ulog, log_slow, &config )));
+    assert( EEXIST == ulog_status_to_int(
+            ulog->op->add_async( ulog, log_slow, &config )));
+    assert( ENODATA == ulog_status_to_int(
+            ulog->op->handler_counters( ulog, log_slow, NULL )));
+
+    UINFO( "first" );
+    while( !__atomic_load_n( &waiting, __ATOMIC_ACQUIRE )) { pause_briefly(); }
+    /* slow handler is stuck, but fast one keeps getting every message */
+    for( unsigned i = 1U; i < MESSAGES; ++i ) { UINFO( "message %u", i ); }
+    assert( MESSAGES == fast_calls );
+    assert( 1U == slow_calls );
+    assert( !pthread_equal( slow_caller, pthread_self()));
+
+    /* watchdog flags the handler once its call exceeds config.stall */
+    do
+    {
+        pause_briefly();
+        assert( ulog_status_success(
+                ulog->op->handler_counters( ulog, log_slow, &counters )));
+    }
+    while( !counters.stalled );
+    assert(( MESSAGES - 1U - CAPACITY ) == counters.dropped );
+    assert( ulog_status_success(
+            ulog->op->handler_counters( ulog, log_fast, &counters )));
+    assert( !counters.stalled );
+    assert( 0U == counters.delivered );
+
+    /* removal delivers what's left in the queue */
+    __atomic_store_n( &open_gate, true, __ATOMIC_RELEASE );
+    assert( ulog_status_success( ulog->op->remove( ulog, log_slow )));
+    assert(( 1U + CAPACITY ) == slow_calls );
+    assert( ENOENT == ulog_status_to_int(
+            ulog->op->handler_counters( ulog, log_slow, &counters )));
+
+    /* queued handler is released by cleanup too */
+    assert( ulog_status_success(
+            ulog->op->add_async( ulog, log_slow, &config )));
+    UINFO( "last" );
+    assert( ulog_status_success( ulog->op->cleanup( ulog )));
+    assert(( 2U + CAPACITY ) == slow_calls );
+    return 0;
+}
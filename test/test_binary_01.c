@@ -0,0 +1,190 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Test handlers taking binary records #01
+ * \date        2016/04/23 15:20:44 PM
+ * \file        test_binary_01.c
+ * \version     1.0
+ *
+ *
+ **/
+
+#include <ulog/binary.h>
+#include <ulog/status.h>
+#include <ulog/ulog.h>
+
+#include <assert.h> /* assert */
+#include <errno.h> /* EEXIST, EINVAL, ENOTCONN, ENOTSUP */
+#include <stdarg.h> /* va_list */
+#include <stdint.h> /* uint64_t */
+#include <stdio.h> /* vsnprintf */
+#include <string.h> /* memcpy, strcmp, strlen */
+
+static char formatted[ 512U ];
+static unsigned char record[ 512U ];
+static size_t recorded;
+
+void
+log_to_buffer(
+    ulog_level const level,
+    char const * const format,
+    va_list args
+)
+{
+    ( void ) level;
+    ( void ) vsnprintf( formatted, sizeof( formatted ), format, args );
+}
+
+void
+log_record(
+    ulog_level const level,
+    void const * const data,
+    size_t const size
+)
+{
+    ( void ) level;
+    assert( size <= sizeof( record ));
+    memcpy( record, data, size );
+    recorded = size;
+}
+
+static ulog_binary_header
+header( void )
+{
+    ulog_binary_header result;
+    memcpy( &result, record, sizeof( result ));
+    return result;
+}
+
+static size_t
+encode(
+    size_t const size,
+    unsigned char const * const signature,
+    char const * const format,
+    ...
+)
+{
+    va_list args;
+    va_start( args, format );
+    size_t const result =
+        ulog_binary_encode( record, size, INFO, signature, format, args, NULL );
+    va_end( args );
+    return result;
+}
+
+int
+main( void )
+{
+    char text[ 512U ];
+    ulog_obj const * const ulog = ulog_obj_get();
+    assert(
+        ENOTCONN
+        == ulog_status_to_int( ulog->op->add_binary( ulog, log_record ))
+    );
+    assert( ulog_status_success( ulog->op->setup( ulog )));
+    assert( ulog_status_success( ulog->op->add( ulog, log_to_buffer )));
+    assert( ulog_status_success( ulog->op->add_binary( ulog, log_record )));
+    assert(
+        EEXIST == ulog_status_to_int( ulog->op->add_binary( ulog, log_record ))
+    );
+
+    /* arguments are stored with types captured by the macro */
+    short const narrow = -3;
+    long long const wide = -1234567890123LL;
+    UINFO(
+        "%d %u %ld %lu %s %-6.3s| %.2f %Lg %p %c %hd %lld %5.1e %%",
+        -7,
+        7U,
+        -70L,
+        70UL,
+        "string",
+        "truncated",
+        3.14159,
+        2.5L,
+        ( void * ) record,
+        'x',
+        narrow,
+        wide,
+        1.5f
+    );
+    ulog_binary_header const typed = header();
+    assert( INFO == typed.level );
+    assert( recorded == typed.size );
+    assert( 5U + 13U + 1U == typed.count );
+    assert( ULOG_ARG_STRING == record[ sizeof( typed ) + 2U ] );
+    assert( ULOG_ARG_LONG == record[ sizeof( typed ) + 7U ] );
+    assert( ULOG_ARG_LDOUBLE == record[ sizeof( typed ) + 12U ] );
+    assert( ULOG_ARG_POINTER == record[ sizeof( typed ) + 13U ] );
+    assert( ULOG_ARG_INT == record[ sizeof( typed ) + 15U ] );
+    assert( ULOG_ARG_DOUBLE == record[ sizeof( typed ) + 17U ] );
+    assert(
+        ulog_status_success(
+            ulog_binary_decode( record, recorded, text, sizeof( text ))
+        )
+    );
+    assert( 0 == strcmp( formatted, text ));
+
+    /* message without types is stored as rendered text */
+    ulog_( WARNING, "raw %u", 42U );
+    ulog_binary_header const raw = header();
+    assert( WARNING == raw.level );
+    assert( 1U == raw.count );
+    assert( 0 == strcmp( "%s", raw.format ));
+    assert(
+        ulog_status_success(
+            ulog_binary_decode( record, recorded, text, sizeof( text ))
+        )
+    );
+    assert( 0 == strcmp( "raw 42", text ));
+
+    /* decoded text is truncated to buffer */
+    assert(
+        ulog_status_success( ulog_binary_decode( record, recorded, text, 4U ))
+    );
+    assert( 0 == strcmp( "raw", text ));
+
+    /* strings which don't fit are truncated, other arguments dropped */
+    static unsigned char const strings[] =
+    {
+        ULOG_ARG_STRING, ULOG_ARG_INT, ULOG_ARG_END
+    };
+    size_t const size = sizeof( ulog_binary_header ) + 2U + 4U + 3U;
+    assert( size - 1U == encode( size, strings, "%s%d", "abcdef", 1 ));
+    assert( 1U == header().count );
+    assert( EINVAL == ulog_status_to_int(
+        ulog_binary_decode( record, size, text, sizeof( text ))
+    ));
+    assert( 0U == encode( sizeof( ulog_binary_header ), strings, "%s", "" ));
+
+    /* arguments must match the format */
+    static unsigned char const integer[] = { ULOG_ARG_INT, ULOG_ARG_END };
+    recorded = encode( sizeof( record ), integer, "%s", 5 );
+    assert( EINVAL == ulog_status_to_int(
+        ulog_binary_decode( record, recorded, text, sizeof( text ))
+    ));
+    recorded = encode( sizeof( record ), integer, "%ld", 5 );
+    assert( EINVAL == ulog_status_to_int(
+        ulog_binary_decode( record, recorded, text, sizeof( text ))
+    ));
+    recorded = encode( sizeof( record ), integer, "%*d", 5 );
+    assert( ENOTSUP == ulog_status_to_int(
+        ulog_binary_decode( record, recorded, text, sizeof( text ))
+    ));
+    assert( EINVAL == ulog_status_to_int(
+        ulog_binary_decode( record, recorded - 1U, text, sizeof( text ))
+    ));
+
+    /* logging is an expression, e.g. an operand of ?: or comma */
+    recorded = 0U;
+    ( 0U == recorded ) ? UINFO( "chosen %d", 1 ) : ( void ) 0;
+    assert( 0 != recorded );
+    assert( 0 == strcmp( formatted + strlen( formatted ) - 9U, "chosen 1\n" ));
+    UINFO( "first" ), UINFO( "second %d", 2 );
+    assert( 0 == strcmp( formatted + strlen( formatted ) - 9U, "second 2\n" ));
+
+    assert( ulog_status_success( ulog->op->remove_binary( ulog, log_record )));
+    recorded = 0U;
+    UINFO( "not recorded" );
+    assert( 0U == recorded );
+    assert( ulog_status_success( ulog->op->cleanup( ulog )));
+    return 0;
+}
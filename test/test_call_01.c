@@ -8,13 +8,20 @@
  *
  **/
 
+#define _POSIX_C_SOURCE 200809L /* for nanosleep */
+
 #include <assert.h>
+#include <pthread.h>
 #include <stdarg.h>
+#include <stdbool.h>
 #include <stdio.h>
+#include <time.h>
 #include <ulog/status.h>
 #include <ulog/ulog.h>
 
 static int check = 0;
+static unsigned inside = 0U;
+static bool met[ 2U ];
 
 void
 dummy_log(
@@ -29,6 +36,37 @@ dummy_log(
     check = 1;
 }
 
+/* waits a while for the other thread to enter the handler too */
+void
+meeting_log(
+    ulog_level const level,
+    char const * const format,
+    va_list args
+)
+{
+    ( void ) format;
+    ( void ) args;
+    __atomic_add_fetch( &inside, 1U, __ATOMIC_SEQ_CST );
+    struct timespec const pause = { .tv_sec = 0, .tv_nsec = 1000000L };
+    for( unsigned i = 0U; i < 1000U; ++i )
+    {
+        if( 2U <= __atomic_load_n( &inside, __ATOMIC_SEQ_CST ))
+        {
+            met[ ERROR == level ] = true;
+            break;
+        }
+        ( void ) nanosleep( &pause, NULL );
+    }
+}
+
+static void *
+log_error( void * const unused )
+{
+    ( void ) unused;
+    UERROR( "" );
+    return NULL;
+}
+
 int
 main( void )
 {
@@ -40,6 +78,15 @@ main( void )
     UERROR( "" );
     assert( 1 == check );
 
+    /* loggers don't exclude each other, handlers run concurrently */
+    assert( ulog_status_success( ulog->op->remove( ulog, dummy_log )));
+    assert( ulog_status_success( ulog->op->add( ulog, meeting_log )));
+    pthread_t other;
+    assert( 0 == pthread_create( &other, NULL, log_error, NULL ));
+    UWARNING( "" );
+    assert( 0 == pthread_join( other, NULL ));
+    assert( met[ 0 ] && met[ 1 ]);
+
     assert( ulog_status_success( ulog->op->cleanup( ulog )));
     return 0;
 }
@@ -0,0 +1,328 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Test block compression of logged records #01
+ * \date        2016/06/06 14:18:02 PM
+ * \file        test_compress_01.c
+ * \version     1.0
+ *
+ *
+ **/
+
+#include <ulog/compress.h>
+#include <ulog/status.h>
+
+#include <assert.h> /* assert */
+#include <errno.h> /* EINVAL, ENOBUFS, ENODATA */
+#include <stdbool.h> /* false */
+#include <stddef.h> /* NULL, size_t */
+#include <stdint.h> /* uint32_t */
+#include <stdio.h> /* snprintf */
+#include <stdlib.h> /* free, malloc */
+#include <string.h> /* memcmp, memcpy, memmove, memset */
+
+#define TEXT_SIZE ( 1024U * 1024U )
+#define CHUNK 4093U
+
+static char text[ TEXT_SIZE ];
+static unsigned char blocks[ 2U * TEXT_SIZE ];
+static unsigned char data[ TEXT_SIZE ];
+
+/* returns size of block */
+static size_t
+round_trip( void const * const input, size_t const size )
+{
+    size_t const capacity = ulog_compress_bound( size );
+    unsigned char * const block = malloc( capacity );
+    assert( NULL != block );
+    size_t written = 0U;
+    assert(
+        ulog_status_success(
+            ulog_compress_block( input, size, block, capacity, &written )
+        )
+    );
+    assert( ulog_compressed( block, written ));
+    assert( written <= ULOG_COMPRESS_HEADER + size );
+    size_t consumed = 0U;
+    size_t length = 0U;
+    assert(
+        ulog_status_success(
+            ulog_decompress_block(
+                block,
+                written,
+                &consumed,
+                data,
+                size,
+                &length
+            )
+        )
+    );
+    assert(( written == consumed ) && ( size == length ));
+    assert(( 0U == size ) || ( 0 == memcmp( input, data, size )));
+    free( block );
+    return written;
+}
+
+static size_t
+fill_text( void )
+{
+    size_t size = 0U;
+    for( unsigned i = 0U; TEXT_SIZE - size > 128U; ++i )
+    {
+        size +=
+            ( size_t ) snprintf(
+                text + size,
+                TEXT_SIZE - size,
+                "[%c][%llu][server.c:handle:%u] request %u took %u us\n",
+                "EWID"[ i % 4U ],
+                1465000000000000000ULL + i * 7919ULL,
+                100U + i % 13U,
+                i,
+                i % 977U
+            );
+    }
+    return size;
+}
+
+static void
+test_blocks( void )
+{
+    assert( ULOG_COMPRESS_HEADER == round_trip( "", 0U ));
+    static char const repeated[] = "abcabcabcabcabcabcabcabcabcabcabcabcab";
+    for( size_t size = 1U; size < sizeof( repeated ); ++size )
+    {
+        ( void ) round_trip( repeated, size );
+    }
+    /* runs overlap their own output, lengths take extra bytes */
+    static unsigned char run[ 70000U ];
+    memset( run, 'a', sizeof( run ));
+    assert( ULOG_COMPRESS_HEADER + 400U > round_trip( run, sizeof( run )));
+    /* data which doesn't compress is stored as it is */
+    uint32_t seed = 1U;
+    for( size_t i = 0U; i < sizeof( run ); ++i )
+    {
+        seed = seed * 1103515245U + 12345U;
+        run[ i ] = ( unsigned char ) ( seed >> 23U );
+    }
+    assert(
+        ULOG_COMPRESS_HEADER + sizeof( run ) == round_trip( run, sizeof( run ))
+    );
+    /* log text takes a fraction of its size, even with unique numbers */
+    size_t const size = fill_text();
+    assert( 3U * round_trip( text, size ) < size );
+}
+
+static void
+test_errors( void )
+{
+    unsigned char block[ 256U ];
+    size_t written = 0U;
+    assert(
+        EINVAL
+        == ulog_status_to_int(
+            ulog_compress_block(
+                text,
+                ULOG_COMPRESS_MAXIMUM + 1U,
+                blocks,
+                sizeof( blocks ),
+                &written
+            )
+        )
+    );
+    assert(
+        ENOBUFS
+        == ulog_status_to_int(
+            ulog_compress_block( text, 200U, block, 200U, &written )
+        )
+    );
+    assert(
+        ulog_status_success(
+            ulog_compress_block( text, 200U, block, sizeof( block ), &written )
+        )
+    );
+    /* header alone tells sizes of the block */
+    size_t consumed = 0U;
+    size_t length = 0U;
+    assert(
+        ENOBUFS
+        == ulog_status_to_int(
+            ulog_decompress_block(
+                block,
+                written,
+                &consumed,
+                NULL,
+                0U,
+                &length
+            )
+        )
+    );
+    assert(( written == consumed ) && ( 200U == length ));
+    assert(
+        ENODATA
+        == ulog_status_to_int(
+            ulog_decompress_block(
+                block,
+                written - 1U,
+                &consumed,
+                data,
+                sizeof( data ),
+                &length
+            )
+        )
+    );
+    /* compressed data ending early is malformed */
+    uint32_t stored = 0U;
+    memcpy( &stored, block + 8U, sizeof( stored ));
+    assert( 200U > stored );
+    --stored;
+    memcpy( block + 8U, &stored, sizeof( stored ));
+    assert(
+        EINVAL
+        == ulog_status_to_int(
+            ulog_decompress_block(
+                block,
+                written,
+                &consumed,
+                data,
+                sizeof( data ),
+                &length
+            )
+        )
+    );
+    block[ 0 ] = 'X';
+    assert( false == ulog_compressed( block, written ));
+    assert(
+        EINVAL
+        == ulog_status_to_int(
+            ulog_decompress_block(
+                block,
+                written,
+                &consumed,
+                data,
+                sizeof( data ),
+                &length
+            )
+        )
+    );
+}
+
+/* file of blocks is decompressed at once, or block by block from any */
+static void
+test_file( void )
+{
+    size_t const size = fill_text();
+    size_t used = 0U;
+    size_t count = 0U;
+    for( size_t offset = 0U; size > offset; offset += CHUNK, ++count )
+    {
+        size_t const chunk = ( size - offset < CHUNK ) ? size - offset : CHUNK;
+        size_t written = 0U;
+        assert(
+            ulog_status_success(
+                ulog_compress_block(
+                    text + offset,
+                    chunk,
+                    blocks + used,
+                    sizeof( blocks ) - used,
+                    &written
+                )
+            )
+        );
+        used += written;
+    }
+    void * expanded = NULL;
+    size_t length = 0U;
+    assert(
+        ulog_status_success(
+            ulog_decompress( blocks, used, 4U, &expanded, &length )
+        )
+    );
+    assert(( size == length ) && ( 0 == memcmp( text, expanded, size )));
+    free( expanded );
+
+    size_t const wanted = count / 2U;
+    size_t offset = 0U;
+    for( size_t i = 0U; i < wanted; ++i )
+    {
+        size_t consumed = 0U;
+        assert(
+            ENOBUFS
+            == ulog_status_to_int(
+                ulog_decompress_block(
+                    blocks + offset,
+                    used - offset,
+                    &consumed,
+                    NULL,
+                    0U,
+                    &length
+                )
+            )
+        );
+        offset += consumed;
+    }
+    size_t consumed = 0U;
+    assert(
+        ulog_status_success(
+            ulog_decompress_block(
+                blocks + offset,
+                used - offset,
+                &consumed,
+                data,
+                sizeof( data ),
+                &length
+            )
+        )
+    );
+    assert(
+        ( CHUNK == length )
+        && ( 0 == memcmp( text + wanted * CHUNK, data, CHUNK ))
+    );
+
+    /* the last block may be still being written, it's left out */
+    size_t const whole = ( count - 1U ) * CHUNK;
+    assert(
+        ulog_status_success(
+            ulog_decompress( blocks, used - 1U, 0U, &expanded, &length )
+        )
+    );
+    assert(( whole == length ) && ( 0 == memcmp( text, expanded, whole )));
+    free( expanded );
+
+    /* streaming keeps what's still needed, then appends the next block */
+    void * window = NULL;
+    size_t capacity = 0U;
+    size_t block = 0U;
+    size_t decoded = 0U;
+    ulog_status taken;
+    for( length = 0U; ; )
+    {
+        size_t const before = length;
+        taken =
+            ulog_decompress_next(
+                blocks,
+                used - 1U,
+                &block,
+                &window,
+                &capacity,
+                &length
+            );
+        if( !ulog_status_success( taken )) { break; }
+        decoded += length - before;
+        assert( 0 == memcmp( text + decoded - length, window, length ));
+        size_t const kept = ( CHUNK / 2U < length ) ? CHUNK / 2U : length;
+        memmove( window, ( unsigned char * ) window + length - kept, kept );
+        length = kept;
+    }
+    assert( ENODATA == ulog_status_to_int( taken ));
+    assert(( whole == decoded ) && ( used - 1U > block ));
+    assert( 2U * CHUNK >= capacity );
+    free( window );
+}
+
+int
+main( void )
+{
+    test_blocks();
+    test_errors();
+    test_file();
+    return 0;
+}
@@ -0,0 +1,137 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Test thread-local context of records #01
+ * \date        2016/05/07 14:32:19 PM
+ * \file        test_context_01.c
+ * \version     1.0
+ *
+ *
+ **/
+
+#include <ulog/binary.h>
+#include <ulog/context.h>
+#include <ulog/status.h>
+#include <ulog/ulog.h>
+
+#include <assert.h> /* assert */
+#include <errno.h> /* ENOBUFS, ENODATA, ENOENT */
+#include <pthread.h> /* pthread_equal, pthread_self, pthread_t */
+#include <stdarg.h> /* va_list */
+#include <stdint.h> /* UINT64_MAX */
+#include <stdio.h> /* snprintf */
+#include <string.h> /* memcpy, strcmp, strstr */
+
+static char seen[ 256U ];
+static pthread_t caller;
+static unsigned char record[ 512U ];
+static size_t recorded;
+
+void
+log_context(
+    ulog_level const level,
+    char const * const format,
+    va_list args
+)
+{
+    ( void ) level;
+    ( void ) format;
+    ( void ) args;
+    caller = pthread_self();
+    ( void ) ulog_context_render( ulog_context_get(), seen, sizeof( seen ));
+}
+
+void
+log_record(
+    ulog_level const level,
+    void const * const data,
+    size_t const size
+)
+{
+    ( void ) level;
+    memcpy( record, data, size );
+    recorded = size;
+}
+
+int
+main( void )
+{
+    char text[ 256U ];
+    ulog_context const * const own = ulog_context_get();
+    assert( 0U == own->count );
+    assert( ENOENT == ulog_status_to_int( ulog_context_pop()));
+    assert( ENODATA == ulog_status_to_int( ulog_context_push( NULL, "x" )));
+
+    assert( ulog_status_success( ulog_context_push( "request", "42" )));
+    assert( ulog_status_success( ulog_context_push( "tenant", "acme" )));
+    assert( 2U == own->count );
+    assert( 0 == strcmp( "tenant", ulog_context_key( own, 1U )));
+    assert( 0 == strcmp( "acme", ulog_context_value( own, 1U )));
+    assert( 22U == ulog_context_render( own, text, sizeof( text )));
+    assert( 0 == strcmp( "request=42 tenant=acme", text ));
+    assert( 7U == ulog_context_render( own, text, 8U ));
+    assert( 0 == strcmp( "request", text ));
+    assert( ulog_status_success( ulog_context_pop()));
+    assert( 1U == own->count );
+
+    /* pushing only what fits */
+    char large[ ULOG_CONTEXT_SIZE ];
+    for( size_t i = 0U; i < sizeof( large ) - 1U; ++i ) { large[ i ] = 'x'; }
+    large[ sizeof( large ) - 1U ] = '\0';
+    assert( ENOBUFS == ulog_status_to_int( ulog_context_push( "k", large )));
+    for( unsigned i = 1U; i < ULOG_CONTEXT_ENTRIES; ++i )
+    {
+        char key[ 8U ];
+        ( void ) snprintf( key, sizeof( key ), "k%u", i );
+        assert( ulog_status_success( ulog_context_push( key, "v" )));
+    }
+    assert( ENOBUFS == ulog_status_to_int( ulog_context_push( "k", "v" )));
+    while( 1U < own->count )
+    {
+        assert( ulog_status_success( ulog_context_pop()));
+    }
+
+    /* handlers see context of the thread which logged */
+    ulog_obj const * const ulog = ulog_obj_get();
+    assert( ulog_status_success( ulog->op->setup( ulog )));
+    assert( ulog_status_success( ulog->op->add( ulog, log_context )));
+    assert( ulog_status_success( ulog->op->add_binary( ulog, log_record )));
+    UINFO( "synchronous" );
+    assert( 0 == strcmp( "request=42", seen ));
+
+    ulog_context copy;
+    assert(
+        ulog_status_success( ulog_binary_context( record, recorded, &copy ))
+    );
+    assert( 1U == copy.count );
+    assert( 0 == strcmp( "request", ulog_context_key( &copy, 0U )));
+    assert( 0 == strcmp( "42", ulog_context_value( &copy, 0U )));
+    assert(
+        ulog_status_success(
+            ulog_binary_decode( record, recorded, text, sizeof( text ))
+        )
+    );
+    assert( NULL != strstr( text, "synchronous" ));
+
+    /* even if delivered later, on another thread */
+    ulog_async_config const config =
+    {
+        .capacity = 16U,
+        .policy = ULOG_BLOCK,
+        .timeout = UINT64_MAX
+    };
+    assert( ulog_status_success( ulog->op->async( ulog, &config )));
+    assert( ulog_status_success( ulog_context_push( "user", "alice" )));
+    UINFO( "asynchronous" );
+    assert( ulog_status_success( ulog_context_pop()));
+    assert( ulog_status_success( ulog_context_pop()));
+    assert( ulog_status_success( ulog->op->async( ulog, NULL )));
+    assert( !pthread_equal( caller, pthread_self()));
+    assert( 0 == strcmp( "request=42 user=alice", seen ));
+    assert(
+        ulog_status_success( ulog_binary_context( record, recorded, &copy ))
+    );
+    assert( 2U == copy.count );
+
+    assert( ulog_status_success( ulog->op->cleanup( ulog )));
+    return 0;
+}
@@ -0,0 +1,240 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Test control of verbosity and call sites #01
+ * \date        2016/05/21 15:20:37 PM
+ * \file        test_control_01.c
+ * \version     1.0
+ *
+ *
+ **/
+
+#define _POSIX_C_SOURCE 200809L /* for mkdtemp, nanosleep */
+
+#include <ulog/status.h>
+#include <ulog/ulog.h>
+
+#include <assert.h> /* assert */
+#include <errno.h> /* ENOBUFS, ENODATA, ENOTCONN */
+#include <signal.h> /* SIGUSR1, SIGUSR2, raise */
+#include <stdarg.h> /* va_list */
+#include <stdbool.h> /* bool */
+#include <stdio.h> /* FILE, fclose, fopen, fputs, remove, rename, snprintf */
+#include <stdlib.h> /* mkdtemp */
+#include <time.h> /* nanosleep */
+#include <unistd.h> /* rmdir */
+
+static unsigned calls;
+
+void
+count_calls(
+    ulog_level const level,
+    char const * const format,
+    va_list args
+)
+{
+    ( void ) level;
+    ( void ) format;
+    ( void ) args;
+    ++calls;
+}
+
+static unsigned
+debug_here( void )
+{
+    unsigned const before = calls;
+    UDEBUG( "debug" );
+    return calls - before;
+}
+
+static unsigned
+error_here( void )
+{
+    unsigned const before = calls;
+    UERROR( "error" );
+    return calls - before;
+}
+
+static void
+write_file( char const * const path, char const * const text )
+{
+    char temporary[ 256U ];
+    ( void ) snprintf( temporary, sizeof( temporary ), "%s.new", path );
+    FILE * const file = fopen( temporary, "w" );
+    assert( NULL != file );
+    fputs( text, file );
+    assert( 0 == fclose( file ));
+    assert( 0 == rename( temporary, path ));
+}
+
+/* watcher thread applies the file asynchronously */
+static bool
+wait_for_threshold( int const threshold )
+{
+    struct timespec const pause = { .tv_sec = 0, .tv_nsec = 10000000L };
+    for( unsigned i = 0U; i < 500U; ++i )
+    {
+        if(
+            threshold
+            == __atomic_load_n( &( ulog_fast_->threshold ), __ATOMIC_ACQUIRE )
+        )
+        {
+            return true;
+        }
+        ( void ) nanosleep( &pause, NULL );
+    }
+    return false;
+}
+
+int
+main( void )
+{
+    ulog_obj const * const ulog = ulog_obj_get();
+    ulog_control_config const signals = { .signals = true };
+    assert(
+        ENOTCONN
+        == ulog_status_to_int( ulog->op->control( ulog, &signals ))
+    );
+    assert( ulog_status_success( ulog->op->setup( ulog )));
+    assert( ulog_status_success( ulog->op->add( ulog, count_calls )));
+    assert( 0U == ulog_fast_->generation );
+
+    /* call sites */
+    assert( ulog_status_success( ulog->op->verbosity( ulog, ERROR )));
+    assert( 0U == debug_here());
+    assert(
+        ulog_status_success(
+            ulog->op->callsite( ulog, "test_control_01.c", ULOG_CALLSITE_ON )
+        )
+    );
+    assert( 0U != ulog_fast_->generation );
+#if defined( __STDC_VERSION__ ) && ( 201112L <= __STDC_VERSION__ )
+    assert( 1U == debug_here());
+    assert(
+        ulog_status_success(
+            ulog->op->callsite( ulog, "control_01.c", ULOG_CALLSITE_OFF )
+        )
+    );
+    assert( 1U == debug_here());
+    assert(
+        ulog_status_success(
+            ulog->op->callsite(
+                ulog,
+                "test/test_control_01.c",
+                ULOG_CALLSITE_OFF
+            )
+        )
+    );
+    assert( 0U == debug_here());
+    assert( 0U == error_here());
+    assert(
+        ulog_status_success(
+            ulog->op->callsite(
+                ulog,
+                "test/test_control_01.c",
+                ULOG_CALLSITE_DEFAULT
+            )
+        )
+    );
+    assert( 1U == debug_here());
+    assert( 1U == error_here());
+#endif /* __STDC_VERSION__ */
+    assert(
+        ulog_status_success(
+            ulog->op->callsite( ulog, NULL, ULOG_CALLSITE_DEFAULT )
+        )
+    );
+    assert( 0U == ulog_fast_->generation );
+    assert( 0U == debug_here());
+
+    char const * const invalid[] =
+    {
+        "",
+        "file.c:",
+        "file.c:0",
+        "file.c:x",
+        ":12",
+        "0123456789012345678901234567890123456789012345678901234567890123"
+    };
+    for( size_t i = 0U; i < sizeof( invalid ) / sizeof( invalid[ 0 ] ); ++i )
+    {
+        assert(
+            ENODATA
+            == ulog_status_to_int(
+                ulog->op->callsite( ulog, invalid[ i ], ULOG_CALLSITE_ON )
+            )
+        );
+    }
+    assert(
+        ENODATA
+        == ulog_status_to_int(
+            ulog->op->callsite( ulog, "file.c", ( ulog_callsite_state ) 7 )
+        )
+    );
+    for( unsigned i = 1U; i <= ULOG_CALLSITE_RULES; ++i )
+    {
+        char pattern[ 32U ];
+        ( void ) snprintf( pattern, sizeof( pattern ), "file.c:%u", i );
+        assert(
+            ulog_status_success(
+                ulog->op->callsite( ulog, pattern, ULOG_CALLSITE_OFF )
+            )
+        );
+    }
+    assert(
+        ENOBUFS
+        == ulog_status_to_int(
+            ulog->op->callsite( ulog, "*", ULOG_CALLSITE_ON )
+        )
+    );
+    /* replacing existing rule needs no space */
+    assert(
+        ulog_status_success(
+            ulog->op->callsite( ulog, "file.c:1", ULOG_CALLSITE_ON )
+        )
+    );
+    assert(
+        ulog_status_success(
+            ulog->op->callsite( ulog, NULL, ULOG_CALLSITE_DEFAULT )
+        )
+    );
+
+    /* signals */
+    assert( ulog_status_success( ulog->op->control( ulog, &signals )));
+    assert( ulog_status_success( ulog->op->verbosity( ulog, INFO )));
+    assert( 0 == raise( SIGUSR1 ));
+    assert(( int ) DEBUG == ulog_fast_->threshold );
+    assert( 0 == raise( SIGUSR1 ));
+    assert(( int ) DEBUG == ulog_fast_->threshold );
+    assert( 0 == raise( SIGUSR2 ));
+    assert( 0 == raise( SIGUSR2 ));
+    assert(( int ) WARNING == ulog_fast_->threshold );
+    assert( 1U == error_here());
+    assert( 0U == debug_here());
+
+    /* control file */
+    char directory[] = "/tmp/ulog_control_XXXXXX";
+    assert( NULL != mkdtemp( directory ));
+    char path[ 128U ];
+    ( void ) snprintf( path, sizeof( path ), "%s/ulog.ctl", directory );
+    write_file(
+        path,
+        "# set up by operator\n"
+        "verbosity error\n"
+        "callsite test_control_01.c on\n"
+        "unknown line\n"
+    );
+    ulog_control_config const watched = { .signals = false, .file = path };
+    assert( ulog_status_success( ulog->op->control( ulog, &watched )));
+    assert(( int ) ERROR == ulog_fast_->threshold );
+    assert( 0U != ulog_fast_->generation );
+    write_file( path, "verbosity DEBUG\n" );
+    assert( wait_for_threshold(( int ) DEBUG ));
+    assert( 0U == ulog_fast_->generation );
+    write_file( path, "verbosity INFO" );
+    assert( wait_for_threshold(( int ) INFO ));
+
+    assert( ulog_status_success( ulog->op->cleanup( ulog )));
+    assert( 0 == remove( path ));
+    assert( 0 == rmdir( directory ));
+    return 0;
+}
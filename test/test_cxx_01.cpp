@@ -0,0 +1,170 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Test C++ front-end #01
+ * \date        2016/04/30 14:51:26 PM
+ * \file        test_cxx_01.cpp
+ * \version     1.0
+ *
+ *
+ **/
+
+#include <ulog/binary.h>
+#include <ulog/status.h>
+#include <ulog/ulog.hpp>
+
+#include <cassert> /* assert */
+#include <cstdarg> /* va_list */
+#include <cstdio> /* std::snprintf, std::vsnprintf */
+#include <cstring> /* std::memcpy, std::strcmp, std::strspn, std::strstr */
+#include <string> /* std::string */
+#include <string_view> /* std::string_view */
+
+using ulog::detail::matches;
+
+static_assert( matches< int >( "%d" ), "int matches %d" );
+static_assert( !matches< int >( "%s" ), "int doesn't match %s" );
+static_assert( !matches<>( "%d" ), "missing argument" );
+static_assert( !matches< int, int >( "%d" ), "excess argument" );
+static_assert( !matches< long long >( "%d" ), "too wide for %d" );
+static_assert( matches< long long >( "%lld" ), "long long matches %lld" );
+static_assert( matches< int, double >( "%*.2f%%" ), "width from argument" );
+static_assert( matches< std::string >( "%s" ), "strings match %s" );
+static_assert( matches< char const * >( "%-5.2s" ), "with precision" );
+static_assert( matches< short, bool >( "%hd %d" ), "promoted to int" );
+static_assert( !matches< double >( "%Lf" ), "long double expected" );
+static_assert( !matches< void * >( "%s" ), "pointer isn't string" );
+
+namespace
+{
+
+char formatted[ 1024U ];
+unsigned char record[ 1024U ];
+std::size_t recorded;
+
+enum class color : unsigned char { red = 2U };
+
+} // namespace
+
+extern "C" void
+log_to_buffer(
+    ulog_level const level,
+    char const * const format,
+    va_list args
+)
+{
+    static_cast< void >( level );
+    static_cast< void >(
+        std::vsnprintf( formatted, sizeof( formatted ), format, args )
+    );
+}
+
+extern "C" void
+log_record(
+    ulog_level const level,
+    void const * const data,
+    std::size_t const size
+)
+{
+    static_cast< void >( level );
+    assert( size <= sizeof( record ));
+    std::memcpy( record, data, size );
+    recorded = size;
+}
+
+int
+main()
+{
+    ulog_obj const * const ulog = ulog_obj_get();
+    assert( ulog_status_success( ulog->op->setup( ulog )));
+    assert( ulog_status_success( ulog->op->add( ulog, log_to_buffer )));
+    assert( ulog_status_success( ulog->op->add_binary( ulog, log_record )));
+
+    std::string const owned = "string";
+    /* not zero-terminated, has to be copied */
+    std::string_view const view =
+        std::string_view( "viewed!" ).substr( 0U, 6U );
+    UINFO(
+        "%s %s %d %u %.1f %p %c %lld",
+        owned,
+        view,
+        color::red,
+        7U,
+        1.5f,
+        nullptr,
+        'x',
+        5LL
+    );
+    char expected[ 128U ];
+    static_cast< void >(
+        std::snprintf(
+            expected,
+            sizeof( expected ),
+            "string viewed 2 7 1.5 %p x 5\n",
+            static_cast< void const * >( nullptr )
+        )
+    );
+    assert( nullptr != std::strstr( formatted, expected ));
+
+    ulog_binary_header header;
+    std::memcpy( &header, record, sizeof( header ));
+    assert( INFO == header.level );
+    assert( 5U + 8U + 1U == header.count );
+    char text[ 512U ];
+    assert(
+        ulog_status_success(
+            ulog_binary_decode( record, recorded, text, sizeof( text ))
+        )
+    );
+    assert( 0 == std::strcmp( formatted, text ));
+
+    /* views past the arena are truncated, then passed as empty strings */
+    std::string const long_string( 300U, 'a' );
+    std::string_view const long_view( long_string );
+    UINFO( "%s|%s|%s", long_view, long_view, long_view );
+    /* arguments may be passed in any order, so sum up lengths of fields */
+    char const * field = std::strstr( formatted, "] " );
+    assert( nullptr != field );
+    ++field;
+    std::size_t lengths[ 3U ];
+    for( std::size_t i = 0U; i < 3U; ++i )
+    {
+        ++field;
+        lengths[ i ] = std::strspn( field, "a" );
+        field += lengths[ i ];
+    }
+    assert( 0 == std::strcmp( field, "\n" ));
+    assert( 300U + 210U == lengths[ 0 ] + lengths[ 1 ] + lengths[ 2 ]);
+    assert(
+        ( 0U == lengths[ 0 ]) || ( 0U == lengths[ 1 ]) || ( 0U == lengths[ 2 ])
+    );
+
+    {
+        ulog::context_scope const request( "request", "42" );
+        assert( 1U == ulog_context_get()->count );
+    }
+    assert( 0U == ulog_context_get()->count );
+
+    assert( ulog_status_success( ulog->op->verbosity( ulog, DEBUG )));
+    {
+        UTRACE_SCOPE( "scope" );
+        assert( 1U == ulog_trace_.depth );
+        assert( nullptr != std::strstr( formatted, "trace B " ));
+    }
+    assert( 0U == ulog_trace_.depth );
+    assert( nullptr != std::strstr( formatted, "trace E " ));
+
+    /* disabled messages don't evaluate arguments */
+    assert( ulog_status_success( ulog->op->verbosity( ulog, ERROR )));
+    bool evaluated = false;
+    UDEBUG( "%d", ( evaluated = true ));
+    assert( !evaluated );
+
+    /* logging is an expression, e.g. an operand of ?: or comma */
+    !evaluated ? UERROR( "chosen %d", 1 ) : static_cast< void >( 0 );
+    assert( nullptr != std::strstr( formatted, "chosen 1\n" ));
+    UERROR( "first" ), UERROR( "second %d", 2 );
+    assert( nullptr != std::strstr( formatted, "second 2\n" ));
+
+    assert( ulog_status_success( ulog->op->cleanup( ulog )));
+    return 0;
+}
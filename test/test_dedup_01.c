@@ -0,0 +1,150 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Test suppression of duplicate messages #01
+ * \date        2016/02/07 16:02:17 PM
+ * \file        test_dedup_01.c
+ * \version     1.0
+ *
+ *
+ **/
+
+#define _POSIX_C_SOURCE 200809L /* for nanosleep */
+
+#include <ulog/status.h>
+#include <ulog/ulog.h>
+
+#include <assert.h> /* assert */
+#include <errno.h> /* ENOTCONN */
+#include <pthread.h> /* pthread_create, pthread_join, pthread_t */
+#include <stdarg.h> /* va_list */
+#include <stdio.h> /* vsnprintf */
+#include <string.h> /* memset, strstr */
+#include <time.h> /* nanosleep */
+
+static unsigned calls;
+static unsigned summaries;
+static char last[ 256U ];
+
+void
+log_to_buffer(
+    ulog_level const level,
+    char const * const format,
+    va_list args
+)
+{
+    ( void ) level;
+    ++calls;
+    ( void ) vsnprintf( last, sizeof( last ), format, args );
+    if( NULL != strstr( last, "last message repeated" )) { ++summaries; }
+}
+
+static void
+log_many( unsigned const count, unsigned const value )
+{
+    for( unsigned i = 0U; i < count; ++i ) { UINFO( "value %u", value ); }
+}
+
+static void
+log_slowly( unsigned const count, unsigned const value )
+{
+    struct timespec const pause = { .tv_sec = 0, .tv_nsec = 1000000L };
+    for( unsigned i = 0U; i < count; ++i )
+    {
+        UINFO( "value %u", value );
+        ( void ) nanosleep( &pause, NULL );
+    }
+}
+
+static void *
+log_in_thread( void * const arg )
+{
+    log_many( 3U, *( unsigned const * ) arg );
+    return NULL;
+}
+
+static void
+run_thread( unsigned value )
+{
+    pthread_t thread;
+    assert( 0 == pthread_create( &thread, NULL, log_in_thread, &value ));
+    assert( 0 == pthread_join( thread, NULL ));
+}
+
+int
+main( void )
+{
+    ulog_obj const * const ulog = ulog_obj_get();
+    assert( ENOTCONN == ulog_status_to_int( ulog->op->dedup( ulog, 1U )));
+    assert( ulog_status_success( ulog->op->setup( ulog )));
+    assert( ulog_status_success( ulog->op->add( ulog, log_to_buffer )));
+
+    /* disabled by default */
+    log_many( 3U, 1U );
+    assert( 3U == calls );
+
+    calls = 0U;
+    assert( ulog_status_success( ulog->op->dedup( ulog, UINT64_MAX )));
+    log_many( 5U, 1U );
+    assert( 1U == calls );
+    assert( NULL != strstr( last, "value 1" ));
+
+    /* different arguments flush summary first */
+    log_many( 1U, 2U );
+    assert( 3U == calls );
+    assert( NULL != strstr( last, "value 2" ));
+
+    /* different call site is a different record */
+    UINFO( "value %u", 2U );
+    assert( 4U == calls );
+
+    /* summary reports suppressed copies */
+    log_many( 4U, 3U );
+    UINFO( "other" );
+    assert( 7U == calls );
+    assert( NULL != strstr( last, "other" ));
+
+    /* long messages differing only in their tails aren't duplicates */
+    char tail[ 400U ];
+    memset( tail, 'x', sizeof( tail ) - 1U );
+    tail[ sizeof( tail ) - 1U ] = '\0';
+    calls = 0U;
+    for( unsigned i = 0U; i < 3U; ++i )
+    {
+        tail[ sizeof( tail ) - 2U ] = ( i < 2U ) ? ( char ) ( 'a' + i ) : 'b';
+        UINFO( "%s", tail );
+    }
+    assert( 2U == calls );
+    UINFO( "other" );
+    assert( 4U == calls );
+
+    /* short timeout flushes summary on each duplicate */
+    calls = 0U;
+    assert( ulog_status_success( ulog->op->dedup( ulog, 1U )));
+    log_slowly( 3U, 4U );
+    assert( 3U == calls );
+    assert( NULL != strstr( last, "last message repeated 1 times" ));
+
+    /* duplicates of thread which stopped logging are reported by others */
+    assert( ulog_status_success( ulog->op->dedup( ulog, 1000000U )));
+    calls = 0U;
+    summaries = 0U;
+    run_thread( 6U );
+    assert( 1U == calls );
+    struct timespec const pause = { .tv_sec = 0, .tv_nsec = 2000000L };
+    ( void ) nanosleep( &pause, NULL );
+    UINFO( "other" );
+    assert( 3U == calls );
+    assert( 1U == summaries );
+
+    /* summaries with pending duplicates of all threads flushed on cleanup */
+    calls = 0U;
+    summaries = 0U;
+    assert( ulog_status_success( ulog->op->dedup( ulog, UINT64_MAX )));
+    log_many( 2U, 5U );
+    run_thread( 7U );
+    assert( 2U == calls );
+    assert( ulog_status_success( ulog->op->cleanup( ulog )));
+    assert( 4U == calls );
+    assert( 2U == summaries );
+    return 0;
+}
@@ -0,0 +1,86 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Test inline check of log level #01
+ * \date        2016/04/16 09:42:08 AM
+ * \file        test_fast_path_01.c
+ * \version     1.0
+ *
+ *
+ **/
+
+#include <ulog/status.h>
+#include <ulog/ulog.h>
+
+#include <assert.h> /* assert */
+#include <stdarg.h> /* va_list */
+#include <stdbool.h> /* true */
+
+static unsigned calls;
+static unsigned evaluated;
+
+void
+count_calls(
+    ulog_level const level,
+    char const * const format,
+    va_list args
+)
+{
+    ( void ) level;
+    ( void ) format;
+    ( void ) args;
+    ++calls;
+}
+
+static unsigned
+evaluate( void )
+{
+    return ++evaluated;
+}
+
+int
+main( void )
+{
+    ulog_obj const * const ulog = ulog_obj_get();
+    /* nothing is evaluated before setup */
+    assert( -1 == ulog_fast_->threshold );
+    UERROR( "%u", evaluate());
+    assert( 0U == evaluated );
+
+    assert( ulog_status_success( ulog->op->setup( ulog )));
+    assert( ( int ) DEBUG == ulog_fast_->threshold );
+    assert( ulog_status_success( ulog->op->add( ulog, count_calls )));
+    assert( ulog_status_success( ulog->op->verbosity( ulog, WARNING )));
+    assert( ( int ) WARNING == ulog_fast_->threshold );
+    UDEBUG( "%u", evaluate());
+    UINFO( "%u", evaluate());
+    assert( 0U == evaluated );
+    assert( 0U == calls );
+    UWARNING( "%u", evaluate());
+    UERROR( "%u", evaluate());
+    assert( 2U == evaluated );
+    assert( 2U == calls );
+
+    /* statistics count suppressed messages, so they're passed on */
+    assert( ulog_status_success( ulog->op->cleanup( ulog )));
+    assert( -1 == ulog_fast_->threshold );
+    ulog_obj_config const config =
+    {
+        .handlers = ULOG_DEFAULT_HANDLERS,
+        .stats = true
+    };
+    assert( ulog_status_success( ulog->op->configure( ulog, &config )));
+    assert( ulog_status_success( ulog->op->setup( ulog )));
+    assert( ulog_status_success( ulog->op->add( ulog, count_calls )));
+    assert( ulog_status_success( ulog->op->verbosity( ulog, ERROR )));
+    assert( ( int ) DEBUG == ulog_fast_->threshold );
+    UDEBUG( "%u", evaluate());
+    assert( 3U == evaluated );
+    assert( 2U == calls );
+    ulog_handler_stats handler[ 1U ];
+    ulog_stats stats = { .handlers = 1U, .handler = handler };
+    assert( ulog_status_success( ulog->op->stats( ulog, &stats )));
+    assert( 1U == stats.suppressed );
+
+    assert( ulog_status_success( ulog->op->cleanup( ulog )));
+    return 0;
+}
@@ -0,0 +1,316 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Test logging into file of each thread #01
+ * \date        2016/06/02 14:05:36 PM
+ * \file        test_files_01.c
+ * \version     1.0
+ *
+ *
+ **/
+
+#define _POSIX_C_SOURCE 200809L /* for fork, opendir */
+
+#include <ulog/intern.h>
+#include <ulog/merge.h>
+#include <ulog/status.h>
+#include <ulog/ulog.h>
+
+#include <assert.h> /* assert */
+#include <dirent.h> /* closedir, opendir, readdir */
+#include <errno.h> /* EINVAL */
+#include <pthread.h> /* pthread_create, pthread_join, pthread_t */
+#include <stdarg.h> /* va_list */
+#include <stddef.h> /* NULL, size_t */
+#include <inttypes.h> /* SCNu64 */
+#include <stdint.h> /* uint64_t */
+#include <stdio.h> /* FILE, fclose, fgets, fopen, remove, snprintf, etc. */
+#include <stdlib.h> /* EXIT_FAILURE, EXIT_SUCCESS, _Exit */
+#include <string.h> /* strcmp, strlen, strncmp, strstr */
+#include <sys/types.h> /* pid_t */
+#include <sys/wait.h> /* WEXITSTATUS, WIFEXITED, waitpid */
+#include <unistd.h> /* fork */
+
+#define BASE "test_files_01"
+#define THREADS 4U
+#define MESSAGES 1000U
+#define MAXIMUM_FILES 16U
+
+static unsigned handled;
+static char paths[ MAXIMUM_FILES ][ 64U ];
+
+void
+count_handled(
+    ulog_level const level,
+    char const * const format,
+    va_list args
+)
+{
+    ( void ) level;
+    ( void ) format;
+    ( void ) args;
+    __atomic_add_fetch( &handled, 1U, __ATOMIC_RELAXED );
+}
+
+static void *
+log_messages( void * const arg )
+{
+    unsigned const thread = *( unsigned const * ) arg;
+    for( unsigned i = 0U; i < MESSAGES; ++i )
+    {
+        UINFO( "thread %u message %u", thread, i );
+    }
+    return NULL;
+}
+
+static size_t
+find_files( void )
+{
+    DIR * const directory = opendir( "." );
+    assert( NULL != directory );
+    size_t found = 0U;
+    for( struct dirent * entry; NULL != ( entry = readdir( directory )); )
+    {
+        size_t const length = strlen( entry->d_name );
+        if(
+            ( 0 == strncmp( BASE ".", entry->d_name, strlen( BASE "." )))
+            && ( 4U < length )
+            && (
+                ( 0 == strcmp( ".log", entry->d_name + length - 4U ))
+                || ( 0 == strcmp( ".uli", entry->d_name + length - 4U ))
+            )
+        )
+        {
+            assert( MAXIMUM_FILES > found );
+            snprintf(
+                paths[ found++ ],
+                sizeof( paths[ 0 ]),
+                "%s",
+                entry->d_name
+            );
+        }
+    }
+    assert( 0 == closedir( directory ));
+    return found;
+}
+
+static void
+remove_files( void )
+{
+    size_t const count = find_files();
+    for( size_t i = 0U; i < count; ++i )
+    {
+        assert( 0 == remove( paths[ i ]));
+    }
+}
+
+/* records of each thread are in its file alone, in order of logging */
+static unsigned
+check_file( char const * const path )
+{
+    FILE * const file = fopen( path, "r" );
+    assert( NULL != file );
+    char line[ ULOG_RECORD_SIZE ];
+    unsigned lines = 0U;
+    unsigned first = THREADS + 1U;
+    while( NULL != fgets( line, sizeof( line ), file ))
+    {
+        unsigned thread = 0U;
+        unsigned message = 0U;
+        char const * const text = strstr( line, "thread " );
+        assert( NULL != text );
+        assert( 2 == sscanf( text, "thread %u message %u", &thread, &message ));
+        if( 0U == lines ) { first = thread; }
+        assert( first == thread );
+        assert( lines % MESSAGES == message );
+        ++lines;
+    }
+    assert( 0 == fclose( file ));
+    return lines;
+}
+
+static void
+test_threads( ulog_obj const * const ulog )
+{
+    /* buffer holding a single record is written after each of them */
+    ulog_files_config const config = { .base = BASE, .buffer = 1U };
+    assert( ulog_status_success( ulog->op->files( ulog, &config )));
+    pthread_t threads[ THREADS ];
+    unsigned numbers[ THREADS ];
+    for( unsigned i = 0U; i < THREADS; ++i )
+    {
+        numbers[ i ] = i;
+        assert(
+            0 == pthread_create( threads + i, NULL, log_messages, numbers + i )
+        );
+    }
+    unsigned main_number = THREADS;
+    ( void ) log_messages( &main_number );
+    for( unsigned i = 0U; i < THREADS; ++i )
+    {
+        assert( 0 == pthread_join( threads[ i ], NULL ));
+    }
+    /* files of exited threads are already complete */
+    assert( THREADS + 1U == find_files());
+    assert( ulog_status_success( ulog->op->files( ulog, NULL )));
+
+    size_t const count = find_files();
+    assert( THREADS + 1U == count );
+    for( size_t i = 0U; i < count; ++i )
+    {
+        assert( MESSAGES == check_file( paths[ i ]));
+    }
+    char const * merged[ MAXIMUM_FILES ];
+    for( size_t i = 0U; i < count; ++i ) { merged[ i ] = paths[ i ]; }
+    FILE * const output = tmpfile();
+    assert( NULL != output );
+    uint64_t records = 0U;
+    assert(
+        ulog_status_success( ulog_merge( merged, count, output, &records ))
+    );
+    assert(( THREADS + 1U ) * MESSAGES == records );
+    assert( 0 == fclose( output ));
+    remove_files();
+}
+
+/* interned files are read back as text lines, ordered by time */
+static void
+test_interned( ulog_obj const * const ulog )
+{
+    ulog_files_config const config =
+    {
+        .base = BASE,
+        .buffer = 1U,
+        .interned = true
+    };
+    assert( ulog_status_success( ulog->op->files( ulog, &config )));
+    pthread_t threads[ THREADS ];
+    unsigned numbers[ THREADS ];
+    for( unsigned i = 0U; i < THREADS; ++i )
+    {
+        numbers[ i ] = i;
+        assert(
+            0 == pthread_create( threads + i, NULL, log_messages, numbers + i )
+        );
+    }
+    for( unsigned i = 0U; i < THREADS; ++i )
+    {
+        assert( 0 == pthread_join( threads[ i ], NULL ));
+    }
+    /* message of unknown types is interned as its text */
+    ulog_( WARNING, "[W][%u][a.c:f:1] untyped %s\n", 1U, "text" );
+    assert( ulog_status_success( ulog->op->files( ulog, NULL )));
+
+    size_t const count = find_files();
+    assert( THREADS + 1U == count );
+    char const * merged[ MAXIMUM_FILES ];
+    for( size_t i = 0U; i < count; ++i )
+    {
+        merged[ i ] = paths[ i ];
+        FILE * const file = fopen( paths[ i ], "rb" );
+        assert( NULL != file );
+        unsigned char start[ 64U ];
+        size_t const size = fread( start, 1U, sizeof( start ), file );
+        assert( 0 == fclose( file ));
+        assert( ulog_interned( start, size ));
+    }
+    FILE * const output = tmpfile();
+    assert( NULL != output );
+    uint64_t records = 0U;
+    assert(
+        ulog_status_success( ulog_merge( merged, count, output, &records ))
+    );
+    assert( THREADS * MESSAGES + 1U == records );
+    rewind( output );
+    char line[ ULOG_RECORD_SIZE ];
+    assert( NULL != fgets( line, sizeof( line ), output ));
+    assert( 0 == strcmp( "[W][1][a.c:f:1] untyped text\n", line ));
+    uint64_t last = 0U;
+    unsigned next[ THREADS ] = { 0U };
+    while( NULL != fgets( line, sizeof( line ), output ))
+    {
+        uint64_t time = 0U;
+        unsigned thread = THREADS;
+        unsigned message = 0U;
+        char const * const text = strstr( line, "thread " );
+        assert( NULL != text );
+        assert( 1 == sscanf( line, "[I][%" SCNu64, &time ));
+        assert( 2 == sscanf( text, "thread %u message %u", &thread, &message ));
+        assert( last <= time );
+        assert(( THREADS > thread ) && ( next[ thread ]++ == message ));
+        last = time;
+    }
+    assert( 0 == fclose( output ));
+    remove_files();
+}
+
+static void
+test_fork( ulog_obj const * const ulog )
+{
+    ulog_files_config const config = { .base = BASE };
+    assert( ulog_status_success( ulog->op->files( ulog, &config )));
+    UINFO( "thread %u message %u", 0U, 0U );
+    pid_t const child = fork();
+    assert( -1 != child );
+    if( 0 == child )
+    {
+        /* buffer of the parent isn't written again by the child */
+        UINFO( "thread %u message %u", 1U, 0U );
+        _Exit(
+            ulog_status_success( ulog->op->cleanup( ulog ))
+                ? EXIT_SUCCESS
+                : EXIT_FAILURE
+        );
+    }
+    int status = 0;
+    assert( child == waitpid( child, &status, 0 ));
+    assert( WIFEXITED( status ) && ( EXIT_SUCCESS == WEXITSTATUS( status )));
+    assert( ulog_status_success( ulog->op->files( ulog, NULL )));
+
+    size_t const count = find_files();
+    assert( 2U == count );
+    for( size_t i = 0U; i < count; ++i )
+    {
+        assert( 1U == check_file( paths[ i ]));
+    }
+    char child_path[ 64U ];
+    snprintf(
+        child_path,
+        sizeof( child_path ),
+        BASE ".%ld.log",
+        ( long ) child
+    );
+    assert(
+        ( 0 == strcmp( child_path, paths[ 0 ]))
+        || ( 0 == strcmp( child_path, paths[ 1 ]))
+    );
+    remove_files();
+}
+
+int
+main( void )
+{
+    remove_files();
+    ulog_obj const * const ulog = ulog_obj_get();
+    assert( ulog_status_success( ulog->op->setup( ulog )));
+    assert( ulog_status_success( ulog->op->add( ulog, count_handled )));
+    ulog_files_config const invalid = { .base = "" };
+    assert(
+        EINVAL == ulog_status_to_int( ulog->op->files( ulog, &invalid ))
+    );
+    test_threads( ulog );
+    test_interned( ulog );
+    test_fork( ulog );
+    /* records went to files instead of handlers */
+    assert( 0U == handled );
+    UINFO( "to handlers again" );
+    assert( 1U == handled );
+    /* cleanup writes files still in use */
+    ulog_files_config const config = { .base = BASE };
+    assert( ulog_status_success( ulog->op->files( ulog, &config )));
+    UINFO( "thread %u message %u", 0U, 0U );
+    assert( ulog_status_success( ulog->op->cleanup( ulog )));
+    assert( 1U == find_files());
+    assert( 1U == check_file( paths[ 0 ]));
+    remove_files();
+    return 0;
+}
@@ -0,0 +1,383 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Test logging into compressed file of each thread #02
+ * \date        2016/06/06 15:47:29 PM
+ * \file        test_files_02.c
+ * \version     1.0
+ *
+ *
+ **/
+
+#define _POSIX_C_SOURCE 200809L /* for fork, opendir */
+
+#include <ulog/compress.h>
+#include <ulog/grep.h>
+#include <ulog/intern.h>
+#include <ulog/merge.h>
+#include <ulog/status.h>
+#include <ulog/ulog.h>
+
+#include <assert.h> /* assert */
+#include <dirent.h> /* closedir, opendir, readdir */
+#include <fcntl.h> /* O_RDONLY, open */
+#include <pthread.h> /* pthread_create, pthread_join, pthread_t */
+#include <stdbool.h> /* true */
+#include <stddef.h> /* NULL, size_t */
+#include <stdint.h> /* uint64_t */
+#include <stdio.h> /* FILE, fclose, fopen, fwrite, remove, snprintf, etc. */
+#include <stdlib.h> /* EXIT_FAILURE, EXIT_SUCCESS, _Exit, free, malloc */
+#include <string.h> /* memchr, strcmp, strlen, strncmp, strstr */
+#include <sys/stat.h> /* fstat, struct stat */
+#include <sys/types.h> /* pid_t */
+#include <sys/wait.h> /* WEXITSTATUS, WIFEXITED, waitpid */
+#include <unistd.h> /* close, fork, read */
+
+#define BASE "test_files_02"
+#define THREADS 4U
+#define MESSAGES 1000U
+#define MAXIMUM_FILES 16U
+
+static char paths[ MAXIMUM_FILES ][ 64U ];
+
+static void *
+log_messages( void * const arg )
+{
+    unsigned const thread = *( unsigned const * ) arg;
+    for( unsigned i = 0U; i < MESSAGES; ++i )
+    {
+        UINFO( "thread %u message %u", thread, i );
+    }
+    return NULL;
+}
+
+static size_t
+find_files( void )
+{
+    DIR * const directory = opendir( "." );
+    assert( NULL != directory );
+    size_t found = 0U;
+    for( struct dirent * entry; NULL != ( entry = readdir( directory )); )
+    {
+        size_t const length = strlen( entry->d_name );
+        if(
+            ( 0 == strncmp( BASE ".", entry->d_name, strlen( BASE "." )))
+            && ( 4U < length )
+            && ( 0 == strcmp( ".ulz", entry->d_name + length - 4U ))
+        )
+        {
+            assert( MAXIMUM_FILES > found );
+            snprintf(
+                paths[ found++ ],
+                sizeof( paths[ 0 ]),
+                "%s",
+                entry->d_name
+            );
+        }
+    }
+    assert( 0 == closedir( directory ));
+    return found;
+}
+
+static void
+remove_files( void )
+{
+    size_t const count = find_files();
+    for( size_t i = 0U; i < count; ++i )
+    {
+        assert( 0 == remove( paths[ i ]));
+    }
+}
+
+/* returns contents of compressed file, sets sizes before and after */
+static char *
+decompress_file(
+    char const * const path,
+    size_t * const stored,
+    size_t * const length
+)
+{
+    int const file = open( path, O_RDONLY );
+    assert( -1 != file );
+    struct stat status;
+    assert( 0 == fstat( file, &status ));
+    *stored = ( size_t ) status.st_size;
+    unsigned char * const blocks = malloc( *stored + 1U );
+    assert( NULL != blocks );
+    assert(( ssize_t ) *stored == read( file, blocks, *stored ));
+    assert( 0 == close( file ));
+    assert( ulog_compressed( blocks, *stored ));
+    void * data = NULL;
+    assert(
+        ulog_status_success(
+            ulog_decompress( blocks, *stored, 0U, &data, length )
+        )
+    );
+    free( blocks );
+    return data;
+}
+
+/* records of each thread are in its file alone, in order of logging */
+static unsigned
+check_file( char const * const path )
+{
+    size_t stored = 0U;
+    size_t length = 0U;
+    char * const text = decompress_file( path, &stored, &length );
+    unsigned lines = 0U;
+    unsigned first = THREADS + 1U;
+    for( char const * line = text; text + length > line; )
+    {
+        char const * const end =
+            memchr( line, '\n', ( size_t ) ( text + length - line ));
+        assert( NULL != end );
+        unsigned thread = 0U;
+        unsigned message = 0U;
+        char const * const found = strstr( line, "thread " );
+        assert(( NULL != found ) && ( end > found ));
+        assert(
+            2 == sscanf( found, "thread %u message %u", &thread, &message )
+        );
+        if( 0U == lines ) { first = thread; }
+        assert( first == thread );
+        assert( lines % MESSAGES == message );
+        ++lines;
+        line = end + 1;
+    }
+    free( text );
+    return lines;
+}
+
+static void
+test_threads( ulog_obj const * const ulog )
+{
+    /* each record is a block of its own */
+    ulog_files_config const config =
+    {
+        .base = BASE,
+        .buffer = 1U,
+        .compress = true
+    };
+    assert( ulog_status_success( ulog->op->files( ulog, &config )));
+    pthread_t threads[ THREADS ];
+    unsigned numbers[ THREADS ];
+    for( unsigned i = 0U; i < THREADS; ++i )
+    {
+        numbers[ i ] = i;
+        assert(
+            0 == pthread_create( threads + i, NULL, log_messages, numbers + i )
+        );
+    }
+    unsigned main_number = THREADS;
+    ( void ) log_messages( &main_number );
+    for( unsigned i = 0U; i < THREADS; ++i )
+    {
+        assert( 0 == pthread_join( threads[ i ], NULL ));
+    }
+    assert( ulog_status_success( ulog->op->files( ulog, NULL )));
+
+    size_t const count = find_files();
+    assert( THREADS + 1U == count );
+    for( size_t i = 0U; i < count; ++i )
+    {
+        assert( MESSAGES == check_file( paths[ i ]));
+    }
+    /* readers decompress files themselves */
+    char const * merged[ MAXIMUM_FILES ];
+    for( size_t i = 0U; i < count; ++i ) { merged[ i ] = paths[ i ]; }
+    FILE * const output = tmpfile();
+    assert( NULL != output );
+    uint64_t records = 0U;
+    assert(
+        ulog_status_success( ulog_merge( merged, count, output, &records ))
+    );
+    assert(( THREADS + 1U ) * MESSAGES == records );
+    ulog_grep_config const criteria = { .pattern = "message 999" };
+    for( size_t i = 0U; i < count; ++i )
+    {
+        assert(
+            ulog_status_success(
+                ulog_grep( paths[ i ], &criteria, output, &records )
+            )
+        );
+        assert( 1U == records );
+    }
+    assert( 0 == fclose( output ));
+    remove_files();
+}
+
+/* full buffers are compressed into blocks a fraction of their size */
+static void
+test_ratio( ulog_obj const * const ulog )
+{
+    ulog_files_config const config = { .base = BASE, .compress = true };
+    assert( ulog_status_success( ulog->op->files( ulog, &config )));
+    unsigned number = 0U;
+    for( unsigned i = 0U; i < 20U; ++i ) { ( void ) log_messages( &number ); }
+    assert( ulog_status_success( ulog->op->files( ulog, NULL )));
+    assert( 1U == find_files());
+    size_t stored = 0U;
+    size_t length = 0U;
+    free( decompress_file( paths[ 0 ], &stored, &length ));
+    assert( 3U * stored < length );
+    /* readers stream blocks, records may span them */
+    char const * const merged[] = { paths[ 0 ] };
+    FILE * const output = tmpfile();
+    assert( NULL != output );
+    uint64_t records = 0U;
+    assert( ulog_status_success( ulog_merge( merged, 1U, output, &records )));
+    assert( 20U * MESSAGES == records );
+    ulog_grep_config const criteria =
+    {
+        .pattern = "message 999",
+        .threads = 2U,
+        .chunk = 4096U
+    };
+    assert(
+        ulog_status_success(
+            ulog_grep( paths[ 0 ], &criteria, output, &records )
+        )
+    );
+    assert( 20U == records );
+    assert( 0 == fclose( output ));
+    remove_files();
+}
+
+/* interned files are compressed block by block, as text ones are */
+static void
+test_interned( ulog_obj const * const ulog )
+{
+    ulog_files_config const config =
+    {
+        .base = BASE,
+        .buffer = 4096U,
+        .compress = true,
+        .interned = true
+    };
+    assert( ulog_status_success( ulog->op->files( ulog, &config )));
+    unsigned number = 0U;
+    for( unsigned i = 0U; i < 20U; ++i ) { ( void ) log_messages( &number ); }
+    assert( ulog_status_success( ulog->op->files( ulog, NULL )));
+    assert( 1U == find_files());
+    size_t stored = 0U;
+    size_t length = 0U;
+    char * const stream = decompress_file( paths[ 0 ], &stored, &length );
+    assert( ulog_interned( stream, length ));
+    free( stream );
+    char const * const merged[] = { paths[ 0 ] };
+    FILE * const output = tmpfile();
+    assert( NULL != output );
+    uint64_t records = 0U;
+    assert( ulog_status_success( ulog_merge( merged, 1U, output, &records )));
+    assert( 20U * MESSAGES == records );
+    rewind( output );
+    char line[ ULOG_RECORD_SIZE ];
+    for( unsigned i = 0U; NULL != fgets( line, sizeof( line ), output ); ++i )
+    {
+        char expected[ 64U ];
+        snprintf(
+            expected,
+            sizeof( expected ),
+            "] thread 0 message %u\n",
+            i % MESSAGES
+        );
+        assert( NULL != strstr( line, expected ));
+    }
+    assert( 0 == fclose( output ));
+    remove_files();
+}
+
+/* the last block may be still being written, readers stop before it */
+static void
+test_truncated( ulog_obj const * const ulog )
+{
+    ulog_files_config const config =
+    {
+        .base = BASE,
+        .buffer = 1U,
+        .compress = true
+    };
+    assert( ulog_status_success( ulog->op->files( ulog, &config )));
+    unsigned number = 0U;
+    ( void ) log_messages( &number );
+    assert( ulog_status_success( ulog->op->files( ulog, NULL )));
+    assert( 1U == find_files());
+    int const file = open( paths[ 0 ], O_RDONLY );
+    assert( -1 != file );
+    struct stat status;
+    assert( 0 == fstat( file, &status ));
+    size_t const size = ( size_t ) status.st_size;
+    unsigned char * const blocks = malloc( size );
+    assert( NULL != blocks );
+    assert(( ssize_t ) size == read( file, blocks, size ));
+    assert( 0 == close( file ));
+    char const * const truncated[] = { BASE ".truncated.ulz" };
+    FILE * const copy = fopen( truncated[ 0 ], "wb" );
+    assert( NULL != copy );
+    assert( 1U == fwrite( blocks, size - 1U, 1U, copy ));
+    assert( 0 == fclose( copy ));
+    free( blocks );
+
+    FILE * const output = tmpfile();
+    assert( NULL != output );
+    uint64_t records = 0U;
+    assert(
+        ulog_status_success( ulog_merge( truncated, 1U, output, &records ))
+    );
+    assert( MESSAGES - 1U == records );
+    ulog_grep_config const criteria = { .pattern = "message 99" };
+    assert(
+        ulog_status_success(
+            ulog_grep( truncated[ 0 ], &criteria, output, &records )
+        )
+    );
+    /* message 99 and 990 to 998 */
+    assert( 10U == records );
+    assert( 0 == fclose( output ));
+    remove_files();
+}
+
+static void
+test_fork( ulog_obj const * const ulog )
+{
+    ulog_files_config const config = { .base = BASE, .compress = true };
+    assert( ulog_status_success( ulog->op->files( ulog, &config )));
+    UINFO( "thread %u message %u", 0U, 0U );
+    pid_t const child = fork();
+    assert( -1 != child );
+    if( 0 == child )
+    {
+        /* new compressing thread writes blocks of the child */
+        UINFO( "thread %u message %u", 1U, 0U );
+        _Exit(
+            ulog_status_success( ulog->op->cleanup( ulog ))
+                ? EXIT_SUCCESS
+                : EXIT_FAILURE
+        );
+    }
+    int status = 0;
+    assert( child == waitpid( child, &status, 0 ));
+    assert( WIFEXITED( status ) && ( EXIT_SUCCESS == WEXITSTATUS( status )));
+    assert( ulog_status_success( ulog->op->files( ulog, NULL )));
+    size_t const count = find_files();
+    assert( 2U == count );
+    for( size_t i = 0U; i < count; ++i )
+    {
+        assert( 1U == check_file( paths[ i ]));
+    }
+    remove_files();
+}
+
+int
+main( void )
+{
+    remove_files();
+    ulog_obj const * const ulog = ulog_obj_get();
+    assert( ulog_status_success( ulog->op->setup( ulog )));
+    test_threads( ulog );
+    test_ratio( ulog );
+    test_interned( ulog );
+    test_truncated( ulog );
+    test_fork( ulog );
+    assert( ulog_status_success( ulog->op->cleanup( ulog )));
+    return 0;
+}
@@ -0,0 +1,273 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Test logging across fork #01
+ * \date        2016/05/29 10:42:17 AM
+ * \file        test_fork_01.c
+ * \version     1.0
+ *
+ *
+ **/
+
+#define _POSIX_C_SOURCE 200809L /* for fork, getpid */
+
+#include <ulog/shared.h>
+#include <ulog/status.h>
+#include <ulog/ulog.h>
+
+#include <assert.h> /* assert */
+#include <pthread.h> /* pthread_create, pthread_join, pthread_t */
+#include <stdarg.h> /* va_arg, va_list */
+#include <stdbool.h> /* bool */
+#include <stddef.h> /* NULL */
+#include <stdio.h> /* snprintf */
+#include <stdlib.h> /* _Exit */
+#include <string.h> /* strcmp, strstr */
+#include <sys/types.h> /* pid_t */
+#include <sys/wait.h> /* WEXITSTATUS, WIFEXITED, waitpid */
+#include <unistd.h> /* fork, getpid */
+
+#define LOGGERS 2
+#define FORKS 20
+
+static unsigned direct;
+static unsigned queued;
+static unsigned from_children;
+static bool stop;
+
+void
+count_direct(
+    ulog_level const level,
+    char const * const format,
+    va_list args
+)
+{
+    ( void ) level;
+    ( void ) format;
+    ( void ) args;
+    __atomic_add_fetch( &direct, 1U, __ATOMIC_RELAXED );
+}
+
+void
+count_queued(
+    ulog_level const level,
+    char const * const format,
+    va_list args
+)
+{
+    ( void ) level;
+    ( void ) format;
+    ( void ) args;
+    __atomic_add_fetch( &queued, 1U, __ATOMIC_RELAXED );
+}
+
+void
+count_children(
+    ulog_level const level,
+    char const * const format,
+    va_list args
+)
+{
+    ( void ) level;
+    if(
+        ( 0 == strcmp( "%s", format ))
+        && ( NULL != strstr( va_arg( args, char const * ), "from child" ))
+    )
+    {
+        ++from_children;
+    }
+}
+
+static void *
+keep_logging( void * const unused )
+{
+    ( void ) unused;
+    while( !__atomic_load_n( &stop, __ATOMIC_ACQUIRE ))
+    {
+        UINFO( "parent" );
+    }
+    return NULL;
+}
+
+static void *
+log_once( void * const unused )
+{
+    ( void ) unused;
+    UINFO( "parent" );
+    return NULL;
+}
+
+/* threads listed for duplicate suppression come and go while forking */
+static void *
+keep_listing( void * const unused )
+{
+    ( void ) unused;
+    while( !__atomic_load_n( &stop, __ATOMIC_ACQUIRE ))
+    {
+        pthread_t thread;
+        if( 0 == pthread_create( &thread, NULL, log_once, NULL ))
+        {
+            assert( 0 == pthread_join( thread, NULL ));
+        }
+    }
+    return NULL;
+}
+
+/* child delivers its own records through threads of its own */
+static void
+log_in_child( ulog_obj const * const ulog )
+{
+    unsigned const direct_before =
+        __atomic_load_n( &direct, __ATOMIC_RELAXED );
+    unsigned const queued_before =
+        __atomic_load_n( &queued, __ATOMIC_RELAXED );
+    UINFO( "child" );
+    bool const cleaned = ulog_status_success( ulog->op->cleanup( ulog ));
+    _Exit(
+        cleaned
+        && ( direct_before + 1U == direct )
+        && ( queued_before + 1U == queued )
+        ? 0 : 1
+    );
+}
+
+static void
+test_threads( bool const adaptive )
+{
+    ulog_obj const * const ulog = ulog_obj_get();
+    ulog_obj_config const config =
+    {
+        .handlers = ULOG_DEFAULT_HANDLERS,
+        .adaptive = adaptive
+    };
+    ulog_async_config const channel =
+    {
+        .capacity = 64U,
+        .policy = ULOG_BLOCK,
+        .timeout = 1000000000U
+    };
+    assert( ulog_status_success( ulog->op->configure( ulog, &config )));
+    assert( ulog_status_success( ulog->op->setup( ulog )));
+    assert( ulog_status_success( ulog->op->add( ulog, count_direct )));
+    assert(
+        ulog_status_success(
+            ulog->op->add_async( ulog, count_queued, &channel )
+        )
+    );
+    assert( ulog_status_success( ulog->op->async( ulog, &channel )));
+
+    __atomic_store_n( &stop, false, __ATOMIC_RELEASE );
+    pthread_t loggers[ LOGGERS ];
+    for( int i = 0; i < LOGGERS; ++i )
+    {
+        assert(
+            0 == pthread_create( &( loggers[ i ] ), NULL, keep_logging, NULL )
+        );
+    }
+    for( int i = 0; i < FORKS; ++i )
+    {
+        pid_t const child = fork();
+        assert( -1 != child );
+        if( 0 == child ) { log_in_child( ulog ); }
+        int status = 0;
+        assert( child == waitpid( child, &status, 0 ));
+        assert( WIFEXITED( status ) && ( 0 == WEXITSTATUS( status )));
+    }
+    __atomic_store_n( &stop, true, __ATOMIC_RELEASE );
+    for( int i = 0; i < LOGGERS; ++i )
+    {
+        assert( 0 == pthread_join( loggers[ i ], NULL ));
+    }
+    /* parent kept logging through fork and delivers all it queued */
+    assert( ulog_status_success( ulog->op->cleanup( ulog )));
+    assert( direct == queued );
+    assert( 0U < direct );
+}
+
+/* child walks the list of threads when it sweeps their duplicates */
+static void
+test_dedup( void )
+{
+    ulog_obj const * const ulog = ulog_obj_get();
+    assert( ulog_status_success( ulog->op->setup( ulog )));
+    assert( ulog_status_success( ulog->op->add( ulog, count_direct )));
+    assert( ulog_status_success( ulog->op->dedup( ulog, 1000000U )));
+
+    __atomic_store_n( &stop, false, __ATOMIC_RELEASE );
+    pthread_t listers[ LOGGERS ];
+    for( int i = 0; i < LOGGERS; ++i )
+    {
+        assert(
+            0 == pthread_create( &( listers[ i ] ), NULL, keep_listing, NULL )
+        );
+    }
+    for( int i = 0; i < FORKS; ++i )
+    {
+        pid_t const child = fork();
+        assert( -1 != child );
+        if( 0 == child )
+        {
+            UINFO( "child" );
+            UINFO( "child" );
+            _Exit( ulog_status_success( ulog->op->cleanup( ulog )) ? 0 : 1 );
+        }
+        int status = 0;
+        assert( child == waitpid( child, &status, 0 ));
+        assert( WIFEXITED( status ) && ( 0 == WEXITSTATUS( status )));
+    }
+    __atomic_store_n( &stop, true, __ATOMIC_RELEASE );
+    for( int i = 0; i < LOGGERS; ++i )
+    {
+        assert( 0 == pthread_join( listers[ i ], NULL ));
+    }
+    assert( ulog_status_success( ulog->op->cleanup( ulog )));
+}
+
+/* children of the collector write into its ring, as pre-forked workers */
+static void
+test_ring( char const * const name )
+{
+    ulog_obj const * const ulog = ulog_obj_get();
+    ulog_ring_config const config =
+    {
+        .name = name,
+        .capacity = 64U,
+        .collect = true
+    };
+    assert( ulog_status_success( ulog->op->setup( ulog )));
+    assert( ulog_status_success( ulog->op->add( ulog, count_children )));
+    assert( ulog_status_success( ulog->op->ring( ulog, &config )));
+    for( int i = 0; i < FORKS; ++i )
+    {
+        pid_t const child = fork();
+        assert( -1 != child );
+        if( 0 == child )
+        {
+            UINFO( "from child %d", i );
+            _Exit( ulog_status_success( ulog->op->cleanup( ulog )) ? 0 : 1 );
+        }
+        int status = 0;
+        assert( child == waitpid( child, &status, 0 ));
+        assert( WIFEXITED( status ) && ( 0 == WEXITSTATUS( status )));
+    }
+    assert( ulog_status_success( ulog->op->ring( ulog, NULL )));
+    assert( FORKS == from_children );
+    assert( ulog_status_success( ulog->op->cleanup( ulog )));
+    assert( ulog_status_success( ulog_shared_remove( name )));
+}
+
+int
+main( void )
+{
+    test_threads( false );
+    test_threads( true );
+    test_dedup();
+    char name[ 64U ];
+    ( void ) snprintf(
+        name,
+        sizeof( name ),
+        "/ulog_fork_%ld",
+        ( long ) getpid()
+    );
+    test_ring( name );
+    return 0;
+}
@@ -0,0 +1,184 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Test parallel search of logged records #01
+ * \date        2016/05/30 16:08:52 PM
+ * \file        test_grep_01.c
+ * \version     1.0
+ *
+ *
+ **/
+
+#define _POSIX_C_SOURCE 200809L /* for getpid */
+
+#include <ulog/grep.h>
+#include <ulog/status.h>
+#include <ulog/ulog.h>
+
+#include <assert.h> /* assert */
+#include <errno.h> /* EINVAL, EIO, ENODATA */
+#include <stddef.h> /* NULL, size_t */
+#include <stdint.h> /* uint64_t */
+#include <stdio.h> /* FILE, fclose, fopen, fprintf, fread, remove, etc. */
+#include <string.h> /* strcmp, strlen, strstr */
+#include <unistd.h> /* getpid */
+
+#define BLOCKS 500U
+
+static uint64_t
+grep(
+    char const * const path,
+    ulog_grep_config const * const config,
+    char * const output,
+    size_t const size
+)
+{
+    FILE * const matches = tmpfile();
+    assert( NULL != matches );
+    uint64_t matched = 0U;
+    assert( ulog_status_success( ulog_grep( path, config, matches, &matched )));
+    rewind( matches );
+    size_t const read = fread( output, 1U, size - 1U, matches );
+    output[ read ] = '\0';
+    ( void ) fclose( matches );
+    return matched;
+}
+
+static void
+test_text( char const * const path )
+{
+    FILE * const file = fopen( path, "w" );
+    assert( NULL != file );
+    for( unsigned i = 0U; i < BLOCKS; ++i )
+    {
+        fprintf( file, "[I][%u][a.c:f:1] alpha %u\n", 1000U + i, i );
+        fprintf( file, "[E][%u][a.c:f:2] beta alpha\n", 2000U + i );
+        fprintf( file, "no header alpha\n" );
+    }
+    fprintf( file, "[W][3000][a.c:f:3] gamma" );
+    assert( 0 == fclose( file ));
+
+    static char output[ 64U * 1024U ];
+    ulog_grep_config config =
+    {
+        .pattern = "alpha",
+        .threads = 3U,
+        .chunk = 100U
+    };
+    assert( 3U * BLOCKS == grep( path, &config, output, sizeof( output )));
+    /* matches come in file order, whichever thread found them */
+    assert( output == strstr( output, "[I][1000][a.c:f:1] alpha 0\n" ));
+    assert( NULL != strstr( output, "alpha 1\n[E][2001]" ));
+    assert( NULL == strstr( output, "gamma" ));
+
+    config.levels = "E";
+    assert( BLOCKS == grep( path, &config, output, sizeof( output )));
+    config.levels = NULL;
+    config.since = 1010U;
+    config.until = 2004U;
+    assert(
+        ( BLOCKS - 10U ) + 5U
+        == grep( path, &config, output, sizeof( output ))
+    );
+    config.pattern = "";
+    config.levels = "W";
+    config.since = 0U;
+    config.until = 0U;
+    assert( 1U == grep( path, &config, output, sizeof( output )));
+    assert( 0 == strcmp( "[W][3000][a.c:f:3] gamma\n", output ));
+    config.pattern = "nowhere";
+    config.levels = NULL;
+    config.threads = 0U;
+    config.chunk = 0U;
+    assert( 0U == grep( path, &config, output, sizeof( output )));
+
+    assert(
+        ENODATA
+        == ulog_status_to_int( ulog_grep( path, NULL, stdout, NULL ))
+    );
+    assert(
+        EIO
+        == ulog_status_to_int(
+            ulog_grep( "test_grep_01.missing", &config, stdout, NULL )
+        )
+    );
+}
+
+/* records of interned file are matched as lines they're decoded into */
+static void
+test_interned( void )
+{
+    ulog_obj const * const ulog = ulog_obj_get();
+    assert( ulog_status_success( ulog->op->setup( ulog )));
+    ulog_files_config const files =
+    {
+        .base = "test_grep_01",
+        .interned = true
+    };
+    assert( ulog_status_success( ulog->op->files( ulog, &files )));
+    uint64_t const start = ulog_current_time_();
+    for( unsigned i = 0U; i < BLOCKS; ++i )
+    {
+        UINFO( "alpha %u", i );
+        UERROR( "beta %s", "delta" );
+    }
+    ulog_( WARNING, "untyped %s\n", "delta" );
+    assert( ulog_status_success( ulog->op->cleanup( ulog )));
+    char path[ 64U ];
+    snprintf( path, sizeof( path ), "test_grep_01.%ld.uli", ( long ) getpid());
+
+    static char output[ 256U * 1024U ];
+    ulog_grep_config config =
+    {
+        .pattern = "delta",
+        .threads = 4U,
+        .chunk = 1000U
+    };
+    assert( BLOCKS + 1U == grep( path, &config, output, sizeof( output )));
+    assert( output == strstr( output, "[E][" ));
+    assert( NULL != strstr( output, "] beta delta\n[E][" ));
+    size_t const length = strlen( output );
+    assert( 0 == strcmp( "untyped delta\n", output + length - 14U ));
+    /* pattern may span interned strings and arguments */
+    config.pattern = ":test_interned:";
+    assert( 2U * BLOCKS == grep( path, &config, output, sizeof( output )));
+    config.pattern = "] alpha 499\n";
+    assert( 1U == grep( path, &config, output, sizeof( output )));
+
+    config.pattern = NULL;
+    config.levels = "I";
+    config.since = start;
+    assert( BLOCKS == grep( path, &config, output, sizeof( output )));
+    config.until = start - 1U;
+    config.since = 1U;
+    assert( 0U == grep( path, &config, output, sizeof( output )));
+
+    /* the last record may be still being written, it ends the file */
+    FILE * const truncated = fopen( path, "ab" );
+    assert( NULL != truncated );
+    assert( 3U == fwrite( "\2\1\0", 1U, 3U, truncated ));
+    assert( 0 == fclose( truncated ));
+    config.levels = NULL;
+    config.since = 0U;
+    config.until = 0U;
+    assert( 2U * BLOCKS + 1U == grep( path, &config, output, sizeof( output )));
+    FILE * const malformed = fopen( path, "ab" );
+    assert( NULL != malformed );
+    /* which makes it a record shorter than its own header */
+    assert( 2U == fwrite( "\0\0", 1U, 2U, malformed ));
+    assert( 0 == fclose( malformed ));
+    assert(
+        EINVAL
+        == ulog_status_to_int( ulog_grep( path, &config, stdout, NULL ))
+    );
+    assert( 0 == remove( path ));
+}
+
+int
+main( void )
+{
+    char const * const path = "test_grep_01.log";
+    test_text( path );
+    assert( 0 == remove( path ));
+    test_interned();
+    return 0;
+}
@@ -0,0 +1,386 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Test interning of strings repeated by binary records #01
+ * \date        2016/06/03 16:40:12 PM
+ * \file        test_intern_01.c
+ * \version     1.0
+ *
+ *
+ **/
+
+#include <ulog/binary.h>
+#include <ulog/intern.h>
+#include <ulog/status.h>
+#include <ulog/ulog.h>
+
+#include <assert.h> /* assert */
+#include <errno.h> /* EINVAL, ENOBUFS, ENODATA */
+#include <inttypes.h> /* PRIu64 */
+#include <stdbool.h> /* false */
+#include <stddef.h> /* NULL, size_t */
+#include <stdint.h> /* UINT64_MAX, uint32_t, uint64_t */
+#include <stdio.h> /* snprintf */
+#include <string.h> /* memcpy, strcmp, strlen */
+
+#define MESSAGES 200U
+#define TIMES ( 2U * ULOG_INTERN_CHECKPOINT + 2U )
+
+static ulog_intern_stream stream;
+static unsigned char encoded[ MESSAGES * 2U * ULOG_RECORD_SIZE ];
+static size_t encoded_size;
+static size_t raw_size;
+static char expected[ 2U * MESSAGES ][ ULOG_RECORD_SIZE ];
+static size_t records;
+static unsigned char last_record[ ULOG_RECORD_SIZE ];
+static size_t last_size;
+
+void
+write_interned(
+    ulog_level const level,
+    void const * const record,
+    size_t const size
+)
+{
+    ( void ) level;
+    assert(
+        ulog_status_success(
+            ulog_binary_decode(
+                record,
+                size,
+                expected[ records ],
+                sizeof( expected[ 0 ] )
+            )
+        )
+    );
+    ++records;
+    size_t written = 0U;
+    assert(
+        ulog_status_success(
+            ulog_intern_encode(
+                &stream,
+                record,
+                size,
+                encoded + encoded_size,
+                sizeof( encoded ) - encoded_size,
+                &written
+            )
+        )
+    );
+    encoded_size += written;
+    raw_size += size;
+    memcpy( last_record, record, size );
+    last_size = size;
+}
+
+static void
+test_stream( void )
+{
+    ulog_obj const * const ulog = ulog_obj_get();
+    assert( ulog_status_success( ulog->op->setup( ulog )));
+    assert( ulog_status_success( ulog->op->add_binary( ulog, write_interned )));
+    for( unsigned i = 0U; i < MESSAGES; ++i )
+    {
+        UINFO( "alpha %u %s", i, ( i % 2U ) ? "odd" : "even" );
+        UERROR( "beta %lu", ( unsigned long ) i * 1000UL );
+    }
+    assert( ulog_status_success( ulog->op->cleanup( ulog )));
+    assert( 2U * MESSAGES == records );
+    /* file, function and format are carried once */
+    assert( encoded_size + 2U * MESSAGES * 16U < raw_size );
+
+    ulog_intern_dictionary dictionary = { .text = NULL };
+    char text[ ULOG_RECORD_SIZE ];
+    size_t offset = 0U;
+    for( size_t i = 0U; i < records; ++i )
+    {
+        size_t consumed = 0U;
+        assert(
+            ulog_status_success(
+                ulog_intern_decode(
+                    &dictionary,
+                    encoded + offset,
+                    encoded_size - offset,
+                    &consumed,
+                    text,
+                    sizeof( text )
+                )
+            )
+        );
+        assert( 0 == strcmp( expected[ i ], text ));
+        offset += consumed;
+    }
+    assert( encoded_size == offset );
+    size_t consumed = 1U;
+    assert(
+        ENODATA
+        == ulog_status_to_int(
+            ulog_intern_decode(
+                &dictionary,
+                encoded,
+                0U,
+                &consumed,
+                text,
+                sizeof( text )
+            )
+        )
+    );
+    assert( 0U == consumed );
+    ulog_intern_release( &dictionary );
+    assert(( NULL == dictionary.text ) && ( 0U == dictionary.count ));
+}
+
+/* new stream defines its strings again, failed encoding defines nothing */
+static void
+test_definitions( void )
+{
+    static ulog_intern_stream fresh;
+    static unsigned char buffer[ ULOG_INTERN_BUFFER ];
+    size_t written = 0U;
+    assert(
+        ENOBUFS
+        == ulog_status_to_int(
+            ulog_intern_encode(
+                &fresh,
+                last_record,
+                last_size,
+                buffer,
+                16U,
+                &written
+            )
+        )
+    );
+    assert(
+        ulog_status_success(
+            ulog_intern_encode(
+                &fresh,
+                last_record,
+                last_size,
+                buffer,
+                sizeof( buffer ),
+                &written
+            )
+        )
+    );
+    size_t const defining = written;
+    assert(
+        ulog_status_success(
+            ulog_intern_encode(
+                &fresh,
+                last_record,
+                last_size,
+                buffer,
+                sizeof( buffer ),
+                &written
+            )
+        )
+    );
+    assert( defining > written );
+
+    /* record alone refers to strings the reader doesn't know */
+    ulog_intern_dictionary dictionary = { .text = NULL };
+    char text[ ULOG_RECORD_SIZE ];
+    size_t consumed = 0U;
+    assert(
+        EINVAL
+        == ulog_status_to_int(
+            ulog_intern_decode(
+                &dictionary,
+                buffer,
+                written,
+                &consumed,
+                text,
+                sizeof( text )
+            )
+        )
+    );
+    assert(
+        EINVAL
+        == ulog_status_to_int(
+            ulog_intern_encode( NULL, last_record, last_size, buffer, 1U, NULL )
+        )
+    );
+    ulog_intern_release( &dictionary );
+}
+
+static void
+put(
+    unsigned char * const record,
+    size_t * const size,
+    void const * const value,
+    size_t const length
+)
+{
+    memcpy( record + *size, value, length );
+    *size += length;
+}
+
+/* record as logged by the wrapper macros at given time */
+static size_t
+headed_record( unsigned char * const record, uint64_t const time )
+{
+    static char const file[] = "test.c";
+    static char const function[] = "main";
+    unsigned char const types[] =
+    {
+        ULOG_ARG_INT,
+        ( sizeof( uint64_t ) == sizeof( unsigned long ))
+            ? ULOG_ARG_ULONG
+            : ULOG_ARG_ULLONG,
+        ULOG_ARG_STRING,
+        ULOG_ARG_STRING,
+        ULOG_ARG_UINT
+    };
+    ulog_binary_header header =
+    {
+        .level = INFO,
+        .count = sizeof( types ),
+        .context = 0U,
+        .format = ULOG_HEADER_FORMAT_ "\n"
+    };
+    size_t size = sizeof( header );
+    int const level = 'I';
+    uint32_t const file_length = sizeof( file ) - 1U;
+    uint32_t const function_length = sizeof( function ) - 1U;
+    unsigned const line = 7U;
+    put( record, &size, types, sizeof( types ));
+    put( record, &size, &level, sizeof( level ));
+    put( record, &size, &time, sizeof( time ));
+    put( record, &size, &file_length, sizeof( file_length ));
+    put( record, &size, file, file_length );
+    put( record, &size, &function_length, sizeof( function_length ));
+    put( record, &size, function, function_length );
+    put( record, &size, &line, sizeof( line ));
+    header.size = ( uint32_t ) size;
+    memcpy( record, &header, sizeof( header ));
+    return size;
+}
+
+/* times going back and jumping far are kept exactly */
+static void
+test_time( void )
+{
+    static ulog_intern_stream fresh;
+    static unsigned char buffer[ TIMES * ULOG_RECORD_SIZE ];
+    static uint64_t times[ TIMES ];
+    static size_t offsets[ TIMES ];
+    unsigned char record[ ULOG_RECORD_SIZE ];
+    size_t used = 0U;
+    size_t raw = 0U;
+    for( size_t i = 0U; i < TIMES; ++i )
+    {
+        times[ i ] = 1465000000000000000U + i * 1000U - ( i % 3U ) * 700U;
+    }
+    times[ 1 ] = 0U;
+    times[ 2 ] = UINT64_MAX;
+    times[ 3 ] = 5U;
+    for( size_t i = 0U; i < TIMES; ++i )
+    {
+        size_t const size = headed_record( record, times[ i ]);
+        size_t written = 0U;
+        assert(
+            ulog_status_success(
+                ulog_intern_encode(
+                    &fresh,
+                    record,
+                    size,
+                    buffer + used,
+                    sizeof( buffer ) - used,
+                    &written
+                )
+            )
+        );
+        offsets[ i ] = used;
+        used += written;
+        raw += size;
+    }
+    /* small differences take far fewer bytes than the whole time */
+    assert( used + TIMES * 4U < raw );
+
+    ulog_intern_dictionary dictionary = { .text = NULL };
+    char text[ ULOG_RECORD_SIZE ];
+    char expected_text[ ULOG_RECORD_SIZE ];
+    size_t offset = 0U;
+    for( size_t i = 0U; i < TIMES; ++i )
+    {
+        size_t consumed = 0U;
+        assert(
+            ulog_status_success(
+                ulog_intern_decode(
+                    &dictionary,
+                    buffer + offset,
+                    used - offset,
+                    &consumed,
+                    text,
+                    sizeof( text )
+                )
+            )
+        );
+        snprintf(
+            expected_text,
+            sizeof( expected_text ),
+            "[I][%" PRIu64 "][test.c:main:7] \n",
+            times[ i ]
+        );
+        assert( 0 == strcmp( expected_text, text ));
+        offset += consumed;
+    }
+    assert( used == offset );
+
+    /* time has to be known before a difference */
+    dictionary.time = 0U;
+    dictionary.timed = false;
+    size_t consumed = 0U;
+    assert(
+        EINVAL
+        == ulog_status_to_int(
+            ulog_intern_decode(
+                &dictionary,
+                buffer + offsets[ ULOG_INTERN_CHECKPOINT - 1U ],
+                used - offsets[ ULOG_INTERN_CHECKPOINT - 1U ],
+                &consumed,
+                text,
+                sizeof( text )
+            )
+        )
+    );
+    ulog_intern_release( &dictionary );
+    assert( false == dictionary.timed );
+
+    /* reading may begin at a checkpoint, which defines strings again */
+    ulog_intern_dictionary later = { .text = NULL };
+    offset = offsets[ ULOG_INTERN_CHECKPOINT ];
+    for( size_t i = ULOG_INTERN_CHECKPOINT; i < TIMES; ++i )
+    {
+        assert(
+            ulog_status_success(
+                ulog_intern_decode(
+                    &later,
+                    buffer + offset,
+                    used - offset,
+                    &consumed,
+                    text,
+                    sizeof( text )
+                )
+            )
+        );
+        snprintf(
+            expected_text,
+            sizeof( expected_text ),
+            "[I][%" PRIu64 "][test.c:main:7] \n",
+            times[ i ]
+        );
+        assert( 0 == strcmp( expected_text, text ));
+        offset += consumed;
+    }
+    assert( used == offset );
+    ulog_intern_release( &later );
+}
+
+int
+main( void )
+{
+    test_stream();
+    test_definitions();
+    test_time();
+    return 0;
+}
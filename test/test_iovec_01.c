@@ -0,0 +1,114 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Test handlers receiving messages in pieces #01
+ * \date        2016/04/09 12:14:52 PM
+ * \file        test_iovec_01.c
+ * \version     1.0
+ *
+ *
+ **/
+
+#define _POSIX_C_SOURCE 200809L /* for fileno, ftruncate */
+
+#include <ulog/status.h>
+#include <ulog/ulog.h>
+
+#include <assert.h> /* assert */
+#include <errno.h> /* EEXIST, ENOTCONN */
+#include <stdarg.h> /* va_list */
+#include <stdio.h> /* fclose, fileno, fread, rewind, tmpfile, vsnprintf */
+#include <string.h> /* memcpy, strcmp, strlen, strstr */
+#include <sys/uio.h> /* writev */
+#include <unistd.h> /* ftruncate, ssize_t */
+
+static char formatted[ 256U ];
+static char gathered[ 256U ];
+static char written[ 256U ];
+static int pieces;
+static FILE * file;
+
+void
+log_to_buffer(
+    ulog_level const level,
+    char const * const format,
+    va_list args
+)
+{
+    ( void ) level;
+    ( void ) vsnprintf( formatted, sizeof( formatted ), format, args );
+}
+
+void
+log_pieces(
+    ulog_level const level,
+    struct iovec const * const piece,
+    int const count
+)
+{
+    ( void ) level;
+    pieces = count;
+    size_t length = 0U;
+    for( int i = 0; i < count; ++i )
+    {
+        assert( length + piece[ i ].iov_len < sizeof( gathered ));
+        memcpy( gathered + length, piece[ i ].iov_base, piece[ i ].iov_len );
+        length += piece[ i ].iov_len;
+    }
+    gathered[ length ] = '\0';
+    assert(( ssize_t ) length == writev( fileno( file ), piece, count ));
+}
+
+static void
+read_back( void )
+{
+    rewind( file );
+    size_t const length = fread( written, 1U, sizeof( written ) - 1U, file );
+    written[ length ] = '\0';
+    rewind( file );
+    assert( 0 == ftruncate( fileno( file ), 0 ));
+}
+
+int
+main( void )
+{
+    file = tmpfile();
+    assert( NULL != file );
+    ulog_obj const * const ulog = ulog_obj_get();
+    assert(
+        ENOTCONN == ulog_status_to_int( ulog->op->add_iovec( ulog, log_pieces ))
+    );
+    assert( ulog_status_success( ulog->op->setup( ulog )));
+    assert( ulog_status_success( ulog->op->add( ulog, log_to_buffer )));
+    assert( ulog_status_success( ulog->op->add_iovec( ulog, log_pieces )));
+    assert(
+        EEXIST == ulog_status_to_int( ulog->op->add_iovec( ulog, log_pieces ))
+    );
+
+    UINFO( "first %d and %s", 1, "second" );
+    assert( 6 == pieces );
+    assert( 0 == strcmp( formatted, gathered ));
+    assert( NULL != strstr( gathered, "first 1 and second" ));
+    read_back();
+    assert( 0 == strcmp( formatted, written ));
+
+    /* message without header is delivered whole */
+    ulog_( WARNING, "raw %u", 42U );
+    assert( 1 == pieces );
+    assert( 0 == strcmp( "raw 42", gathered ));
+    assert( 0 == strcmp( formatted, gathered ));
+    read_back();
+    assert( 0 == strcmp( "raw 42", written ));
+
+    assert( ulog_status_success( ulog->op->remove_iovec( ulog, log_pieces )));
+    assert(
+        !ulog_status_success( ulog->op->remove_iovec( ulog, log_pieces ))
+    );
+    pieces = 0;
+    UINFO( "not gathered" );
+    assert( 0 == pieces );
+    assert( NULL != strstr( formatted, "not gathered" ));
+
+    assert( ulog_status_success( ulog->op->cleanup( ulog )));
+    assert( 0 == fclose( file ));
+    return 0;
+}
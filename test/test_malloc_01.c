@@ -0,0 +1,260 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Test that logging doesn't allocate memory #01
+ * \date        2016/02/27 15:02:26 PM
+ * \file        test_malloc_01.c
+ * \version     1.0
+ *
+ * Interposes malloc() and friends to count allocations made while
+ * logging; relies on glibc exporting its own allocator functions.
+ **/
+
+#define _POSIX_C_SOURCE 200809L /* for getpid */
+
+#include <ulog/status.h>
+#include <ulog/ulog.h>
+
+#include <assert.h> /* assert */
+#include <errno.h> /* EBUSY, EINVAL, ENOMEM */
+#include <stdarg.h> /* va_list */
+#include <stddef.h> /* size_t */
+#include <stdio.h> /* remove, snprintf, vsnprintf */
+#include <string.h> /* memset */
+#include <sys/uio.h> /* struct iovec */
+#include <unistd.h> /* getpid */
+
+#define SKIPPED 77 /* automake's exit status for skipped test */
+#define BASE "test_malloc_01"
+
+#ifdef __GLIBC__
+
+extern void * __libc_malloc( size_t size );
+extern void * __libc_calloc( size_t count, size_t size );
+extern void * __libc_realloc( void * pointer, size_t size );
+extern void __libc_free( void * pointer );
+
+static unsigned long allocations;
+
+void *
+malloc( size_t size )
+{
+    __atomic_add_fetch( &allocations, 1U, __ATOMIC_RELAXED );
+    return __libc_malloc( size );
+}
+
+void *
+calloc( size_t count, size_t size )
+{
+    __atomic_add_fetch( &allocations, 1U, __ATOMIC_RELAXED );
+    return __libc_calloc( count, size );
+}
+
+void *
+realloc( void * pointer, size_t size )
+{
+    __atomic_add_fetch( &allocations, 1U, __ATOMIC_RELAXED );
+    return __libc_realloc( pointer, size );
+}
+
+void
+free( void * pointer )
+{
+    __libc_free( pointer );
+}
+
+static unsigned long
+counted( void )
+{
+    return __atomic_load_n( &allocations, __ATOMIC_ACQUIRE );
+}
+
+static void
+reset( void )
+{
+    __atomic_store_n( &allocations, 0U, __ATOMIC_RELEASE );
+}
+
+void
+log_to_buffer(
+    ulog_level const level,
+    char const * const format,
+    va_list args
+)
+{
+    char buffer[ 256U ];
+    ( void ) level;
+    ( void ) vsnprintf( buffer, sizeof( buffer ), format, args );
+}
+
+void
+log_nowhere(
+    ulog_level const level,
+    char const * const format,
+    va_list args
+)
+{
+    ( void ) level;
+    ( void ) format;
+    ( void ) args;
+}
+
+void
+iovec_nowhere(
+    ulog_level const level,
+    struct iovec const * const pieces,
+    int const count
+)
+{
+    ( void ) level;
+    ( void ) pieces;
+    ( void ) count;
+}
+
+void
+binary_nowhere(
+    ulog_level const level,
+    void const * const record,
+    size_t const size
+)
+{
+    ( void ) level;
+    ( void ) record;
+    ( void ) size;
+}
+
+/* each kind of handler and sink is added to those before it */
+static void
+test_handlers( void )
+{
+    ulog_obj const * const ulog = ulog_obj_get();
+    ulog_obj_config const config =
+    {
+        .handlers = ULOG_DEFAULT_HANDLERS,
+        .stats = true
+    };
+    assert( ulog_status_success( ulog->op->configure( ulog, &config )));
+    assert( ulog_status_success( ulog->op->setup( ulog )));
+    assert( ulog_status_success( ulog->op->add( ulog, log_to_buffer )));
+    reset();
+    for( unsigned i = 0U; i < 1000U; ++i ) { UINFO( "statistics %u", i ); }
+    assert( 0U == counted());
+
+    assert( ulog_status_success( ulog->op->add_iovec( ulog, iovec_nowhere )));
+    reset();
+    for( unsigned i = 0U; i < 1000U; ++i ) { UINFO( "iovec %u", i ); }
+    assert( 0U == counted());
+
+    assert(
+        ulog_status_success( ulog->op->add_binary( ulog, binary_nowhere ))
+    );
+    reset();
+    for( unsigned i = 0U; i < 1000U; ++i ) { UINFO( "binary %u", i ); }
+    assert( 0U == counted());
+
+    ulog_async_config const queue =
+    {
+        .capacity = 64U,
+        .policy = ULOG_BLOCK,
+        .timeout = UINT64_MAX
+    };
+    assert(
+        ulog_status_success( ulog->op->add_async( ulog, log_nowhere, &queue ))
+    );
+    reset();
+    for( unsigned i = 0U; i < 1000U; ++i ) { UINFO( "queued %u", i ); }
+    assert( 0U == counted());
+
+    /* longer than buffer of log_to_buffer, so truncated once rendered */
+    char text[ 300U ];
+    memset( text, 'x', sizeof( text ) - 1U );
+    text[ sizeof( text ) - 1U ] = '\0';
+    assert( ulog_status_success( ulog->op->dedup( ulog, 1000U )));
+    reset();
+    for( unsigned i = 0U; i < 1000U; ++i )
+    {
+        UINFO( "long %s %u", text, i / 10U );
+    }
+    assert( 0U == counted());
+    assert( ulog_status_success( ulog->op->cleanup( ulog )));
+}
+
+/* the first record opens the file of its thread, later ones only write */
+static void
+test_files( void )
+{
+    ulog_obj const * const ulog = ulog_obj_get();
+    ulog_files_config const config = { .base = BASE };
+    assert( ulog_status_success( ulog->op->setup( ulog )));
+    assert( ulog_status_success( ulog->op->files( ulog, &config )));
+    UINFO( "first" );
+    reset();
+    for( unsigned i = 0U; i < 1000U; ++i ) { UINFO( "files %u", i ); }
+    assert( 0U == counted());
+    assert( ulog_status_success( ulog->op->cleanup( ulog )));
+
+    char path[ 64U ];
+    ( void ) snprintf(
+        path,
+        sizeof( path ),
+        BASE ".%ld.log",
+        ( long ) getpid()
+    );
+    assert( 0 == remove( path ));
+}
+
+int
+main( void )
+{
+    ulog_obj const * const ulog = ulog_obj_get();
+    ulog_obj_config config = { .handlers = 0U };
+    assert( EINVAL == ulog_status_to_int( ulog->op->configure( ulog, NULL )));
+    assert( EINVAL == ulog_status_to_int(
+            ulog->op->configure( ulog, &config )));
+    config.handlers = 1U;
+    assert( ulog_status_success( ulog->op->configure( ulog, &config )));
+    assert( ulog_status_success( ulog->op->setup( ulog )));
+    assert( EBUSY == ulog_status_to_int(
+            ulog->op->configure( ulog, &config )));
+
+    reset();
+    assert( ulog_status_success( ulog->op->add( ulog, log_to_buffer )));
+    assert( ENOMEM == ulog_status_to_int(
+            ulog->op->add( ulog, log_nowhere )));
+    assert( ulog_status_success( ulog->op->remove( ulog, log_to_buffer )));
+    assert( ulog_status_success( ulog->op->add( ulog, log_to_buffer )));
+    assert( 0U == counted());
+
+    for( unsigned i = 0U; i < 1000U; ++i ) { UINFO( "synchronous %u", i ); }
+    assert( 0U == counted());
+
+    assert( ulog_status_success( ulog->op->dedup( ulog, 1000U )));
+    reset();
+    for( unsigned i = 0U; i < 1000U; ++i ) { UINFO( "dedup %u", i / 10U ); }
+    assert( 0U == counted());
+
+    ulog_async_config const async =
+    {
+        .capacity = 64U,
+        .policy = ULOG_BLOCK,
+        .timeout = UINT64_MAX
+    };
+    assert( ulog_status_success( ulog->op->async( ulog, &async )));
+    reset();
+    for( unsigned i = 0U; i < 1000U; ++i ) { UINFO( "asynchronous %u", i ); }
+    assert( 0U == counted());
+
+    assert( ulog_status_success( ulog->op->cleanup( ulog )));
+    test_handlers();
+    test_files();
+    return 0;
+}
+
+#else /* !__GLIBC__ */
+
+int
+main( void )
+{
+    return SKIPPED;
+}
+
+#endif /* __GLIBC__ */
@@ -0,0 +1,170 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Test merge of logged records by time #01
+ * \date        2016/06/01 15:22:09 PM
+ * \file        test_merge_01.c
+ * \version     1.0
+ *
+ *
+ **/
+
+#include <ulog/merge.h>
+#include <ulog/status.h>
+#include <ulog/ulog.h>
+
+#include <assert.h> /* assert */
+#include <errno.h> /* EIO, ENODATA */
+#include <inttypes.h> /* SCNu64 */
+#include <stdarg.h> /* va_list */
+#include <stddef.h> /* NULL, size_t */
+#include <stdint.h> /* uint64_t */
+#include <stdio.h> /* FILE, fclose, fopen, fputs, fread, remove, etc. */
+#include <string.h> /* strchr, strcmp */
+
+#define FILES 3U
+#define MESSAGES 300U
+
+static FILE * files[ FILES ];
+static unsigned logged;
+
+void
+log_to_file(
+    ulog_level const level,
+    char const * const format,
+    va_list args
+)
+{
+    ( void ) level;
+    assert( 0 < vfprintf( files[ logged++ % FILES ], format, args ));
+}
+
+static uint64_t
+merge(
+    char const * const * const paths,
+    size_t const count,
+    char * const output,
+    size_t const size
+)
+{
+    FILE * const merged = tmpfile();
+    assert( NULL != merged );
+    uint64_t records = 0U;
+    assert(
+        ulog_status_success( ulog_merge( paths, count, merged, &records ))
+    );
+    rewind( merged );
+    size_t const read = fread( output, 1U, size - 1U, merged );
+    output[ read ] = '\0';
+    ( void ) fclose( merged );
+    return records;
+}
+
+static void
+write_file( char const * const path, char const * const content )
+{
+    FILE * const file = fopen( path, "w" );
+    assert( NULL != file );
+    assert( EOF != fputs( content, file ));
+    assert( 0 == fclose( file ));
+}
+
+static void
+test_written( char const * const * const paths )
+{
+    write_file(
+        paths[ 0 ],
+        "preface\n"
+        "[I][10][a.c:f:1] a0\n"
+        "  continued a0\n"
+        "[I][30][a.c:f:2] a1\n"
+        "[I][30][a.c:f:3] a2\n"
+    );
+    /* last record lacks its newline */
+    write_file(
+        paths[ 1 ],
+        "[W][20][b.c:f:1] b0\n"
+        "[W][30][b.c:f:2] b1\n"
+        "[W][40][b.c:f:3] b2"
+    );
+    write_file( paths[ 2 ], "" );
+    write_file(
+        paths[ 3 ],
+        "[E][5][c.c:f:1] c0\n"
+        "[E][30][c.c:f:2] c1\n"
+    );
+    static char output[ 4096U ];
+    assert( 9U == merge( paths, 4U, output, sizeof( output )));
+    /* records of the same time keep order of files */
+    assert(
+        0 == strcmp(
+            "preface\n"
+            "[E][5][c.c:f:1] c0\n"
+            "[I][10][a.c:f:1] a0\n"
+            "  continued a0\n"
+            "[W][20][b.c:f:1] b0\n"
+            "[I][30][a.c:f:2] a1\n"
+            "[I][30][a.c:f:3] a2\n"
+            "[W][30][b.c:f:2] b1\n"
+            "[E][30][c.c:f:2] c1\n"
+            "[W][40][b.c:f:3] b2\n",
+            output
+        )
+    );
+    assert( 0U == merge( paths + 2, 1U, output, sizeof( output )));
+    assert( 0U == merge( paths, 0U, output, sizeof( output )));
+
+    assert(
+        ENODATA
+        == ulog_status_to_int( ulog_merge( NULL, 1U, stdout, NULL ))
+    );
+    char const * const missing[] = { paths[ 0 ], "test_merge_01.missing" };
+    assert(
+        EIO == ulog_status_to_int( ulog_merge( missing, 2U, stdout, NULL ))
+    );
+}
+
+static void
+test_logged( char const * const * const paths )
+{
+    for( size_t i = 0U; i < FILES; ++i )
+    {
+        files[ i ] = fopen( paths[ i ], "w" );
+        assert( NULL != files[ i ]);
+    }
+    ulog_obj const * const ulog = ulog_obj_get();
+    assert( ulog_status_success( ulog->op->setup( ulog )));
+    assert( ulog_status_success( ulog->op->add( ulog, log_to_file )));
+    for( unsigned i = 0U; i < MESSAGES; ++i ) { UINFO( "message %u", i ); }
+    assert( ulog_status_success( ulog->op->cleanup( ulog )));
+    for( size_t i = 0U; i < FILES; ++i ) { assert( 0 == fclose( files[ i ])); }
+
+    static char output[ 128U * 1024U ];
+    assert( MESSAGES == merge( paths, FILES, output, sizeof( output )));
+    uint64_t previous = 0U;
+    for( char const * line = output; '\0' != *line; )
+    {
+        uint64_t time = 0U;
+        assert( 1 == sscanf( line, "[I][%" SCNu64 "]", &time ));
+        assert( previous <= time );
+        previous = time;
+        line = strchr( line, '\n' );
+        assert( NULL != line );
+        ++line;
+    }
+}
+
+int
+main( void )
+{
+    char const * const paths[] =
+    {
+        "test_merge_01.0.log",
+        "test_merge_01.1.log",
+        "test_merge_01.2.log",
+        "test_merge_01.3.log"
+    };
+    test_written( paths );
+    test_logged( paths );
+    for( size_t i = 0U; i < 4U; ++i ) { assert( 0 == remove( paths[ i ])); }
+    return 0;
+}
@@ -0,0 +1,57 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Test adaptive mutex #01
+ * \date        2016/03/12 10:14:52 AM
+ * \file        test_mutex_adaptive_01.c
+ * \version     1.0
+ *
+ *
+ **/
+
+#include <ulog/mutex.h>
+#include <ulog/status.h> /* ulog_status_to_int */
+
+#include <assert.h> /* assert */
+#include <errno.h> /* EALREADY, EINVAL */
+
+int main(void)
+{
+    ulog_mutex mutex = ulog_mutex_get_adaptive();
+    ulog_mutex plain = ulog_mutex_get();
+
+    assert( EINVAL == ulog_status_to_int( mutex.op->lock( &mutex )));
+    assert( EALREADY == ulog_status_to_int( mutex.op->cleanup( &mutex )));
+    assert( ulog_status_success( mutex.op->setup( &mutex )));
+    assert( EALREADY == ulog_status_to_int( mutex.op->setup( &mutex )));
+    assert( ulog_status_success( mutex.op->lock( &mutex )));
+    assert( ulog_status_success( mutex.op->unlock( &mutex )));
+
+    /* inline fast paths work for both kinds, falling back to operations */
+    assert( !ulog_mutex_lock( &plain ));
+    assert( ulog_status_success( plain.op->setup( &plain )));
+    assert( ulog_mutex_lock( &plain ));
+    assert( ulog_mutex_unlock( &plain ));
+    assert( ulog_mutex_lock_shared( &plain ));
+    assert( ulog_mutex_unlock_shared( &plain ));
+    assert( ulog_status_success( plain.op->cleanup( &plain )));
+    assert( ulog_mutex_lock( &mutex ));
+    assert( ulog_mutex_unlock( &mutex ));
+    assert( ulog_status_success( mutex.op->lock_shared( &mutex )));
+    assert( ulog_status_success( mutex.op->unlock_shared( &mutex )));
+    assert( ulog_mutex_lock( &mutex ));
+    assert( ulog_mutex_unlock( &mutex ));
+    assert( ulog_mutex_lock_shared( &mutex ));
+    assert( ulog_mutex_lock_shared( &mutex ));
+    assert( ulog_mutex_unlock_shared( &mutex ));
+    assert( ulog_mutex_unlock_shared( &mutex ));
+
+    /* objects of both kinds can't be mixed */
+    assert( EINVAL == ulog_status_to_int( plain.op->lock( &mutex )));
+    assert( EINVAL == ulog_status_to_int( mutex.op->setup( &plain )));
+
+    assert( ulog_status_success( mutex.op->cleanup( &mutex )));
+    assert( EINVAL == ulog_status_to_int( mutex.op->unlock( &mutex )));
+    assert( !ulog_mutex_lock( &mutex ));
+    assert( !ulog_mutex_lock_shared( &mutex ));
+    return 0;
+}
@@ -0,0 +1,65 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Test mutex shared locking #01
+ * \date        2016/03/19 10:22:41 AM
+ * \file        test_mutex_shared_01.c
+ * \version     1.0
+ *
+ *
+ **/
+
+#include <ulog/mutex.h>
+#include <ulog/status.h> /* ulog_status_to_int */
+
+#include <assert.h> /* assert */
+#include <errno.h> /* EINVAL */
+#include <pthread.h> /* pthread_barrier_t, pthread_create, pthread_join */
+#include <stddef.h> /* NULL */
+
+#define READERS 8U
+
+static pthread_barrier_t barrier;
+
+void * reader( void * arg )
+{
+    ulog_mutex * mutex = arg;
+    assert( ulog_status_success( mutex->op->lock_shared( mutex )));
+    /* passes only if all readers hold the mutex at the same time */
+    pthread_barrier_wait( &barrier );
+    assert( ulog_status_success( mutex->op->unlock_shared( mutex )));
+    return NULL;
+}
+
+int main(void)
+{
+    ulog_mutex plain = ulog_mutex_get();
+    ulog_mutex mutex = ulog_mutex_get_adaptive();
+
+    assert( EINVAL == ulog_status_to_int( plain.op->lock_shared( &plain )));
+    assert( EINVAL == ulog_status_to_int( mutex.op->unlock_shared( &mutex )));
+
+    /* plain mutex treats shared locking as exclusive */
+    assert( ulog_status_success( plain.op->setup( &plain )));
+    assert( ulog_status_success( plain.op->lock_shared( &plain )));
+    assert( ulog_status_success( plain.op->unlock_shared( &plain )));
+    assert( ulog_status_success( plain.op->cleanup( &plain )));
+
+    assert( ulog_status_success( mutex.op->setup( &mutex )));
+    assert( 0 == pthread_barrier_init( &barrier, NULL, READERS ));
+    pthread_t threads[ READERS ];
+    for( unsigned i = 0U; i < READERS; ++i )
+    {
+        assert( 0 == pthread_create( &threads[ i ], NULL, reader, &mutex ));
+    }
+    for( unsigned i = 0U; i < READERS; ++i )
+    {
+        assert( 0 == pthread_join( threads[ i ], NULL ));
+    }
+    assert( 0 == pthread_barrier_destroy( &barrier ));
+
+    /* exclusive lock is still available after all readers left */
+    assert( ulog_status_success( mutex.op->lock( &mutex )));
+    assert( ulog_status_success( mutex.op->unlock( &mutex )));
+    assert( ulog_status_success( mutex.op->cleanup( &mutex )));
+    return 0;
+}
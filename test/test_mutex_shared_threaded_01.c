@@ -0,0 +1,87 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Test mutex shared locking threaded #01
+ * \date        2016/03/19 10:58:13 AM
+ * \file        test_mutex_shared_threaded_01.c
+ * \version     1.0
+ *
+ *
+ **/
+
+#include <ulog/mutex.h>
+#include <ulog/status.h> /* ulog_status_success */
+
+#include <assert.h> /* assert */
+#include <pthread.h> /* pthread_create, pthread_join, pthread_t */
+#include <stddef.h> /* NULL */
+
+#define READERS 32U
+#define WRITERS 4U
+
+/* writers keep both equal, readers must never see them differ */
+static volatile unsigned first;
+static volatile unsigned second;
+static unsigned loops = 20000U;
+
+void * reader( void * arg )
+{
+    ulog_mutex * mutex = arg;
+    for( unsigned i = 0; i < loops; ++i )
+    {
+        /* inline and table operations of the mutex are interchangeable */
+        if( 0U == i % 2U )
+        {
+            assert( ulog_status_success( mutex->op->lock_shared( mutex )));
+        }
+        else { assert( ulog_mutex_lock_shared( mutex )); }
+        assert( first == second );
+        if( 0U == i % 3U ) { assert( ulog_mutex_unlock_shared( mutex )); }
+        else
+        {
+            assert( ulog_status_success( mutex->op->unlock_shared( mutex )));
+        }
+    }
+    return NULL;
+}
+
+void * writer( void * arg )
+{
+    ulog_mutex * mutex = arg;
+    for( unsigned i = 0; i < loops / 10U; ++i )
+    {
+        assert( ulog_status_success( mutex->op->lock( mutex )));
+        ++first;
+        ++second;
+        assert( ulog_status_success( mutex->op->unlock( mutex )));
+    }
+    return NULL;
+}
+
+int main(void)
+{
+    ulog_mutex mutex = ulog_mutex_get_adaptive();
+    assert( ulog_status_success( mutex.op->setup( &mutex )));
+
+    pthread_t threads[ READERS + WRITERS ];
+    for( unsigned i = 0U; i < READERS + WRITERS; ++i )
+    {
+        assert(
+            0 == pthread_create(
+                &threads[ i ],
+                NULL,
+                ( i < READERS ) ? reader : writer,
+                &mutex
+            )
+        );
+    }
+    for( unsigned i = 0U; i < READERS + WRITERS; ++i )
+    {
+        assert( 0 == pthread_join( threads[ i ], NULL ));
+    }
+
+    assert(( WRITERS * ( loops / 10U )) == first );
+    assert( first == second );
+
+    assert( ulog_status_success( mutex.op->cleanup( &mutex )));
+    return 0;
+}
@@ -0,0 +1,54 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Test adaptive mutex threaded #01
+ * \date        2016/03/12 10:31:07 AM
+ * \file        test_mutex_threaded_adaptive_01.c
+ * \version     1.0
+ *
+ *
+ **/
+
+#include <ulog/mutex.h>
+#include <ulog/status.h> /* ulog_status_success */
+
+#include <assert.h> /* assert */
+#include <pthread.h> /* pthread_create, pthread_join, pthread_t */
+#include <stddef.h> /* NULL */
+
+#define THREADS 64U
+
+static unsigned resource;
+static unsigned loops = 20000U;
+
+void * foo( void * arg )
+{
+  ulog_mutex * mutex = arg;
+  for( unsigned i = 0; i < loops; ++i )
+  {
+    assert( ulog_status_success( mutex->op->lock( mutex )));
+    ++resource;
+    assert( ulog_status_success( mutex->op->unlock( mutex )));
+  }
+  return NULL;
+}
+
+int main(void)
+{
+    ulog_mutex mutex = ulog_mutex_get_adaptive();
+    assert( ulog_status_success( mutex.op->setup( &mutex )));
+
+    pthread_t threads[ THREADS ];
+    for( unsigned i = 0U; i < THREADS; ++i )
+    {
+        assert( 0 == pthread_create( &threads[ i ], NULL, foo, &mutex ));
+    }
+    for( unsigned i = 0U; i < THREADS; ++i )
+    {
+        assert( 0 == pthread_join( threads[ i ], NULL ));
+    }
+
+    assert(( THREADS * loops ) == resource );
+
+    assert( ulog_status_success( mutex.op->cleanup( &mutex )));
+    return 0;
+}
@@ -0,0 +1,65 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Test pool #01
+ * \date        2016/02/27 13:18:52 PM
+ * \file        test_pool_simple_01.c
+ * \version     1.0
+ *
+ *
+ **/
+
+#include <ulog/pool.h>
+#include <ulog/status.h> /* ulog_status* */
+
+#include <assert.h> /* assert */
+#include <errno.h> /* EALREADY, EINVAL, ENODATA, ENOMEM */
+#include <stddef.h> /* NULL */
+#include <stdint.h> /* uintptr_t */
+#include <string.h> /* memset */
+
+#define BLOCKS 3U
+#define SIZE 40U
+
+int
+main( void )
+{
+    void * blocks[ BLOCKS ];
+    void * extra;
+    ulog_pool pool = ulog_pool_get();
+
+    assert( EINVAL == ulog_status_to_int( pool.op->setup( NULL, SIZE, 1U )));
+    assert( EINVAL == ulog_status_to_int( pool.op->setup( &pool, 0U, 1U )));
+    assert( EINVAL == ulog_status_to_int( pool.op->setup( &pool, SIZE, 0U )));
+    assert( EINVAL == ulog_status_to_int( pool.op->acquire( &pool, &extra )));
+    assert( EALREADY == ulog_status_to_int( pool.op->cleanup( &pool )));
+
+    assert( ulog_status_success( pool.op->setup( &pool, SIZE, BLOCKS )));
+    assert( EALREADY == ulog_status_to_int(
+            pool.op->setup( &pool, SIZE, BLOCKS )));
+    assert( ENODATA == ulog_status_to_int( pool.op->acquire( &pool, NULL )));
+
+    for( unsigned i = 0U; i < BLOCKS; ++i )
+    {
+        assert( ulog_status_success( pool.op->acquire( &pool, blocks + i )));
+        assert( 0U == (( uintptr_t ) blocks[ i ] ) % ULOG_POOL_ALIGNMENT );
+        memset( blocks[ i ], 0xFF, SIZE );
+    }
+    assert( ENOMEM == ulog_status_to_int( pool.op->acquire( &pool, &extra )));
+
+    assert( ENODATA == ulog_status_to_int( pool.op->release( &pool, NULL )));
+    assert( ENODATA == ulog_status_to_int( pool.op->release( &pool, &extra )));
+    assert( ENODATA == ulog_status_to_int(
+            pool.op->release( &pool, (( char * ) blocks[ 0 ] ) + 1 )));
+
+    assert( ulog_status_success( pool.op->release( &pool, blocks[ 1 ] )));
+    assert( ulog_status_success( pool.op->acquire( &pool, &extra )));
+    assert( blocks[ 1 ] == extra );
+
+    for( unsigned i = 0U; i < BLOCKS; ++i )
+    {
+        assert( ulog_status_success( pool.op->release( &pool, blocks[ i ] )));
+    }
+    assert( ulog_status_success( pool.op->cleanup( &pool )));
+    assert( EALREADY == ulog_status_to_int( pool.op->cleanup( &pool )));
+    return 0;
+}
@@ -0,0 +1,86 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Test queue #01
+ * \date        2016/02/13 15:44:09 PM
+ * \file        test_queue_simple_01.c
+ * \version     1.0
+ *
+ *
+ **/
+
+#include <ulog/queue.h>
+#include <ulog/status.h> /* ulog_status* */
+
+#include <assert.h> /* assert */
+#include <errno.h> /* EAGAIN, EALREADY, EINVAL, ENODATA, ENOENT */
+#include <stddef.h> /* NULL */
+
+typedef struct
+{
+    int i;
+    ulog_queueable queue;
+}
+test_struct;
+
+int
+main( void )
+{
+    test_struct t[ 5 ];
+    for( int i = 0; i < 5; ++i )
+    {
+        t[ i ] = ( test_struct ) { .i = i, .queue = ulog_queueable_get() };
+    }
+    ulog_queueable * element = NULL;
+    ulog_queue queue = ulog_queue_get();
+
+    assert( EINVAL == ulog_status_to_int( queue.op->setup( NULL, 4U )));
+    assert( EINVAL == ulog_status_to_int( queue.op->setup( &queue, 0U )));
+    assert( EINVAL == ulog_status_to_int(
+            queue.op->push( &queue, &( t[ 0 ].queue ))));
+    assert( EINVAL == ulog_status_to_int( queue.op->pop( &queue, &element )));
+    assert( EALREADY == ulog_status_to_int( queue.op->cleanup( &queue )));
+
+    /* capacity is rounded up to 4 */
+    assert( ulog_status_success( queue.op->setup( &queue, 3U )));
+    assert( EALREADY == ulog_status_to_int( queue.op->setup( &queue, 3U )));
+    assert( ENODATA == ulog_status_to_int( queue.op->push( &queue, NULL )));
+    assert( ENODATA == ulog_status_to_int( queue.op->pop( &queue, NULL )));
+    assert( ENOENT == ulog_status_to_int( queue.op->pop( &queue, &element )));
+
+    for( int i = 0; i < 4; ++i )
+    {
+        assert( ulog_status_success(
+                queue.op->push( &queue, &( t[ i ].queue ))));
+    }
+    assert( EAGAIN == ulog_status_to_int(
+            queue.op->push( &queue, &( t[ 4 ].queue ))));
+
+    for( int i = 0; i < 4; ++i )
+    {
+        assert( ulog_status_success( queue.op->pop( &queue, &element )));
+        test_struct const * const item =
+            ulog_queueable_get_container( element, test_struct, queue );
+        assert( i == item->i );
+        assert(( unsigned ) i == element->sequence );
+    }
+    assert( ENOENT == ulog_status_to_int( queue.op->pop( &queue, &element )));
+
+    /* wrap around */
+    for( int round = 0; round < 3; ++round )
+    {
+        for( int i = 0; i < 3; ++i )
+        {
+            assert( ulog_status_success(
+                    queue.op->push( &queue, &( t[ i ].queue ))));
+        }
+        for( int i = 0; i < 3; ++i )
+        {
+            assert( ulog_status_success( queue.op->pop( &queue, &element )));
+            assert( &( t[ i ].queue ) == element );
+        }
+    }
+
+    assert( ulog_status_success( queue.op->cleanup( &queue )));
+    assert( EALREADY == ulog_status_to_int( queue.op->cleanup( &queue )));
+    return 0;
+}
@@ -0,0 +1,94 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Stress test of queue with many producers #01
+ * \date        2016/02/13 16:20:37 PM
+ * \file        test_queue_threaded_01.c
+ * \version     1.0
+ *
+ *
+ **/
+
+#include <ulog/queue.h>
+#include <ulog/status.h> /* ulog_status* */
+
+#include <assert.h> /* assert */
+#include <errno.h> /* EAGAIN */
+#include <pthread.h>
+#include <sched.h> /* sched_yield */
+#include <stddef.h> /* NULL */
+
+#define PRODUCERS 16U
+#define ITEMS 20000U
+
+typedef struct
+{
+    unsigned producer;
+    unsigned index;
+    ulog_queueable queue;
+}
+test_struct;
+
+static test_struct items[ PRODUCERS ][ ITEMS ];
+static unsigned producer_ids[ PRODUCERS ];
+static ulog_queue queue;
+
+void * produce( void * arg )
+{
+    unsigned const id = *( unsigned const * ) arg;
+    for( unsigned i = 0U; i < ITEMS; ++i )
+    {
+        items[ id ][ i ] = ( test_struct )
+        {
+            .producer = id,
+            .index = i,
+            .queue = ulog_queueable_get()
+        };
+        ulog_status result;
+        while( EAGAIN == ulog_status_to_int(
+            result = queue.op->push( &queue, &( items[ id ][ i ].queue ))))
+        {
+            sched_yield();
+        }
+        assert( ulog_status_success( result ));
+    }
+    return NULL;
+}
+
+int main(void)
+{
+    queue = ulog_queue_get();
+    assert( ulog_status_success( queue.op->setup( &queue, 64U )));
+
+    pthread_t threads[ PRODUCERS ];
+    for( unsigned i = 0U; i < PRODUCERS; ++i )
+    {
+        producer_ids[ i ] = i;
+        assert( 0 == pthread_create(
+                &( threads[ i ] ), NULL, produce, &( producer_ids[ i ] )));
+    }
+
+    /* per producer order must be kept and nothing lost or duplicated */
+    unsigned expected[ PRODUCERS ] = { 0U };
+    for( unsigned received = 0U; received < ( PRODUCERS * ITEMS ); )
+    {
+        ulog_queueable * element;
+        if( !ulog_status_success( queue.op->pop( &queue, &element )))
+        {
+            sched_yield();
+            continue;
+        }
+        test_struct const * const item =
+            ulog_queueable_get_container( element, test_struct, queue );
+        assert( expected[ item->producer ] == item->index );
+        ++expected[ item->producer ];
+        ++received;
+    }
+
+    for( unsigned i = 0U; i < PRODUCERS; ++i )
+    {
+        assert( 0 == pthread_join( threads[ i ], NULL ));
+        assert( ITEMS == expected[ i ] );
+    }
+    assert( ulog_status_success( queue.op->cleanup( &queue )));
+    return 0;
+}
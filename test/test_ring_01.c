@@ -0,0 +1,371 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Test ring of records shared by processes #01
+ * \date        2016/05/28 16:21:09 PM
+ * \file        test_ring_01.c
+ * \version     1.0
+ *
+ *
+ **/
+
+#define _POSIX_C_SOURCE 200809L /* for fork, getpid, nanosleep */
+
+#include <ulog/ring.h>
+#include <ulog/shared.h>
+#include <ulog/status.h>
+#include <ulog/ulog.h>
+
+#include <assert.h> /* assert */
+#include <errno.h> /* EALREADY, EBUSY, EINVAL, EIO, ENOBUFS, etc. */
+#include <stdarg.h> /* va_list */
+#include <stdbool.h> /* bool */
+#include <stdio.h> /* snprintf, sscanf */
+#include <stdlib.h> /* _Exit */
+#include <string.h> /* memset, strcmp, strstr */
+#include <sys/types.h> /* pid_t */
+#include <sys/wait.h> /* WEXITSTATUS, WIFEXITED, waitpid */
+#include <time.h> /* nanosleep */
+#include <unistd.h> /* close, fork, getpid, pipe, read, write */
+
+#define WORKERS 3
+#define MESSAGES 5
+#define COLLECTED 16U
+
+static char collected[ COLLECTED ][ ULOG_RECORD_SIZE ];
+static unsigned collected_count;
+
+static void
+collect_text(
+    void * const userdata,
+    ulog_level const level,
+    char const * const text,
+    size_t const length
+)
+{
+    ( void ) userdata;
+    ( void ) level;
+    assert( strlen( text ) == length );
+    if( COLLECTED > collected_count )
+    {
+        snprintf(
+            collected[ collected_count ],
+            ULOG_RECORD_SIZE,
+            "%s",
+            text
+        );
+    }
+    __atomic_add_fetch( &collected_count, 1U, __ATOMIC_RELEASE );
+}
+
+static int worker_next[ WORKERS ];
+static unsigned worker_records;
+
+void
+count_workers(
+    ulog_level const level,
+    char const * const format,
+    va_list args
+)
+{
+    ( void ) level;
+    if( 0 != strcmp( "%s", format )) { return; }
+    char const * const text =
+        strstr( va_arg( args, char const * ), "worker " );
+    int worker = -1;
+    int message = -1;
+    if(
+        ( NULL == text )
+        || ( 2 != sscanf( text, "worker %d message %d", &worker, &message ))
+    )
+    {
+        return;
+    }
+    /* each producer's records come in its order */
+    assert(( 0 <= worker ) && ( WORKERS > worker ));
+    assert( worker_next[ worker ] == message );
+    ++worker_next[ worker ];
+    ++worker_records;
+}
+
+static ulog_status
+submit( ulog_ring const * const ring, char const * const format, ... )
+{
+    va_list args;
+    va_start( args, format );
+    ulog_status const result = ring->op->submit( ring, INFO, format, args );
+    va_end( args );
+    return result;
+}
+
+static void
+wait_for( unsigned const count )
+{
+    struct timespec const pause = { .tv_sec = 0, .tv_nsec = 1000000L };
+    for( unsigned i = 0U; i < 5000U; ++i )
+    {
+        if( count <= __atomic_load_n( &collected_count, __ATOMIC_ACQUIRE ))
+        {
+            return;
+        }
+        ( void ) nanosleep( &pause, NULL );
+    }
+    assert( false );
+}
+
+static void
+test_ring( char const * const name )
+{
+    ulog_ring producer = ulog_ring_get();
+    ulog_ring_config config = { .name = name, .capacity = 3U };
+    ulog_ring_reservation dead;
+    assert(
+        EINVAL
+        == ulog_status_to_int( producer.op->reserve( &producer, &dead ))
+    );
+    assert(
+        ulog_status_success(
+            producer.op->setup( &producer, &config, NULL, NULL )
+        )
+    );
+
+    /* capacity is rounded up to four records, then the ring is full */
+    for( unsigned i = 0U; i < 4U; ++i )
+    {
+        assert( ulog_status_success( submit( &producer, "record %u", i )));
+    }
+    assert( ENOBUFS == ulog_status_to_int( submit( &producer, "lost" )));
+
+    ulog_ring collector = ulog_ring_get();
+    config.collect = true;
+    config.timeout = 10000000U;
+    assert(
+        EINVAL
+        == ulog_status_to_int(
+            collector.op->setup( &collector, &config, NULL, NULL )
+        )
+    );
+    config.capacity = 8U;
+    assert(
+        EIO
+        == ulog_status_to_int(
+            collector.op->setup( &collector, &config, collect_text, NULL )
+        )
+    );
+    config.capacity = 4U;
+    assert(
+        ulog_status_success(
+            collector.op->setup( &collector, &config, collect_text, NULL )
+        )
+    );
+    ulog_ring other = ulog_ring_get();
+    assert(
+        EBUSY
+        == ulog_status_to_int(
+            other.op->setup( &other, &config, collect_text, NULL )
+        )
+    );
+    wait_for( 4U );
+    assert( 0 == strcmp( "record 0", collected[ 0 ]));
+    assert( 0 == strcmp( "record 3", collected[ 3 ]));
+
+    /* producer which never commits holds collection up only until timeout */
+    assert( ulog_status_success( producer.op->reserve( &producer, &dead )));
+    assert( ulog_status_success( submit( &producer, "after %s", "dead" )));
+    wait_for( 5U );
+    assert( 0 == strcmp( "after dead", collected[ 4 ]));
+    assert(
+        ETIMEDOUT
+        == ulog_status_to_int(
+            producer.op->commit( &producer, &dead, INFO, 0U )
+        )
+    );
+    ulog_ring_counters counters;
+    assert(
+        ulog_status_success( producer.op->counters( &producer, &counters ))
+    );
+    assert( 5U == counters.written );
+    assert( 1U == counters.dropped );
+    assert( 5U == counters.collected );
+    assert( 1U == counters.abandoned );
+
+    assert( ulog_status_success( collector.op->cleanup( &collector )));
+    assert( ulog_status_success( producer.op->cleanup( &producer )));
+    assert(
+        EALREADY
+        == ulog_status_to_int( producer.op->cleanup( &producer ))
+    );
+    assert( ulog_status_success( ulog_shared_remove( name )));
+}
+
+/* returns text of reserved slot, after committing record into it */
+static char *
+produce( ulog_ring const * const ring, unsigned const number )
+{
+    ulog_ring_reservation reservation;
+    assert( ulog_status_success( ring->op->reserve( ring, &reservation )));
+    int const length =
+        snprintf( reservation.text, reservation.size, "lap %u", number );
+    assert(
+        ulog_status_success(
+            ring->op->commit( ring, &reservation, INFO, ( size_t ) length )
+        )
+    );
+    return reservation.text;
+}
+
+/* slot taken from stalled producer isn't reused while it may still write */
+static void
+test_stall( char const * const name )
+{
+    collected_count = 0U;
+    ulog_ring collector = ulog_ring_get();
+    ulog_ring_config config =
+    {
+        .name = name,
+        .capacity = 4U,
+        .collect = true,
+        .timeout = 10000000U
+    };
+    assert(
+        ulog_status_success(
+            collector.op->setup( &collector, &config, collect_text, NULL )
+        )
+    );
+    ulog_ring producer = ulog_ring_get();
+    config.collect = false;
+    assert(
+        ulog_status_success(
+            producer.op->setup( &producer, &config, NULL, NULL )
+        )
+    );
+    ulog_ring_reservation stalled;
+    assert( ulog_status_success( producer.op->reserve( &producer, &stalled )));
+    /* collector waits out the timeout, then two laps go around the slot */
+    for( unsigned i = 0U; i < 8U; ++i )
+    {
+        assert( stalled.text != produce( &producer, i ));
+        wait_for( i + 1U );
+    }
+    memset( stalled.text, 'x', stalled.size );
+    assert(
+        ETIMEDOUT
+        == ulog_status_to_int(
+            producer.op->commit( &producer, &stalled, INFO, stalled.size )
+        )
+    );
+    for( unsigned i = 0U; i < 8U; ++i )
+    {
+        char expected[ 16U ];
+        ( void ) snprintf( expected, sizeof( expected ), "lap %u", i );
+        assert( 0 == strcmp( expected, collected[ i ] ));
+    }
+    /* released slot is used again */
+    bool reused = false;
+    for( unsigned i = 8U; i < 16U; ++i )
+    {
+        reused = ( stalled.text == produce( &producer, i )) || reused;
+        wait_for( i + 1U );
+    }
+    assert( reused );
+    ulog_ring_counters counters;
+    assert(
+        ulog_status_success( producer.op->counters( &producer, &counters ))
+    );
+    assert( 16U == counters.written );
+    assert( 0U == counters.dropped );
+    assert( 16U == counters.collected );
+    assert( 1U == counters.abandoned );
+    assert( ulog_status_success( collector.op->cleanup( &collector )));
+    assert( ulog_status_success( producer.op->cleanup( &producer )));
+    assert( ulog_status_success( ulog_shared_remove( name )));
+}
+
+static void
+work( char const * const name, int const worker, int const start )
+{
+    char go;
+    if( 1 != read( start, &go, 1U )) { _Exit( 1 ); }
+    ulog_obj const * const ulog = ulog_obj_get();
+    ulog_ring_config const config = { .name = name, .capacity = 64U };
+    if(
+        !ulog_status_success( ulog->op->setup( ulog ))
+        || !ulog_status_success( ulog->op->ring( ulog, &config ))
+    )
+    {
+        _Exit( 1 );
+    }
+    for( int i = 0; i < MESSAGES; ++i )
+    {
+        UINFO( "worker %d message %d", worker, i );
+    }
+    _Exit( ulog_status_success( ulog->op->cleanup( ulog )) ? 0 : 1 );
+}
+
+static void
+test_processes( char const * const name )
+{
+    int start[ 2 ];
+    assert( 0 == pipe( start ));
+    pid_t workers[ WORKERS ];
+    for( int i = 0; i < WORKERS; ++i )
+    {
+        workers[ i ] = fork();
+        assert( -1 != workers[ i ] );
+        if( 0 == workers[ i ] ) { work( name, i, start[ 0 ] ); }
+    }
+
+    ulog_obj const * const ulog = ulog_obj_get();
+    ulog_ring_config const config =
+    {
+        .name = name,
+        .capacity = 64U,
+        .collect = true
+    };
+    assert( ENOTCONN == ulog_status_to_int( ulog->op->ring( ulog, &config )));
+    assert( ulog_status_success( ulog->op->setup( ulog )));
+    assert( ulog_status_success( ulog->op->add( ulog, count_workers )));
+    assert( ulog_status_success( ulog->op->ring( ulog, &config )));
+    char const go[ WORKERS ] = { 0 };
+    assert( WORKERS == write( start[ 1 ], go, WORKERS ));
+    for( int i = 0; i < WORKERS; ++i )
+    {
+        int status = 0;
+        assert( workers[ i ] == waitpid( workers[ i ], &status, 0 ));
+        assert( WIFEXITED( status ) && ( 0 == WEXITSTATUS( status )));
+    }
+    /* collector passes what's committed to handlers before it stops */
+    assert( ulog_status_success( ulog->op->ring( ulog, NULL )));
+    assert( WORKERS * MESSAGES == worker_records );
+    assert( ulog_status_success( ulog->op->cleanup( ulog )));
+    close( start[ 0 ] );
+    close( start[ 1 ] );
+    assert( ulog_status_success( ulog_shared_remove( name )));
+}
+
+int
+main( void )
+{
+    char name[ 64U ];
+    ( void ) snprintf(
+        name,
+        sizeof( name ),
+        "/ulog_ring_%ld",
+        ( long ) getpid()
+    );
+    test_ring( name );
+    ( void ) snprintf(
+        name,
+        sizeof( name ),
+        "/ulog_stall_%ld",
+        ( long ) getpid()
+    );
+    test_stall( name );
+    ( void ) snprintf(
+        name,
+        sizeof( name ),
+        "/ulog_workers_%ld",
+        ( long ) getpid()
+    );
+    test_processes( name );
+    return 0;
+}
@@ -0,0 +1,160 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Test control shared by processes #01
+ * \date        2016/05/25 09:14:26 AM
+ * \file        test_shared_01.c
+ * \version     1.0
+ *
+ *
+ **/
+
+#define _POSIX_C_SOURCE 200809L /* for fork, getpid */
+
+#include <ulog/shared.h>
+#include <ulog/status.h>
+#include <ulog/ulog.h>
+
+#include <assert.h> /* assert */
+#include <errno.h> /* ENODATA, ENOTCONN */
+#include <pthread.h> /* pthread_create, pthread_join, pthread_t */
+#include <stdbool.h> /* bool */
+#include <stddef.h> /* NULL */
+#include <stdarg.h> /* va_list */
+#include <stdio.h> /* snprintf */
+#include <stdlib.h> /* _Exit */
+#include <sys/types.h> /* pid_t */
+#include <sys/wait.h> /* WEXITSTATUS, WIFEXITED, waitpid */
+#include <unistd.h> /* fork, getpid */
+
+static unsigned calls;
+static unsigned debug_line;
+static bool stop;
+
+void
+count_calls(
+    ulog_level const level,
+    char const * const format,
+    va_list args
+)
+{
+    ( void ) level;
+    ( void ) format;
+    ( void ) args;
+    ++calls;
+}
+
+static unsigned
+debug_here( void )
+{
+    unsigned const before = calls;
+    debug_line = __LINE__; UDEBUG( "debug" );
+    return calls - before;
+}
+
+/* verbosity is the same in both pages, so it never seems to change */
+static void *
+keep_checking( void * const unused )
+{
+    ( void ) unused;
+    bool enabled = true;
+    while( enabled && !__atomic_load_n( &stop, __ATOMIC_ACQUIRE ))
+    {
+        enabled = ulog_enabled_( DEBUG );
+    }
+    return enabled ? NULL : &stop;
+}
+
+int
+main( void )
+{
+    char name[ 64U ];
+    ( void ) snprintf(
+        name,
+        sizeof( name ),
+        "/ulog_test_%ld",
+        ( long ) getpid()
+    );
+    ulog_obj const * const ulog = ulog_obj_get();
+    assert( ENOTCONN == ulog_status_to_int( ulog->op->share( ulog, name )));
+    assert( ulog_status_success( ulog->op->setup( ulog )));
+    assert( ulog_status_success( ulog->op->add( ulog, count_calls )));
+    assert( ulog_status_success( ulog->op->verbosity( ulog, INFO )));
+    assert( ENODATA == ulog_status_to_int( ulog->op->share( ulog, "x" )));
+    assert( ENODATA == ulog_status_to_int( ulog->op->share( ulog, "/a/b" )));
+
+    /* page is created with verbosity of the process */
+    assert( ulog_status_success( ulog->op->share( ulog, name )));
+    assert( ULOG_SHARED_MAGIC == ulog_fast_->magic );
+    assert(( int ) INFO == ulog_fast_->threshold );
+    assert( 0U != ulog_fast_->generation );
+    assert( 0U == debug_here());
+
+    /* other mapping of the page controls this process */
+    ulog_fast_state * page = NULL;
+    assert( ulog_status_success( ulog_shared_open( name, &page )));
+    assert( ulog_fast_ != page );
+    assert( ulog_status_success( ulog_shared_verbosity( page, DEBUG )));
+    assert(( int ) DEBUG == ulog_fast_->threshold );
+    assert( 1U == debug_here());
+    assert( ulog_status_success( ulog->op->verbosity( ulog, WARNING )));
+    assert(( int ) WARNING == page->threshold );
+    assert( 0U == debug_here());
+#if defined( __STDC_VERSION__ ) && ( 201112L <= __STDC_VERSION__ )
+    ulog_shared_enable( page, "test_shared_01.c", debug_line, true );
+    assert( ulog_shared_enabled( ulog_fast_, __FILE__, debug_line ));
+    assert( 1U == debug_here());
+    ulog_shared_enable( page, "test/test_shared_01.c", debug_line, false );
+    assert( 0U == debug_here());
+#endif /* __STDC_VERSION__ */
+    assert( ULOG_SHARED_BITS > ulog_shared_bit( "/a/b/c.c", 12U ));
+    assert( ulog_shared_bit( "c.c", 12U ) == ulog_shared_bit( "b/c.c", 12U ));
+
+    /* so does other process */
+    pid_t const child = fork();
+    assert( -1 != child );
+    if( 0 == child )
+    {
+        ulog_fast_state * other = NULL;
+        _Exit(
+            ulog_status_success( ulog_shared_open( name, &other ))
+            && ulog_status_success( ulog_shared_verbosity( other, INFO ))
+            ? 0 : 1
+        );
+    }
+    int status = 0;
+    assert( child == waitpid( child, &status, 0 ));
+    assert( WIFEXITED( status ) && ( 0 == WEXITSTATUS( status )));
+    assert(( int ) INFO == ulog_fast_->threshold );
+
+    /* process keeps verbosity once it stops sharing */
+    assert( ulog_status_success( ulog->op->share( ulog, NULL )));
+    assert( 0U == ulog_fast_->magic );
+    assert(( int ) INFO == ulog_fast_->threshold );
+    assert( ulog_status_success( ulog_shared_verbosity( page, DEBUG )));
+    assert(( int ) INFO == ulog_fast_->threshold );
+    assert( 0U == debug_here());
+
+    /* existing page keeps its verbosity */
+    assert( ulog_status_success( ulog->op->share( ulog, name )));
+    assert(( int ) DEBUG == ulog_fast_->threshold );
+
+    /* logging macros keep up while sharing starts and stops */
+    pthread_t checker;
+    assert( 0 == pthread_create( &checker, NULL, keep_checking, NULL ));
+    for( unsigned i = 0U; i < 100U; ++i )
+    {
+        assert( ulog_status_success( ulog->op->share( ulog, NULL )));
+        assert( ulog_status_success( ulog->op->share( ulog, name )));
+    }
+    __atomic_store_n( &stop, true, __ATOMIC_RELEASE );
+    void * checked = &stop;
+    assert( 0 == pthread_join( checker, &checked ));
+    assert( NULL == checked );
+    ulog_shared_close( page );
+    assert( ulog_status_success( ulog->op->cleanup( ulog )));
+    assert( -1 == ulog_fast_->threshold );
+    assert( 0U == ulog_fast_->magic );
+    assert( ulog_status_success( ulog_shared_remove( name )));
+    assert( ENODATA == ulog_status_to_int( ulog_shared_remove( "" )));
+    return 0;
+}
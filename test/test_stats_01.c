@@ -0,0 +1,148 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Test statistics #01
+ * \date        2016/03/26 13:16:25 PM
+ * \file        test_stats_01.c
+ * \version     1.0
+ *
+ *
+ **/
+
+#include <ulog/status.h>
+#include <ulog/ulog.h>
+
+#include <assert.h> /* assert */
+#include <errno.h> /* EINVAL, ENOBUFS, ENODATA, ENOTCONN, ENOTSUP */
+#include <stdarg.h> /* va_list */
+#include <stdbool.h> /* true */
+#include <stddef.h> /* NULL, size_t */
+#include <stdint.h> /* uint64_t */
+#include <stdio.h> /* vsnprintf */
+#include <string.h> /* strcmp, strstr */
+
+static unsigned calls;
+static unsigned reports;
+static size_t length;
+
+void
+count( ulog_level const level, char const * const format, va_list args )
+{
+    char buffer[ 256U ];
+    ( void ) level;
+    int const result = vsnprintf( buffer, sizeof( buffer ), format, args );
+    assert( 0 < result );
+    if( NULL != strstr( buffer, "ulog stats:" )) { ++reports; return; }
+    /* messages are rendered once, to be measured, then passed as text */
+    assert( 0 == strcmp( "%s", format ));
+    ++calls;
+    length += ( size_t ) result;
+}
+
+void
+discard( ulog_level const level, char const * const format, va_list args )
+{
+    ( void ) level;
+    ( void ) format;
+    ( void ) args;
+}
+
+int
+main( void )
+{
+    ulog_obj const * const ulog = ulog_obj_get();
+    ulog_handler_stats handler[ 2U ];
+    ulog_stats stats = { .handlers = 2U, .handler = handler };
+    ulog_obj_config config = { .handlers = 4U, .stats_period = 1U };
+
+    for( uint64_t i = 0U; i < 100000U; i = i * 2U + 1U )
+    {
+        /* each latency falls within a quarter of its bucket's start */
+        uint64_t low = 0U;
+        for( size_t j = 0U; j < ULOG_STATS_BUCKETS; ++j )
+        {
+            uint64_t const start = ulog_stats_bucket_start( j );
+            if( start > i ) { break; }
+            low = start;
+        }
+        assert( low <= i );
+        assert(( i - low ) * 4U <= low + 3U );
+    }
+
+    assert( ENOTCONN == ulog_status_to_int( ulog->op->stats( ulog, &stats )));
+    assert( EINVAL == ulog_status_to_int(
+            ulog->op->configure( ulog, &config )));
+    config.stats = true;
+    assert( ulog_status_success( ulog->op->configure( ulog, &config )));
+    assert( ulog_status_success( ulog->op->setup( ulog )));
+    assert( ENODATA == ulog_status_to_int( ulog->op->stats( ulog, NULL )));
+    assert( ulog_status_success( ulog->op->add( ulog, count )));
+    assert( ulog_status_success( ulog->op->verbosity( ulog, INFO )));
+
+    UERROR( "error %d", 1 );
+    UWARNING( "warning %d", 2 );
+    UINFO( "info %d", 3 );
+    UINFO( "info %d", 4 );
+    UDEBUG( "debug %d", 5 );
+    assert( 4U == calls );
+    /* stats_period is a nanosecond, so each accepted call reports */
+    assert( 0U < reports );
+
+    assert( ulog_status_success( ulog->op->stats( ulog, &stats )));
+    assert( 1U == stats.messages[ ERROR ] );
+    assert( 1U == stats.messages[ WARNING ] );
+    assert( 2U == stats.messages[ INFO ] );
+    assert( 0U == stats.messages[ DEBUG ] );
+    assert( 1U == stats.suppressed );
+    assert( length == stats.bytes );
+    assert( 1U == stats.handlers );
+    assert( count == handler[ 0U ].handler );
+    assert( calls + reports == handler[ 0U ].calls );
+    uint64_t total = 0U;
+    for( size_t i = 0U; i < ULOG_STATS_BUCKETS; ++i )
+    {
+        total += handler[ 0U ].latency[ i ];
+    }
+    assert( total == handler[ 0U ].calls );
+    assert(
+        ulog_stats_percentile( &handler[ 0U ], 0.5 )
+        <= ulog_stats_percentile( &handler[ 0U ], 0.99 )
+    );
+
+    assert( ulog_status_success( ulog->op->add( ulog, discard )));
+    stats.handlers = 1U;
+    assert( ENOBUFS == ulog_status_to_int( ulog->op->stats( ulog, &stats )));
+    assert( 1U == stats.handlers );
+    stats.handlers = 2U;
+    assert( ulog_status_success( ulog->op->stats( ulog, &stats )));
+    assert( 2U == stats.handlers );
+
+    /* removed and re-added handler starts counting anew */
+    assert( ulog_status_success( ulog->op->remove( ulog, discard )));
+    assert( ulog_status_success( ulog->op->add( ulog, discard )));
+    assert( ulog_status_success( ulog->op->stats( ulog, &stats )));
+    assert( discard == handler[ 1U ].handler );
+    assert( 0U == handler[ 1U ].calls );
+
+    /* asynchronous channel takes the measured text too */
+    ulog_async_config const async =
+    {
+        .capacity = 16U,
+        .policy = ULOG_BLOCK,
+        .timeout = UINT64_MAX
+    };
+    assert( ulog_status_success( ulog->op->async( ulog, &async )));
+    UINFO( "async %d", 6 );
+    assert( ulog_status_success( ulog->op->async( ulog, NULL )));
+    assert( 5U == calls );
+    assert( ulog_status_success( ulog->op->stats( ulog, &stats )));
+    assert( length == stats.bytes );
+
+    assert( ulog_status_success( ulog->op->cleanup( ulog )));
+    config.stats = false;
+    config.stats_period = 0U;
+    assert( ulog_status_success( ulog->op->configure( ulog, &config )));
+    assert( ulog_status_success( ulog->op->setup( ulog )));
+    assert( ENOTSUP == ulog_status_to_int( ulog->op->stats( ulog, &stats )));
+    assert( ulog_status_success( ulog->op->cleanup( ulog )));
+    return 0;
+}
@@ -0,0 +1,159 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Test spans and their export #01
+ * \date        2016/05/14 13:05:48 PM
+ * \file        test_trace_01.c
+ * \version     1.0
+ *
+ *
+ **/
+
+#include <ulog/status.h>
+#include <ulog/trace.h>
+#include <ulog/ulog.h>
+
+#include <assert.h> /* assert */
+#include <errno.h> /* ENODATA */
+#include <pthread.h> /* pthread_create, pthread_join, pthread_t */
+#include <stdarg.h> /* va_list */
+#include <stddef.h> /* NULL */
+#include <stdio.h> /* FILE, fclose, fputs, fread, rewind, snprintf, etc. */
+#include <string.h> /* strstr */
+#include <unistd.h> /* getpid */
+
+static FILE * logged;
+
+void
+log_to_file(
+    ulog_level const level,
+    char const * const format,
+    va_list args
+)
+{
+    ( void ) level;
+    ( void ) vfprintf( logged, format, args );
+}
+
+static void *
+span_in_thread( void * const unused )
+{
+    ( void ) unused;
+    UTRACE_BEGIN( "worker" );
+    assert( 1U == ulog_trace_.depth );
+    UTRACE_END();
+    return ( void * ) ( unsigned long ) ulog_trace_.thread;
+}
+
+static char *
+export( char * const json, size_t const size )
+{
+    FILE * const output = tmpfile();
+    assert( NULL != output );
+    rewind( logged );
+    assert( ulog_status_success( ulog_trace_export( logged, output )));
+    rewind( output );
+    size_t const length = fread( json, 1U, size - 1U, output );
+    json[ length ] = '\0';
+    fclose( output );
+    return json;
+}
+
+int
+main( void )
+{
+    logged = tmpfile();
+    assert( NULL != logged );
+    ulog_obj const * const ulog = ulog_obj_get();
+    assert( ulog_status_success( ulog->op->setup( ulog )));
+    assert( ulog_status_success( ulog->op->add( ulog, log_to_file )));
+    assert( ulog_status_success( ulog->op->verbosity( ulog, DEBUG )));
+
+    assert( NULL == ulog_trace_end_());
+    UTRACE_END();
+    UTRACE_BEGIN( "outer" );
+    UTRACE_BEGIN( "inner" );
+    assert( 2U == ulog_trace_.depth );
+    UINFO( "said \"%s\"", "hello" );
+    UTRACE_END();
+    pthread_t worker;
+    assert( 0 == pthread_create( &worker, NULL, span_in_thread, NULL ));
+    void * thread = NULL;
+    assert( 0 == pthread_join( worker, &thread ));
+    assert( ulog_trace_.thread != ( unsigned long ) thread );
+    UTRACE_END();
+    assert( 0U == ulog_trace_.depth );
+
+    /* nesting is kept even if spans aren't logged */
+    assert( ulog_status_success( ulog->op->verbosity( ulog, INFO )));
+    UTRACE_BEGIN( "hidden" );
+    assert( 1U == ulog_trace_.depth );
+    assert( ulog_status_success( ulog->op->verbosity( ulog, DEBUG )));
+    UTRACE_BEGIN( "visible" );
+    UTRACE_END();
+    UTRACE_END();
+    assert( 0U == ulog_trace_.depth );
+    assert( ulog_status_success( ulog->op->cleanup( ulog )));
+
+    char json[ 4096U ];
+    export( json, sizeof( json ));
+    assert( json == strstr( json, "{\"traceEvents\":[" ));
+    char const * const outer = strstr( json, "\"name\":\"outer\"" );
+    char const * const inner = strstr( json, "\"name\":\"inner\"" );
+    char const * const said =
+        strstr( json, "\"name\":\"said \\\"hello\\\"\"" );
+    assert(( NULL != outer ) && ( NULL != inner ) && ( NULL != said ));
+    assert(( outer < inner ) && ( inner < said ));
+    assert( NULL != strstr( said, "\"ph\":\"i\"" ));
+    assert( NULL != strstr( said, "\"level\":\"I\"" ));
+    assert( NULL != strstr( json, "\"name\":\"worker\"" ));
+    char process[ 32U ];
+    snprintf( process, sizeof( process ), "\"pid\":%ld,", ( long ) getpid());
+    assert( NULL != strstr( outer, process ));
+    assert( NULL != strstr( said, process ));
+    assert( NULL == strstr( json, "\"name\":\"hidden\"" ));
+    assert( NULL != strstr( json, "\"name\":\"visible\"" ));
+    assert( NULL != strstr( json, "],\"displayTimeUnit\":\"ns\"}" ));
+
+    /* ends without beginnings are skipped, lost ones are supplied */
+    fclose( logged );
+    logged = tmpfile();
+    assert( NULL != logged );
+    fputs( "[D][1000][f.c:f:1] trace E 7 1 0 orphan\n", logged );
+    fputs( "not a record\n", logged );
+    fputs( "[D][2000][f.c:f:2] trace B 7 1 0 parent\n", logged );
+    fputs( "[D][3000][f.c:f:3] trace B 7 1 1 child\n", logged );
+    fputs( "[D][4500][f.c:f:5] trace E 7 1 0 parent\n", logged );
+    export( json, sizeof( json ));
+    assert( NULL == strstr( json, "orphan" ));
+    assert( NULL == strstr( json, "not a record" ));
+    assert( NULL != strstr( json, "\"ts\":2.000" ));
+    char const * const lost =
+        strstr( json, "\"name\":\"\",\"cat\":\"span\"" );
+    assert( NULL != lost );
+    assert( NULL != strstr( lost, "\"ph\":\"E\",\"ts\":4.500" ));
+    assert(
+        NULL
+        != strstr( lost, "\"name\":\"parent\",\"cat\":\"span\",\"ph\":\"E\"" )
+    );
+
+    /* threads are told apart by process, any identifier takes little */
+    fclose( logged );
+    logged = tmpfile();
+    assert( NULL != logged );
+    fputs( "[D][1000][f.c:f:1] trace B 7 4000000000 0 far\n", logged );
+    fputs( "[D][2000][f.c:f:2] trace B 8 4000000000 0 forked\n", logged );
+    fputs( "[D][3000][f.c:f:3] trace E 7 4000000000 0 far\n", logged );
+    fputs( "[D][4000][f.c:f:4] trace E 8 4000000000 0 forked\n", logged );
+    export( json, sizeof( json ));
+    char const * const far =
+        strstr( json, "\"name\":\"far\",\"cat\":\"span\",\"ph\":\"E\"" );
+    char const * const forked =
+        strstr( json, "\"name\":\"forked\",\"cat\":\"span\",\"ph\":\"E\"" );
+    assert(( NULL != far ) && ( NULL != forked ));
+    assert( NULL != strstr( far, "\"pid\":7,\"tid\":4000000000}" ));
+    assert( NULL != strstr( forked, "\"pid\":8,\"tid\":4000000000}" ));
+
+    assert( ENODATA == ulog_status_to_int( ulog_trace_export( NULL, logged )));
+    fclose( logged );
+    return 0;
+}
@@ -0,0 +1,143 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Renders interned streams of records as text.
+ * \date        2016/06/03 15:26:19 PM
+ * \file        ulog_decode.c
+ * \version     1.0
+ *
+ * Usage: ulog-decode FILE...
+ * Writes records of each FILE, written with ulog_intern_encode(), e.g. by
+ * interned files of threads, to standard output as text, the same as logged
+ * by text handlers. Streams compressed into blocks with ulog_compress_block()
+ * are decompressed first.
+ **/
+
+#define _POSIX_C_SOURCE 200809L /* for posix_madvise */
+
+#include <ulog/compress.h>
+#include <ulog/intern.h>
+#include <ulog/status.h>
+
+#include <errno.h> /* EIO, ENODATA */
+#include <fcntl.h> /* O_RDONLY, open */
+#include <stdbool.h> /* bool */
+#include <stddef.h> /* NULL, size_t */
+#include <stdio.h> /* fflush, fprintf, fputs, stdout */
+#include <stdlib.h> /* EXIT_FAILURE, EXIT_SUCCESS, free */
+#include <string.h> /* strerror */
+#include <sys/mman.h> /* mmap, munmap, posix_madvise */
+#include <sys/stat.h> /* fstat, struct stat */
+#include <unistd.h> /* close */
+
+static ulog_status
+decode_mapped(
+    unsigned char const * const data,
+    size_t const size,
+    FILE * const output
+)
+{
+    ulog_intern_dictionary dictionary = { .text = NULL };
+    static char text[ ULOG_INTERN_BUFFER ];
+    ulog_status result = ulog_status_descriptive( 0, "file decoded" );
+    for( size_t offset = 0U; size > offset; )
+    {
+        size_t consumed = 0U;
+        result =
+            ulog_intern_decode(
+                &dictionary,
+                data + offset,
+                size - offset,
+                &consumed,
+                text,
+                sizeof( text )
+            );
+        offset += consumed;
+        if( ENODATA == ulog_status_to_int( result ))
+        {
+            result =
+                ( size == offset )
+                    ? ulog_status_descriptive( 0, "file decoded" )
+                    : ulog_status_descriptive( ENODATA, "file truncated" );
+            break;
+        }
+        if( !ulog_status_success( result )) { break; }
+        if( EOF == fputs( text, output ))
+        {
+            result = ulog_status_descriptive( EIO, "cannot write output" );
+            break;
+        }
+    }
+    ulog_intern_release( &dictionary );
+    return result;
+}
+
+static ulog_status
+decode( char const * const path, FILE * const output )
+{
+    int const file = open( path, O_RDONLY );
+    struct stat status;
+    if(( -1 == file ) || ( 0 != fstat( file, &status )))
+    {
+        if( -1 != file ) { close( file ); }
+        return ulog_status_descriptive( EIO, "cannot open file" );
+    }
+    size_t const size = ( size_t ) status.st_size;
+    if( 0U == size )
+    {
+        close( file );
+        return ulog_status_descriptive( 0, "file empty" );
+    }
+    void * const mapped = mmap( NULL, size, PROT_READ, MAP_PRIVATE, file, 0 );
+    close( file );
+    if( MAP_FAILED == mapped )
+    {
+        return ulog_status_descriptive( EIO, "cannot map file" );
+    }
+    ( void ) posix_madvise( mapped, size, POSIX_MADV_SEQUENTIAL );
+    if( !ulog_compressed( mapped, size ))
+    {
+        ulog_status const result = decode_mapped( mapped, size, output );
+        munmap( mapped, size );
+        return result;
+    }
+    void * expanded = NULL;
+    size_t length = 0U;
+    ulog_status result =
+        ulog_decompress( mapped, size, 0U, &expanded, &length );
+    munmap( mapped, size );
+    if( ulog_status_success( result ))
+    {
+        result = decode_mapped( expanded, length, output );
+        free( expanded );
+    }
+    return result;
+}
+
+int
+main( int const argc, char * const * const argv )
+{
+    if( 2 > argc )
+    {
+        fprintf( stderr, "usage: %s FILE...\n", argv[ 0 ] );
+        return EXIT_FAILURE;
+    }
+    bool failed = false;
+    for( int i = 1; i < argc; ++i )
+    {
+        ulog_status const decoded = decode( argv[ i ], stdout );
+        if( !ulog_status_success( decoded ))
+        {
+            fprintf(
+                stderr,
+                "%s: %s: %s (%s)\n",
+                argv[ 0 ],
+                argv[ i ],
+                strerror( ulog_status_to_int( decoded )),
+                decoded.description
+            );
+            failed = true;
+        }
+    }
+    if( 0 != fflush( stdout )) { failed = true; }
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,102 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Searches logged records with many threads.
+ * \date        2016/05/30 14:26:40 PM
+ * \file        ulog_grep.c
+ * \version     1.0
+ *
+ * Usage: ulog-grep [-l LEVELS] [-s SINCE] [-u UNTIL] [-j THREADS]
+ *        PATTERN FILE...
+ * Writes records of each FILE containing PATTERN, which may be empty, to
+ * standard output. Options:
+ * -l LEVELS - keeps only records of given level characters, e.g. EW,
+ * -s SINCE, -u UNTIL - keeps only records logged within given nanoseconds,
+ * -j THREADS - searches with given number of threads, not one per CPU.
+ * Compressed files are decompressed block by block, as they are searched;
+ * records of interned ones are decoded into text lines first.
+ * Exits with success if any record matched.
+ **/
+
+#define _POSIX_C_SOURCE 200809L /* for getopt */
+
+#include <ulog/grep.h>
+#include <ulog/status.h>
+
+#include <stdbool.h> /* bool */
+#include <stdint.h> /* uint64_t */
+#include <stdio.h> /* fprintf, stdout */
+#include <stdlib.h> /* EXIT_FAILURE, EXIT_SUCCESS, strtoull */
+#include <string.h> /* strerror */
+#include <unistd.h> /* getopt, optarg, optind */
+
+static bool
+parse_number( char const * const text, uint64_t * const number )
+{
+    char * end = NULL;
+    unsigned long long const value = strtoull( text, &end, 10 );
+    if(( text == end ) || ( '\0' != *end )) { return false; }
+    *number = ( uint64_t ) value;
+    return true;
+}
+
+static int
+usage( char const * const name )
+{
+    fprintf(
+        stderr,
+        "usage: %s [-l LEVELS] [-s SINCE] [-u UNTIL] [-j THREADS]"
+        " PATTERN FILE...\n",
+        name
+    );
+    return EXIT_FAILURE;
+}
+
+int
+main( int const argc, char * const * const argv )
+{
+    ulog_grep_config config = { .pattern = NULL };
+    uint64_t threads = 0U;
+    for( int option; -1 != ( option = getopt( argc, argv, "l:s:u:j:" )); )
+    {
+        bool valid = true;
+        switch( option )
+        {
+            case 'l': config.levels = optarg; break;
+            case 's': valid = parse_number( optarg, &( config.since )); break;
+            case 'u': valid = parse_number( optarg, &( config.until )); break;
+            case 'j':
+                valid =
+                    parse_number( optarg, &threads ) && ( 1024U >= threads );
+                break;
+            default: valid = false; break;
+        }
+        if( !valid ) { return usage( argv[ 0 ] ); }
+    }
+    if( argc - optind < 2 ) { return usage( argv[ 0 ] ); }
+    config.pattern = argv[ optind ];
+    config.threads = ( unsigned ) threads;
+
+    uint64_t total = 0U;
+    bool failed = false;
+    for( int i = optind + 1; i < argc; ++i )
+    {
+        uint64_t matched = 0U;
+        ulog_status const searched =
+            ulog_grep( argv[ i ], &config, stdout, &matched );
+        total += matched;
+        if( !ulog_status_success( searched ))
+        {
+            fprintf(
+                stderr,
+                "%s: %s: %s (%s)\n",
+                argv[ 0 ],
+                argv[ i ],
+                strerror( ulog_status_to_int( searched )),
+                searched.description
+            );
+            failed = true;
+        }
+    }
+    if( 0 != fflush( stdout )) { failed = true; }
+    return ( !failed && ( 0U != total )) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,54 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Merges logged records of many files by time.
+ * \date        2016/06/01 13:40:05 PM
+ * \file        ulog_merge.c
+ * \version     1.0
+ *
+ * Usage: ulog-merge FILE...
+ * Writes records of all FILEs to standard output, ordered by time, e.g.
+ * records of files logged separately by each thread or process. Compressed
+ * files are decompressed block by block, interned ones decoded into text.
+ **/
+
+#include <ulog/merge.h>
+#include <ulog/status.h>
+
+#include <stddef.h> /* NULL, size_t */
+#include <stdio.h> /* _IOFBF, fflush, fprintf, setvbuf, stdout */
+#include <stdlib.h> /* EXIT_FAILURE, EXIT_SUCCESS */
+#include <string.h> /* strerror */
+
+/* merged records are written in large blocks */
+#define OUTPUT_BUFFER ( 1024U * 1024U )
+
+int
+main( int const argc, char * const * const argv )
+{
+    if( 2 > argc )
+    {
+        fprintf( stderr, "usage: %s FILE...\n", argv[ 0 ] );
+        return EXIT_FAILURE;
+    }
+    static char buffer[ OUTPUT_BUFFER ];
+    ( void ) setvbuf( stdout, buffer, _IOFBF, sizeof( buffer ));
+    ulog_status const merged =
+        ulog_merge(
+            ( char const * const * ) ( argv + 1 ),
+            ( size_t ) ( argc - 1 ),
+            stdout,
+            NULL
+        );
+    if( !ulog_status_success( merged ))
+    {
+        fprintf(
+            stderr,
+            "%s: %s (%s)\n",
+            argv[ 0 ],
+            strerror( ulog_status_to_int( merged )),
+            merged.description
+        );
+        return EXIT_FAILURE;
+    }
+    return ( 0 == fflush( stdout )) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
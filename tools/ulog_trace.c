@@ -0,0 +1,48 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Converts logged text into Chrome Trace Event JSON.
+ * \date        2016/05/14 15:47:12 PM
+ * \file        ulog_trace.c
+ * \version     1.0
+ *
+ * Usage: ulog-trace [LOG [JSON]]
+ * Reads records from LOG, or standard input, and writes trace events to
+ * JSON, or standard output.
+ **/
+
+#include <ulog/status.h>
+#include <ulog/trace.h>
+
+#include <stddef.h> /* NULL */
+#include <stdio.h> /* FILE, fclose, fopen, fprintf, stdin, stdout */
+#include <stdlib.h> /* EXIT_FAILURE, EXIT_SUCCESS */
+#include <string.h> /* strerror */
+
+int
+main( int const argc, char const * const * const argv )
+{
+    if( 3 < argc )
+    {
+        fprintf( stderr, "usage: %s [LOG [JSON]]\n", argv[ 0 ] );
+        return EXIT_FAILURE;
+    }
+    FILE * const input = ( 1 < argc ) ? fopen( argv[ 1 ], "r" ) : stdin;
+    FILE * const output = ( 2 < argc ) ? fopen( argv[ 2 ], "w" ) : stdout;
+    ulog_status const exported = ulog_trace_export( input, output );
+    if( !ulog_status_success( exported ))
+    {
+        fprintf(
+            stderr,
+            "%s: %s (%s)\n",
+            argv[ 0 ],
+            strerror( ulog_status_to_int( exported )),
+            exported.description
+        );
+    }
+    if(( NULL != input ) && ( stdin != input )) { fclose( input ); }
+    if(( NULL != output ) && ( stdout != output ) && ( 0 != fclose( output )))
+    {
+        return EXIT_FAILURE;
+    }
+    return ulog_status_success( exported ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,173 @@
+/**
+ * \author      Mateusz Jemielity matthew.jemielity@gmail.com
+ * \brief       Controls logging of processes sharing a page.
+ * \date        2016/05/24 21:15:33 PM
+ * \file        ulogctl.c
+ * \version     1.0
+ *
+ * Usage: ulogctl NAME COMMAND
+ * where NAME is the one given to share() and COMMAND is one of:
+ * show - prints verbosity and number of enabled call sites,
+ * verbosity LEVEL - sets verbosity to ERROR, WARNING, INFO or DEBUG,
+ * on FILE:LINE - makes call site log regardless of verbosity,
+ * off FILE:LINE - makes call site log according to verbosity again,
+ * remove - removes the name; processes which use it keep sharing the page.
+ **/
+
+#include <ulog/shared.h>
+#include <ulog/status.h>
+#include <ulog/ulog.h>
+
+#include <errno.h> /* ENODATA */
+#include <limits.h> /* UINT_MAX */
+#include <stdbool.h> /* bool */
+#include <stddef.h> /* NULL, size_t */
+#include <stdio.h> /* fprintf, printf */
+#include <stdlib.h> /* EXIT_FAILURE, EXIT_SUCCESS, strtoul */
+#include <string.h> /* memcpy, strcmp, strerror, strrchr */
+#include <strings.h> /* strcasecmp */
+
+static char const * const names[ ULOG_LEVELS ] =
+{
+    [ ERROR ] = "ERROR",
+    [ WARNING ] = "WARNING",
+    [ INFO ] = "INFO",
+    [ DEBUG ] = "DEBUG"
+};
+
+static bool
+parse_level( char const * const text, ulog_level * const level )
+{
+    for( size_t i = 0U; i < ULOG_LEVELS; ++i )
+    {
+        if( 0 == strcasecmp( text, names[ i ] ))
+        {
+            *level = ( ulog_level ) i;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool
+parse_site(
+    char const * const text,
+    char * const file,
+    size_t const size,
+    unsigned * const line
+)
+{
+    char const * const colon = strrchr( text, ':' );
+    if(( NULL == colon ) || ( colon == text )) { return false; }
+    size_t const length = ( size_t ) ( colon - text );
+    char * end = NULL;
+    unsigned long const number = strtoul( colon + 1, &end, 10 );
+    if(
+        ( size <= length ) || ( colon + 1 == end ) || ( '\0' != *end )
+        || ( 0UL == number ) || ( UINT_MAX < number )
+    )
+    {
+        return false;
+    }
+    memcpy( file, text, length );
+    file[ length ] = '\0';
+    *line = ( unsigned ) number;
+    return true;
+}
+
+static void
+show( ulog_fast_state const * const page )
+{
+    int const threshold =
+        __atomic_load_n( &( page->threshold ), __ATOMIC_RELAXED );
+    size_t enabled = 0U;
+    for( size_t i = 0U; i < sizeof( page->enabled ); ++i )
+    {
+        for( unsigned byte = page->enabled[ i ]; 0U != byte; byte >>= 1U )
+        {
+            enabled += byte & 1U;
+        }
+    }
+    printf(
+        "verbosity %s\ncall sites %zu\n",
+        (( 0 <= threshold ) && ( ULOG_LEVELS > ( unsigned ) threshold ))
+            ? names[ threshold ]
+            : "?",
+        enabled
+    );
+}
+
+static ulog_status
+run( ulog_fast_state * const page, int const argc, char * const * const argv )
+{
+    char const * const command = argv[ 2 ];
+    if(( 3 == argc ) && ( 0 == strcmp( command, "show" )))
+    {
+        show( page );
+        return ulog_status_descriptive( 0, "shown" );
+    }
+    ulog_level level;
+    if(
+        ( 4 == argc )
+        && ( 0 == strcmp( command, "verbosity" ))
+        && parse_level( argv[ 3 ], &level )
+    )
+    {
+        return ulog_shared_verbosity( page, level );
+    }
+    char file[ ULOG_CALLSITE_PATTERN ];
+    unsigned line = 0U;
+    bool const on = ( 0 == strcmp( command, "on" ));
+    if(
+        ( 4 == argc )
+        && ( on || ( 0 == strcmp( command, "off" )))
+        && parse_site( argv[ 3 ], file, sizeof( file ), &line )
+    )
+    {
+        ulog_shared_enable( page, file, line, on );
+        return ulog_status_descriptive( 0, "call site set" );
+    }
+    return ulog_status_descriptive( ENODATA, "invalid command" );
+}
+
+int
+main( int const argc, char * const * const argv )
+{
+    if(( 3 > argc ) || ( 4 < argc ))
+    {
+        fprintf(
+            stderr,
+            "usage: %s NAME show|remove|verbosity LEVEL|on FILE:LINE"
+            "|off FILE:LINE\n",
+            argv[ 0 ]
+        );
+        return EXIT_FAILURE;
+    }
+    ulog_status result;
+    if(( 3 == argc ) && ( 0 == strcmp( argv[ 2 ], "remove" )))
+    {
+        result = ulog_shared_remove( argv[ 1 ] );
+    }
+    else
+    {
+        ulog_fast_state * page = NULL;
+        result = ulog_shared_open( argv[ 1 ], &page );
+        if( ulog_status_success( result ))
+        {
+            result = run( page, argc, argv );
+            ulog_shared_close( page );
+        }
+    }
+    if( !ulog_status_success( result ))
+    {
+        fprintf(
+            stderr,
+            "%s: %s (%s)\n",
+            argv[ 0 ],
+            strerror( ulog_status_to_int( result )),
+            result.description
+        );
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}